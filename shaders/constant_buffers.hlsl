@@ -26,6 +26,8 @@ cbuffer ModelCB : register(b0) {
 	uint vertex_offset;
     uint vertex_type;
     float padding;
+    float4 vertex_pos_center;
+    float4 vertex_pos_extent;
 };
 
 // 1 x 256
@@ -45,10 +45,10 @@ ps_output main( PixelShaderInput input )
         output.albedo = gDiffuseMap.Sample(anisotropicClamp, input.tex_coord.xy);
 
         // normal mapping
-        float3 normal = gNormalMap.Sample(linearClamp, input.tex_coord.xy).xyz;
-        //normal.x = normal.x * 2 - 1;
-        //normal.y = -normal.y * 2 + 1;
-        normal = normal * 2.0 - 1.0;
+        // z is rebuilt, cooked normal maps are BC5 and only carry x and y
+        float3 normal;
+        normal.xy = gNormalMap.Sample(linearClamp, input.tex_coord.xy).xy * 2.0 - 1.0;
+        normal.z = sqrt(saturate(1.0 - dot(normal.xy, normal.xy)));
         normal = normalize(mul(normal, input.TBN));
         output.normal = float4(normal, 1.0);
         output.pos = float4(input.world_position.xyz, (input.world_position.w - NearFarZ.x) / (NearFarZ.y - NearFarZ.x));
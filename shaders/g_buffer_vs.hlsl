@@ -23,14 +23,15 @@ VertexShaderOutput main(uint vert_id : SV_VertexID)
     MVP = mul(MVP, P);
     output.position = mul(float4(v_data.position, 1.0f), MVP);
     output.world_position = float4(mul(float4(v_data.position, 1), M).xyz, output.position.z);
-    output.tex_coord.z = vertex_type;
+    const uint shading_type = get_vertex_shading_type(vertex_type);
+    output.tex_coord.z = shading_type;
     
-    if (vertex_type == 0)
+    if (shading_type == 0)
     {
         output.normal.xyz = mul(float4(v_data.normal, 0.0f), M).xyz;
         output.color = float4(v_data.color, 1.0f);
     }
-    if (vertex_type == 1)
+    if (shading_type == 1)
     {
         output.tex_coord.xy = v_data.tex_coords.xy;
 
@@ -37,6 +37,60 @@ float unpack_vertex_float(ByteAddressBuffer vertex_buffer, uint offset)
     return output;
 }
 
+// sign extends the low and high halves of a packed snorm16x2
+float2 unpack_snorm16x2(uint packed)
+{
+    const int2 val = int2(int(packed << 16) >> 16, int(packed) >> 16);
+    return max(float2(val) / 32767.0, -1.0);
+}
+
+// position snorm16x3 in the mesh bounds (ModelCB vertex_pos_center/extent), w carries a sign
+float3 unpack_vertex_position_snorm16(ByteAddressBuffer vertex_buffer, uint offset, out float w)
+{
+    const uint2 packed = vertex_buffer.Load2(offset);
+    const float2 xy = unpack_snorm16x2(packed.x);
+    const float2 zw = unpack_snorm16x2(packed.y);
+    w = zw.y;
+    
+    return vertex_pos_center.xyz + float3(xy, zw.x) * vertex_pos_extent.xyz;
+}
+
+float3 unpack_octahedral(uint packed)
+{
+    const float2 e = unpack_snorm16x2(packed);
+    float3 n = float3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+    const float t = saturate(-n.z);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    
+    return normalize(n);
+}
+
+float2 unpack_half2(uint packed)
+{
+    return float2(f16tof32(packed & 0xffff), f16tof32(packed >> 16));
+}
+
+float3 unpack_unorm8x3(uint packed)
+{
+    return float3(packed & 0xff, (packed >> 8) & 0xff, (packed >> 16) & 0xff) / 255.0;
+}
+
+// packed vertex types are shaded as the full float layout they replace
+uint get_vertex_shading_type(uint vertex_type)
+{
+    if (vertex_type == 4)
+    {
+        return 0;
+    }
+    if (vertex_type == 5)
+    {
+        return 1;
+    }
+    
+    return vertex_type;
+}
+
 uint get_vertex_size(uint vertex_type)
 {
     uint size = 0;
@@ -49,6 +103,14 @@ uint get_vertex_size(uint vertex_type)
     {
         size = 56;
     }
+    else if (vertex_type == 4)
+    {
+        size = 16;
+    }
+    else if (vertex_type == 5)
+    {
+        size = 20;
+    }
     
     return size;
 }
@@ -56,6 +118,26 @@ uint get_vertex_size(uint vertex_type)
 VertexData unpack_vertex_buffer_data(ByteAddressBuffer vertex_buffer, uint offset, uint vertex_type)
 {
     VertexData output = (VertexData)0;
+    
+    if (vertex_type == 4 || vertex_type == 5)
+    {
+        float bitangent_sign;
+        output.position.xyz = unpack_vertex_position_snorm16(vertex_buffer, offset, bitangent_sign);
+        output.normal.xyz = unpack_octahedral(vertex_buffer.Load(offset + 8));
+        if (vertex_type == 4)
+        {
+            output.color.xyz = unpack_unorm8x3(vertex_buffer.Load(offset + 12));
+        }
+        else
+        {
+            output.tangents.xyz = unpack_octahedral(vertex_buffer.Load(offset + 12));
+            output.bitangents.xyz = cross(output.normal.xyz, output.tangents.xyz) * (bitangent_sign < 0.0 ? -1.0 : 1.0);
+            output.tex_coords.xy = unpack_half2(vertex_buffer.Load(offset + 16));
+        }
+        
+        return output;
+    }
+    
     output.position.xyz = unpack_vertex_float3(vertex_buffer, offset);
     
     switch (vertex_type)
@@ -0,0 +1,50 @@
+#include "AllocCounter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<bool> count_heap_allocs{ false };
+    thread_local uint64_t heap_allocs = 0;
+
+    void* CountedAlloc(size_t size, size_t alignment) {
+        if (count_heap_allocs.load(std::memory_order_relaxed)) {
+            heap_allocs++;
+        }
+        void* ptr = nullptr;
+        if (alignment <= alignof(std::max_align_t)) {
+            ptr = malloc(size ? size : 1);
+        }
+        else if (posix_memalign(&ptr, alignment, size ? size : 1) != 0) {
+            ptr = nullptr;
+        }
+        return ptr;
+    }
+}
+
+namespace alloc_counter {
+    void SetCounting(bool counting) {
+        count_heap_allocs = counting;
+    }
+
+    uint64_t GetThreadAllocs() {
+        return heap_allocs;
+    }
+}
+
+void* operator new(size_t size) { if (void* ptr = CountedAlloc(size, 0)) return ptr; throw std::bad_alloc(); }
+void* operator new[](size_t size) { if (void* ptr = CountedAlloc(size, 0)) return ptr; throw std::bad_alloc(); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size, 0); }
+void* operator new(size_t size, std::align_val_t al) { if (void* ptr = CountedAlloc(size, (size_t)al)) return ptr; throw std::bad_alloc(); }
+void* operator new[](size_t size, std::align_val_t al) { if (void* ptr = CountedAlloc(size, (size_t)al)) return ptr; throw std::bad_alloc(); }
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { free(ptr); }
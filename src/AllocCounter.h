@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+// The operator new/delete replacement in AllocCounter.cpp is process-wide, so it is only built with
+// DX12LIB_COUNT_ALLOCS; other builds keep the default allocation functions and count nothing.
+namespace alloc_counter {
+#ifdef DX12LIB_COUNT_ALLOCS
+    constexpr bool enabled = true;
+    // each thread counts its own calls while counting is on
+    void SetCounting(bool counting);
+    uint64_t GetThreadAllocs();
+#else
+    constexpr bool enabled = false;
+    inline void SetCounting(bool) {}
+    inline uint64_t GetThreadAllocs() { return 0; }
+#endif
+}
@@ -0,0 +1,382 @@
+#include "AllocatorBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include "free_allocator.h"
+#include "gpu_heap_allocator.h"
+#include "ring_allocator.h"
+#include "tlsf_allocator.h"
+
+using pro_game_containers::gpu_heap_allocator;
+using pro_game_containers::ring_allocator;
+using pro_game_containers::tlsf_allocator;
+
+namespace {
+    constexpr uint32_t arena_size = 1024 * 1024 * 32;
+
+    struct Op {
+        bool allocate{ false };
+        uint32_t size{ 0 };
+        uint32_t slot{ 0 };     // allocate fills it, deallocate frees it
+    };
+
+    // allocations of 16 byte to 16 KB, mostly small, up to live_max at once; the live bytes stay far below the arena
+    // size, the first fit allocator can only assert when it runs out
+    std::vector<Op> MakeOps(uint32_t ops_num, uint32_t live_max, std::mt19937& rng) {
+        std::vector<Op> ops;
+        ops.reserve(ops_num);
+        std::vector<uint32_t> live;
+        std::vector<uint32_t> free_slots;
+        std::geometric_distribution<uint32_t> small(0.02);
+        std::uniform_int_distribution<uint32_t> large(1, 1024);
+        uint32_t slots_num = 0;
+        for (uint32_t i = 0; i < ops_num; i++) {
+            if (!live.empty() && (live.size() == live_max || rng() % 2)) {
+                const uint32_t at = rng() % live.size();
+                ops.push_back({ false, 0, live[at] });
+                free_slots.push_back(live[at]);
+                live[at] = live.back();
+                live.pop_back();
+            }
+            else {
+                const uint32_t units = (rng() % 8) ? std::min(small(rng) + 1, 1024u) : large(rng);
+                uint32_t slot = slots_num;
+                if (free_slots.empty()) {
+                    slots_num++;
+                }
+                else {
+                    slot = free_slots.back();
+                    free_slots.pop_back();
+                }
+                ops.push_back({ true, units * 16, slot });
+                live.push_back(slot);
+            }
+        }
+        return ops;
+    }
+
+    uint32_t SlotsNum(const std::vector<Op>& ops) {
+        uint32_t slots_num = 0;
+        for (const Op& op : ops) {
+            slots_num = std::max(slots_num, op.slot + 1);
+        }
+        return slots_num;
+    }
+
+    template <class F>
+    double BestNs(uint32_t repeats, uint32_t ops_num, F&& func) {
+        using clock = std::chrono::steady_clock;
+        double best = 0.0;
+        for (uint32_t i = 0; i < repeats; i++) {
+            const clock::time_point start = clock::now();
+            func();
+            const double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / std::max(ops_num, 1u);
+            best = (i == 0) ? ns : std::min(best, ns);
+        }
+        return best;
+    }
+}
+
+namespace allocator_benchmark {
+    std::vector<BenchmarkResult> Benchmark(uint32_t ops_num, uint32_t repeats) {
+        std::vector<BenchmarkResult> results;
+        std::mt19937 rng(17);
+
+        // a few hundred live allocations like a small level, then thousands like a streamed one
+        for (uint32_t live_max : { 256u, 4096u }) {
+            const std::vector<Op> ops = MakeOps(ops_num, live_max, rng);
+            std::vector<uint64_t> starts(SlotsNum(ops));
+            std::vector<uint32_t> sizes(starts.size());  // free_allocator wants the size back
+
+            BenchmarkResult res{ live_max == 256 ? "256 live" : "4096 live", ops_num };
+            res.first_fit_ns = BestNs(repeats, ops_num, [&]() {
+                pro_game_containers::free_allocator allocator(arena_size);
+                for (const Op& op : ops) {
+                    if (op.allocate) {
+                        starts[op.slot] = allocator.allocate(op.size);
+                        sizes[op.slot] = op.size;
+                    }
+                    else {
+                        allocator.deallocate(starts[op.slot], sizes[op.slot]);
+                    }
+                }
+            });
+            res.tlsf_ns = BestNs(repeats, ops_num, [&]() {
+                tlsf_allocator allocator(arena_size);
+                for (const Op& op : ops) {
+                    if (op.allocate) {
+                        starts[op.slot] = allocator.allocate(op.size);
+                    }
+                    else {
+                        allocator.deallocate(starts[op.slot]);
+                    }
+                }
+                const tlsf_allocator::stats stats = allocator.get_stats();
+                res.tlsf_free_blocks = stats.free_blocks_num;
+                res.tlsf_fragmentation = stats.fragmentation();
+                res.tlsf_high_water = stats.high_water;
+            });
+            results.push_back(res);
+        }
+
+        return results;
+    }
+
+    std::vector<std::string> Check(uint32_t ops_num) {
+        std::vector<std::string> failures;
+        auto check = [&failures](bool passed, const char* name) {
+            if (!passed) {
+                failures.push_back(name);
+            }
+        };
+
+        // baseline: the deallocate branches for a free neighbour on one side only
+        {
+            pro_game_containers::free_allocator allocator(256);
+            const uint64_t a = allocator.allocate(64);
+            const uint64_t b = allocator.allocate(64);
+            const uint64_t c = allocator.allocate(64);
+            allocator.deallocate(a, 64);
+            allocator.deallocate(b, 64);    // free before
+            allocator.deallocate(c, 64);    // free both sides
+            check(allocator.allocate(256) == allocator.begin(), "free_allocator coalescing");
+        }
+
+        constexpr uint64_t page_size = 1024 * 1024;
+        constexpr uint32_t max_pages = 4;
+        tlsf_allocator allocator(page_size, max_pages, 16);
+        check(allocator.pages_num() == 1 && allocator.get_stats().free_blocks_num == 1, "one free page up front");
+
+        std::mt19937 rng(23);
+        std::map<uint64_t, uint64_t> live; // offset, rounded size
+        uint64_t used = 0;
+        uint64_t high_water = 0;
+        bool aligned = true;
+        bool disjoint = true;
+        bool in_page = true;
+        bool sizes = true;
+        uint32_t failed = 0;
+        for (uint32_t i = 0; i < ops_num; i++) {
+            // fill up past a page now and then, then drain
+            const bool fill = (i / 4096) % 2 == 0;
+            if (!live.empty() && (rng() % 4 == 0 || (!fill && rng() % 4 != 0))) {
+                auto it = live.lower_bound(rng() % allocator.capacity());
+                it = (it == live.end()) ? live.begin() : it;
+                allocator.deallocate(it->first);
+                used -= it->second;
+                live.erase(it);
+                continue;
+            }
+
+            const uint64_t size = (rng() % 16) ? (rng() % 4096) + 1 : (rng() % (page_size / 4)) + 1;
+            const uint64_t alignment = (rng() % 4) ? 0 : 1ull << (rng() % 13);
+            const uint64_t offset = allocator.allocate(size, alignment);
+            if (offset == tlsf_allocator::invalid_offset) {
+                failed++;
+                continue;
+            }
+
+            const uint64_t rounded = allocator.size_of(offset);
+            aligned &= offset % 16 == 0 && (!alignment || offset % alignment == 0);
+            sizes &= rounded >= size && rounded - size < 16;
+            in_page &= offset / page_size == (offset + rounded - 1) / page_size && offset + rounded <= allocator.capacity();
+            const auto next = live.lower_bound(offset);
+            disjoint &= next == live.end() || offset + rounded <= next->first;
+            disjoint &= next == live.begin() || std::prev(next)->first + std::prev(next)->second <= offset;
+            live.emplace(offset, rounded);
+            used += rounded;
+            high_water = std::max(high_water, used);
+        }
+        check(aligned, "alignment");
+        check(sizes, "sizes rounded to the granularity");
+        check(disjoint, "allocations never overlap");
+        check(in_page, "allocations stay inside a page");
+
+        tlsf_allocator::stats stats = allocator.get_stats();
+        check(stats.used_bytes == used && stats.allocations_num == live.size(), "used bytes");
+        check(stats.high_water == high_water, "high water");
+        check(stats.failed_num == failed, "failed count");
+        check(stats.pages_num > 1 && stats.pages_num <= max_pages && stats.capacity == stats.pages_num * page_size, "growth by pages");
+
+        // nothing bigger than a page, and no pages past max_pages
+        check(allocator.allocate(page_size + 1) == tlsf_allocator::invalid_offset, "larger than a page fails");
+        while (allocator.allocate(page_size / 2) != tlsf_allocator::invalid_offset) {
+        }
+        check(allocator.pages_num() == max_pages, "grows up to max pages");
+        check(allocator.size_of(8) == 0, "size_of an offset not allocated");
+
+        // a fresh one: everything freed in random order folds back to one block per page
+        tlsf_allocator fresh(page_size, max_pages, 16);
+        std::vector<uint64_t> offsets;
+        for (uint32_t i = 0; i < 2000; i++) {
+            const uint64_t offset = fresh.allocate((rng() % 2048) + 1, 1ull << (rng() % 9));
+            if (offset != tlsf_allocator::invalid_offset) {
+                offsets.push_back(offset);
+            }
+        }
+        stats = fresh.get_stats();
+        check(stats.free_blocks_num > 0 && stats.fragmentation() >= 0.0f && stats.fragmentation() < 1.0f, "fragmentation in range");
+        std::shuffle(offsets.begin(), offsets.end(), rng);
+        for (uint64_t offset : offsets) {
+            fresh.deallocate(offset);
+        }
+        stats = fresh.get_stats();
+        check(stats.used_bytes == 0 && stats.allocations_num == 0, "empty after freeing everything");
+        check(stats.free_blocks_num == stats.pages_num && stats.largest_free == page_size && stats.fragmentation() == 0.0f, "full coalescing");
+        check(fresh.allocate(page_size) != tlsf_allocator::invalid_offset, "whole page after coalescing");
+
+        // ring: frames of constant buffer sized allocations, retired two frames later like the model constants
+        {
+            constexpr uint64_t ring_size = 64 * 1024;
+            constexpr uint32_t frames_in_flight = 2;
+            ring_allocator ring(ring_size);
+            struct Range { uint64_t offset; uint64_t size; uint32_t frame; };
+            std::vector<Range> in_flight;
+            bool ring_aligned = true;
+            bool ring_disjoint = true;
+            bool ring_bounds = true;
+            bool ring_used = true;
+            uint32_t ring_failed = 0;
+            for (uint32_t frame = 0; frame < 1000; frame++) {
+                if (frame >= frames_in_flight) {
+                    ring.retire(frame - frames_in_flight);
+                    in_flight.erase(std::remove_if(in_flight.begin(), in_flight.end(), [frame](const Range& range) {
+                        return frame - range.frame >= frames_in_flight;
+                    }), in_flight.end());
+                }
+
+                // now and then a frame too big to fit next to the ones in flight
+                const uint32_t allocs_num = (frame % 50 == 49) ? 200 : rng() % 80;
+                for (uint32_t i = 0; i < allocs_num; i++) {
+                    const uint64_t size = (rng() % 2) ? 256 : (rng() % 600) + 1;
+                    const uint64_t offset = ring.allocate(size, 256);
+                    if (offset == ring_allocator::invalid_offset) {
+                        ring_failed++;
+                        continue;
+                    }
+
+                    ring_aligned &= offset % 256 == 0;
+                    ring_bounds &= offset + size <= ring_size;
+                    for (const Range& range : in_flight) {
+                        ring_disjoint &= offset + size <= range.offset || range.offset + range.size <= offset;
+                    }
+                    in_flight.push_back({ offset, size, frame });
+                }
+                ring.finish_frame(frame);
+
+                uint64_t live = 0;
+                for (const Range& range : in_flight) {
+                    live += range.size;
+                }
+                const ring_allocator::stats ring_stats = ring.get_stats();
+                ring_used &= ring_stats.used_bytes >= live && ring_stats.used_bytes <= ring_size && ring_stats.high_water <= ring_size;
+            }
+            check(ring_aligned, "ring alignment");
+            check(ring_bounds, "ring allocations stay inside the ring");
+            check(ring_disjoint, "ring never hands out bytes of a frame in flight");
+            check(ring_used, "ring used bytes");
+            check(ring_failed > 0 && ring.get_stats().failed_num == ring_failed, "ring fails when full");
+
+            ring.retire(~0ull);
+            const ring_allocator::stats ring_stats = ring.get_stats();
+            check(ring_stats.used_bytes == 0 && ring_stats.frames_in_flight == 0, "ring empty after retiring everything");
+            check(ring.allocate(ring_size) == 0, "whole ring once empty");
+        }
+
+        // heaps: placement like the dx12 backend does it, small textures at 4 KB, the rest at 64 KB, then a
+        // defragmentation pass that empties the last heap
+        {
+            constexpr uint64_t heap_size = 4 * 1024 * 1024;
+            constexpr uint32_t max_heaps = 4;
+            gpu_heap_allocator heaps(heap_size, max_heaps, 2);
+            check(heaps.heaps_num(0) == 0 && heaps.heaps_num(1) == 0, "heaps created with the first allocation");
+
+            struct Placed { gpu_heap_allocator::allocation alloc; uint64_t alignment; };
+            std::vector<Placed> placed;
+            bool heap_aligned = true;
+            bool heap_bounds = true;
+            bool heap_disjoint = true;
+            for (uint32_t i = 0; i < 400; i++) {
+                const uint32_t pool = rng() % 2;
+                const uint64_t alignment = (rng() % 2) ? gpu_heap_allocator::small_alignment : gpu_heap_allocator::default_alignment;
+                const uint64_t size = (rng() % 4) ? (rng() % (64 * 1024)) + 1 : (rng() % (heap_size / 8)) + 1;
+                const gpu_heap_allocator::allocation alloc = heaps.allocate(pool, size, alignment, i);
+                if (!alloc.valid()) {
+                    continue;
+                }
+
+                heap_aligned &= alloc.offset % alignment == 0 && alloc.size % gpu_heap_allocator::small_alignment == 0;
+                heap_bounds &= alloc.size >= size && alloc.offset + alloc.size <= heap_size && alloc.heap < heaps.heaps_num(pool);
+                for (const Placed& other : placed) {
+                    const gpu_heap_allocator::allocation& b = other.alloc;
+                    heap_disjoint &= b.pool != pool || b.heap != alloc.heap || alloc.offset + alloc.size <= b.offset || b.offset + b.size <= alloc.offset;
+                }
+                placed.push_back({ alloc, alignment });
+            }
+            check(heap_aligned, "heap placement alignment");
+            check(heap_bounds, "heap placements stay inside their heap");
+            check(heap_disjoint, "heap placements never overlap");
+            check(heaps.heaps_num(0) > 1 && heaps.heaps_num(0) <= max_heaps, "heaps added when full");
+            check(!heaps.allocate(0, heap_size + 1).valid() && heaps.get_stats(0).failed_num > 0, "larger than a heap fails");
+
+            // free most of it in random order, what is left in the last heaps moves down
+            std::shuffle(placed.begin(), placed.end(), rng);
+            const size_t kept = placed.size() / 8;
+            for (size_t i = kept; i < placed.size(); i++) {
+                heaps.deallocate(placed[i].alloc);
+            }
+            placed.resize(kept);
+
+            bool moves_down = true;
+            bool moves_aligned = true;
+            uint32_t moves_num = 0;
+            for (uint32_t pool = 0; pool < 2; pool++) {
+                const std::vector<gpu_heap_allocator::move> moves = heaps.plan_defragment(pool, ~0u);
+                check(heaps.get_stats(pool).moves_num == moves.size(), "planned moves counted");
+                for (const gpu_heap_allocator::move& m : moves) {
+                    const auto it = std::find_if(placed.begin(), placed.end(), [&m](const Placed& p) {
+                        return p.alloc.pool == m.from.pool && p.alloc.heap == m.from.heap && p.alloc.offset == m.from.offset;
+                    });
+                    moves_down &= it != placed.end() && m.to.heap < m.from.heap && m.to.size == m.from.size;
+                    if (it == placed.end()) {
+                        continue;
+                    }
+                    moves_aligned &= m.to.offset % it->alignment == 0;
+                    // the first move goes back, the others are done
+                    if (moves_num++ == 0) {
+                        heaps.cancel_move(m);
+                        continue;
+                    }
+                    heaps.complete_move(m);
+                    it->alloc = m.to;
+                }
+                check(heaps.get_stats(pool).moves_num == 0, "moves completed or cancelled");
+            }
+            check(moves_num > 1, "defragmentation finds moves");
+            check(moves_down, "moves go to a lower heap");
+            check(moves_aligned, "moves keep the alignment");
+
+            uint32_t empty_heaps = 0;
+            uint32_t allocations = 0;
+            for (uint32_t pool = 0; pool < 2; pool++) {
+                const gpu_heap_allocator::stats heap_stats = heaps.get_stats(pool);
+                empty_heaps += heap_stats.empty_heaps_num;
+                allocations += heap_stats.allocations_num;
+            }
+            check(empty_heaps > 0, "defragmentation empties heaps");
+            check(allocations == placed.size(), "heap allocations counted");
+
+            for (const Placed& p : placed) {
+                heaps.deallocate(p.alloc);
+            }
+            for (uint32_t pool = 0; pool < 2; pool++) {
+                const gpu_heap_allocator::stats heap_stats = heaps.get_stats(pool);
+                check(heap_stats.used_bytes == 0 && heap_stats.empty_heaps_num == heap_stats.heaps_num && heap_stats.largest_free == heap_size, "heaps empty after freeing everything");
+            }
+        }
+
+        return failures;
+    }
+}
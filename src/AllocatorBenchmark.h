@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// free_allocator against tlsf_allocator on vertex storage sized allocations
+namespace allocator_benchmark {
+    struct BenchmarkResult {
+        const char* pattern{ nullptr };
+        uint32_t ops_num{ 0 };
+        double first_fit_ns{ 0.0 };     // per allocate or deallocate
+        double tlsf_ns{ 0.0 };
+        uint32_t tlsf_free_blocks{ 0 };         // at the end
+        float tlsf_fragmentation{ 0.0f };
+        uint64_t tlsf_high_water{ 0 };
+    };
+
+    // 32 MB arenas, ops_num random allocations and deallocations of 16 byte to 16 KB, best of repeats
+    std::vector<BenchmarkResult> Benchmark(uint32_t ops_num, uint32_t repeats);
+
+    // tlsf_allocator against a reference map of live ranges: alignment, overlap, page bounds, growth, failure past
+    // the last page, stats and full coalescing once everything is freed; ring_allocator against the ranges of the
+    // frames in flight; gpu_heap_allocator placement and defragmentation; names of the checks that failed
+    std::vector<std::string> Check(uint32_t ops_num);
+}
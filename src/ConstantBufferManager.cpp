@@ -6,6 +6,10 @@
 #include "IHeapBuffer.h"
 #include "Frontend.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
 extern Frontend* gFrontend;
 
 
@@ -21,6 +25,8 @@ void ConstantBufferManager::OnInit() {
 			buff->Map();
 		}
 	}
+
+	CreateModelRing(model_ring_size);
 }
 
 void ConstantBufferManager::Destroy() {
@@ -28,15 +34,76 @@ void ConstantBufferManager::Destroy() {
     if (std::shared_ptr<IHeapBuffer> buff = m_scene_cbs[id]->GetBuffer().lock()) {
         buff->Unmap();
     }
+    if (std::shared_ptr<IHeapBuffer> buff = m_model_ring_res->GetBuffer().lock()) {
+        buff->Unmap();
+    }
+    for (const std::pair<std::unique_ptr<IGpuResource>, uint64_t> &retired : m_retired_rings) {
+        if (std::shared_ptr<IHeapBuffer> buff = retired.first->GetBuffer().lock()) {
+            buff->Unmap();
+        }
+    }
+    m_retired_rings.clear();
+}
+
+// after SyncWithCPU
+void ConstantBufferManager::BeginFrame(uint64_t completed_fence) {
+    auto it = std::remove_if(m_retired_rings.begin(), m_retired_rings.end(), [completed_fence](const std::pair<std::unique_ptr<IGpuResource>, uint64_t> &retired) {
+        if (!retired.second || retired.second > completed_fence) {
+            return false;
+        }
+        if (std::shared_ptr<IHeapBuffer> buff = retired.first->GetBuffer().lock()) {
+            buff->Unmap();
+        }
+        return true;
+    });
+    m_retired_rings.erase(it, m_retired_rings.end());
+
+    m_model_ring->retire(completed_fence);
+}
+
+// after Present
+void ConstantBufferManager::EndFrame(uint64_t fence) {
+    m_model_ring->finish_frame(fence);
+    for (std::pair<std::unique_ptr<IGpuResource>, uint64_t> &retired : m_retired_rings) {
+        if (!retired.second) {
+            retired.second = fence;
+        }
+    }
+}
+
+void ConstantBufferManager::CreateModelRing(uint32_t size) {
+    m_model_ring_res.reset(CreateGpuResource());
+    m_model_ring_res->CreateBuffer(HeapType::ht_upload, size, ResourceState::rs_resource_state_generic_read, L"models_cb_ring");
+    if (std::shared_ptr<IHeapBuffer> buff = m_model_ring_res->GetBuffer().lock()) {
+        m_model_ring_data = buff->Map();
+    }
+    m_model_ring = std::make_unique<pro_game_containers::ring_allocator>(size);
+}
+
+// every draw gets its own copy, frames in flight keep reading theirs
+uint64_t ConstantBufferManager::AllocateModelCB() {
+    const uint32_t cb_size = calc_cb_size(sizeof(ModelCB));
+    uint64_t offset = m_model_ring->allocate(cb_size, cb_size);
+    if (offset == pro_game_containers::ring_allocator::invalid_offset) {
+        // the old ring stays alive until its frames are done, the new one starts empty
+        m_retired_rings.emplace_back(std::move(m_model_ring_res), 0);
+        CreateModelRing(uint32_t(m_model_ring->capacity() * 2));
+        offset = m_model_ring->allocate(cb_size, cb_size);
+    }
+    assert(offset != pro_game_containers::ring_allocator::invalid_offset);
+    memcpy(m_model_ring_data + offset, &m_model_data, sizeof(ModelCB));
+
+    return offset;
+}
+
+pro_game_containers::ring_allocator::stats ConstantBufferManager::GetModelRingStats() const {
+    return m_model_ring->get_stats();
 }
 
 void ConstantBufferManager::SetMatrix4Constant(Constants id, const DirectX::XMMATRIX & matrix){
     const uint32_t frame_id = gFrontend->FrameId();
     if (id == Constants::cM){
-        if (std::shared_ptr<IHeapBuffer> buff = m_model_cb->GetBuffer().lock()){
-            ModelCB* model_cb = (ModelCB*) buff->GetCpuData();
-            DirectX::XMStoreFloat4x4(&model_cb->M, matrix);
-        }
+        DirectX::XMStoreFloat4x4(&m_model_data.M, matrix);
     }
     else if (id == Constants::cV){
         if (std::shared_ptr<IHeapBuffer> buff = m_scene_cbs[frame_id]->GetBuffer().lock()) {
@@ -73,10 +140,7 @@ void ConstantBufferManager::SetMatrix4Constant(Constants id, const DirectX::XMMA
 void ConstantBufferManager::SetMatrix4Constant(Constants id, const DirectX::XMFLOAT4X4 & matrix){
     const uint32_t frame_id = gFrontend->FrameId();
     if (id == Constants::cM){
-        if (std::shared_ptr<IHeapBuffer> buff = m_model_cb->GetBuffer().lock()){
-            ModelCB* model_cb = (ModelCB*) buff->GetCpuData();
-            model_cb->M = matrix;
-        }
+        m_model_data.M = matrix;
     }
     else if (id == Constants::cV){
         if (std::shared_ptr<IHeapBuffer> buff = m_scene_cbs[frame_id]->GetBuffer().lock()){
@@ -142,6 +206,12 @@ void ConstantBufferManager::SetVector4Constant(Constants id, const DirectX::XMVE
 			DirectX::XMStoreFloat4(&scene_cb->Time, vec);
 		}
 	}
+	else if (id == Constants::cVertexPosCenter) {
+		DirectX::XMStoreFloat4(&m_model_data.vertex_pos_center, vec);
+	}
+	else if (id == Constants::cVertexPosExtent) {
+		DirectX::XMStoreFloat4(&m_model_data.vertex_pos_extent, vec);
+	}
 }
 
 void ConstantBufferManager::SetVector4Constant(Constants id, const DirectX::XMFLOAT4 & vec){
@@ -176,39 +246,37 @@ void ConstantBufferManager::SetVector4Constant(Constants id, const DirectX::XMFL
 			scene_cb->Time = vec;
 		}
 	}
+	else if (id == Constants::cVertexPosCenter) {
+		m_model_data.vertex_pos_center = vec;
+	}
+	else if (id == Constants::cVertexPosExtent) {
+		m_model_data.vertex_pos_extent = vec;
+	}
 }
 
 void ConstantBufferManager::SetUint32(Constants id, uint32_t val)
 {
     if (id == Constants::cMat) {
-		if (std::shared_ptr<IHeapBuffer> buff = m_model_cb->GetBuffer().lock()) {
-			ModelCB* model_cb = (ModelCB*)buff->GetCpuData();
-			model_cb->material_id = val;
-		}
+		m_model_data.material_id = val;
     }
     else if (id == Constants::cVertexBufferOffset) {
-        if (std::shared_ptr<IHeapBuffer> buff = m_model_cb->GetBuffer().lock()) {
-            ModelCB* model_cb = (ModelCB*)buff->GetCpuData();
-            model_cb->vertex_buffer_offset = val;
-        }
+        m_model_data.vertex_buffer_offset = val;
     }
     else if (id == Constants::cVertexType) {
-        if (std::shared_ptr<IHeapBuffer> buff = m_model_cb->GetBuffer().lock()) {
-            ModelCB* model_cb = (ModelCB*)buff->GetCpuData();
-            model_cb->vertex_type = val;
-        }
+        m_model_data.vertex_type = val;
     }
 }
 
 void ConstantBufferManager::CommitCB(ICommandList* command_list, ConstantBuffers id, bool gfx)
 {
     if (id == cb_model) {
-        if (std::shared_ptr<IHeapBuffer> buff = m_model_cb->GetBuffer().lock()) {
+        const uint64_t offset = AllocateModelCB();
+        if (std::shared_ptr<IHeapBuffer> buff = m_model_ring_res->GetBuffer().lock()) {
             if (gfx) {
-                command_list->SetGraphicsRootConstantBufferView(bi_model_cb, buff);
+                command_list->SetGraphicsRootConstantBufferView(bi_model_cb, buff, offset);
             }
             else {
-                command_list->SetComputeRootConstantBufferView(bi_model_cb, buff);
+                command_list->SetComputeRootConstantBufferView(bi_model_cb, buff, offset);
             }
         }
     }
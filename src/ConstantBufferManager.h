@@ -1,9 +1,11 @@
 #pragma once
 
 #include <array>
+#include <vector>
 #include <DirectXMath.h>
 #include "LevelLight.h"
 #include "IGpuResource.h"
+#include "ring_allocator.h"
 
 class ICommandList;
 
@@ -22,6 +24,8 @@ enum class Constants {
     cVertexType,            // vertex type for render model
     cSunV,                  // sun V mx
     cSunP,                  // sun P mx
+    cVertexPosCenter,       // packed vertex types: position = center + snorm * extent
+    cVertexPosExtent,
 };
 
 
@@ -37,8 +41,11 @@ public:
     void SetVector4Constant(Constants id, const DirectX::XMVECTOR & vec);
     void SetVector4Constant(Constants id, const DirectX::XMFLOAT4 & vec);
     void SetUint32(Constants id, uint32_t val);
-    void SetModelCB(IGpuResource* res) { m_model_cb = res; }
     void CommitCB(ICommandList* command_list, ConstantBuffers id, bool gfx = true);
+    // gfx fences: the last one known complete, and the one the frame just presented signals
+    void BeginFrame(uint64_t completed_fence);
+    void EndFrame(uint64_t fence);
+    pro_game_containers::ring_allocator::stats GetModelRingStats() const;
 
     static void SyncCpuDataToCB(ICommandList* command_list, IGpuResource* res, void* cpu_data, uint32_t size, BindingId bind_point, bool gfx = true);
 
@@ -50,6 +57,8 @@ public:
         uint32_t vertex_buffer_offset;
         uint32_t vertex_type;
         float padding;
+        DirectX::XMFLOAT4 vertex_pos_center;
+        DirectX::XMFLOAT4 vertex_pos_extent;
     };
 
     // 2 x 256
@@ -67,6 +76,17 @@ public:
         DirectX::XMFLOAT4X4 SunP;
     };
 
-    IGpuResource* m_model_cb;
+private:
+    void CreateModelRing(uint32_t size);
+    uint64_t AllocateModelCB();
+
+    // 16k draws before the ring has to grow
+    static constexpr uint32_t model_ring_size = 256 * 16384;
+
+    ModelCB m_model_data{};
+    std::unique_ptr<IGpuResource> m_model_ring_res;
+    std::unique_ptr<pro_game_containers::ring_allocator> m_model_ring;
+    uint8_t* m_model_ring_data{ nullptr };
+    std::vector<std::pair<std::unique_ptr<IGpuResource>, uint64_t>> m_retired_rings; // ring, fence of its last frame, 0 until presented
     std::array<std::unique_ptr<IGpuResource>, 2> m_scene_cbs;
 };
\ No newline at end of file
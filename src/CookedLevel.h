@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+// Binary layout of cooked levels (content/cooked/levels/<level>.cooked), little-endian.
+// header | definition names | placements | lights | strings, each array starts on an alignment boundary.
+// Placements and lights are stored exactly as level_file keeps them in memory, they load with one memcpy each.
+namespace cooked_level {
+    static constexpr uint32_t magic = 0x4c564c43; // "CLVL"
+    static constexpr uint32_t version = 2;
+    static constexpr uint32_t alignment = 16;
+
+    struct String {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t file_size;
+        uint64_t source_size;
+        int64_t source_time;
+        uint32_t definitions_num;
+        uint32_t placements_num;
+        uint32_t lights_num;
+        uint32_t padding;
+        uint64_t definitions_offset;
+        uint64_t placements_offset;
+        uint64_t lights_offset;
+        uint64_t strings_offset;
+        uint64_t strings_size;
+        float camera_pos[3];
+        float camera_dir[3];
+        float camera_fov;
+        float camera_near;
+        float camera_far;
+        String skybox;
+        String terrain_height_map;
+        float terrain_pos[3];
+        uint32_t terrain_dim;
+        uint32_t terrain_tech_id;
+        float water_pos[3];
+        uint32_t water_dim;
+        uint32_t water_tech_id;
+        float stream_cell_size;
+        float stream_load_radius;
+        float stream_unload_radius;
+        uint32_t stream_budget_mb;
+    };
+
+    inline uint64_t align(uint64_t val) {
+        return (val + alignment - 1) & ~uint64_t(alignment - 1);
+    }
+}
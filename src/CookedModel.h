@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+
+// Binary layout of cooked models (content/cooked/<model>.cooked), little-endian.
+// header | nodes | meshes | textures | strings | streams, every stream starts on a stream_alignment boundary.
+// Embedded textures are stored as imported (compressed file or raw texels) in the streams area.
+// Nodes are stored in pre-order, node 0 is the model root.
+namespace cooked_model {
+    static constexpr uint32_t magic = 0x4c444d43; // "CMDL"
+    static constexpr uint32_t version = 5;
+    static constexpr uint32_t stream_alignment = 16;
+    static constexpr uint32_t no_index = uint32_t(-1);
+    static constexpr uint32_t texture_slots = 4;
+    static constexpr uint32_t max_lods = 4;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t file_size;
+        uint64_t source_size;
+        int64_t source_time;
+        uint32_t nodes_num;
+        uint32_t meshes_num;
+        uint64_t nodes_offset;
+        uint64_t meshes_offset;
+        uint64_t strings_offset;
+        uint64_t strings_size;
+        uint32_t lod_levels; // import settings the lods were built with
+        float lod_target_error;
+        uint32_t textures_num;
+        uint32_t padding;
+        uint64_t textures_offset;
+    };
+
+    struct String {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    struct Node {
+        String name;
+        uint32_t parent;
+        uint32_t mesh;
+        float position[3];
+        float rotation[3];
+        float scale[3];
+        String textures[texture_slots];
+    };
+
+    enum MeshFlags {
+        mf_tex_coords = 1 << 0,
+        mf_normals = 1 << 1,
+        mf_tangents = 1 << 2,
+        mf_optimized = 1 << 3,
+        mf_index32 = 1 << 4, // uint32_t indices, uint16_t otherwise
+        mf_split = 1 << 5
+    };
+
+    // index range of a level of detail, every level is stored in the mesh index stream
+    struct Lod {
+        uint32_t index_offset;
+        uint32_t indices_num;
+        float error;
+    };
+
+    struct Mesh {
+        String name;
+        uint32_t vertices_num;
+        uint32_t indices_num;
+        uint32_t flags;
+        uint32_t lods_num;
+        uint64_t content_hash;
+        uint64_t vertices_offset;
+        uint64_t indices_offset;
+        uint64_t tex_coords_offset;
+        uint64_t normals_offset;
+        uint64_t tangents_offset;
+        uint64_t bitangents_offset;
+        float bounding_sphere[4];
+        Lod lods[max_lods];
+    };
+
+    // nodes refer to it by name
+    struct Texture {
+        String name;
+        String format_hint;
+        uint32_t width; // 0: data is a compressed file
+        uint32_t height;
+        uint64_t content_hash;
+        uint64_t data_offset;
+        uint64_t data_size;
+    };
+
+    inline uint64_t align(uint64_t val) {
+        return (val + stream_alignment - 1) & ~uint64_t(stream_alignment - 1);
+    }
+}
@@ -1,9 +1,15 @@
 #include "FileManager.h"
 
 #include <vector>
+#include <algorithm>
+#include <atomic>
 #include <assert.h>
 #include <DirectXMath.h>
 #include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <iterator>
+#include <fstream>
 
 #ifdef _DEBUG
 #include <sstream>
@@ -12,10 +18,18 @@
 #include <assimp/Importer.hpp>      // C++ importer interface
 #include <assimp/scene.h>           // Output data structure
 #include <assimp/postprocess.h>     // Post processing flags
+#include <assimp/IOSystem.hpp>
+#include <assimp/IOStream.hpp>
 #include "RenderModel.h"
 #include "RenderQuad.h"
 #include "Frontend.h"
 #include "GeomUtils.h"
+#include "VirtualFileSystem.h"
+#include "StartupProfiler.h"
+#include "CookedModel.h"
+#include "ThreadPool.h"
+#include "IGpuResource.h"
+#include "Logger.h"
 
 extern Frontend* gFrontend;
 
@@ -29,56 +43,367 @@ static const aiMatrix4x4 identity_mx(
 #define ThrowIfFailed(exp) exp // TODO: hack
 
 static constexpr uint32_t NO_MESH_IDX = (uint32_t)(-1);
+static constexpr uint32_t max_16bit_vertices = 1 << 16;
 
-bool FileManager::AllocMesh(const std::wstring &name, RenderMesh* &mesh){
-	const auto it = std::find_if(m_load_meshes.begin(), m_load_meshes.end(), [&name](RenderMesh &mesh){ return (mesh.GetName() == name); });
-	if (it != m_load_meshes.end()){
-		mesh = &(*it);
+static constexpr uint32_t import_flags =
+	aiProcess_CalcTangentSpace |
+	aiProcess_Triangulate |
+	aiProcess_SortByPType |
+	aiProcess_ConvertToLeftHanded;
 
+static int64_t GetSourceTime(const std::filesystem::path &path) {
+	return (int64_t)std::filesystem::last_write_time(path).time_since_epoch().count();
+}
+
+// Assimp reads models and the files next to them (.mtl, .bin, ...) through the VFS
+class VfsIOStream : public Assimp::IOStream {
+public:
+	explicit VfsIOStream(std::shared_ptr<VfsFile> file) : m_file(std::move(file)) {}
+
+	size_t Read(void* buffer, size_t size, size_t count) override {
+		if (!size) {
+			return 0;
+		}
+		count = std::min<size_t>(count, (size_t)(m_file->GetSize() - m_pos) / size);
+		memcpy(buffer, m_file->GetData() + m_pos, size * count);
+		m_pos += size * count;
+		return count;
+	}
+	size_t Write(const void* buffer, size_t size, size_t count) override { return 0; }
+	aiReturn Seek(size_t offset, aiOrigin origin) override {
+		const uint64_t base = (origin == aiOrigin_SET) ? 0 : (origin == aiOrigin_CUR) ? m_pos : m_file->GetSize();
+		if (base + offset > m_file->GetSize()) {
+			return aiReturn_FAILURE;
+		}
+		m_pos = base + offset;
+		return aiReturn_SUCCESS;
+	}
+	size_t Tell() const override { return (size_t)m_pos; }
+	size_t FileSize() const override { return (size_t)m_file->GetSize(); }
+	void Flush() override {}
+
+private:
+	std::shared_ptr<VfsFile> m_file;
+	uint64_t m_pos{ 0 };
+};
+
+class VfsIOSystem : public Assimp::IOSystem {
+public:
+	bool Exists(const char* file) const override { return VirtualFileSystem::Get().Exists(std::filesystem::u8path(file)); }
+	char getOsSeparator() const override { return '/'; }
+	Assimp::IOStream* Open(const char* file, const char* mode) override {
+		if (strchr(mode, 'w') || strchr(mode, 'a')) {
+			return nullptr;
+		}
+		std::shared_ptr<VfsFile> vfs_file = VirtualFileSystem::Get().Open(std::filesystem::u8path(file));
+		return vfs_file ? new VfsIOStream(std::move(vfs_file)) : nullptr;
+	}
+	void Close(Assimp::IOStream* file) override { delete file; }
+};
+
+static bool IsRangeValid(uint64_t offset, uint64_t size, uint64_t file_size) {
+	return offset <= file_size && size <= file_size - offset;
+}
+
+static uint32_t GetCookedIndexSize(const cooked_model::Mesh &mesh) {
+	return (mesh.flags & cooked_model::mf_index32) ? sizeof(uint32_t) : sizeof(uint16_t);
+}
+
+// checks everything the loader is going to touch, nothing gets allocated for a stale or broken file
+static const cooked_model::Header* ValidateCookedModel(const VfsFile &mapping, const std::filesystem::path &source_path) {
+	using namespace cooked_model;
+	const uint64_t file_size = mapping.GetSize();
+	if (file_size < sizeof(Header)) {
+		return nullptr;
+	}
+
+	const Header* header = (const Header*)mapping.GetData();
+	if (header->magic != magic || header->version != version || header->file_size != file_size) {
+		return nullptr;
+	}
+
+	uint64_t source_size = 0;
+	int64_t source_time = 0;
+	if (!VirtualFileSystem::Get().Stat(source_path, source_size, source_time) || header->source_size != source_size || header->source_time != source_time) {
+		return nullptr;
+	}
+
+	if (header->nodes_num == 0 ||
+		!IsRangeValid(header->nodes_offset, (uint64_t)header->nodes_num * sizeof(Node), file_size) ||
+		!IsRangeValid(header->meshes_offset, (uint64_t)header->meshes_num * sizeof(Mesh), file_size) ||
+		!IsRangeValid(header->textures_offset, (uint64_t)header->textures_num * sizeof(Texture), file_size) ||
+		!IsRangeValid(header->strings_offset, header->strings_size, file_size)) {
+		return nullptr;
+	}
+
+	auto is_string_valid = [header](const String &str) { return IsRangeValid(str.offset, str.size, header->strings_size); };
+
+	const Node* nodes = (const Node*)(mapping.GetData() + header->nodes_offset);
+	for (uint32_t i = 0; i < header->nodes_num; i++) {
+		const Node &node = nodes[i];
+		if ((i == 0) != (node.parent == no_index) || (i && node.parent >= i)) {
+			return nullptr;
+		}
+		if ((node.mesh != no_index && node.mesh >= header->meshes_num) || !is_string_valid(node.name)) {
+			return nullptr;
+		}
+		for (const String &tex : node.textures) {
+			if (!is_string_valid(tex)) {
+				return nullptr;
+			}
+		}
+	}
+
+	const Mesh* meshes = (const Mesh*)(mapping.GetData() + header->meshes_offset);
+	for (uint32_t i = 0; i < header->meshes_num; i++) {
+		const Mesh &mesh = meshes[i];
+		const uint64_t vec3_size = (uint64_t)mesh.vertices_num * sizeof(DirectX::XMFLOAT3);
+		const uint64_t vec2_size = (uint64_t)mesh.vertices_num * sizeof(DirectX::XMFLOAT2);
+		if (!is_string_valid(mesh.name) ||
+			!IsRangeValid(mesh.vertices_offset, vec3_size, file_size) ||
+			!IsRangeValid(mesh.indices_offset, (uint64_t)mesh.indices_num * GetCookedIndexSize(mesh), file_size) ||
+			((mesh.flags & mf_tex_coords) && !IsRangeValid(mesh.tex_coords_offset, vec2_size, file_size)) ||
+			((mesh.flags & mf_normals) && !IsRangeValid(mesh.normals_offset, vec3_size, file_size)) ||
+			((mesh.flags & mf_tangents) && (!IsRangeValid(mesh.tangents_offset, vec3_size, file_size) || !IsRangeValid(mesh.bitangents_offset, vec3_size, file_size))) ||
+			mesh.lods_num > max_lods) {
+			return nullptr;
+		}
+		for (uint32_t lod = 0; lod < mesh.lods_num; lod++) {
+			if (!IsRangeValid(mesh.lods[lod].index_offset, mesh.lods[lod].indices_num, mesh.indices_num)) {
+				return nullptr;
+			}
+		}
+	}
+
+	const Texture* textures = (const Texture*)(mapping.GetData() + header->textures_offset);
+	for (uint32_t i = 0; i < header->textures_num; i++) {
+		const Texture &texture = textures[i];
+		if (!is_string_valid(texture.name) || !is_string_valid(texture.format_hint) || !texture.content_hash ||
+			!IsRangeValid(texture.data_offset, texture.data_size, file_size) ||
+			(texture.width && texture.data_size != (uint64_t)texture.width * texture.height * 4)) {
+			return nullptr;
+		}
+	}
+
+	return header;
+}
+
+// word at a time multiply-xorshift, good enough to key geometry, equality is still checked on a hit
+static uint64_t HashBytes(const void* data, uint64_t size, uint64_t hash) {
+	static constexpr uint64_t prime = 0x9e3779b97f4a7c15ull;
+	const uint8_t* bytes = (const uint8_t*)data;
+	uint64_t i = 0;
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, bytes + i, sizeof(word));
+		hash = (hash ^ (word * prime)) * prime;
+		hash ^= hash >> 29;
+	}
+	for (; i < size; i++) {
+		hash = (hash ^ bytes[i]) * prime;
+	}
+
+	return hash ^ (hash >> 32);
+}
+
+static uint64_t HashStreams(const RenderMesh::Streams &streams) {
+	const uint64_t vec3_size = (uint64_t)streams.vertices_num * sizeof(DirectX::XMFLOAT3);
+	uint64_t hash = HashBytes(&streams.vertices_num, sizeof(streams.vertices_num), 0);
+	hash = HashBytes(&streams.indices_num, sizeof(streams.indices_num), hash);
+	hash = HashBytes(&streams.index_size, sizeof(streams.index_size), hash);
+	hash = HashBytes(streams.vertices, vec3_size, hash);
+	hash = HashBytes(streams.indices, (uint64_t)streams.indices_num * streams.index_size, hash);
+	if (streams.tex_coords) {
+		hash = HashBytes(streams.tex_coords, (uint64_t)streams.vertices_num * sizeof(DirectX::XMFLOAT2), hash);
+	}
+	if (streams.normals) {
+		hash = HashBytes(streams.normals, vec3_size, hash);
+	}
+	if (streams.tangents) {
+		hash = HashBytes(streams.tangents, vec3_size, hash);
+		hash = HashBytes(streams.bitangents, vec3_size, hash);
+	}
+
+	return hash;
+}
+
+static bool IsSameStream(const void* lhs, const void* rhs, uint64_t size) {
+	if (!lhs || !rhs) {
+		return lhs == rhs;
+	}
+
+	return lhs == rhs || memcmp(lhs, rhs, size) == 0;
+}
+
+static bool IsSameGeometry(const RenderMesh::Streams &lhs, const RenderMesh::Streams &rhs) {
+	if (lhs.vertices_num != rhs.vertices_num || lhs.indices_num != rhs.indices_num || lhs.index_size != rhs.index_size) {
 		return false;
 	}
-	else {
-		const uint32_t idx = m_load_meshes.push_back(); 
-		m_load_meshes[idx].SetId(idx); 
-		mesh = &(m_load_meshes[idx]);
-		mesh->SetName(name);
 
-		return true;
+	const uint64_t vec3_size = (uint64_t)lhs.vertices_num * sizeof(DirectX::XMFLOAT3);
+	return IsSameStream(lhs.vertices, rhs.vertices, vec3_size) &&
+		IsSameStream(lhs.indices, rhs.indices, (uint64_t)lhs.indices_num * lhs.index_size) &&
+		IsSameStream(lhs.tex_coords, rhs.tex_coords, (uint64_t)lhs.vertices_num * sizeof(DirectX::XMFLOAT2)) &&
+		IsSameStream(lhs.normals, rhs.normals, vec3_size) &&
+		IsSameStream(lhs.tangents, rhs.tangents, vec3_size) &&
+		IsSameStream(lhs.bitangents, rhs.bitangents, vec3_size);
+}
+
+// embedded images are keyed by content, one image referenced by several materials or models is one texture
+static std::wstring AddEmbeddedTexture(const aiTexture* texture, FileManager::ModelImport &import) {
+	// mHeight == 0: mWidth bytes of a compressed file, otherwise mWidth * mHeight texels
+	const uint64_t size = texture->mHeight ? (uint64_t)texture->mWidth * texture->mHeight * sizeof(aiTexel) : texture->mWidth;
+	uint64_t hash = HashBytes(&texture->mWidth, sizeof(texture->mWidth), 0);
+	hash = HashBytes(&texture->mHeight, sizeof(texture->mHeight), hash);
+	hash = HashBytes(texture->pcData, size, hash);
+	hash = hash ? hash : 1; // 0 marks file textures
+
+	for (const FileManager::ModelImport::Texture &imp_texture : import.textures) {
+		if (imp_texture.content_hash == hash) {
+			return imp_texture.name;
+		}
 	}
+
+	const std::string hint(texture->achFormatHint);
+	wchar_t hash_str[17];
+	swprintf(hash_str, 17, L"%016llx", (unsigned long long)hash);
+
+	import.textures.emplace_back();
+	FileManager::ModelImport::Texture &imp_texture = import.textures.back();
+	imp_texture.name = std::wstring(L"embedded_") + hash_str + L"." + std::wstring(hint.begin(), hint.end());
+	imp_texture.content_hash = hash;
+	imp_texture.data.assign((const uint8_t*)texture->pcData, (const uint8_t*)texture->pcData + size);
+	imp_texture.image.data = imp_texture.data.data();
+	imp_texture.image.size = size;
+	imp_texture.image.width = texture->mHeight ? texture->mWidth : 0;
+	imp_texture.image.height = texture->mHeight;
+	imp_texture.image.format_hint = hint;
+
+	return imp_texture.name;
+}
+
+static RenderMesh::Streams GetGeomStreams(const FileManager::Geom &geom) {
+	RenderMesh::Streams streams;
+	streams.vertices = geom.vertices.empty() ? nullptr : geom.vertices.data();
+	streams.indices = geom.indices.empty() ? nullptr : geom.indices.data();
+	streams.tex_coords = geom.tex_coords.empty() ? nullptr : geom.tex_coords.data();
+	streams.vertices_num = (uint32_t)geom.vertices.size();
+	streams.indices_num = (uint32_t)geom.indices.size();
+
+	return streams;
+}
+
+static RenderMesh::Streams GetCookedStreams(const uint8_t* data, const cooked_model::Mesh &mesh) {
+	using namespace cooked_model;
+	RenderMesh::Streams streams;
+	streams.vertices = (const DirectX::XMFLOAT3*)(data + mesh.vertices_offset);
+	streams.indices = data + mesh.indices_offset;
+	streams.index_size = GetCookedIndexSize(mesh);
+	streams.tex_coords = (mesh.flags & mf_tex_coords) ? (const DirectX::XMFLOAT2*)(data + mesh.tex_coords_offset) : nullptr;
+	streams.normals = (mesh.flags & mf_normals) ? (const DirectX::XMFLOAT3*)(data + mesh.normals_offset) : nullptr;
+	streams.tangents = (mesh.flags & mf_tangents) ? (const DirectX::XMFLOAT3*)(data + mesh.tangents_offset) : nullptr;
+	streams.bitangents = (mesh.flags & mf_tangents) ? (const DirectX::XMFLOAT3*)(data + mesh.bitangents_offset) : nullptr;
+	streams.vertices_num = mesh.vertices_num;
+	streams.indices_num = mesh.indices_num;
+
+	return streams;
+}
+
+bool FileManager::AllocMesh(const std::wstring &name, uint64_t content_hash, const RenderMesh::Streams &streams, RenderMesh* &mesh){
+	// identical geometry is shared whatever model or node it came from
+	const auto range = m_mesh_hashes.equal_range(content_hash);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (IsSameGeometry(m_load_meshes[it->second].GetStreams(), streams)) {
+			mesh = &m_load_meshes[it->second];
+			mesh->AddModelRef();
+			SetMeshName(name, it->second);
+
+			return false;
+		}
+	}
+
+	const pro_game_containers::pool_handle handle = m_load_meshes.insert();
+	mesh = &m_load_meshes[handle];
+	mesh->SetId(handle.index());
+	mesh->SetName(name);
+	mesh->SetContentHash(content_hash);
+	mesh->AddModelRef();
+	m_mesh_hashes.emplace(content_hash, handle);
+	SetMeshName(name, handle); // a reloaded model's new geometry takes over the name
+
+	return true;
+}
+
+void FileManager::SetMeshName(const std::wstring &name, pro_game_containers::pool_handle handle){
+	const auto res = m_mesh_names.emplace(name, handle);
+	if (!res.second) {
+		if (res.first->second == handle) {
+			return;
+		}
+		// the mesh the name pointed at before forgets it
+		std::vector<std::wstring> &old_names = m_mesh_name_lists[res.first->second.value];
+		old_names.erase(std::find(old_names.begin(), old_names.end(), name));
+		res.first->second = handle;
+	}
+	m_mesh_name_lists[handle.value].push_back(name);
+}
+
+void FileManager::ReleaseMesh(RenderMesh* mesh){
+	if (mesh->ReleaseModelRef()) {
+		return;
+	}
+
+	// a name may have moved on to a newer mesh, only the ones still pointing here are listed
+	const pro_game_containers::pool_handle handle = m_load_meshes.handle_of(mesh);
+	const auto range = m_mesh_hashes.equal_range(mesh->GetContentHash());
+	for (auto it = range.first; it != range.second; ++it) {
+		if (it->second == handle) {
+			m_mesh_hashes.erase(it);
+			break;
+		}
+	}
+	const auto names = m_mesh_name_lists.find(handle.value);
+	if (names != m_mesh_name_lists.end()) {
+		for (const std::wstring &name : names->second) {
+			m_mesh_names.erase(name);
+		}
+		m_mesh_name_lists.erase(names);
+	}
+	m_load_meshes.erase(handle);
+}
+
+RenderMesh* FileManager::FindMesh(const std::wstring &name){
+	const auto it = m_mesh_names.find(name);
+	return (it != m_mesh_names.end()) ? m_load_meshes.get(it->second) : nullptr;
 }
 
 RenderModel* FileManager::LoadModel(const std::wstring &name){
 	return LoadModelInternal(name);
 }
 
-void FileManager::SetupModelRoot(const aiScene* scene, RenderModel* curr_model){
+void FileManager::SetupModelRoot(const aiScene* scene, ModelImport &import){
 	aiNode* rootNode = scene->mRootNode;
 	aiMatrix4x4 model_xform(rootNode->mTransformation);
 	assert(rootNode->mNumMeshes < 2);
 	uint32_t mesh_idx = rootNode->mNumMeshes ? rootNode->mMeshes[0] : NO_MESH_IDX;
-	InitializeModel(scene, rootNode, mesh_idx, model_xform, curr_model);
+	InitializeModel(scene, rootNode, mesh_idx, model_xform, std::wstring(), NO_MESH_IDX, import);
 }
 
-void FileManager::TraverseMeshes(const aiScene* scene, aiNode* rootNode, const aiMatrix4x4 &parent_trans, RenderModel* parent_model)
+void FileManager::TraverseMeshes(const aiScene* scene, aiNode* rootNode, const aiMatrix4x4 &parent_trans, uint32_t parent_node, ModelImport &import)
 {
 	aiMatrix4x4 trans_for_children(identity_mx);
 	if (rootNode->mNumMeshes)
 	{
-		RenderModel* curr_model = nullptr;
+		uint32_t curr_node = NO_MESH_IDX;
 		for (uint32_t i = 0; i < rootNode->mNumMeshes; i++){
 			uint32_t meshesIdx = rootNode->mMeshes[i];
 
-			uint32_t id = m_load_models.push_back();
-			curr_model = &m_load_models[id];
-
 			const std::wstring curr_name(&rootNode->mName.C_Str()[0], &rootNode->mName.C_Str()[strlen(rootNode->mName.C_Str())]);
-			curr_model->SetName(curr_name);
 			const aiMatrix4x4 model_xform = (rootNode->mTransformation * parent_trans);
-			InitializeModel(scene, rootNode, meshesIdx, model_xform, curr_model);
-			parent_model->AddChild(curr_model);
+			curr_node = InitializeModel(scene, rootNode, meshesIdx, model_xform, curr_name, parent_node, import);
 		}
-		parent_model = curr_model;
-		assert(parent_model);
+		parent_node = curr_node;
+		assert(parent_node != NO_MESH_IDX);
 	}
 	else {
 		// stack xform's of nodes without meshes only.
@@ -89,7 +414,7 @@ void FileManager::TraverseMeshes(const aiScene* scene, aiNode* rootNode, const a
 	
 	for (uint32_t i = 0; i < rootNode->mNumChildren; i++)
 	{
-		TraverseMeshes(scene, rootNode->mChildren[i], trans_for_children, parent_model);
+		TraverseMeshes(scene, rootNode->mChildren[i], trans_for_children, parent_node, import);
 	}
 }
 
@@ -97,6 +422,7 @@ FileManager::FileManager() :
 	m_modelImporter(std::make_unique<Assimp::Importer>())
 {
 	m_model_dir = gFrontend->GetRootDir() / L"content" / L"models";
+	m_cooked_dir = gFrontend->GetRootDir() / L"content" / L"cooked";
 	m_texture_loader.reset(CreateTextureLoader(gFrontend->GetRootDir()));
 	m_texture_loader->OnInit();
 
@@ -109,42 +435,50 @@ FileManager::FileManager() :
 
 FileManager::~FileManager()
 {
+	// models give their shared vertex allocations back to their meshes, which go after them
+	m_load_models.clear();
 }
 
-void FileManager::ReadModelFromFBX(const std::wstring &name, uint32_t id, RenderModel* outModel)
+bool FileManager::ReadModelFromFBX(const std::wstring &name, ModelImport &import)
 {
 	std::filesystem::path file_path = m_model_dir / name;
-	assert(std::filesystem::exists(file_path));
-	// fetch data
-	const aiScene* scene = m_modelImporter->ReadFile(file_path.u8string(),
-		aiProcess_CalcTangentSpace |
-		aiProcess_Triangulate |
-		aiProcess_SortByPType |
-		aiProcess_ConvertToLeftHanded );
+	// workers, the streamer and the hot reloader import too, a missing model is a failed import there, not an abort
+	if (!VirtualFileSystem::Get().Exists(file_path)) {
+		return false;
+	}
+	// fetch data, importer per call so imports can run on several threads
+	Assimp::Importer importer;
+	importer.SetIOHandler(new VfsIOSystem);
+	// optimization needs an indexed mesh, most exporters write unique vertices per face
+	const aiScene* scene = importer.ReadFile(file_path.u8string(), import_flags | (m_optimize_meshes ? aiProcess_JoinIdenticalVertices : 0));
 	if (scene) {
 		aiNode* rootNode = scene->mRootNode;
-		SetupModelRoot(scene, outModel);
+		SetupModelRoot(scene, import);
 		aiMatrix4x4 currTrans(identity_mx);
-		TraverseMeshes(scene, rootNode, currTrans, outModel);
+		TraverseMeshes(scene, rootNode, currTrans, 0, import);
 	}
+
+	return scene != nullptr;
 }
 
-void FileManager::InitializeModel(const aiScene* scene, const aiNode* rootNode, uint32_t meshesIdx, const aiMatrix4x4 &model_xform, RenderModel* outModel) {
+uint32_t FileManager::InitializeModel(const aiScene* scene, const aiNode* rootNode, uint32_t meshesIdx, const aiMatrix4x4 &model_xform, const std::wstring &node_name, uint32_t parent_node, ModelImport &import) {
+	const uint32_t node_idx = (uint32_t)import.nodes.size();
+	import.nodes.emplace_back();
 	if (scene)
 	{
+		ModelImport::Node &node = import.nodes.back();
+		node.name = node_name;
+		node.parent = parent_node;
+
 		// xform
 		aiVector3D rot;
 		aiVector3D scale;
 		aiVector3D trans;
 		model_xform.Decompose(scale, rot, trans);
 
-		DirectX::XMFLOAT3 DXrot(rot.x, rot.y, rot.z);
-		DirectX::XMFLOAT3 DXscale(scale.x, scale.y, scale.z);
-		DirectX::XMFLOAT3 DXtrans(trans.x, trans.y, trans.z);
-
-		outModel->Move(DXtrans);
-		outModel->Scale(DXscale);
-		outModel->Rotate(DXrot);
+		node.position = DirectX::XMFLOAT3(trans.x, trans.y, trans.z);
+		node.scale = DirectX::XMFLOAT3(scale.x, scale.y, scale.z);
+		node.rotation = DirectX::XMFLOAT3(rot.x, rot.y, rot.z);
 
 		// mesh
 		if (meshesIdx != NO_MESH_IDX)
@@ -158,11 +492,19 @@ void FileManager::InitializeModel(const aiScene* scene, const aiNode* rootNode,
 			std::vector<DirectX::XMFLOAT3> tangents(verticesNum);
 			std::vector<DirectX::XMFLOAT3> bitangents(verticesNum);
 
-			RenderMesh* r_mesh = nullptr;
-			if (AllocMesh(outModel->GetName(), r_mesh)) {
-				std::vector<DirectX::XMFLOAT3> vertices(verticesNum);
+			// nodes referencing the same scene mesh share it, identical content is shared later by AllocMesh
+			const auto it = std::find_if(import.meshes.begin(), import.meshes.end(), [meshesIdx](const ModelImport::Mesh &mesh) { return (mesh.source_mesh == meshesIdx); });
+			node.mesh = (uint32_t)std::distance(import.meshes.begin(), it);
+			if (it == import.meshes.end()) {
+				import.meshes.emplace_back();
+				ModelImport::Mesh &r_mesh = import.meshes.back();
+				r_mesh.name = node_name;
+				r_mesh.source_mesh = meshesIdx;
+				std::vector<DirectX::XMFLOAT3> &vertices = r_mesh.vertices;
+				vertices.resize(verticesNum);
 
-				std::vector<uint16_t> indices(indicesNum);
+				std::vector<uint32_t> &indices = r_mesh.indices;
+				indices.resize(indicesNum);
 
 				for (i = 0; i < verticesNum; i++)
 				{
@@ -170,7 +512,6 @@ void FileManager::InitializeModel(const aiScene* scene, const aiNode* rootNode,
 					vertices[i].y = mesh->mVertices[i].y;
 					vertices[i].z = mesh->mVertices[i].z;
 				}
-				r_mesh->SetVertices(std::move(vertices));
 
 				for (uint32_t j = 0, i = 0; i < (uint32_t)mesh->mNumFaces; i++)
 				{
@@ -178,20 +519,18 @@ void FileManager::InitializeModel(const aiScene* scene, const aiNode* rootNode,
 					indices[j++] = mesh->mFaces[i].mIndices[1];
 					indices[j++] = mesh->mFaces[i].mIndices[2];
 				}
-				r_mesh->SetIndices(std::move(indices));
 
 				// texture coords
 				if (mesh->mTextureCoords)
 				{
-					std::vector<DirectX::XMFLOAT2> textCoords_(mesh->mNumVertices);
+					std::vector<DirectX::XMFLOAT2> &textCoords_ = r_mesh.tex_coords;
+					textCoords_.resize(mesh->mNumVertices);
 
 					for (uint32_t k = 0; k < mesh->mNumVertices; k++)
 					{
 						textCoords_[k].x = mesh->mTextureCoords[0][k].x;
 						textCoords_[k].y = mesh->mTextureCoords[0][k].y;
 					}
-
-					r_mesh->SetTextureCoords(std::move(textCoords_));
 				}
 
 				if (mesh->HasNormals())
@@ -214,16 +553,34 @@ void FileManager::InitializeModel(const aiScene* scene, const aiNode* rootNode,
 						}
 					}
 
-					r_mesh->SetNormals(std::move(normals));
+					r_mesh.normals = std::move(normals);
 
 					if (mesh->HasTangentsAndBitangents())
 					{
-						r_mesh->SetTangents(std::move(tangents), std::move(bitangents));
+						r_mesh.tangents = std::move(tangents);
+						r_mesh.bitangents = std::move(bitangents);
 					}
 				}
-			}
 
-			outModel->SetMesh(r_mesh);
+				if (m_optimize_meshes) {
+					OptimizeMesh(r_mesh);
+				}
+
+				// parts go in one after another, nodes find them through the first one
+				if (m_index_width == iw_16 && verticesNum > max_16bit_vertices) {
+					ModelImport::Mesh whole = std::move(r_mesh);
+					import.meshes.pop_back();
+					std::vector<ModelImport::Mesh> parts;
+					SplitMesh(whole, parts);
+					std::move(parts.begin(), parts.end(), std::back_inserter(import.meshes));
+				}
+				for (uint32_t p = node.mesh; p < (uint32_t)import.meshes.size(); p++) {
+					BuildLods(import.meshes[p], m_lod_levels, m_lod_target_error);
+					PackIndices(import.meshes[p]);
+					import.meshes[p].UpdateStreams();
+					import.meshes[p].content_hash = HashStreams(import.meshes[p].streams);
+				}
+			}
 
 			// materials, textures
 			if (scene->mNumMaterials)
@@ -260,14 +617,12 @@ void FileManager::InitializeModel(const aiScene* scene, const aiNode* rootNode,
 						// Check if it's an embedded or external  texture.
 						if (auto texture_embeded = scene->GetEmbeddedTexture(texturePath.C_Str()))
 						{
-							assert(false);
+							node.textures[RenderModel::TextureType::DiffuseTexture] = AddEmbeddedTexture(texture_embeded, import);
 						}
 						else
 						{
 							const std::wstring texture_path(&texturePath.C_Str()[0], &texturePath.C_Str()[strlen(texturePath.C_Str())]);
-							ITextureLoader::TextureData* texture_data = m_texture_loader->LoadTextureOnCPU(texture_path);
-							assert(texture_data);
-							outModel->SetTexture(texture_data, RenderModel::TextureType::DiffuseTexture);
+							node.textures[RenderModel::TextureType::DiffuseTexture] = texture_path;
 						}
 					}
 				}
@@ -280,14 +635,12 @@ void FileManager::InitializeModel(const aiScene* scene, const aiNode* rootNode,
 					{
 						if (auto texture_embeded = scene->GetEmbeddedTexture(texturePath.C_Str()))
 						{
-							assert(false);
+							node.textures[RenderModel::TextureType::NormalTexture] = AddEmbeddedTexture(texture_embeded, import);
 						}
 						else
 						{
 							const std::wstring texture_path(&texturePath.C_Str()[0], &texturePath.C_Str()[strlen(texturePath.C_Str())]);
-							ITextureLoader::TextureData* texture_data = m_texture_loader->LoadTextureOnCPU(texture_path);
-							assert(texture_data);
-							outModel->SetTexture(texture_data, RenderModel::TextureType::NormalTexture);
+							node.textures[RenderModel::TextureType::NormalTexture] = texture_path;
 						}
 					}
 				}
@@ -299,14 +652,12 @@ void FileManager::InitializeModel(const aiScene* scene, const aiNode* rootNode,
 					{
 						if (auto texture_embeded = scene->GetEmbeddedTexture(texturePath.C_Str()))
 						{
-							assert(false);
+							node.textures[RenderModel::TextureType::MetallicTexture] = AddEmbeddedTexture(texture_embeded, import);
 						}
 						else
 						{
 							const std::wstring texture_path(&texturePath.C_Str()[0], &texturePath.C_Str()[strlen(texturePath.C_Str())]);
-							ITextureLoader::TextureData* texture_data = m_texture_loader->LoadTextureOnCPU(texture_path);
-							assert(texture_data);
-							outModel->SetTexture(texture_data, RenderModel::TextureType::MetallicTexture);
+							node.textures[RenderModel::TextureType::MetallicTexture] = texture_path;
 						}
 					}
 				}
@@ -319,63 +670,876 @@ void FileManager::InitializeModel(const aiScene* scene, const aiNode* rootNode,
 					{
 						if (auto texture_embeded = scene->GetEmbeddedTexture(texturePath.C_Str()))
 						{
-							assert(false);
+							node.textures[RenderModel::TextureType::RoughTexture] = AddEmbeddedTexture(texture_embeded, import);
 						}
 						else
 						{
 							const std::wstring texture_path(&texturePath.C_Str()[0], &texturePath.C_Str()[strlen(texturePath.C_Str())]);
-							ITextureLoader::TextureData* texture_data = m_texture_loader->LoadTextureOnCPU(texture_path);
-							assert(texture_data);
-							outModel->SetTexture(texture_data, RenderModel::TextureType::RoughTexture);
+							node.textures[RenderModel::TextureType::RoughTexture] = texture_path;
 						}
 					}
 				}
 			}
+
+			// the other parts of a split mesh hang off the node with an identity xform
+			const uint32_t first_part = node.mesh;
+			const std::array<std::wstring, RenderObject::TextureCount> textures = node.textures;
+			for (uint32_t p = first_part + 1; p < (uint32_t)import.meshes.size() && import.meshes[p].source_mesh == meshesIdx; p++) {
+				import.nodes.emplace_back();
+				ModelImport::Node &part_node = import.nodes.back();
+				part_node.name = import.meshes[p].name;
+				part_node.parent = node_idx;
+				part_node.mesh = p;
+				part_node.textures = textures;
+			}
 		}
-		outModel->Initialized();
 	}
+
+	return node_idx;
 }
 
 const std::filesystem::path& FileManager::GetModelDir() const{
 	return m_model_dir;
 }
 
-void FileManager::LoadTextureOnGPU(ICommandList* command_list, IGpuResource* res, ITextureLoader::TextureData* tex_data)
+std::shared_ptr<IGpuResource> FileManager::LoadTextureOnGPU(ICommandList* command_list, ITextureLoader::TextureData* tex_data)
+{
+	// first model to ask uploads, the rest share its texture
+	if (!tex_data->gpu_resource) {
+		tex_data->gpu_resource.reset(CreateGpuResource());
+		m_texture_loader->LoadTextureOnGPU(command_list, tex_data->gpu_resource.get(), tex_data);
+	}
+
+	return tex_data->gpu_resource;
+}
+
+TextureRegistry::Stats FileManager::GetTextureStats()
 {
-	m_texture_loader->LoadTextureOnGPU(command_list, res, tex_data);
+	return m_texture_loader->GetRegistry().GetStats();
+}
+
+FileManager::Residency FileManager::GetResidency()
+{
+	Residency residency;
+	residency.models_num = m_load_models.size();
+	residency.meshes_num = m_load_meshes.size();
+	for (const RenderMesh &mesh : m_load_meshes) {
+		residency.mesh_bytes += mesh.GetStreamBytes();
+	}
+
+	const TextureRegistry::Stats stats = m_texture_loader->GetRegistry().GetStats();
+	residency.textures_num = (uint32_t)stats.textures.size();
+	residency.texture_cpu_bytes = stats.cpu_bytes;
+	residency.texture_gpu_bytes = stats.gpu_bytes;
+
+	return residency;
+}
+
+void FileManager::SetTextureCpuBudget(uint64_t bytes)
+{
+	m_texture_loader->GetRegistry().SetCpuBudget(bytes);
 }
 
 RenderModel* FileManager::LoadModelInternal(const std::wstring &name){
-	uint32_t idx = m_load_models.push_back();
-	RenderModel *new_model = &m_load_models[idx];
-	uint32_t cnt = 0;
-	ReadModelFromFBX(name, 0, new_model);
+	std::unique_ptr<ModelImport> import = ImportModel(name);
+	// a missing or unreadable model gets an empty placeholder that draws nothing, as before the cooks
+	if (import->nodes.empty()) {
+		gFrontend->GetLogger()->hlog(logger::ll_WARNING, "model: %s did not load, using an empty placeholder", std::filesystem::path(name).u8string().c_str());
+		return MergeModel(*import);
+	}
+
+	RenderModel *new_model = MergeModel(*import);
 	assert(new_model->IsInitialized());
 
 	return new_model;
 }
 
+std::unique_ptr<FileManager::ModelImport> FileManager::ImportModel(const std::wstring &name) {
+	StartupScope scope("model import", name);
+	std::unique_ptr<ModelImport> import = std::make_unique<ModelImport>();
+	if (!ReadCookedModel(name, *import)) {
+		ReadModelFromFBX(name, *import);
+		WriteCookedModel(name, *import);
+	}
+
+	return import;
+}
+
+RenderModel* FileManager::MergeModel(const ModelImport &import) {
+	// a failed import merges to an empty placeholder that draws nothing, a later hot reload of the model swaps it out
+	if (import.nodes.empty()) {
+		return AllocModel();
+	}
+
+	std::vector<RenderModel*> models(import.nodes.size(), nullptr);
+	for (uint32_t i = 0; i < import.nodes.size(); i++) {
+		const ModelImport::Node &node = import.nodes[i];
+		RenderModel* model = AllocModel();
+		models[i] = model;
+		if (i) {
+			model->SetName(node.name);
+		}
+
+		model->Move(node.position);
+		model->Scale(node.scale);
+		model->Rotate(node.rotation);
+
+		if (node.mesh != NO_MESH_IDX) {
+			const ModelImport::Mesh &mesh = import.meshes[node.mesh];
+			RenderMesh* r_mesh = nullptr;
+			if (AllocMesh(mesh.name, mesh.content_hash, mesh.streams, r_mesh)) {
+				if (import.mapping) {
+					r_mesh->SetMappedStreams(mesh.streams, import.mapping);
+				}
+				else {
+					r_mesh->SetVertices(mesh.vertices);
+					if (mesh.indices16.empty()) {
+						r_mesh->SetIndices(mesh.indices);
+					}
+					else {
+						r_mesh->SetIndices(mesh.indices16);
+					}
+					r_mesh->SetTextureCoords(mesh.tex_coords);
+					r_mesh->SetNormals(mesh.normals);
+					r_mesh->SetTangents(mesh.tangents, mesh.bitangents);
+				}
+				r_mesh->SetLods(mesh.lods.data(), mesh.lods_num, mesh.bounding_sphere);
+			}
+			model->SetMesh(r_mesh);
+		}
+
+		for (uint32_t slot = 0; slot < RenderModel::TextureType::TextureCount; slot++) {
+			if (!node.textures[slot].empty()) {
+				ITextureLoader::TextureData* texture_data = ReserveTexture(import, node.textures[slot]);
+				assert(texture_data);
+				if (texture_data->NeedsDecode()) {
+					m_texture_loader->DecodeTexture(texture_data);
+				}
+				model->SetTexture(TextureHandle(m_texture_loader->GetRegistry(), texture_data), RenderModel::TextureType(slot));
+			}
+		}
+
+		model->Initialized();
+		if (i) {
+			models[node.parent]->AddChild(model);
+		}
+	}
+
+	return models[0];
+}
+
+bool FileManager::DecodeTextureFile(const std::wstring &name, image_decoder::Image &image) {
+	return m_texture_loader->DecodeImage(std::filesystem::path(name).filename().wstring(), nullptr, image);
+}
+
+bool FileManager::IsTextureInUse(const std::wstring &name) {
+	const ITextureLoader::TextureData* texture_data = m_texture_loader->GetRegistry().Find(name);
+	return texture_data && texture_data->ref_count;
+}
+
+uint32_t FileManager::ReloadTexture(const std::wstring &name, image_decoder::Image &&image) {
+	TextureRegistry &registry = m_texture_loader->GetRegistry();
+	ITextureLoader::TextureData* texture_data = registry.Find(name);
+	if (!texture_data || !texture_data->ref_count) {
+		return 0;
+	}
+
+	registry.Replace(texture_data, std::move(image));
+
+	// same handle again, only to flag the slot for upload
+	uint32_t models_num = 0;
+	for (RenderModel &model : m_load_models) {
+		for (uint32_t slot = 0; slot < RenderModel::TextureType::TextureCount; slot++) {
+			if (model.GetTextureData(RenderModel::TextureType(slot)) == texture_data) {
+				model.SetTexture(TextureHandle(registry, texture_data), RenderModel::TextureType(slot));
+				models_num++;
+			}
+		}
+	}
+
+	return models_num;
+}
+
+void FileManager::ReleaseModel(RenderModel* model) {
+	if (model) {
+		// Release forgets the children, so gather the tree first
+		std::vector<RenderModel*> nodes;
+		CollectModelNodes(model, nodes);
+		std::vector<RenderMesh*> meshes;
+		std::vector<std::wstring> textures;
+		for (RenderModel* node : nodes) {
+			if (RenderMesh* mesh = node->GetMesh()) {
+				meshes.push_back(mesh);
+			}
+			for (uint32_t slot = 0; slot < RenderModel::TextureType::TextureCount; slot++) {
+				if (const ITextureLoader::TextureData* texture_data = node->GetTextureData(RenderModel::TextureType(slot))) {
+					textures.push_back(texture_data->name);
+				}
+			}
+		}
+		model->Release();
+		for (RenderModel* node : nodes) {
+			m_load_models.erase(m_load_models.handle_of(node));
+		}
+		// after the models, they hand their shared vertex allocations back to the meshes
+		for (RenderMesh* mesh : meshes) {
+			ReleaseMesh(mesh);
+		}
+
+		// textures that left the registry are prefetched again by the next import asking for them
+		std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+		for (const std::wstring &name : textures) {
+			if (!m_texture_loader->GetRegistry().Find(name)) {
+				m_decoded_textures.erase(name);
+			}
+		}
+	}
+}
+
+void FileManager::ReleaseModelDeferred(RenderModel* model) {
+	if (model) {
+		// retired between frames, the last frame that could draw it is the last one presented
+		m_retired_models.emplace_back(model, gFrontend->GetPresentedFence());
+	}
+}
+
+void FileManager::ReleaseRetiredModels() {
+	const uint64_t completed_fence = gFrontend->GetCompletedFence();
+	auto it = std::remove_if(m_retired_models.begin(), m_retired_models.end(), [this, completed_fence](const std::pair<RenderModel*, uint64_t> &retired) {
+		if (retired.second > completed_fence) {
+			return false;
+		}
+		ReleaseModel(retired.first);
+		return true;
+	});
+	m_retired_models.erase(it, m_retired_models.end());
+}
+
+void FileManager::ReportCookErrors() {
+	std::lock_guard<std::mutex> lock(m_cook_errors_mutex);
+	for (const std::string &path : m_cook_errors) {
+		gFrontend->GetLogger()->hlog(logger::ll_WARNING, "cook: %s could not be replaced, the old cook stays", path.c_str());
+	}
+	m_cook_errors.clear();
+}
+
+uint64_t FileManager::EstimateModelBytes(const std::wstring &name) const {
+	uint64_t size = 0;
+	int64_t time = 0;
+	if (VirtualFileSystem::Get().Stat(GetCookedPath(name), size, time) || VirtualFileSystem::Get().Stat(m_model_dir / name, size, time)) {
+		return size;
+	}
+
+	return 0;
+}
+
+RenderModel* FileManager::AllocModel() {
+	const pro_game_containers::pool_handle handle = m_load_models.insert();
+	RenderModel* model = &m_load_models[handle];
+	model->SetId(handle.index());
+
+	return model;
+}
+
+void FileManager::CollectModelNodes(RenderModel* model, std::vector<RenderModel*> &nodes) {
+	nodes.push_back(model);
+	for (uint32_t i = 0; i < model->GetChildrenNum(); i++) {
+		CollectModelNodes(model->GetChild(i), nodes);
+	}
+}
+
+ITextureLoader::TextureData* FileManager::ReserveTexture(const ModelImport &import, const std::wstring &name) {
+	for (const ModelImport::Texture &texture : import.textures) {
+		if (texture.name == name) {
+			return m_texture_loader->ReserveTexture(name, texture.content_hash, texture.image);
+		}
+	}
+
+	return m_texture_loader->ReserveTexture(name);
+}
+
+void FileManager::PrefetchTextures(const ModelImport &import) {
+	for (const ModelImport::Node &node : import.nodes) {
+		for (const std::wstring &name : node.textures) {
+			if (name.empty()) {
+				continue;
+			}
+
+			const std::wstring filename = std::filesystem::path(name).filename().wstring();
+			{
+				// first import to ask decodes it
+				std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+				if (m_decoded_textures.count(filename) || !m_prefetched.emplace(filename, nullptr).second) {
+					continue;
+				}
+			}
+
+			const ITextureLoader::EmbeddedImage* embedded = nullptr;
+			for (const ModelImport::Texture &texture : import.textures) {
+				if (texture.name == name) {
+					embedded = &texture.image;
+				}
+			}
+
+			std::unique_ptr<image_decoder::Image> image = std::make_unique<image_decoder::Image>();
+			if (!m_texture_loader->DecodeImage(filename, embedded, *image)) {
+				continue; // LoadTexturesOnCPU tries again
+			}
+
+			std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+			m_prefetched[filename] = std::move(image);
+		}
+	}
+}
+
+uint32_t FileManager::LoadTexturesOnCPU(const std::vector<std::unique_ptr<ModelImport>> &imports, ThreadPool &thread_pool) {
+	// pool slots are taken in import order, only the decode runs in parallel
+	std::vector<ITextureLoader::TextureData*> pending;
+	uint32_t decoded_num = 0;
+	for (const std::unique_ptr<ModelImport> &import : imports) {
+		for (const ModelImport::Node &node : import->nodes) {
+			for (const std::wstring &name : node.textures) {
+				if (name.empty()) {
+					continue;
+				}
+
+				ITextureLoader::TextureData* texture_data = ReserveTexture(*import, name);
+				if (!texture_data->NeedsDecode() || std::find(pending.begin(), pending.end(), texture_data) != pending.end()) {
+					continue;
+				}
+
+				// the level streamer may be prefetching for its next cell meanwhile
+				std::unique_ptr<image_decoder::Image> image;
+				{
+					std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+					const auto it = m_prefetched.find(texture_data->name);
+					if (it != m_prefetched.end()) {
+						image = std::move(it->second);
+					}
+				}
+				if (image) {
+					m_texture_loader->GetRegistry().SetDecoded(texture_data, std::move(*image));
+					decoded_num++;
+				}
+				else {
+					pending.push_back(texture_data);
+				}
+			}
+		}
+	}
+
+	thread_pool.ParallelFor((uint32_t)pending.size(), [this, &pending](uint32_t idx) {
+		m_texture_loader->DecodeTexture(pending[idx]);
+	});
+
+	// later loads reuse them, no need to prefetch again
+	std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+	for (auto &prefetched : m_prefetched) {
+		m_decoded_textures.insert(prefetched.first);
+	}
+	for (ITextureLoader::TextureData* texture_data : pending) {
+		m_decoded_textures.insert(texture_data->name);
+	}
+	m_prefetched.clear();
+
+	return decoded_num + (uint32_t)pending.size();
+}
+
+std::filesystem::path FileManager::GetCookedPath(const std::wstring &name) const {
+	std::filesystem::path cooked_path = m_cooked_dir / name;
+	cooked_path += L".cooked";
+
+	return cooked_path;
+}
+
+bool FileManager::IsModelSupported(const std::filesystem::path &path) const {
+	return std::filesystem::is_regular_file(path) && m_modelImporter->IsExtensionSupported(path.extension().u8string());
+}
+
+bool FileManager::ReadCookedModel(const std::wstring &name, ModelImport &import) {
+	using namespace cooked_model;
+	std::shared_ptr<VfsFile> mapping = VirtualFileSystem::Get().Open(GetCookedPath(name));
+	if (!mapping) {
+		return false;
+	}
+
+	const Header* header = ValidateCookedModel(*mapping, m_model_dir / name);
+	if (!header) {
+		return false;
+	}
+
+	const uint8_t* data = mapping->GetData();
+	const Node* nodes = (const Node*)(data + header->nodes_offset);
+	const Mesh* meshes = (const Mesh*)(data + header->meshes_offset);
+	const char* strings = (const char*)(data + header->strings_offset);
+	auto get_string = [strings](const String &str) { return std::wstring(&strings[str.offset], &strings[str.offset + str.size]); };
+
+	// cooked with other import settings
+	if (header->lod_levels != m_lod_levels || header->lod_target_error != m_lod_target_error) {
+		return false;
+	}
+	for (uint32_t i = 0; i < header->meshes_num; i++) {
+		const uint32_t flags = meshes[i].flags;
+		if (((flags & mf_optimized) != 0) != m_optimize_meshes ||
+			(m_index_width == iw_16 && (flags & mf_index32)) ||
+			(m_index_width == iw_fit && (flags & mf_split))) {
+			return false;
+		}
+	}
+
+	import.nodes.resize(header->nodes_num);
+	for (uint32_t i = 0; i < header->nodes_num; i++) {
+		const Node &node = nodes[i];
+		ModelImport::Node &imp_node = import.nodes[i];
+		imp_node.name = get_string(node.name);
+		imp_node.parent = node.parent;
+		imp_node.mesh = node.mesh;
+		imp_node.position = DirectX::XMFLOAT3(node.position);
+		imp_node.rotation = DirectX::XMFLOAT3(node.rotation);
+		imp_node.scale = DirectX::XMFLOAT3(node.scale);
+		for (uint32_t slot = 0; slot < texture_slots; slot++) {
+			imp_node.textures[slot] = get_string(node.textures[slot]);
+		}
+	}
+
+	import.meshes.resize(header->meshes_num);
+	for (uint32_t i = 0; i < header->meshes_num; i++) {
+		import.meshes[i].name = get_string(meshes[i].name);
+		import.meshes[i].streams = GetCookedStreams(data, meshes[i]);
+		import.meshes[i].content_hash = meshes[i].content_hash;
+		import.meshes[i].optimized = (meshes[i].flags & mf_optimized) != 0;
+		import.meshes[i].split = (meshes[i].flags & mf_split) != 0;
+		import.meshes[i].lods_num = meshes[i].lods_num;
+		for (uint32_t lod = 0; lod < meshes[i].lods_num; lod++) {
+			import.meshes[i].lods[lod] = RenderMesh::Lod{ meshes[i].lods[lod].index_offset, meshes[i].lods[lod].indices_num, meshes[i].lods[lod].error };
+		}
+		import.meshes[i].bounding_sphere = DirectX::XMFLOAT4(meshes[i].bounding_sphere);
+	}
+	const Texture* textures = (const Texture*)(data + header->textures_offset);
+	import.textures.resize(header->textures_num);
+	for (uint32_t i = 0; i < header->textures_num; i++) {
+		ModelImport::Texture &imp_texture = import.textures[i];
+		imp_texture.name = get_string(textures[i].name);
+		imp_texture.content_hash = textures[i].content_hash;
+		imp_texture.image.data = data + textures[i].data_offset;
+		imp_texture.image.size = textures[i].data_size;
+		imp_texture.image.width = textures[i].width;
+		imp_texture.image.height = textures[i].height;
+		imp_texture.image.format_hint.assign(&strings[textures[i].format_hint.offset], textures[i].format_hint.size);
+	}
+	import.mapping = std::move(mapping);
+
+	return true;
+}
+
+void FileManager::WriteCookedModel(const std::wstring &name, const ModelImport &import) {
+	using namespace cooked_model;
+	static_assert(texture_slots == RenderModel::TextureType::TextureCount, "cooked texture slots must match RenderModel textures");
+	static_assert(max_lods == RenderMesh::max_lods, "cooked lods must match RenderMesh lods");
+
+	const std::filesystem::path source_path = m_model_dir / name;
+	std::error_code ec;
+	const uint64_t source_size = std::filesystem::file_size(source_path, ec);
+	if (ec || import.nodes.empty()) {
+		return;
+	}
+
+	std::string strings;
+	// names were widened char by char on import, narrowing back is lossless
+	auto add_string = [&strings](const std::wstring &str) {
+		String res{ (uint32_t)strings.size(), (uint32_t)str.size() };
+		for (wchar_t c : str) {
+			strings.push_back((char)c);
+		}
+		return res;
+	};
+
+	// import nodes are already pre-order, parents come before their children
+	std::vector<Node> nodes(import.nodes.size());
+	for (uint32_t i = 0; i < import.nodes.size(); i++) {
+		const ModelImport::Node &imp_node = import.nodes[i];
+		Node &node = nodes[i];
+		node.name = add_string(imp_node.name);
+		node.parent = imp_node.parent;
+		node.mesh = imp_node.mesh;
+		memcpy(node.position, &imp_node.position, sizeof(node.position));
+		memcpy(node.rotation, &imp_node.rotation, sizeof(node.rotation));
+		memcpy(node.scale, &imp_node.scale, sizeof(node.scale));
+		for (uint32_t slot = 0; slot < texture_slots; slot++) {
+			node.textures[slot] = add_string(imp_node.textures[slot]);
+		}
+	}
+
+	std::vector<Mesh> meshes(import.meshes.size());
+	for (uint32_t i = 0; i < import.meshes.size(); i++) {
+		const RenderMesh::Streams &streams = import.meshes[i].streams;
+		Mesh &mesh = meshes[i];
+		mesh.name = add_string(import.meshes[i].name);
+		mesh.vertices_num = streams.vertices_num;
+		mesh.indices_num = streams.indices_num;
+		mesh.content_hash = import.meshes[i].content_hash;
+		mesh.flags = (streams.tex_coords ? mf_tex_coords : 0) | (streams.normals ? mf_normals : 0) | (streams.tangents ? mf_tangents : 0) | (import.meshes[i].optimized ? mf_optimized : 0) |
+			(streams.index_size == sizeof(uint32_t) ? mf_index32 : 0) | (import.meshes[i].split ? mf_split : 0);
+		mesh.lods_num = import.meshes[i].lods_num;
+		for (uint32_t lod = 0; lod < mesh.lods_num; lod++) {
+			const RenderMesh::Lod &imp_lod = import.meshes[i].lods[lod];
+			mesh.lods[lod] = Lod{ imp_lod.index_offset, imp_lod.indices_num, imp_lod.error };
+		}
+		memcpy(mesh.bounding_sphere, &import.meshes[i].bounding_sphere, sizeof(mesh.bounding_sphere));
+	}
+
+	std::vector<Texture> textures(import.textures.size());
+	for (uint32_t i = 0; i < import.textures.size(); i++) {
+		const ModelImport::Texture &imp_texture = import.textures[i];
+		Texture &texture = textures[i];
+		texture.name = add_string(imp_texture.name);
+		texture.format_hint = add_string(std::wstring(imp_texture.image.format_hint.begin(), imp_texture.image.format_hint.end()));
+		texture.width = imp_texture.image.width;
+		texture.height = imp_texture.image.height;
+		texture.content_hash = imp_texture.content_hash;
+		texture.data_size = imp_texture.image.size;
+	}
+
+	Header header{};
+	header.magic = magic;
+	header.version = version;
+	header.source_size = source_size;
+	header.source_time = GetSourceTime(source_path);
+	header.nodes_num = (uint32_t)nodes.size();
+	header.meshes_num = (uint32_t)meshes.size();
+	header.nodes_offset = align(sizeof(Header));
+	header.meshes_offset = align(header.nodes_offset + nodes.size() * sizeof(Node));
+	header.textures_num = (uint32_t)textures.size();
+	header.textures_offset = align(header.meshes_offset + meshes.size() * sizeof(Mesh));
+	header.strings_offset = align(header.textures_offset + textures.size() * sizeof(Texture));
+	header.strings_size = strings.size();
+	header.lod_levels = m_lod_levels;
+	header.lod_target_error = m_lod_target_error;
+
+	uint64_t offset = align(header.strings_offset + header.strings_size);
+	auto place_stream = [&offset](uint64_t size) {
+		const uint64_t res = offset;
+		offset = align(offset + size);
+		return res;
+	};
+	for (Mesh &mesh : meshes) {
+		const uint64_t vec3_size = (uint64_t)mesh.vertices_num * sizeof(DirectX::XMFLOAT3);
+		mesh.vertices_offset = place_stream(vec3_size);
+		mesh.indices_offset = place_stream((uint64_t)mesh.indices_num * GetCookedIndexSize(mesh));
+		if (mesh.flags & mf_tex_coords) {
+			mesh.tex_coords_offset = place_stream((uint64_t)mesh.vertices_num * sizeof(DirectX::XMFLOAT2));
+		}
+		if (mesh.flags & mf_normals) {
+			mesh.normals_offset = place_stream(vec3_size);
+		}
+		if (mesh.flags & mf_tangents) {
+			mesh.tangents_offset = place_stream(vec3_size);
+			mesh.bitangents_offset = place_stream(vec3_size);
+		}
+	}
+	for (Texture &texture : textures) {
+		texture.data_offset = place_stream(texture.data_size);
+	}
+	header.file_size = offset;
+
+	std::vector<uint8_t> blob(offset, 0);
+	auto write = [&blob](uint64_t at, const void* src, uint64_t size) {
+		if (size) {
+			memcpy(&blob[at], src, size);
+		}
+	};
+	write(0, &header, sizeof(Header));
+	write(header.nodes_offset, nodes.data(), nodes.size() * sizeof(Node));
+	write(header.meshes_offset, meshes.data(), meshes.size() * sizeof(Mesh));
+	write(header.textures_offset, textures.data(), textures.size() * sizeof(Texture));
+	write(header.strings_offset, strings.data(), strings.size());
+	for (uint32_t i = 0; i < meshes.size(); i++) {
+		const Mesh &mesh = meshes[i];
+		const RenderMesh::Streams &streams = import.meshes[i].streams;
+		const uint64_t vec3_size = (uint64_t)mesh.vertices_num * sizeof(DirectX::XMFLOAT3);
+		write(mesh.vertices_offset, streams.vertices, vec3_size);
+		write(mesh.indices_offset, streams.indices, (uint64_t)mesh.indices_num * streams.index_size);
+		if (mesh.flags & mf_tex_coords) {
+			write(mesh.tex_coords_offset, streams.tex_coords, (uint64_t)mesh.vertices_num * sizeof(DirectX::XMFLOAT2));
+		}
+		if (mesh.flags & mf_normals) {
+			write(mesh.normals_offset, streams.normals, vec3_size);
+		}
+		if (mesh.flags & mf_tangents) {
+			write(mesh.tangents_offset, streams.tangents, vec3_size);
+			write(mesh.bitangents_offset, streams.bitangents, vec3_size);
+		}
+	}
+	for (uint32_t i = 0; i < textures.size(); i++) {
+		write(textures[i].data_offset, import.textures[i].image.data, textures[i].data_size);
+	}
+
+	// write aside and swap in, a crash mid-write never leaves a truncated cook behind; the level streamer and the
+	// hot reloader may cook the same model at once, each write gets its own file and the last rename wins
+	static std::atomic<uint32_t> writes_num{ 0 };
+	const std::filesystem::path cooked_path = GetCookedPath(name);
+	std::filesystem::path tmp_path = cooked_path;
+	tmp_path += L"." + std::to_wstring(writes_num++) + L".tmp";
+	std::filesystem::create_directories(cooked_path.parent_path(), ec);
+	{
+		std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+		if (!file.write((const char*)blob.data(), blob.size())) {
+			file.close();
+			std::filesystem::remove(tmp_path, ec);
+			return;
+		}
+	}
+	// a reader without delete sharing or a locked directory keeps the old cook, the next load cooks again
+	std::filesystem::rename(tmp_path, cooked_path, ec);
+	if (ec) {
+		std::filesystem::remove(tmp_path, ec);
+		std::lock_guard<std::mutex> lock(m_cook_errors_mutex);
+		m_cook_errors.push_back(cooked_path.string());
+	}
+}
+
+void FileManager::OptimizeMesh(ModelImport::Mesh &mesh) {
+	const uint32_t vertices_num = (uint32_t)mesh.vertices.size();
+	mesh.cache_before = mesh_optimizer::AnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), vertices_num);
+
+	mesh_optimizer::OptimizeVertexCache(mesh.indices.data(), mesh.indices.size(), vertices_num);
+	mesh_optimizer::OptimizeOverdraw(mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), vertices_num);
+
+	// vertex_data is fetched by SV_VertexID, first use order makes those reads sequential
+	std::vector<uint32_t> remap;
+	const uint32_t new_vertices_num = mesh_optimizer::OptimizeVertexFetchRemap(mesh.indices.data(), mesh.indices.size(), vertices_num, remap);
+	mesh_optimizer::RemapStream(mesh.vertices, remap, new_vertices_num);
+	mesh_optimizer::RemapStream(mesh.tex_coords, remap, new_vertices_num);
+	mesh_optimizer::RemapStream(mesh.normals, remap, new_vertices_num);
+	mesh_optimizer::RemapStream(mesh.tangents, remap, new_vertices_num);
+	mesh_optimizer::RemapStream(mesh.bitangents, remap, new_vertices_num);
+
+	mesh.cache_after = mesh_optimizer::AnalyzeVertexCache(mesh.indices.data(), mesh.indices.size(), new_vertices_num);
+	mesh.optimized = true;
+}
+
+template<class T>
+static void GatherStream(const std::vector<T> &src, const std::vector<uint32_t> &used, std::vector<T> &dst) {
+	if (src.empty()) {
+		return;
+	}
+
+	dst.resize(used.size());
+	for (size_t i = 0; i < used.size(); i++) {
+		dst[i] = src[used[i]];
+	}
+}
+
+// greedy over the triangles in their (cache optimized) order, a part is closed once the next triangle does not fit
+void FileManager::SplitMesh(ModelImport::Mesh &mesh, std::vector<ModelImport::Mesh> &parts) {
+	std::vector<uint32_t> remap(mesh.vertices.size(), mesh_optimizer::no_vertex);
+	const size_t triangles_num = mesh.indices.size() / 3;
+	size_t tri = 0;
+	while (tri < triangles_num) {
+		parts.emplace_back();
+		ModelImport::Mesh &part = parts.back();
+		part.name = (parts.size() == 1) ? mesh.name : mesh.name + L"_part" + std::to_wstring(parts.size() - 1);
+		part.source_mesh = mesh.source_mesh;
+		part.optimized = mesh.optimized;
+		part.split = true;
+		part.cache_before = mesh.cache_before;
+
+		std::vector<uint32_t> used; // source vertex of every part vertex
+		for (; tri < triangles_num; tri++) {
+			const uint32_t* triangle = &mesh.indices[tri * 3];
+			const uint32_t new_vertices = (remap[triangle[0]] == mesh_optimizer::no_vertex) + (remap[triangle[1]] == mesh_optimizer::no_vertex) + (remap[triangle[2]] == mesh_optimizer::no_vertex);
+			if (used.size() + new_vertices > max_16bit_vertices) {
+				break;
+			}
+
+			for (uint32_t k = 0; k < 3; k++) {
+				if (remap[triangle[k]] == mesh_optimizer::no_vertex) {
+					remap[triangle[k]] = (uint32_t)used.size();
+					used.push_back(triangle[k]);
+				}
+				part.indices.push_back(remap[triangle[k]]);
+			}
+		}
+
+		for (uint32_t v : used) {
+			remap[v] = mesh_optimizer::no_vertex;
+		}
+		GatherStream(mesh.vertices, used, part.vertices);
+		GatherStream(mesh.tex_coords, used, part.tex_coords);
+		GatherStream(mesh.normals, used, part.normals);
+		GatherStream(mesh.tangents, used, part.tangents);
+		GatherStream(mesh.bitangents, used, part.bitangents);
+		part.cache_after = mesh_optimizer::AnalyzeVertexCache(part.indices.data(), part.indices.size(), (uint32_t)used.size());
+	}
+}
+
+// every level is simplified from the full mesh so errors do not stack, and appended to the index stream
+void FileManager::BuildLods(ModelImport::Mesh &mesh, uint32_t levels, float target_error) {
+	const uint32_t vertices_num = (uint32_t)mesh.vertices.size();
+	const uint32_t full_num = (uint32_t)mesh.indices.size();
+	mesh.bounding_sphere = mesh_optimizer::ComputeBoundingSphere(mesh.vertices.data(), vertices_num);
+	mesh.lods[0] = RenderMesh::Lod{ 0, full_num, 0.f };
+	mesh.lods_num = 1;
+
+	const float radius = mesh.bounding_sphere.w;
+	std::vector<uint32_t> lod_indices(full_num);
+	for (uint32_t level = 1; level < levels && radius > 0.f; level++) {
+		const size_t target = size_t(full_num >> level) / 3 * 3;
+		float error = 0.f;
+		const size_t lod_num = mesh_optimizer::Simplify(lod_indices.data(), mesh.indices.data(), full_num, mesh.vertices.data(), vertices_num, target, target_error * float(1u << (level - 1)), &error);
+		// not worth a level when it barely removes anything
+		if (lod_num == 0 || lod_num * 5 > (size_t)mesh.lods[level - 1].indices_num * 4) {
+			break;
+		}
+
+		mesh_optimizer::OptimizeVertexCache(lod_indices.data(), lod_num, vertices_num);
+		mesh.lods[level] = RenderMesh::Lod{ (uint32_t)mesh.indices.size(), (uint32_t)lod_num, error / radius };
+		mesh.indices.insert(mesh.indices.end(), lod_indices.begin(), lod_indices.begin() + lod_num);
+		mesh.lods_num++;
+	}
+}
+
+void FileManager::PackIndices(ModelImport::Mesh &mesh) {
+	if (mesh.vertices.size() > max_16bit_vertices) {
+		return;
+	}
+
+	mesh.indices16.assign(mesh.indices.begin(), mesh.indices.end());
+	std::vector<uint32_t>().swap(mesh.indices);
+}
+
+void FileManager::CookModel(const std::wstring &name) {
+	ModelImport import;
+	if (ReadCookedModel(name, import)) {
+		return;
+	}
+
+	if (ReadModelFromFBX(name, import)) {
+		WriteCookedModel(name, import);
+	}
+}
+
+std::vector<FileManager::TextureReport> FileManager::CookTextures(ThreadPool &thread_pool) {
+	using namespace texture_cooker;
+	std::unordered_map<std::wstring, Role> roles;
+	for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(m_model_dir)) {
+		if (!IsModelSupported(entry.path())) {
+			continue;
+		}
+
+		const std::unique_ptr<ModelImport> import = ImportModel(entry.path().filename().wstring());
+		for (const ModelImport::Node &node : import->nodes) {
+			for (uint32_t slot = 0; slot < node.textures.size(); slot++) {
+				if (node.textures[slot].empty()) {
+					continue;
+				}
+				const Role role = (slot == RenderObject::DiffuseTexture) ? Role::tr_albedo : (slot == RenderObject::NormalTexture) ? Role::tr_normal : Role::tr_mask;
+				roles.emplace(std::filesystem::path(node.textures[slot]).filename().wstring(), role);
+			}
+		}
+	}
+
+	const std::filesystem::path texture_dir = gFrontend->GetRootDir() / L"content" / L"textures";
+	std::vector<TextureReport> reports;
+	std::error_code ec;
+	for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(texture_dir, ec)) {
+		if (entry.is_regular_file() && image_decoder::IsSupported(entry.path().extension().u8string())) {
+			TextureReport report;
+			report.name = entry.path().filename().wstring();
+			const auto it = roles.find(report.name);
+			report.role = (it != roles.end()) ? it->second : GuessRole(report.name);
+			reports.push_back(report);
+		}
+	}
+
+	const std::filesystem::path cooked_dir = m_cooked_dir / L"textures";
+	thread_pool.ParallelFor((uint32_t)reports.size(), [&reports, &texture_dir, &cooked_dir](uint32_t idx) {
+		using clock = std::chrono::steady_clock;
+		const clock::time_point start = clock::now();
+		TextureReport &report = reports[idx];
+		const std::filesystem::path source_path = texture_dir / report.name;
+
+		Settings settings;
+		settings.role = report.role;
+		image_decoder::Image source;
+		image_decoder::Image cooked;
+		if (image_decoder::DecodeFile(source_path, source) && Cook(source, settings, cooked, &report.cook)) {
+			report.cooked = WriteDDS(texture_cooker::GetCookedPath(cooked_dir, report.name), cooked, source_path);
+		}
+		report.ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+	});
+
+	return reports;
+}
+
+FileManager::LoadTiming FileManager::BenchmarkModelLoad(const std::wstring &name) {
+	using clock = std::chrono::steady_clock;
+	LoadTiming timing;
+
+	// cold: full assimp import, stream extraction and mesh optimization
+	clock::time_point start = clock::now();
+	{
+		ModelImport import;
+		if (!ReadModelFromFBX(name, import)) {
+			return timing;
+		}
+		timing.import_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+		for (const ModelImport::Mesh &mesh : import.meshes) {
+			MeshReport report;
+			report.name = mesh.name;
+			report.vertices_num = mesh.streams.vertices_num;
+			report.triangles_num = (mesh.lods_num ? mesh.lods[0].indices_num : mesh.streams.indices_num) / 3;
+			for (uint32_t lod = 1; lod < mesh.lods_num; lod++) {
+				report.lod_triangles.push_back(mesh.lods[lod].indices_num / 3);
+			}
+			report.index_size = mesh.streams.index_size;
+			report.before = mesh.cache_before;
+			report.after = mesh.cache_after;
+			timing.meshes.push_back(report);
+		}
+	}
+
+	// warm: map, validate and touch every stream page the gpu upload would read
+	start = clock::now();
+	{
+		ModelImport import;
+		if (ReadCookedModel(name, import)) {
+			const VfsFile &mapping = *import.mapping;
+			const cooked_model::Header* header = (const cooked_model::Header*)mapping.GetData();
+			volatile uint8_t sink = 0;
+			for (uint64_t b = cooked_model::align(header->strings_offset + header->strings_size); b < mapping.GetSize(); b += 4096) {
+				sink = sink + mapping.GetData()[b];
+			}
+			timing.cooked_size = mapping.GetSize();
+		}
+	}
+	timing.cooked_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+	return timing;
+}
+
 void FileManager::CreateModel(const std::wstring &tex_name, Geom_type type, RenderObject*& model) {
 	if (!model){
-		const uint32_t id = m_load_models.push_back();
-		model = &m_load_models[id];
-		model->SetId(id);
+		model = AllocModel();
 	}
 
 	if (type != gt_quad) {
-		const uint32_t idx = m_load_meshes.push_back();
-		RenderMesh* r_mesh = &m_load_meshes[idx];
-		r_mesh->SetId(idx);
-		r_mesh->SetVertices(m_geoms[type].vertices);
-		r_mesh->SetIndices(m_geoms[type].indices);
-		r_mesh->SetTextureCoords(m_geoms[type].tex_coords);
+		static const std::array<std::wstring, gt_num> geom_names = { L"geom_sphere", L"geom_quad", L"geom_triangle" };
+		const RenderMesh::Streams streams = GetGeomStreams(m_geoms[type]);
+		RenderMesh* r_mesh = nullptr;
+		if (AllocMesh(geom_names[type], HashStreams(streams), streams, r_mesh)) {
+			r_mesh->SetVertices(m_geoms[type].vertices);
+			r_mesh->SetIndices(m_geoms[type].indices);
+			r_mesh->SetTextureCoords(m_geoms[type].tex_coords);
+		}
 		model->SetMesh(r_mesh);
 	}
 
 	if (!tex_name.empty()){
 		ITextureLoader::TextureData* texture_data = m_texture_loader->LoadTextureOnCPU(tex_name);
 		assert(texture_data);
-		model->SetTexture(texture_data, RenderModel::TextureType::DiffuseTexture);
+		model->SetTexture(TextureHandle(m_texture_loader->GetRegistry(), texture_data), RenderModel::TextureType::DiffuseTexture);
 	}
 	model->Initialized();
 }
\ No newline at end of file
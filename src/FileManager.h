@@ -3,12 +3,20 @@
 #include <string>
 #include <memory>
 #include <array>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
 #include <filesystem>
 #include <assimp/matrix4x4.h>
 #include "simple_object_pool.h"
+#include "generational_pool.h"
 #include "RenderModel.h"
 #include "free_allocator.h"
 #include "ITextureLoader.h"
+#include "TextureRegistry.h"
+#include "TextureCooker.h"
+#include "MeshOptimizer.h"
 
 namespace Assimp
 {
@@ -21,11 +29,15 @@ struct aiNode;
 class RenderQuad;
 class ICommandList;
 class IGpuResource;
+class VfsFile;
+class ThreadPool;
 
 class FileManager
 {
 public:
     enum Geom_type { gt_sphere = 0, gt_quad, gt_triangle, gt_num };
+    // iw_fit: 16 bit indices where the mesh fits, 32 bit otherwise; iw_16: always 16 bit, bigger meshes are split
+    enum Index_width { iw_fit = 0, iw_16 };
     struct Geom {
         std::vector<DirectX::XMFLOAT3> vertices;
         std::vector<DirectX::XMFLOAT2> tex_coords;
@@ -33,33 +45,191 @@ public:
         Geom_type type;
     };
 
+    // CPU side result of a model import; built without touching the pools, so imports can run on several threads
+    struct ModelImport {
+        struct Node {
+            std::wstring name;
+            uint32_t parent{ uint32_t(-1) };
+            uint32_t mesh{ uint32_t(-1) };
+            DirectX::XMFLOAT3 position{ 0.f, 0.f, 0.f };
+            DirectX::XMFLOAT3 rotation{ 0.f, 0.f, 0.f };
+            DirectX::XMFLOAT3 scale{ 1.f, 1.f, 1.f };
+            std::array<std::wstring, RenderObject::TextureCount> textures;
+        };
+        struct Mesh {
+            std::wstring name;
+            std::vector<DirectX::XMFLOAT3> vertices;
+            std::vector<uint32_t> indices; // import width, cleared once packed into indices16
+            std::vector<uint16_t> indices16;
+            std::vector<DirectX::XMFLOAT2> tex_coords;
+            std::vector<DirectX::XMFLOAT3> normals;
+            std::vector<DirectX::XMFLOAT3> tangents;
+            std::vector<DirectX::XMFLOAT3> bitangents;
+            RenderMesh::Streams streams; // into the vectors above or into mapping
+            uint64_t content_hash{ 0 };
+            uint32_t source_mesh{ uint32_t(-1) }; // aiScene mesh index, only used while importing
+            bool optimized{ false };
+            bool split{ false }; // one of the parts of a mesh too big for 16 bit indices
+            std::array<RenderMesh::Lod, RenderMesh::max_lods> lods;
+            uint32_t lods_num{ 0 };
+            DirectX::XMFLOAT4 bounding_sphere{ 0.f, 0.f, 0.f, 0.f };
+            mesh_optimizer::VertexCacheStats cache_before;
+            mesh_optimizer::VertexCacheStats cache_after;
+
+            void UpdateStreams() {
+                streams.vertices = vertices.data();
+                streams.index_size = indices16.empty() ? sizeof(uint32_t) : sizeof(uint16_t);
+                streams.indices = indices16.empty() ? (const void*)indices.data() : (const void*)indices16.data();
+                streams.tex_coords = tex_coords.empty() ? nullptr : tex_coords.data();
+                streams.normals = normals.empty() ? nullptr : normals.data();
+                streams.tangents = tangents.empty() ? nullptr : tangents.data();
+                streams.bitangents = bitangents.empty() ? nullptr : bitangents.data();
+                streams.vertices_num = (uint32_t)vertices.size();
+                streams.indices_num = (uint32_t)(indices16.empty() ? indices.size() : indices16.size());
+            }
+        };
+        // image embedded in the model file, nodes refer to it by name
+        struct Texture {
+            std::wstring name;
+            uint64_t content_hash{ 0 };
+            std::vector<uint8_t> data;
+            ITextureLoader::EmbeddedImage image; // into data or into mapping
+        };
+        std::vector<Node> nodes; // pre-order, node 0 is the root
+        std::vector<Mesh> meshes;
+        std::vector<Texture> textures;
+        std::shared_ptr<VfsFile> mapping; // cooked model, loose or in a pak
+    };
+
+    struct MeshReport {
+        std::wstring name;
+        uint32_t vertices_num{ 0 };
+        uint32_t triangles_num{ 0 };
+        uint32_t index_size{ 0 };
+        std::vector<uint32_t> lod_triangles;
+        mesh_optimizer::VertexCacheStats before;
+        mesh_optimizer::VertexCacheStats after;
+    };
+
+    struct LoadTiming {
+        double import_ms{ 0.0 };
+        double cooked_ms{ 0.0 };
+        uint64_t cooked_size{ 0 };
+        std::vector<MeshReport> meshes;
+    };
+
+    struct TextureReport {
+        std::wstring name;
+        texture_cooker::Role role{ texture_cooker::Role::tr_albedo };
+        texture_cooker::Report cook;
+        double ms{ 0.0 };
+        bool cooked{ false };
+    };
+
+    // what the pools hold, unloading streamed cells brings it back down
+    struct Residency {
+        uint32_t models_num{ 0 };
+        uint32_t meshes_num{ 0 };
+        uint64_t mesh_bytes{ 0 };
+        uint32_t textures_num{ 0 };
+        uint64_t texture_cpu_bytes{ 0 };
+        uint64_t texture_gpu_bytes{ 0 };
+    };
+
     FileManager();
     ~FileManager();
 
     RenderModel* LoadModel(const std::wstring &name);
+    // LoadModel in two steps: ImportModel is thread safe, MergeModel fills the pools and must run on one thread
+    std::unique_ptr<ModelImport> ImportModel(const std::wstring &name);
+    // never null, an import without nodes merges to an empty placeholder model
+    RenderModel* MergeModel(const ModelImport &import);
+    // decodes the textures of an import ahead of LoadTexturesOnCPU, thread safe so it can run right after ImportModel
+    void PrefetchTextures(const ModelImport &import);
+    // textures of every import, the ones already decoded are skipped; returns the number decoded here or by PrefetchTextures
+    uint32_t LoadTexturesOnCPU(const std::vector<std::unique_ptr<ModelImport>> &imports, ThreadPool &thread_pool);
+    void CookModel(const std::wstring &name);
+    // every texture the decoders read goes to content/cooked/textures, roles come from the model slots using a texture or from its name
+    std::vector<TextureReport> CookTextures(ThreadPool &thread_pool);
+    LoadTiming BenchmarkModelLoad(const std::wstring &name);
+    bool IsModelSupported(const std::filesystem::path &path) const;
     void CreateModel(const std::wstring &tex_name, Geom_type type, RenderObject* &model);
+    RenderMesh* FindMesh(const std::wstring &name);
+    // vertex cache, overdraw and vertex fetch reordering of imported meshes, cooks made with the other setting are stale
+    void SetOptimizeMeshes(bool optimize) { m_optimize_meshes = optimize; }
+    // cooks made with the other setting are stale too
+    void SetIndexWidth(Index_width width) { m_index_width = width; }
+    // levels include the full mesh, level i aims at 1/2^i of the triangles within target_error * 2^(i-1) of the mesh extent
+    void SetLodSettings(uint32_t levels, float target_error) { m_lod_levels = std::min(std::max(levels, 1u), RenderMesh::max_lods); m_lod_target_error = target_error; }
     const std::filesystem::path& GetModelDir() const;
 
-    void LoadTextureOnGPU(ICommandList* command_list, IGpuResource* res, ITextureLoader::TextureData* tex_data);
+    // hot reload: decoding is thread safe, the rest runs on the main thread once the gpu is idle
+    bool DecodeTextureFile(const std::wstring &name, image_decoder::Image &image);
+    bool IsTextureInUse(const std::wstring &name);
+    // swaps the texels of a texture file in use, models using it upload again; returns the number of models rebound
+    uint32_t ReloadTexture(const std::wstring &name, image_decoder::Image &&image);
+    // the model tree of a replaced model gives back its buffers and textures, its pool slots are reused; meshes go
+    // with the last model using them
+    void ReleaseModel(RenderModel* model);
+    // streaming: models the frames in flight may still draw, released once the gpu is past them
+    void ReleaseModelDeferred(RenderModel* model);
+    void ReleaseRetiredModels();
+    // cooks written on the workers that failed to swap in, logged on the main thread
+    void ReportCookErrors();
+    // resident size guess before importing: the cooked model, else the source file
+    uint64_t EstimateModelBytes(const std::wstring &name) const;
+
+    std::shared_ptr<IGpuResource> LoadTextureOnGPU(ICommandList* command_list, ITextureLoader::TextureData* tex_data);
+    // resident texture bytes per registry entry; cpu copies only live between decode and upload
+    TextureRegistry::Stats GetTextureStats();
+    void SetTextureCpuBudget(uint64_t bytes);
+    Residency GetResidency();
 private:
     static constexpr uint32_t meshes_capacity = 256;
 
 
-    void SetupModelRoot(const aiScene* scene, RenderModel* curr_model);
-    void TraverseMeshes(const aiScene* scene, aiNode* rootNode, const aiMatrix4x4 &parent_trans, RenderModel* parent_model);
-    bool AllocMesh(const std::wstring &name, RenderMesh* &mesh);
+    void SetupModelRoot(const aiScene* scene, ModelImport &import);
+    void TraverseMeshes(const aiScene* scene, aiNode* rootNode, const aiMatrix4x4 &parent_trans, uint32_t parent_node, ModelImport &import);
+    ITextureLoader::TextureData* ReserveTexture(const ModelImport &import, const std::wstring &name);
+    bool AllocMesh(const std::wstring &name, uint64_t content_hash, const RenderMesh::Streams &streams, RenderMesh* &mesh);
+    void ReleaseMesh(RenderMesh* mesh);
+    void SetMeshName(const std::wstring &name, pro_game_containers::pool_handle handle);
+    RenderModel* AllocModel();
+    void CollectModelNodes(RenderModel* model, std::vector<RenderModel*> &nodes);
     RenderModel* LoadModelInternal(const std::wstring &name);
-    void ReadModelFromFBX(const std::wstring &name, uint32_t id, RenderModel* outModel);
-    void InitializeModel(const aiScene* scene, const aiNode* rootNode, uint32_t meshesIdx, const aiMatrix4x4 &model_xform, RenderModel* outModel);
-    
+    bool ReadModelFromFBX(const std::wstring &name, ModelImport &import);
+    uint32_t InitializeModel(const aiScene* scene, const aiNode* rootNode, uint32_t meshesIdx, const aiMatrix4x4 &model_xform, const std::wstring &node_name, uint32_t parent_node, ModelImport &import);
+    std::filesystem::path GetCookedPath(const std::wstring &name) const;
+    bool ReadCookedModel(const std::wstring &name, ModelImport &import);
+    void WriteCookedModel(const std::wstring &name, const ModelImport &import);
+    static void OptimizeMesh(ModelImport::Mesh &mesh);
+    static void SplitMesh(ModelImport::Mesh &mesh, std::vector<ModelImport::Mesh> &parts);
+    static void PackIndices(ModelImport::Mesh &mesh);
+    static void BuildLods(ModelImport::Mesh &mesh, uint32_t levels, float target_error);
 
     std::unique_ptr<Assimp::Importer> m_modelImporter;
-    pro_game_containers::simple_object_pool<RenderModel, meshes_capacity * 2> m_load_models;
-    pro_game_containers::simple_object_pool<RenderMesh, meshes_capacity> m_load_meshes;
+    // before the models, their texture handles release into it
+    std::unique_ptr<ITextureLoader> m_texture_loader;
+    // released models give their slot back, streaming levels grow it a chunk at a time
+    pro_game_containers::generational_pool<RenderModel, meshes_capacity * 2, 4> m_load_models;
+    pro_game_containers::generational_pool<RenderMesh, meshes_capacity, 8> m_load_meshes;
+    std::unordered_multimap<uint64_t, pro_game_containers::pool_handle> m_mesh_hashes;
+    std::unordered_map<std::wstring, pro_game_containers::pool_handle> m_mesh_names;
+    std::unordered_map<uint32_t, std::vector<std::wstring>> m_mesh_name_lists; // mesh handle value -> the names pointing at it, a mesh forgets them by key
+    std::vector<std::pair<RenderModel*, uint64_t>> m_retired_models; // model, gfx fence of the last frame that could draw it
     
     std::array<Geom, gt_num> m_geoms;
     //std::array<std::wstring, gt_num> m_geom_name;
 
     std::filesystem::path m_model_dir;
-    std::unique_ptr<ITextureLoader> m_texture_loader;
+    std::filesystem::path m_cooked_dir;
+    std::mutex m_prefetch_mutex;
+    std::unordered_map<std::wstring, std::unique_ptr<image_decoder::Image>> m_prefetched; // null while decoding
+    std::unordered_set<std::wstring> m_decoded_textures;
+    std::mutex m_cook_errors_mutex;
+    std::vector<std::string> m_cook_errors;
+    bool m_optimize_meshes{ true };
+    Index_width m_index_width{ iw_fit };
+    uint32_t m_lod_levels{ RenderMesh::max_lods };
+    float m_lod_target_error{ 0.01f };
 };
\ No newline at end of file
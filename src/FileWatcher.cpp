@@ -0,0 +1,193 @@
+#include "FileWatcher.h"
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+FileWatcher::~FileWatcher()
+{
+    Stop();
+}
+
+bool FileWatcher::Start(const std::filesystem::path& dir, Mode mode)
+{
+    Stop();
+
+    std::error_code ec;
+    if (!std::filesystem::is_directory(dir, ec)) {
+        return false;
+    }
+    m_dir = dir;
+
+#if defined(__linux__)
+    if (mode == Mode::fw_auto) {
+        m_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_inotify_fd >= 0 && !AddWatches(m_dir)) {
+            // out of watches most likely, polling still works
+            close(m_inotify_fd);
+            m_inotify_fd = -1;
+            m_watches.clear();
+        }
+    }
+#endif
+
+    m_running = true;
+    if (m_inotify_fd >= 0) {
+        m_thread = std::thread(&FileWatcher::InotifyLoop, this);
+    }
+    else {
+        m_thread = std::thread(&FileWatcher::PollingLoop, this);
+    }
+
+    return true;
+}
+
+void FileWatcher::Stop()
+{
+    m_running = false;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+#if defined(__linux__)
+    if (m_inotify_fd >= 0) {
+        close(m_inotify_fd);
+        m_inotify_fd = -1;
+    }
+#endif
+    m_watches.clear();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_changes.clear();
+}
+
+std::vector<std::filesystem::path> FileWatcher::TakeChanges()
+{
+    std::vector<std::filesystem::path> changes;
+    const clock::time_point now = clock::now();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_changes.begin(); it != m_changes.end();) {
+        if (now - it->second >= settle_time) {
+            // temporaries renamed away since are dropped
+            std::error_code ec;
+            if (std::filesystem::is_regular_file(it->first, ec)) {
+                changes.emplace_back(it->first);
+            }
+            it = m_changes.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    return changes;
+}
+
+void FileWatcher::MarkChanged(const std::filesystem::path& path)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_changes[path.wstring()] = clock::now();
+}
+
+bool FileWatcher::AddWatches(const std::filesystem::path& dir)
+{
+#if defined(__linux__)
+    // inotify is not recursive, every directory gets its own watch
+    const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR;
+    const int wd = inotify_add_watch(m_inotify_fd, dir.c_str(), mask);
+    if (wd < 0) {
+        return false;
+    }
+    m_watches[wd] = dir;
+
+    std::error_code ec;
+    for (std::filesystem::recursive_directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_directory(ec)) {
+            const int sub_wd = inotify_add_watch(m_inotify_fd, it->path().c_str(), mask);
+            if (sub_wd < 0) {
+                return false;
+            }
+            m_watches[sub_wd] = it->path();
+        }
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FileWatcher::InotifyLoop()
+{
+#if defined(__linux__)
+    alignas(inotify_event) char buffer[16 * 1024];
+    while (m_running) {
+        pollfd pfd = { m_inotify_fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+
+        const ssize_t size = read(m_inotify_fd, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < size;) {
+            const inotify_event* event = (const inotify_event*)(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            const auto it = m_watches.find(event->wd);
+            if (it == m_watches.end() || !event->len) {
+                continue;
+            }
+
+            const std::filesystem::path path = it->second / event->name;
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    AddWatches(path);
+                }
+            }
+            else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                // saved in place or written elsewhere and renamed over
+                MarkChanged(path);
+            }
+        }
+    }
+#endif
+}
+
+void FileWatcher::ScanTimes(std::unordered_map<std::wstring, std::filesystem::file_time_type>& times) const
+{
+    std::error_code ec;
+    for (std::filesystem::recursive_directory_iterator it(m_dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code file_ec;
+        if (it->is_regular_file(file_ec)) {
+            times[it->path().wstring()] = it->last_write_time(file_ec);
+        }
+    }
+}
+
+void FileWatcher::PollingLoop()
+{
+    std::unordered_map<std::wstring, std::filesystem::file_time_type> times;
+    ScanTimes(times);
+
+    clock::time_point next_scan = clock::now() + poll_interval;
+    while (m_running) {
+        // short sleeps keep Stop responsive
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (clock::now() < next_scan) {
+            continue;
+        }
+        next_scan = clock::now() + poll_interval;
+
+        std::unordered_map<std::wstring, std::filesystem::file_time_type> new_times;
+        ScanTimes(new_times);
+        for (const auto& file : new_times) {
+            const auto it = times.find(file.first);
+            if (it == times.end() || it->second != file.second) {
+                MarkChanged(file.first);
+            }
+        }
+        times = std::move(new_times);
+    }
+}
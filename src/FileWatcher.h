@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <filesystem>
+
+// Reports files written under a directory tree. Linux uses inotify, everything else (and Linux when inotify is
+// unavailable) rescans write times every poll_interval. Editors save in bursts, so a file is only reported once
+// it has been quiet for settle_time.
+class FileWatcher {
+public:
+    enum class Mode { fw_auto, fw_polling };
+
+    static constexpr std::chrono::milliseconds poll_interval{ 500 };
+    static constexpr std::chrono::milliseconds settle_time{ 150 };
+
+    FileWatcher() = default;
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+    ~FileWatcher();
+
+    bool Start(const std::filesystem::path& dir, Mode mode = Mode::fw_auto);
+    void Stop();
+    bool IsNative() const { return m_inotify_fd >= 0; }
+
+    // thread safe; files changed and settled since the last call, each once
+    std::vector<std::filesystem::path> TakeChanges();
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    void InotifyLoop();
+    void PollingLoop();
+    bool AddWatches(const std::filesystem::path& dir);
+    void ScanTimes(std::unordered_map<std::wstring, std::filesystem::file_time_type>& times) const;
+    void MarkChanged(const std::filesystem::path& path);
+
+    std::filesystem::path m_dir;
+    std::thread m_thread;
+    std::atomic<bool> m_running{ false };
+    int m_inotify_fd{ -1 };
+    std::unordered_map<int, std::filesystem::path> m_watches; // inotify watch descriptor to directory
+
+    std::mutex m_mutex;
+    std::unordered_map<std::wstring, clock::time_point> m_changes; // last write seen
+};
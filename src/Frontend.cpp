@@ -1,5 +1,6 @@
 #include "Frontend.h"
 #include <cassert>
+#include <array>
 #include "defines.h"
 #include "IBackend.h"
 #include "FreeCamera.h"
@@ -15,6 +16,10 @@
 #include "IImguiHelper.h"
 #include "MaterialManager.h"
 #include "GpuDataManager.h"
+#include "Logger.h"
+#include "HotReloader.h"
+#include "FileManager.h"
+#include "StartupProfiler.h"
 
 Frontend* gFrontend = nullptr;
 
@@ -43,24 +48,68 @@ void Frontend::OnInit(const WindowHandler& hwnd, const std::filesystem::path &ro
 	m_start_time = std::chrono::system_clock::now();
 	gFrontend = this;
 
+	// every phase and asset load below is timed, the report is written on exit
+	StartupProfiler& profiler = StartupProfiler::Get();
+	profiler.Start();
+
+	{
+		StartupScope scope("resource managers");
+		ResourceManager::OnInit(root_dir);
+	}
+
 	// create backend
-	ResourceManager::OnInit(root_dir);
-	m_backend.reset(CreateBackend());
-	m_backend->OnInit(hwnd, m_width, m_height, root_dir);
+	{
+		StartupScope scope("backend");
+		m_backend.reset(CreateBackend());
+		m_backend->OnInit(hwnd, m_width, m_height, root_dir);
+	}
 
-	ConstantBufferManager::OnInit();
+	{
+		StartupScope scope("constant buffers");
+		ConstantBufferManager::OnInit();
+	}
 
-	m_level = std::make_shared<Level>();
-	m_level->Load(L"test_level.json");
-	m_material_mgr->LoadMaterials();
+	{
+		StartupScope scope("level", L"test_level.json");
+		m_level = std::make_shared<Level>();
+		m_level->Load(L"test_level.json");
+	}
+	{
+		const Level::LoadTimings& timings = m_level->GetLoadTimings();
+		m_backend->GetLogger()->hlog(logger::ll_INFO, "level load %.2f ms on %u threads: parse %.2f (%s), definitions %.2f (%u), import %.2f (%u models), textures %.2f (%u), merge %.2f (%u entities, %u failed), %u streamed cells",
+			timings.total_ms, timings.threads_num, timings.parse_ms, timings.cooked ? "cooked" : "json", timings.definitions_ms, timings.definitions_num, timings.import_ms, timings.models_num,
+			timings.textures_ms, timings.textures_num, timings.merge_ms, timings.entities_num, timings.failures_num, timings.stream_cells_num);
+	}
+	{
+		StartupScope scope("materials");
+		m_material_mgr->LoadMaterials();
+	}
+
+	{
+		StartupScope scope("render passes");
+		m_post_process_quad->Initialize();
+		m_deferred_shading_quad->Initialize();
+		m_forward_quad->Initialize();
+		m_ssao->Initialize(m_width, m_height, L"SSAO_");
+		m_reflections->Initialize();
+	}
+
+	{
+		StartupScope scope("gpu data");
+		m_gpu_data_mgr->Initialize();
+	}
 
-	m_post_process_quad->Initialize();
-	m_deferred_shading_quad->Initialize();
-	m_forward_quad->Initialize();
-	m_ssao->Initialize(m_width, m_height, L"SSAO_");
-	m_reflections->Initialize();
+	// edits under content/ show up without a restart
+	{
+		StartupScope scope("hot reload");
+		m_hot_reloader = std::make_unique<HotReloader>();
+		if (m_hot_reloader->Start(root_dir / L"content", m_backend->GetLogger())) {
+			m_backend->GetLogger()->hlog(logger::ll_INFO, "hot reload: watching content with %s", m_hot_reloader->IsNative() ? "inotify" : "polling");
+		}
+	}
 
-	m_gpu_data_mgr->Initialize();
+	profiler.Finish();
+	m_backend->GetLogger()->hlog(logger::ll_INFO, "startup %.2f ms", profiler.GetTotalMs());
 }
 
 void Frontend::OnUpdate()
@@ -72,6 +121,13 @@ void Frontend::OnUpdate()
 	m_time = t;
 	m_total_time = t - m_start_time;
 
+	// frame boundary: nothing is recording, reloaded assets swap in here
+	m_hot_reloader->Update();
+	if (std::shared_ptr<FileManager> file_mgr = GetFileManager().lock()) {
+		file_mgr->ReleaseRetiredModels();
+		file_mgr->ReportCookErrors();
+	}
+
 	if (std::shared_ptr<FreeCamera> camera = m_level->GetCamera().lock()) {
 		UpdateCamera(camera, m_dt.count());
 	}
@@ -84,6 +140,8 @@ void Frontend::OnRender()
 {
 	// Wait for signal from new frame
 	m_backend->SyncWithCPU();
+	ConstantBufferManager::BeginFrame(m_backend->GetCompletedFence());
+	m_gpu_data_mgr->BeginFrame(m_backend->GetCompletedFence());
 
 	m_backend->ChechUpdatedShader();
 
@@ -151,11 +209,21 @@ void Frontend::OnRender()
 
 	// Present the frame.
 	m_backend->Present();
+	ConstantBufferManager::EndFrame(m_backend->GetPresentedFence());
+	m_gpu_data_mgr->EndFrame(m_backend->GetPresentedFence());
 }
 
 void Frontend::OnDestroy()
 {
+	// the worker reaches the managers through gFrontend
+	m_hot_reloader.reset();
 	gFrontend = nullptr;
+
+	// next to app.log
+	const StartupProfiler& profiler = StartupProfiler::Get();
+	profiler.WriteJson(L"startup_profile.json");
+	profiler.WriteCsv(L"startup_profile.csv");
+	profiler.WriteChromeTrace(L"startup_trace.json");
 }
 
 void Frontend::OnKeyDown(KeyboardButton key) {
@@ -222,6 +290,26 @@ uint32_t Frontend::FrameId() const
 	return m_backend->GetCurrentBackBufferIndex();
 }
 
+uint32_t Frontend::GetFramesInFlight() const
+{
+	return m_backend->GetFrameCount();
+}
+
+uint64_t Frontend::GetPresentedFence() const
+{
+	return m_backend->GetPresentedFence();
+}
+
+uint64_t Frontend::GetCompletedFence() const
+{
+	return m_backend->GetCompletedFence();
+}
+
+logger* Frontend::GetLogger()
+{
+	return m_backend->GetLogger();
+}
+
 uint32_t Frontend::GetRenderMode() const
 {
 	return m_backend->GetRenderMode();
@@ -275,8 +363,10 @@ void Frontend::UpdateCamera(std::shared_ptr<FreeCamera>& camera, float dt) {
 }
 
 void Frontend::PrepareRenderTarget(ICommandList* command_list, const std::vector<std::shared_ptr<IGpuResource>>& rts, bool set_dsv, bool clear_dsv) {
-	std::vector<IGpuResource*> render_targets(rts.size());
-	for (uint32_t i = 0; i < rts.size(); i++) {
+	assert(rts.size() <= MAX_RTS_NUM);
+	std::array<IGpuResource*, MAX_RTS_NUM> render_targets;
+	const uint32_t rts_num = (uint32_t)rts.size();
+	for (uint32_t i = 0; i < rts_num; i++) {
 		render_targets[i] = rts[i].get();
 	}
 
@@ -285,10 +375,10 @@ void Frontend::PrepareRenderTarget(ICommandList* command_list, const std::vector
 			command_list->ClearDepthStencilView(GetDepthBuffer(), ClearFlagsDsv::cfdsv_depth, 1.0f, 0, 0, nullptr);
 		}
 
-		command_list->SetRenderTargets(render_targets, GetDepthBuffer());
+		command_list->SetRenderTargets(rts_num, render_targets.data(), GetDepthBuffer());
 	}
 	else {
-		command_list->SetRenderTargets(render_targets, nullptr);
+		command_list->SetRenderTargets(rts_num, render_targets.data(), nullptr);
 	}
 
 	// Record commands.
@@ -299,16 +389,16 @@ void Frontend::PrepareRenderTarget(ICommandList* command_list, const std::vector
 }
 
 void Frontend::PrepareRenderTarget(ICommandList* command_list, IGpuResource& rt, bool set_dsv, bool clear_dsv) {
-	std::vector<IGpuResource*> rts{ &rt };
+	IGpuResource* rts[] = { &rt };
 
 	if (set_dsv) {
-		command_list->SetRenderTargets(rts, GetDepthBuffer());
+		command_list->SetRenderTargets(1, rts, GetDepthBuffer());
 		if (clear_dsv) {
 			command_list->ClearDepthStencilView(rt, ClearFlagsDsv::cfdsv_depth, 1.0f, 0, 0, nullptr);
 		}
 	}
 	else {
-		command_list->SetRenderTargets(rts, nullptr);
+		command_list->SetRenderTargets(1, rts, nullptr);
 	}
 
 	// Record commands.
@@ -317,8 +407,8 @@ void Frontend::PrepareRenderTarget(ICommandList* command_list, IGpuResource& rt,
 }
 
 void Frontend::RenderLevel(ICommandList* command_list) {
-	std::vector<ResourceFormat> formats = { ResourceFormat::rf_r16g16b16a16_float, ResourceFormat::rf_r16g16b16a16_float, ResourceFormat::rf_r16g16b16a16_float, ResourceFormat::rf_r16g16b16a16_float };
-	m_deferred_shading_quad->CreateQuadTexture(m_width, m_height, formats, m_backend->GetFrameCount(), 0, L"m_deferred_shading_quad_");
+	const ResourceFormat formats[] = { ResourceFormat::rf_r16g16b16a16_float, ResourceFormat::rf_r16g16b16a16_float, ResourceFormat::rf_r16g16b16a16_float, ResourceFormat::rf_r16g16b16a16_float };
+	m_deferred_shading_quad->CreateQuadTexture(m_width, m_height, formats, (uint32_t)std::size(formats), m_backend->GetFrameCount(), 0, L"m_deferred_shading_quad_");
 	{
 		std::vector<std::shared_ptr<IGpuResource>>& rts = m_deferred_shading_quad->GetRts(FrameId());
 		command_list->ResourceBarrier(rts, ResourceState::rs_resource_state_render_target);
@@ -401,8 +491,8 @@ void Frontend::RenderPostProcessQuad(ICommandList* command_list) {
 
 void Frontend::RenderForwardQuad(ICommandList* command_list) {
 	{
-		std::vector<ResourceFormat> formats = { ResourceFormat::rf_r16g16b16a16_float };
-		m_forward_quad->CreateQuadTexture(m_width, m_height, formats, m_backend->GetFrameCount(), 0, L"m_forward_quad_");
+		const ResourceFormat format = ResourceFormat::rf_r16g16b16a16_float;
+		m_forward_quad->CreateQuadTexture(m_width, m_height, &format, 1, m_backend->GetFrameCount(), 0, L"m_forward_quad_");
 	}
 
 	if (std::shared_ptr<IGpuResource> rt = m_forward_quad->GetRt(FrameId()).lock()) {
@@ -437,8 +527,8 @@ void Frontend::RenderDeferredShadingQuad(ICommandList* command_list) {
 	}
 
 	{
-		std::vector<ResourceFormat> formats = { ResourceFormat::rf_r16g16b16a16_float };
-		m_post_process_quad->CreateQuadTexture(m_width, m_height, formats, m_backend->GetFrameCount(), 0, L"m_post_process_quad_");
+		const ResourceFormat format = ResourceFormat::rf_r16g16b16a16_float;
+		m_post_process_quad->CreateQuadTexture(m_width, m_height, &format, 1, m_backend->GetFrameCount(), 0, L"m_post_process_quad_");
 		if (std::shared_ptr<IGpuResource> rt = m_post_process_quad->GetRt(FrameId()).lock()) {
 			command_list->ResourceBarrier(rt, ResourceState::rs_resource_state_render_target);
 			PrepareRenderTarget(command_list, m_post_process_quad->GetRts(FrameId()), false);
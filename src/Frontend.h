@@ -20,6 +20,8 @@ class IGpuResource;
 class ICommandList;
 class IRootSignature;
 class ICommandQueue;
+class HotReloader;
+class logger;
 
 
 class Frontend : public ResourceManager, public ConstantBufferManager
@@ -63,7 +65,13 @@ public:
     const std::chrono::duration<float>& FrameTime() const { return m_dt; }
     uint32_t FrameNumber() const { return m_frame_id; }
     uint32_t FrameId() const;
+    uint32_t GetFramesInFlight() const;
+    // gfx fences, see IBackend
+    uint64_t GetPresentedFence() const;
+    uint64_t GetCompletedFence() const;
     std::weak_ptr<Level> GetLevel() { return m_level; }
+    const HotReloader* GetHotReloader() const { return m_hot_reloader.get(); }
+    logger* GetLogger();
     uint32_t GetRenderMode() const;
 
     const ITechniques::Technique* GetTechniqueById(uint32_t id) const;
@@ -110,6 +118,7 @@ protected:
     uint32_t m_frame_id{ 0 };
 
     std::shared_ptr<Level> m_level;
+    std::unique_ptr<HotReloader> m_hot_reloader;
 
     struct {
         enum camera_movement_type {
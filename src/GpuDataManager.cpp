@@ -1,40 +1,177 @@
 #include "GpuDataManager.h"
 #include "ICommandList.h"
 #include "IGpuResource.h"
+#include "IHeapBuffer.h"
+#include "Frontend.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
 #include <string>
 
+extern Frontend* gFrontend;
+
 uint64_t GpuDataManager::AllocateVertexBuffer(uint32_t size) {
-    m_dirty = true;
-    return m_vertex_storage.allocate(size);
+    const uint64_t start = m_vertex_storage.allocate(size);
+    if (start == invalid_vertex_offset) {
+        // 0 is a real offset, a full storage must not hand out someone else's vertices
+        return start;
+    }
+
+    // a new page, the gpu buffer follows on the next upload
+    if (m_vertex_data.size() < m_vertex_storage.capacity()) {
+        m_vertex_data.resize(m_vertex_storage.capacity());
+    }
+    // the caller fills it before the next upload
+    MarkDirty(start, size);
+    return start;
 }
 
 void GpuDataManager::DeallocateVertexBuffer(uint64_t start, uint32_t size) {
-    m_vertex_storage.deallocate(start, size);
-    m_dirty = true;
+    if (!size || start == invalid_vertex_offset) {
+        return;
+    }
+
+    // nothing draws from a freed range, it is uploaded again once reallocated
+    m_vertex_storage.deallocate(start);
+}
+
+void GpuDataManager::MarkDirty(uint64_t start, uint64_t size) {
+    if (!size) {
+        return;
+    }
+
+    // ranges are sorted and disjoint; the ones touching or closer than the merge gap fold into one
+    uint64_t begin = start;
+    uint64_t end = start + size;
+    auto first = std::lower_bound(m_dirty_ranges.begin(), m_dirty_ranges.end(), begin, [](const std::pair<uint64_t, uint64_t> &range, uint64_t pos) {
+        return range.second + dirty_merge_gap < pos;
+    });
+    auto last = first;
+    while (last != m_dirty_ranges.end() && last->first <= end + dirty_merge_gap) {
+        begin = std::min(begin, last->first);
+        end = std::max(end, last->second);
+        ++last;
+    }
+
+    if (first == last) {
+        m_dirty_ranges.insert(first, { begin, end });
+    }
+    else {
+        *first = { begin, end };
+        m_dirty_ranges.erase(first + 1, last);
+    }
 }
 
 void GpuDataManager::Initialize()
 {
+    m_vertex_data.resize(m_vertex_storage.capacity());
+    CreateVertexBuffer();
+    CreateStagingRing(staging_ring_size);
+}
+
+void GpuDataManager::CreateVertexBuffer()
+{
+    const uint32_t size = (uint32_t)m_vertex_data.size();
+    m_vertex_buffer_size = size;
     m_vertex_buffer_res.reset(CreateGpuResource());
-    m_vertex_buffer_res->CreateBuffer(HeapType::ht_default, vertex_storage_size, ResourceState::rs_resource_state_all_shader_resource, std::wstring(L"vertex_buffer"));
+    m_vertex_buffer_res->CreateBuffer(HeapType::ht_default, size, ResourceState::rs_resource_state_all_shader_resource, std::wstring(L"vertex_buffer"));
     SRVdesc desc;
     desc.format = ResourceFormat::rf_r8_uint;
     desc.dimension = SRVdesc::SRVdimensionType::srv_dt_buffer;
     desc.buffer.first_element = 0;
-    desc.buffer.num_elements = vertex_storage_size;
+    desc.buffer.num_elements = size;
     desc.buffer.structure_byte_stride = 0;
 
     m_vertex_buffer_res->Create_SRV(desc);
 }
 
-void GpuDataManager::UploadToGpu(ICommandList* command_list)
+void GpuDataManager::CreateStagingRing(uint32_t size)
+{
+    m_staging_res.reset(CreateGpuResource());
+    m_staging_res->CreateBuffer(HeapType::ht_upload, size, ResourceState::rs_resource_state_generic_read, std::wstring(L"vertex_staging_ring"));
+    if (std::shared_ptr<IHeapBuffer> buff = m_staging_res->GetBuffer().lock()) {
+        m_staging_data = buff->Map();
+    }
+    m_staging = std::make_unique<pro_game_containers::ring_allocator>(size);
+}
+
+uint64_t GpuDataManager::AllocateStaging(uint64_t size)
+{
+    uint64_t offset = m_staging->allocate(size, vertex_alignment);
+    if (offset == pro_game_containers::ring_allocator::invalid_offset) {
+        // copies already recorded read the old ring until their frame is done, the new one starts empty
+        m_retired_buffers.emplace_back(std::move(m_staging_res), 0);
+        CreateStagingRing(uint32_t(m_staging->capacity() * 2));
+        offset = m_staging->allocate(size, vertex_alignment);
+    }
+    assert(offset != pro_game_containers::ring_allocator::invalid_offset);
+
+    return offset;
+}
+
+// after SyncWithCPU
+void GpuDataManager::BeginFrame(uint64_t completed_fence)
 {
-    if (m_dirty) {
-        command_list->ResourceBarrier(*m_vertex_buffer_res, ResourceState::rs_resource_state_copy_dest);
-        m_vertex_buffer_res->LoadBuffer(command_list, vertex_storage_size, 1, (void*)m_vertex_storage.begin());
-        command_list->ResourceBarrier(*m_vertex_buffer_res, ResourceState::rs_resource_state_all_shader_resource);
+    auto it = std::remove_if(m_retired_buffers.begin(), m_retired_buffers.end(), [completed_fence](const std::pair<std::unique_ptr<IGpuResource>, uint64_t> &retired) {
+        return retired.second && retired.second <= completed_fence;
+    });
+    m_retired_buffers.erase(it, m_retired_buffers.end());
 
-        m_dirty = false;
+    m_staging->retire(completed_fence);
+}
+
+// after Present
+void GpuDataManager::EndFrame(uint64_t fence)
+{
+    m_staging->finish_frame(fence);
+    for (std::pair<std::unique_ptr<IGpuResource>, uint64_t> &retired : m_retired_buffers) {
+        if (!retired.second) {
+            retired.second = fence;
+        }
     }
 }
 
+void GpuDataManager::UploadToGpu(ICommandList* command_list)
+{
+    // first upload of a frame starts its totals
+    const uint32_t frame = gFrontend->FrameNumber();
+    if (frame != m_upload_stats.frame) {
+        m_upload_stats.frame = frame;
+        m_upload_stats.frame_bytes = 0;
+        m_upload_stats.frame_ranges = 0;
+    }
+
+    // a new buffer starts empty, everything allocated so far goes up again
+    if (m_vertex_buffer_size < m_vertex_data.size()) {
+        m_retired_buffers.emplace_back(std::move(m_vertex_buffer_res), 0);
+        CreateVertexBuffer();
+        MarkDirty(0, m_vertex_storage.get_stats().high_offset);
+    }
+
+    if (m_dirty_ranges.empty()) {
+        return;
+    }
+
+    command_list->ResourceBarrier(*m_vertex_buffer_res, ResourceState::rs_resource_state_copy_dest);
+    std::shared_ptr<IHeapBuffer> dst = m_vertex_buffer_res->GetBuffer().lock();
+    for (const std::pair<uint64_t, uint64_t> &range : m_dirty_ranges) {
+        // at most half the ring per copy, so every piece fits once the ring has grown
+        for (uint64_t begin = range.first; begin < range.second;) {
+            const uint64_t size = std::min<uint64_t>(range.second - begin, m_staging->capacity() / 2);
+            const uint64_t offset = AllocateStaging(size);
+            memcpy(m_staging_data + offset, m_vertex_data.data() + begin, size);
+            if (std::shared_ptr<IHeapBuffer> src = m_staging_res->GetBuffer().lock()) {
+                command_list->CopyBufferRegion(dst, begin, src, offset, size);
+            }
+            begin += size;
+        }
+
+        m_upload_stats.frame_bytes += range.second - range.first;
+        m_upload_stats.frame_ranges++;
+        m_upload_stats.total_bytes += range.second - range.first;
+        m_upload_stats.total_ranges++;
+    }
+    command_list->ResourceBarrier(*m_vertex_buffer_res, ResourceState::rs_resource_state_all_shader_resource);
+
+    m_dirty_ranges.clear();
+}
@@ -1,24 +1,66 @@
 #pragma once
 
 #include <memory>
-#include "free_allocator.h"
+#include <vector>
+#include "ring_allocator.h"
+#include "tlsf_allocator.h"
 
 class IGpuResource;
 class ICommandList;
 
 class GpuDataManager {
 public:
+    struct UploadStats {
+        uint32_t frame{ 0 };            // last frame that uploaded, frame_* are its totals
+        uint64_t frame_bytes{ 0 };
+        uint32_t frame_ranges{ 0 };
+        uint64_t total_bytes{ 0 };
+        uint32_t total_ranges{ 0 };
+    };
+
+    static constexpr uint64_t invalid_vertex_offset = pro_game_containers::tlsf_allocator::invalid_offset;
+
+    // offsets into the vertex storage, what the shaders get as cVertexBufferOffset; invalid_vertex_offset once the
+    // storage can't grow any more, freeing it is a no-op
     uint64_t AllocateVertexBuffer(uint32_t size);
     void DeallocateVertexBuffer(uint64_t start, uint32_t size);
+    // cpu copy of the storage, good until the next allocation grows it
+    uint8_t* GetVertexData(uint64_t start) { return m_vertex_data.data() + start; }
+    // bytes written through GetVertexData after their allocation, copied on the next upload
+    void MarkDirty(uint64_t start, uint64_t size);
+    pro_game_containers::tlsf_allocator::stats GetVertexStorageStats() const { return m_vertex_storage.get_stats(); }
+    const UploadStats& GetUploadStats() const { return m_upload_stats; }
+    pro_game_containers::ring_allocator::stats GetStagingStats() const { return m_staging->get_stats(); }
 
     void Initialize();
+    // staging and retired buffers come back by gfx fence, like ConstantBufferManager's model ring
+    void BeginFrame(uint64_t completed_fence);
+    void EndFrame(uint64_t fence);
     void UploadToGpu(ICommandList* command_list);
     IGpuResource* GetVertexBuffer() { return m_vertex_buffer_res.get(); }
-    uint64_t GetBase() const { return m_vertex_storage.begin(); }
 
 private:
-    static const uint32_t vertex_storage_size = 1024 * 1024 * 32;
-    pro_game_containers::free_allocator m_vertex_storage{vertex_storage_size};
+    void CreateVertexBuffer();
+    void CreateStagingRing(uint32_t size);
+    uint64_t AllocateStaging(uint64_t size);
+
+    static const uint32_t vertex_storage_page = 1024 * 1024 * 32;
+    static const uint32_t vertex_storage_pages_max = 4;
+    static const uint32_t vertex_alignment = 16;
+    static const uint32_t staging_ring_size = 1024 * 1024 * 8;
+    // dirty ranges closer than this are copied as one
+    static const uint32_t dirty_merge_gap = 256;
+    pro_game_containers::tlsf_allocator m_vertex_storage{ vertex_storage_page, vertex_storage_pages_max, vertex_alignment };
+    std::vector<uint8_t> m_vertex_data;
     std::unique_ptr<IGpuResource> m_vertex_buffer_res;
-    bool m_dirty{ false };
-};
\ No newline at end of file
+    uint32_t m_vertex_buffer_size{ 0 };
+    // sorted, disjoint [begin, end) byte ranges of m_vertex_data the gpu buffer has not seen yet
+    std::vector<std::pair<uint64_t, uint64_t>> m_dirty_ranges;
+    // persistent upload buffer the dirty ranges are copied through
+    std::unique_ptr<IGpuResource> m_staging_res;
+    std::unique_ptr<pro_game_containers::ring_allocator> m_staging;
+    uint8_t* m_staging_data{ nullptr };
+    // vertex and staging buffers replaced by a bigger one, kept until the frames that read them are done
+    std::vector<std::pair<std::unique_ptr<IGpuResource>, uint64_t>> m_retired_buffers; // buffer, fence of the frame it was retired in, 0 until that frame is presented
+    UploadStats m_upload_stats;
+};
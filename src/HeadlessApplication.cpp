@@ -0,0 +1,604 @@
+#include "HeadlessApplication.h"
+
+#ifndef WIN32
+
+#include "Frontend.h"
+#include "NullBackend.h"
+#include "FileManager.h"
+#include "Level.h"
+#include "VertexAssembly.h"
+#include "LevelFile.h"
+#include "LevelStreamer.h"
+#include "ThreadPool.h"
+#include "VirtualFileSystem.h"
+#include "HotReloader.h"
+#include "StartupProfiler.h"
+#include "PoolBenchmark.h"
+#include "AllocatorBenchmark.h"
+#include "TextureCheck.h"
+#include "GpuDataManager.h"
+#include "FrameArena.h"
+#include "AllocCounter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <cstdlib>
+#include <cstring>
+
+extern NullBackend* gBackend;
+
+HeadlessApplication::HeadlessApplication(uint32_t width, uint32_t height, const std::wstring& window_name) :
+    m_frontend(std::make_unique<Frontend>(width, height, window_name))
+{
+}
+
+HeadlessApplication::~HeadlessApplication() = default;
+
+void HeadlessApplication::CookModels()
+{
+    std::shared_ptr<FileManager> fm = m_frontend->GetFileManager().lock();
+    if (!fm) {
+        return;
+    }
+
+    printf("%-32s %14s %14s %14s\n", "model", "assimp ms", "cooked ms", "cooked bytes");
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(fm->GetModelDir())) {
+        if (!fm->IsModelSupported(entry.path())) {
+            continue;
+        }
+
+        const std::wstring name = entry.path().filename().wstring();
+        fm->CookModel(name);
+        const FileManager::LoadTiming timing = fm->BenchmarkModelLoad(name);
+        printf("%-32s %14.3f %14.3f %14llu\n", entry.path().filename().u8string().c_str(), timing.import_ms, timing.cooked_ms, (unsigned long long)timing.cooked_size);
+        for (const FileManager::MeshReport& mesh : timing.meshes) {
+            const std::string mesh_name(mesh.name.begin(), mesh.name.end());
+            printf("  %-30s %8u verts %8u tris  idx%-2u  acmr %.3f -> %.3f  atvr %.3f -> %.3f\n", mesh_name.c_str(), mesh.vertices_num, mesh.triangles_num, mesh.index_size * 8,
+                mesh.before.acmr, mesh.after.acmr, mesh.before.atvr, mesh.after.atvr);
+            for (uint32_t lod = 0; lod < mesh.lod_triangles.size(); lod++) {
+                printf("    lod%u %8u tris\n", lod + 1, mesh.lod_triangles[lod]);
+            }
+        }
+    }
+}
+
+void HeadlessApplication::CookTextures()
+{
+    std::shared_ptr<FileManager> fm = m_frontend->GetFileManager().lock();
+    std::shared_ptr<ThreadPool> thread_pool = m_frontend->GetThreadPool().lock();
+    if (!fm || !thread_pool) {
+        return;
+    }
+
+    static const char* role_names[] = { "albedo", "normal", "mask" };
+    printf("%-32s %-7s %6s %12s %5s %14s %14s %9s %10s\n", "texture", "role", "format", "size", "mips", "source bytes", "cooked bytes", "psnr dB", "ms");
+    for (const FileManager::TextureReport& report : fm->CookTextures(*thread_pool)) {
+        const std::string name(report.name.begin(), report.name.end());
+        if (!report.cooked) {
+            printf("%-32s %-7s skipped\n", name.c_str(), role_names[(uint32_t)report.role]);
+            continue;
+        }
+        const std::string size = std::to_string(report.cook.width) + "x" + std::to_string(report.cook.height);
+        printf("%-32s %-7s %6u %12s %5u %14llu %14llu %9.2f %10.1f\n", name.c_str(), role_names[(uint32_t)report.role], (uint32_t)report.cook.format, size.c_str(), report.cook.mip_levels,
+            (unsigned long long)report.cook.source_size, (unsigned long long)report.cook.cooked_size, report.cook.psnr, report.ms);
+    }
+}
+
+void HeadlessApplication::CookLevels()
+{
+    std::shared_ptr<Level> level = m_frontend->GetLevel().lock();
+    if (!level) {
+        return;
+    }
+
+    const std::filesystem::path cooked_dir = level->GetLevelsDir().parent_path() / L"cooked" / L"levels";
+    printf("%-32s %10s %10s %12s %14s\n", "level", "entities", "defs", "source", "cooked bytes");
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(level->GetLevelsDir())) {
+        if (entry.path().extension() != L".json") {
+            continue;
+        }
+
+        const std::filesystem::path cooked_path = level_file::GetCookedPath(cooked_dir, entry.path().filename().wstring());
+        level_file::LevelDesc desc;
+        bool from_cooked = false;
+        bool cook_failed = false;
+        if (!level_file::Load(entry.path(), cooked_path, desc, &from_cooked, &cook_failed)) {
+            printf("%-32s failed\n", entry.path().filename().u8string().c_str());
+            continue;
+        }
+        if (cook_failed) {
+            printf("%-32s cook could not be written\n", entry.path().filename().u8string().c_str());
+        }
+        std::error_code ec;
+        const uint64_t cooked_size = std::filesystem::file_size(cooked_path, ec);
+        printf("%-32s %10u %10u %12s %14llu\n", entry.path().filename().u8string().c_str(), (uint32_t)desc.placements.size(), (uint32_t)desc.definitions.size(),
+            from_cooked ? "cooked" : "json", ec ? 0ull : (unsigned long long)cooked_size);
+    }
+}
+
+void HeadlessApplication::PrintTextureStats()
+{
+    std::shared_ptr<FileManager> fm = m_frontend->GetFileManager().lock();
+    if (!fm) {
+        return;
+    }
+
+    const TextureRegistry::Stats stats = fm->GetTextureStats();
+    printf("textures: cpu %llu bytes (peak %llu, budget %llu), gpu %llu bytes, %u evictions\n", (unsigned long long)stats.cpu_bytes, (unsigned long long)stats.cpu_peak_bytes,
+        (unsigned long long)stats.cpu_budget, (unsigned long long)stats.gpu_bytes, stats.evictions_num);
+    printf("  %-32s %5s %7s %14s %14s\n", "texture", "refs", "decodes", "cpu bytes", "gpu bytes");
+    for (const TextureRegistry::TextureStats& texture : stats.textures) {
+        const std::string name(texture.name.begin(), texture.name.end());
+        printf("  %-32s %5u %7u %14llu %14llu\n", name.c_str(), texture.ref_count, texture.decodes_num, (unsigned long long)texture.cpu_bytes, (unsigned long long)texture.gpu_bytes);
+    }
+}
+
+void HeadlessApplication::PackContent(const std::filesystem::path& root_dir, bool compress)
+{
+    using clock = std::chrono::steady_clock;
+    const clock::time_point start = clock::now();
+    VirtualFileSystem::PakReport report;
+    const bool packed = VirtualFileSystem::WritePak(root_dir / L"content.pak", root_dir, { L"content", L"shaders", std::filesystem::path(L"build") / L"src" / L"shaders" }, compress, &report);
+    const double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    if (!packed) {
+        printf("pack: failed\n");
+        return;
+    }
+    printf("pack: %u files (%u lz4), %llu bytes -> %llu bytes pak, %.1f ms\n", report.files_num, report.compressed_num, (unsigned long long)report.raw_size, (unsigned long long)report.pak_size, ms);
+}
+
+void HeadlessApplication::PrintFileStats()
+{
+    const VirtualFileSystem::Stats stats = VirtualFileSystem::Get().GetStats();
+    printf("files: %u mounts, pak %u opens %llu bytes, loose %u opens %llu bytes, %u misses\n", stats.mounts_num, stats.pak_opens, (unsigned long long)stats.pak_bytes,
+        stats.loose_opens, (unsigned long long)stats.loose_bytes, stats.misses);
+}
+
+void HeadlessApplication::BenchmarkVertexAssembly(uint32_t vertices_num)
+{
+    std::shared_ptr<ThreadPool> thread_pool = m_frontend->GetThreadPool().lock();
+    const uint32_t threads_num = thread_pool ? thread_pool->GetThreadsNum() : 1;
+
+    printf("vertex assembly: %u vertices, Mverts/s\n", vertices_num);
+    printf("%-8s %6s %12s %12s %16s\n", "layout", "bytes", "scalar", "simd", "simd x threads");
+    for (const vertex_assembly::BenchmarkResult& res : vertex_assembly::Benchmark(vertices_num, 5, thread_pool.get())) {
+        printf("vertex%-2u %6u %12.1f %12.1f %13.1f x%u\n", res.vertex_type, res.vertex_size, res.scalar_vps * 1e-6, res.simd_vps * 1e-6, res.parallel_vps * 1e-6, threads_num);
+    }
+}
+
+void HeadlessApplication::BenchmarkLevelParsing(uint32_t entities_num)
+{
+    printf("level parsing: synthetic levels up to %u entities, best of 5\n", entities_num);
+    printf("%10s %14s %10s %10s %14s %10s %12s %12s\n", "entities", "json bytes", "sax ms", "dom ms", "cooked bytes", "cooked ms", "sax ns/ent", "cooked ns/ent");
+    for (const level_file::BenchmarkResult& res : level_file::Benchmark(entities_num, 5)) {
+        printf("%10u %14llu %10.3f %10.3f %14llu %10.3f %12.1f %12.1f\n", res.entities_num, (unsigned long long)res.json_size, res.sax_ms, res.dom_ms,
+            (unsigned long long)res.cooked_size, res.cooked_ms, res.sax_ms * 1e6 / res.entities_num, res.cooked_ms * 1e6 / res.entities_num);
+    }
+}
+
+bool HeadlessApplication::BenchmarkPools(uint32_t ops_num)
+{
+    const std::vector<std::string> failures = pool_benchmark::Check();
+    for (const std::string& failure : failures) {
+        printf("generational_pool check FAILED: %s\n", failure.c_str());
+    }
+
+    printf("object pools: %u ops, ns per op, best of 5\n", ops_num);
+    printf("%-14s %10s %10s %14s\n", "operation", "ops", "simple", "generational");
+    for (const pool_benchmark::BenchmarkResult& res : pool_benchmark::Benchmark(ops_num, 5)) {
+        printf("%-14s %10u %10.2f %14.2f\n", res.operation, res.ops_num, res.simple_ns, res.generational_ns);
+    }
+
+    return failures.empty();
+}
+
+bool HeadlessApplication::BenchmarkAllocators(uint32_t ops_num)
+{
+    const std::vector<std::string> failures = allocator_benchmark::Check(ops_num);
+    for (const std::string& failure : failures) {
+        printf("allocator check FAILED: %s\n", failure.c_str());
+    }
+
+    printf("allocators: %u ops, ns per op, best of 5\n", ops_num);
+    printf("%-10s %10s %10s %10s %12s %14s %14s\n", "pattern", "ops", "first fit", "tlsf", "free blocks", "fragmentation", "high water");
+    for (const allocator_benchmark::BenchmarkResult& res : allocator_benchmark::Benchmark(ops_num, 5)) {
+        printf("%-10s %10u %10.2f %10.2f %12u %14.3f %14llu\n", res.pattern, res.ops_num, res.first_fit_ns, res.tlsf_ns, res.tlsf_free_blocks, res.tlsf_fragmentation,
+            (unsigned long long)res.tlsf_high_water);
+    }
+
+    return failures.empty();
+}
+
+bool HeadlessApplication::ReplayStreaming(uint32_t entities_num)
+{
+    const WorldPartition::Settings settings;
+    bool passed = true;
+    printf("streaming replay: %u entities, cell %.0f, load %.0f, unload %.0f, budget %llu MB\n", entities_num, settings.cell_size, settings.load_radius, settings.unload_radius,
+        (unsigned long long)(settings.memory_budget >> 20));
+    printf("%-10s %7s %7s %9s %8s %8s %8s %8s %8s %8s %8s\n", "path", "latency", "frames", "max cells", "peak MB", "loads", "unloads", "evicted", "missing", "stale", "thrash");
+    for (uint32_t latency : { 1u, 8u }) {
+        for (const WorldPartition::ReplayResult& res : WorldPartition::Replay(entities_num, settings, latency)) {
+            printf("%-10s %7u %7u %9u %8llu %8u %8u %8u %8u %8u %8u %s\n", res.path, latency, res.frames_num, res.max_loaded, (unsigned long long)(res.peak_bytes >> 20), res.loads_num,
+                res.unloads_num, res.evictions_num, res.missing_frames, res.stale_frames, res.thrash_num, res.passed ? "ok" : "FAILED");
+            passed &= res.passed;
+        }
+    }
+
+    return CheckUnloadResidency() && passed;
+}
+
+// cells of models with their own mesh and embedded texture go through MergeModel and ReleaseModelDeferred like the
+// level streamer's, more of them over the run than the mesh and texture pools can hold; once the frames in flight are
+// past a cell the pools have to be back where they were
+bool HeadlessApplication::CheckUnloadResidency()
+{
+    std::shared_ptr<FileManager> fm = m_frontend->GetFileManager().lock();
+    if (!fm) {
+        return false;
+    }
+
+    auto render_frames = [this](uint32_t frames_num) {
+        for (uint32_t frame = 0; frame < frames_num; frame++) {
+            m_frontend->OnUpdate();
+            m_frontend->OnRender();
+        }
+    };
+    constexpr uint32_t cells_num = 64;
+    constexpr uint32_t models_per_cell = 40;
+    const uint32_t retire_frames = m_frontend->GetFramesInFlight() + 1;
+
+    render_frames(retire_frames);
+    const FileManager::Residency baseline = fm->GetResidency();
+    FileManager::Residency loaded;
+    FileManager::Residency unloaded = baseline;
+    bool passed = true;
+    for (uint32_t cell = 0; cell < cells_num && passed; cell++) {
+        std::vector<RenderModel*> models;
+        for (uint32_t i = 0; i < models_per_cell; i++) {
+            const uint32_t id = cell * models_per_cell + i;
+            const std::wstring name = L"unload_check_" + std::to_wstring(id);
+            FileManager::ModelImport import;
+            import.nodes.resize(1);
+            import.nodes[0].name = name;
+            import.nodes[0].mesh = 0;
+            import.nodes[0].textures[RenderObject::DiffuseTexture] = name;
+
+            import.meshes.resize(1);
+            FileManager::ModelImport::Mesh& mesh = import.meshes[0];
+            mesh.name = name;
+            mesh.vertices = { { 0.f, 0.f, (float)id }, { 1.f, 0.f, (float)id }, { 0.f, 1.f, (float)id } };
+            mesh.indices16 = { 0, 1, 2 };
+            mesh.content_hash = 0x5eed000000000000ull | id;
+            mesh.UpdateStreams();
+
+            import.textures.resize(1);
+            FileManager::ModelImport::Texture& texture = import.textures[0];
+            texture.name = name;
+            texture.content_hash = 0x7e80000000000000ull | id;
+            texture.data.assign(2 * 2 * 4, uint8_t(id));
+            texture.image.data = texture.data.data();
+            texture.image.size = texture.data.size();
+            texture.image.width = 2;
+            texture.image.height = 2;
+
+            models.push_back(fm->MergeModel(import));
+        }
+        loaded = fm->GetResidency();
+
+        for (RenderModel* model : models) {
+            fm->ReleaseModelDeferred(model);
+        }
+        render_frames(retire_frames);
+        unloaded = fm->GetResidency();
+        passed = loaded.meshes_num == baseline.meshes_num + models_per_cell && loaded.textures_num == baseline.textures_num + models_per_cell &&
+            unloaded.models_num == baseline.models_num && unloaded.meshes_num == baseline.meshes_num && unloaded.mesh_bytes == baseline.mesh_bytes &&
+            unloaded.textures_num == baseline.textures_num && unloaded.texture_cpu_bytes <= baseline.texture_cpu_bytes;
+    }
+
+    printf("unload residency: %u cells of %u models, loaded %u models %u meshes %u textures, unloaded %u models %u meshes %llu mesh bytes %u textures %llu texture cpu bytes "
+        "(baseline %u models %u meshes %llu mesh bytes %u textures %llu texture cpu bytes)\n", cells_num, models_per_cell, loaded.models_num, loaded.meshes_num, loaded.textures_num,
+        unloaded.models_num, unloaded.meshes_num, (unsigned long long)unloaded.mesh_bytes, unloaded.textures_num, (unsigned long long)unloaded.texture_cpu_bytes,
+        baseline.models_num, baseline.meshes_num, (unsigned long long)baseline.mesh_bytes, baseline.textures_num, (unsigned long long)baseline.texture_cpu_bytes);
+    if (!passed) {
+        fprintf(stderr, "UNLOAD RESIDENCY: meshes and textures of an unloaded cell are expected to leave the pools\n");
+    }
+    return passed;
+}
+
+void HeadlessApplication::PrintStreamingStats()
+{
+    std::shared_ptr<Level> level = m_frontend->GetLevel().lock();
+    const LevelStreamer* streamer = level ? level->GetStreamer() : nullptr;
+    if (!streamer) {
+        return;
+    }
+
+    const WorldPartition::Stats& partition = streamer->GetPartition().GetStats();
+    const LevelStreamer::Stats& stats = streamer->GetStats();
+    printf("streaming: %u/%u cells resident, %u entities, %llu bytes (peak %llu), %u loads, %u unloads, %u evictions, %u failures, last prepare %.2f ms, merge %.2f ms\n",
+        stats.resident_cells, partition.cells_num, stats.entities_num, (unsigned long long)partition.resident_bytes, (unsigned long long)partition.peak_bytes, partition.loads_num,
+        partition.unloads_num, partition.evictions_num, stats.failures_num, stats.last_prepare_ms, stats.last_merge_ms);
+}
+
+void HeadlessApplication::PrintVertexStorageStats()
+{
+    std::shared_ptr<GpuDataManager> gpu_data_mgr = m_frontend->GetGpuDataManager().lock();
+    if (!gpu_data_mgr) {
+        return;
+    }
+
+    const pro_game_containers::tlsf_allocator::stats stats = gpu_data_mgr->GetVertexStorageStats();
+    printf("vertex storage: %u allocations, %llu bytes used (high water %llu) of %llu in %u pages, %u free blocks, largest %llu, fragmentation %.3f\n",
+        stats.allocations_num, (unsigned long long)stats.used_bytes, (unsigned long long)stats.high_water, (unsigned long long)stats.capacity, stats.pages_num,
+        stats.free_blocks_num, (unsigned long long)stats.largest_free, stats.fragmentation());
+
+    const GpuDataManager::UploadStats& upload = gpu_data_mgr->GetUploadStats();
+    const pro_game_containers::ring_allocator::stats staging = gpu_data_mgr->GetStagingStats();
+    printf("vertex upload: %llu bytes in %u ranges last frame, %llu bytes in %u ranges total, staging ring high water %llu of %llu\n",
+        (unsigned long long)upload.frame_bytes, upload.frame_ranges, (unsigned long long)upload.total_bytes, upload.total_ranges,
+        (unsigned long long)staging.high_water, (unsigned long long)staging.capacity);
+}
+
+// a fresh block goes up whole, a 1 KB edit inside it as 1 KB, two touching edits as one range and a free as nothing
+bool HeadlessApplication::CheckIncrementalUpload()
+{
+    std::shared_ptr<GpuDataManager> gpu_data_mgr = m_frontend->GetGpuDataManager().lock();
+    if (!gpu_data_mgr) {
+        return false;
+    }
+
+    auto render_frame = [this, &gpu_data_mgr]() {
+        m_frontend->OnUpdate();
+        m_frontend->OnRender();
+        return gpu_data_mgr->GetUploadStats();
+    };
+    constexpr uint32_t block_size = 64 * 1024;
+    constexpr uint32_t edit_size = 1024;
+
+    render_frame();
+    const uint64_t start = gpu_data_mgr->AllocateVertexBuffer(block_size);
+    memset(gpu_data_mgr->GetVertexData(start), 0x11, block_size);
+    const GpuDataManager::UploadStats whole = render_frame();
+
+    memset(gpu_data_mgr->GetVertexData(start + 4096), 0x22, edit_size);
+    gpu_data_mgr->MarkDirty(start + 4096, edit_size);
+    const GpuDataManager::UploadStats edit = render_frame();
+    const uint64_t copy_bytes = gBackend->GetLastFrameStats().buffer_copy_bytes;
+
+    gpu_data_mgr->MarkDirty(start, edit_size / 2);
+    gpu_data_mgr->MarkDirty(start + edit_size / 2, edit_size / 2);
+    const GpuDataManager::UploadStats merged = render_frame();
+
+    gpu_data_mgr->DeallocateVertexBuffer(start, block_size);
+    const GpuDataManager::UploadStats freed = render_frame();
+
+    printf("incremental upload: new %u byte block %llu bytes, %u byte edit %llu bytes in %u ranges (%llu copied), two touching edits %u ranges, free %llu bytes\n",
+        block_size, (unsigned long long)whole.frame_bytes, edit_size, (unsigned long long)edit.frame_bytes, edit.frame_ranges, (unsigned long long)copy_bytes,
+        merged.frame_ranges, (unsigned long long)freed.frame_bytes);
+    const bool passed = whole.frame_bytes >= block_size && edit.frame_bytes == edit_size && edit.frame_ranges == 1 && copy_bytes == edit_size &&
+        merged.frame_bytes == edit_size && merged.frame_ranges == 1 && freed.frame_bytes == 0;
+    if (!passed) {
+        fprintf(stderr, "INCREMENTAL UPLOAD: a change is expected to upload only its own bytes\n");
+    }
+    return passed;
+}
+
+bool HeadlessApplication::CheckTextures()
+{
+    std::vector<texture_check::CodecResult> codecs;
+    const std::vector<std::string> failures = texture_check::Check(codecs);
+    for (const std::string& failure : failures) {
+        printf("texture check FAILED: %s\n", failure.c_str());
+    }
+
+    printf("block codecs: round trip psnr dB\n");
+    for (const texture_check::CodecResult& codec : codecs) {
+        printf("  %-6s %8.2f  floor %6.2f\n", codec.format, codec.psnr, codec.floor);
+    }
+
+    return failures.empty();
+}
+
+void HeadlessApplication::PrintModelConstantsStats()
+{
+    const pro_game_containers::ring_allocator::stats stats = m_frontend->GetModelRingStats();
+    printf("model constants: %u draws, %llu bytes last frame, %llu bytes in %u frames in flight (high water %llu) of %llu in the ring\n",
+        stats.last_frame_allocations, (unsigned long long)stats.last_frame_bytes, (unsigned long long)stats.used_bytes, stats.frames_in_flight,
+        (unsigned long long)stats.high_water, (unsigned long long)stats.capacity);
+}
+
+bool HeadlessApplication::CheckFrameAllocations(uint32_t frames_num, uint64_t allocs_num, uint64_t max_frame_allocs)
+{
+    if (!alloc_counter::enabled) {
+        fprintf(stderr, "FRAME ALLOCATIONS NOT CHECKED: operator new is only counted in builds with DX12LIB_COUNT_ALLOCS\n");
+        return false;
+    }
+    const FrameArena::Stats& arena = FrameArena::Get().GetStats();
+    printf("frame allocations: %llu operator new calls on the render thread over %u steady frames (max %llu per frame), frame arena high water %llu bytes in %u chunks\n",
+        (unsigned long long)allocs_num, frames_num, (unsigned long long)max_frame_allocs, (unsigned long long)arena.high_water, arena.chunks_num);
+    if (!frames_num) {
+        fprintf(stderr, "FRAME ALLOCATIONS NOT CHECKED: --frames has to be past the warm-up\n");
+        return false;
+    }
+    if (allocs_num) {
+        fprintf(stderr, "FRAME ALLOCATIONS: steady frames are expected to allocate nothing\n");
+        return false;
+    }
+    return true;
+}
+
+bool HeadlessApplication::PrintStartupProfile(uint32_t budget_ms)
+{
+    const StartupProfiler& profiler = StartupProfiler::Get();
+    const std::vector<StartupProfiler::Scope> scopes = profiler.GetScopes();
+
+    // phases down to the level and backend internals, then the assets that cost the most on their own
+    printf("startup ms: total %.3f\n", profiler.GetTotalMs());
+    for (const StartupProfiler::Scope& scope : scopes) {
+        if (scope.thread == 0 && scope.depth <= 1 && scope.asset.empty()) {
+            printf("  %*s%-*s %10.3f  self %10.3f\n", scope.depth * 2, "", 24 - scope.depth * 2, scope.name.c_str(), scope.duration_ms, scope.self_ms);
+        }
+    }
+    std::vector<const StartupProfiler::Scope*> assets;
+    for (const StartupProfiler::Scope& scope : scopes) {
+        if (!scope.asset.empty()) {
+            assets.push_back(&scope);
+        }
+    }
+    const size_t top_num = std::min<size_t>(assets.size(), 8);
+    std::partial_sort(assets.begin(), assets.begin() + top_num, assets.end(), [](const StartupProfiler::Scope* a, const StartupProfiler::Scope* b) { return a->self_ms > b->self_ms; });
+    for (size_t i = 0; i < top_num; i++) {
+        printf("  %-16s %10.3f  %s\n", assets[i]->name.c_str(), assets[i]->self_ms, assets[i]->asset.c_str());
+    }
+
+    if (budget_ms && profiler.GetTotalMs() > budget_ms) {
+        fprintf(stderr, "STARTUP BUDGET EXCEEDED: %.3f ms, budget %u ms (see startup_profile.json, startup_trace.json)\n", profiler.GetTotalMs(), budget_ms);
+        return false;
+    }
+    return true;
+}
+
+int HeadlessApplication::Run(const HeadlessOptions& options)
+{
+    const uint32_t frames = options.frames;
+    using clock = std::chrono::steady_clock;
+
+    // find absolute path, same layout as on windows: <root>/build/src/<exe>
+    std::filesystem::path root_dir = std::filesystem::canonical("/proc/self/exe").parent_path().parent_path().parent_path();
+
+    // the pak is mounted by OnInit, so this run already loads from it
+    if (options.pack) {
+        PackContent(root_dir, options.pack_lz4);
+    }
+
+    WindowHandler w_hndl{ 0 };
+    const clock::time_point init_start = clock::now();
+    m_frontend->OnInit(w_hndl, root_dir);
+    const std::chrono::duration<double, std::milli> init_time = clock::now() - init_start;
+
+    int exit_code = 0;
+    if (!PrintStartupProfile(options.startup_budget_ms)) {
+        exit_code = 1;
+    }
+
+    if (options.cook) {
+        CookModels();
+        CookTextures();
+        CookLevels();
+    }
+
+    if (options.bench_vertices) {
+        BenchmarkVertexAssembly(options.bench_vertices);
+    }
+
+    if (options.bench_level) {
+        BenchmarkLevelParsing(options.bench_level);
+    }
+
+    if (options.bench_pool && !BenchmarkPools(options.bench_pool)) {
+        exit_code = 1;
+    }
+
+    if (options.bench_alloc && !BenchmarkAllocators(options.bench_alloc)) {
+        exit_code = 1;
+    }
+
+    if (options.stream_replay && !ReplayStreaming(options.stream_replay)) {
+        exit_code = 1;
+    }
+
+    if (options.check_textures && !CheckTextures()) {
+        exit_code = 1;
+    }
+
+    double total_ms = 0.0;
+    double min_ms = 0.0;
+    double max_ms = 0.0;
+    // the first frames upload textures, create render targets and grow the frame arena
+    const uint32_t warmup_frames = m_frontend->GetFramesInFlight() + 8;
+    uint64_t steady_allocs = 0;
+    uint64_t max_frame_allocs = 0;
+    alloc_counter::SetCounting(options.check_frame_allocs);
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        const clock::time_point frame_start = clock::now();
+        const uint64_t allocs_start = alloc_counter::GetThreadAllocs();
+        m_frontend->OnUpdate();
+        m_frontend->OnRender();
+        const double frame_ms = std::chrono::duration<double, std::milli>(clock::now() - frame_start).count();
+        if (frame >= warmup_frames) {
+            const uint64_t frame_allocs = alloc_counter::GetThreadAllocs() - allocs_start;
+            steady_allocs += frame_allocs;
+            max_frame_allocs = std::max(max_frame_allocs, frame_allocs);
+        }
+
+        total_ms += frame_ms;
+        min_ms = (frame == 0) ? frame_ms : std::min(min_ms, frame_ms);
+        max_ms = std::max(max_ms, frame_ms);
+    }
+    alloc_counter::SetCounting(false);
+
+    const NullBackendStats& total = gBackend->GetTotalStats();
+    const NullBackendStats& last = gBackend->GetLastFrameStats();
+    const double avg_ms = frames ? total_ms / frames : 0.0;
+
+    printf("headless: init %.3f ms, %u frames\n", init_time.count(), frames);
+    PrintFileStats();
+    PrintVertexStorageStats();
+    PrintModelConstantsStats();
+    if (std::shared_ptr<Level> level = m_frontend->GetLevel().lock()) {
+        const Level::LoadTimings& timings = level->GetLoadTimings();
+        printf("level load ms: total %.3f on %u threads\n", timings.total_ms, timings.threads_num);
+        printf("  %-12s %10.3f  %s\n", "parse", timings.parse_ms, timings.cooked ? "cooked" : "json");
+        printf("  %-12s %10.3f  %u definitions, %u entities\n", "definitions", timings.definitions_ms, timings.definitions_num, timings.entities_num);
+        printf("  %-12s %10.3f  %u models\n", "import", timings.import_ms, timings.models_num);
+        printf("  %-12s %10.3f  %u textures\n", "textures", timings.textures_ms, timings.textures_num);
+        printf("  %-12s %10.3f\n", "merge", timings.merge_ms);
+    }
+    printf("cpu frame ms: avg %.4f min %.4f max %.4f\n", avg_ms, min_ms, max_ms);
+    printf("%-24s %14s %16s\n", "counter", "last frame", "total");
+    auto print_row = [](const char* name, uint64_t frame_val, uint64_t total_val) {
+        printf("%-24s %14llu %16llu\n", name, (unsigned long long)frame_val, (unsigned long long)total_val);
+    };
+    print_row("draw_calls", last.draw_calls, total.draw_calls);
+    print_row("indices", last.indices, total.indices);
+    print_row("vertices", last.vertices, total.vertices);
+    print_row("dispatches", last.dispatches, total.dispatches);
+    print_row("barriers", last.barriers, total.barriers);
+    print_row("root_cbv_binds", last.root_cbv_binds, total.root_cbv_binds);
+    print_row("root_srv_binds", last.root_srv_binds, total.root_srv_binds);
+    print_row("descriptor_tables", last.descriptor_tables, total.descriptor_tables);
+    print_row("descriptors_staged", last.descriptors_staged, total.descriptors_staged);
+    print_row("render_target_sets", last.render_target_sets, total.render_target_sets);
+    print_row("clears", last.clears, total.clears);
+    print_row("pso_changes", last.pso_changes, total.pso_changes);
+    print_row("root_sign_changes", last.root_sign_changes, total.root_sign_changes);
+    print_row("command_lists_executed", last.command_lists_executed, total.command_lists_executed);
+    print_row("buffer_upload_bytes", last.buffer_upload_bytes, total.buffer_upload_bytes);
+    print_row("buffer_copies", last.buffer_copies, total.buffer_copies);
+    print_row("buffer_copy_bytes", last.buffer_copy_bytes, total.buffer_copy_bytes);
+    print_row("texture_upload_bytes", last.texture_upload_bytes, total.texture_upload_bytes);
+    print_row("resources_created", last.resources_created, total.resources_created);
+    print_row("resource_bytes_created", last.resource_bytes_created, total.resource_bytes_created);
+    PrintTextureStats();
+    if (const HotReloader* hot_reloader = m_frontend->GetHotReloader()) {
+        const HotReloader::Stats& stats = hot_reloader->GetStats();
+        printf("hot reload (%s): %u changes, %u models, %u textures, %u definitions, %u levels, %u instances swapped, %u failed, last swap %.3f ms\n",
+            hot_reloader->IsNative() ? "inotify" : "polling", stats.changes_num, stats.models_num, stats.textures_num, stats.definitions_num, stats.levels_num,
+            stats.instances_num, stats.failures_num, stats.last_swap_ms);
+    }
+    PrintStreamingStats();
+    if (options.check_frame_allocs && !CheckFrameAllocations(frames > warmup_frames ? frames - warmup_frames : 0, steady_allocs, max_frame_allocs)) {
+        exit_code = 1;
+    }
+    if (options.check_upload && !CheckIncrementalUpload()) {
+        exit_code = 1;
+    }
+
+    m_frontend->OnDestroy();
+
+    return exit_code;
+}
+
+#endif // WIN32
@@ -0,0 +1,58 @@
+#pragma once
+
+#ifndef WIN32
+
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <filesystem>
+
+class Frontend;
+
+struct HeadlessOptions {
+    uint32_t frames{ 100 };
+    bool cook{ false };
+    uint32_t bench_vertices{ 0 }; // synthetic vertex count for the vertex assembly benchmark, 0 skips it
+    uint32_t bench_level{ 0 }; // entities in the largest synthetic level for the level parsing benchmark, 0 skips it
+    uint32_t bench_pool{ 0 }; // random erases, inserts and lookups for the object pool benchmark, 0 skips it and the pool checks
+    uint32_t bench_alloc{ 0 }; // random allocations and deallocations for the vertex storage allocator benchmark and stress check, 0 skips both
+    uint32_t stream_replay{ 0 }; // entities of the synthetic world the streaming scheduler replays camera paths over, 0 skips it
+    bool check_frame_allocs{ false }; // fails the run when a frame after the warm-up calls operator new on the render thread
+    bool check_upload{ false }; // fails the run when a small vertex storage change is not uploaded as just that range
+    bool check_textures{ false }; // fails the run when the image decoders or block codecs miss their fixtures or PSNR floors
+    uint32_t startup_budget_ms{ 0 }; // OnInit taking longer fails the run, 0 only reports
+    bool pack{ false }; // content, shaders and shader binaries into <root>/content.pak before loading
+    bool pack_lz4{ false };
+};
+
+// runs the frontend frame loop on the null backend, no window and no gpu
+class HeadlessApplication {
+public:
+    HeadlessApplication(uint32_t width, uint32_t height, const std::wstring& window_name);
+    ~HeadlessApplication();
+    int Run(const HeadlessOptions& options);
+private:
+    void CookModels();
+    void CookTextures();
+    void CookLevels();
+    void PackContent(const std::filesystem::path& root_dir, bool compress);
+    void PrintFileStats();
+    void PrintTextureStats();
+    void BenchmarkVertexAssembly(uint32_t vertices_num);
+    void BenchmarkLevelParsing(uint32_t entities_num);
+    bool BenchmarkPools(uint32_t ops_num);
+    bool BenchmarkAllocators(uint32_t ops_num);
+    bool ReplayStreaming(uint32_t entities_num);
+    bool CheckUnloadResidency();
+    void PrintStreamingStats();
+    void PrintVertexStorageStats();
+    void PrintModelConstantsStats();
+    bool PrintStartupProfile(uint32_t budget_ms);
+    bool CheckFrameAllocations(uint32_t frames_num, uint64_t allocs_num, uint64_t max_frame_allocs);
+    bool CheckIncrementalUpload();
+    bool CheckTextures();
+
+    std::unique_ptr<Frontend> m_frontend;
+};
+
+#endif // WIN32
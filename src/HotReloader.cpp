@@ -0,0 +1,344 @@
+#include "HotReloader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+#include "Frontend.h"
+#include "ICommandQueue.h"
+#include "Logger.h"
+#include "VirtualFileSystem.h"
+
+extern Frontend* gFrontend;
+
+HotReloader::~HotReloader()
+{
+    Stop();
+}
+
+bool HotReloader::Start(const std::filesystem::path& content_dir, logger* log, FileWatcher::Mode mode)
+{
+    Stop();
+
+    m_content_dir = content_dir;
+    m_log = log;
+    if (!m_watcher.Start(content_dir, mode)) {
+        return false;
+    }
+
+    m_stop = false;
+    m_worker = std::thread(&HotReloader::WorkerLoop, this);
+
+    return true;
+}
+
+void HotReloader::Stop()
+{
+    m_watcher.Stop();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_jobs.clear();
+    }
+    m_cv.notify_all();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+    m_results.clear();
+}
+
+void HotReloader::Update()
+{
+    std::shared_ptr<Level> level = gFrontend->GetLevel().lock();
+    std::shared_ptr<FileManager> file_mgr = gFrontend->GetFileManager().lock();
+    if (!level || !file_mgr || !m_worker.joinable()) {
+        return;
+    }
+
+    std::vector<Job> jobs;
+    for (const std::filesystem::path& path : m_watcher.TakeChanges()) {
+        m_stats.changes_num++;
+        Job job;
+        if (Classify(path, *level, *file_mgr, job)) {
+            // the edited loose file is the truth now, even with a pak mounted
+            VirtualFileSystem::Get().PreferLoose(path);
+            jobs.push_back(std::move(job));
+        }
+    }
+    if (!jobs.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (Job& job : jobs) {
+                m_jobs.push_back(std::move(job));
+            }
+        }
+        m_cv.notify_one();
+    }
+
+    std::vector<std::unique_ptr<Result>> results;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        results.swap(m_results);
+    }
+    if (results.empty()) {
+        return;
+    }
+
+    // frames in flight may still read what gets replaced
+    const std::chrono::steady_clock::time_point swap_start = std::chrono::steady_clock::now();
+    gFrontend->GetGfxQueue()->Flush();
+    gFrontend->GetComputeQueue()->Flush();
+    for (std::unique_ptr<Result>& result : results) {
+        Apply(*result, *level, *file_mgr);
+    }
+    m_stats.last_swap_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - swap_start).count();
+}
+
+const HotReloader::Stats& HotReloader::GetStats() const
+{
+    return m_stats;
+}
+
+bool HotReloader::Classify(const std::filesystem::path& path, Level& level, FileManager& file_mgr, Job& job) const
+{
+    const std::filesystem::path rel = path.lexically_relative(m_content_dir);
+    if (rel.empty() || *rel.begin() == L"cooked") {
+        return false;
+    }
+
+    const std::wstring filename = path.filename().wstring();
+    const uint32_t entities_num = level.GetEntitiesNum();
+    std::unordered_set<std::wstring> loaded_models;
+    job.path = path;
+    job.entities_dir = level.GetEntitiesDir();
+    for (uint32_t id = 0; id < entities_num; id++) {
+        job.entity_definitions.push_back(level.GetEntity(id).GetDefinitionName());
+        loaded_models.insert(level.GetEntity(id).GetModelName());
+    }
+
+    if (path.parent_path() == level.GetLevelsDir() && filename == level.GetName()) {
+        job.type = AssetType::at_level;
+        job.name = filename;
+        job.cached_definitions = level.GetDefinitions();
+        // placements of a streamed level belong to its cells, they change with the next load
+        return !level.GetStreamer();
+    }
+
+    if (path.parent_path() == level.GetEntitiesDir()) {
+        job.type = AssetType::at_definition;
+        job.name = filename;
+        return std::find(job.entity_definitions.begin(), job.entity_definitions.end(), filename) != job.entity_definitions.end();
+    }
+
+    const std::filesystem::path model_rel = path.lexically_relative(file_mgr.GetModelDir());
+    if (!model_rel.empty() && *model_rel.begin() != L".." && file_mgr.IsModelSupported(path)) {
+        job.type = AssetType::at_model;
+        job.name = model_rel.wstring();
+        return loaded_models.count(job.name) != 0;
+    }
+
+    job.type = AssetType::at_texture;
+    job.name = filename;
+    return file_mgr.IsTextureInUse(filename);
+}
+
+void HotReloader::WorkerLoop()
+{
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+            if (m_stop) {
+                return;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        std::unique_ptr<Result> result = std::make_unique<Result>();
+        result->job = std::move(job);
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        Prepare(*result);
+        result->prepare_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_results.push_back(std::move(result));
+    }
+}
+
+void HotReloader::Prepare(Result& result)
+{
+    std::shared_ptr<FileManager> file_mgr = gFrontend->GetFileManager().lock();
+    std::shared_ptr<Level> level = gFrontend->GetLevel().lock();
+    if (!file_mgr || !level) {
+        return;
+    }
+
+    const Job& job = result.job;
+    switch (job.type) {
+    case AssetType::at_model: {
+        std::unique_ptr<FileManager::ModelImport> import = file_mgr->ImportModel(job.name);
+        result.ok = !import->nodes.empty(); // a file caught half written does not import
+        result.imports.emplace(job.name, std::move(import));
+        break;
+    }
+    case AssetType::at_texture:
+        result.ok = file_mgr->DecodeTextureFile(job.name, result.image);
+        break;
+    case AssetType::at_definition:
+        result.ok = PrepareDefinition(job.name, result);
+        break;
+    case AssetType::at_level:
+        result.ok = level->ReadDesc(result.desc);
+        for (uint32_t i = 0; result.ok && i < result.desc.placements.size(); i++) {
+            // entities keeping their definition only move
+            const std::wstring& definition = result.desc.definitions[result.desc.placements[i].definition];
+            if (i >= job.entity_definitions.size() || job.entity_definitions[i] != definition) {
+                result.ok = PrepareDefinition(definition, result);
+            }
+        }
+        break;
+    }
+}
+
+bool HotReloader::PrepareDefinition(const std::wstring& definition, Result& result)
+{
+    if (result.definitions.count(definition)) {
+        return true;
+    }
+
+    LevelEntity entity;
+    const auto cached = result.job.cached_definitions.find(definition);
+    if (cached != result.job.cached_definitions.end()) {
+        entity.CopyDefinition(cached->second);
+    }
+    else if (!entity.ReadDefinition(result.job.entities_dir / definition)) {
+        return false;
+    }
+
+    // entities switching model and new ones merge a fresh copy, so the model is imported even when already loaded
+    const std::wstring& model_name = entity.GetModelName();
+    if (!result.imports.count(model_name)) {
+        std::shared_ptr<FileManager> file_mgr = gFrontend->GetFileManager().lock();
+        std::unique_ptr<FileManager::ModelImport> import = file_mgr->ImportModel(model_name);
+        if (import->nodes.empty()) {
+            return false;
+        }
+        result.imports.emplace(model_name, std::move(import));
+    }
+    result.definitions.emplace(definition, std::move(entity));
+
+    return true;
+}
+
+void HotReloader::Apply(Result& result, Level& level, FileManager& file_mgr)
+{
+    const Job& job = result.job;
+    const std::string name(job.path.filename().u8string());
+    m_stats.last_prepare_ms = result.prepare_ms;
+    if (!result.ok) {
+        m_stats.failures_num++;
+        if (m_log) {
+            m_log->hlog(logger::ll_WARNING, "hot reload: %s did not load, keeping the old version", name.c_str());
+        }
+        return;
+    }
+
+    uint32_t instances_num = 0;
+    const uint32_t entities_num = level.GetEntitiesNum();
+    switch (job.type) {
+    case AssetType::at_model:
+        m_stats.models_num++;
+        for (uint32_t id = 0; id < entities_num; id++) {
+            LevelEntity& entity = level.GetEntity(id);
+            if (entity.GetModelName() == job.name) {
+                SwapModel(entity, *result.imports[job.name], file_mgr);
+                instances_num++;
+            }
+        }
+        break;
+    case AssetType::at_texture:
+        m_stats.textures_num++;
+        instances_num = file_mgr.ReloadTexture(job.name, std::move(result.image));
+        break;
+    case AssetType::at_definition:
+        m_stats.definitions_num++;
+        level.CacheDefinition(result.definitions.at(job.name));
+        for (uint32_t id = 0; id < entities_num; id++) {
+            LevelEntity& entity = level.GetEntity(id);
+            if (entity.GetDefinitionName() == job.name) {
+                ApplyDefinition(entity, result.definitions.at(job.name), result, file_mgr);
+                instances_num++;
+            }
+        }
+        break;
+    case AssetType::at_level: {
+        m_stats.levels_num++;
+        for (const auto& definition : result.definitions) {
+            level.CacheDefinition(definition.second);
+        }
+        uint32_t skipped_num = 0;
+        for (uint32_t i = 0; i < result.desc.placements.size(); i++) {
+            const level_file::Placement& placement = result.desc.placements[i];
+            const std::wstring& definition = result.desc.definitions[placement.definition];
+            if (i < entities_num) {
+                LevelEntity& entity = level.GetEntity(i);
+                if (entity.GetDefinitionName() != definition) {
+                    ApplyDefinition(entity, result.definitions.at(definition), result, file_mgr);
+                    instances_num++;
+                }
+                entity.SetPos(placement.pos);
+                entity.SetRot(placement.rot);
+                entity.SetScale(placement.scale);
+            }
+            else if (level.GetEntitiesNum() >= Level::entities_num) {
+                skipped_num++;
+            }
+            else {
+                LevelEntity entity(placement.pos, placement.rot, placement.scale);
+                entity.CopyDefinition(result.definitions.at(definition));
+                entity.Setup(file_mgr.MergeModel(*result.imports.at(entity.GetModelName())));
+                level.AddEntity(entity);
+                instances_num++;
+            }
+        }
+        // the entity pool cannot shrink
+        if (result.desc.placements.size() < entities_num && m_log) {
+            m_log->hlog(logger::ll_WARNING, "hot reload: %u entities removed from %s stay until the level loads again",
+                entities_num - (uint32_t)result.desc.placements.size(), name.c_str());
+        }
+        // nor grow past its capacity
+        if (skipped_num && m_log) {
+            m_log->hlog(logger::ll_WARNING, "hot reload: %u entities added to %s do not fit the %u entity pool and are skipped",
+                skipped_num, name.c_str(), Level::entities_num);
+        }
+        break;
+    }
+    }
+    m_stats.instances_num += instances_num;
+
+    if (m_log) {
+        m_log->hlog(logger::ll_INFO, "hot reload: %s, %u instances swapped, prepared in %.2f ms", name.c_str(), instances_num, result.prepare_ms);
+    }
+}
+
+void HotReloader::ApplyDefinition(LevelEntity& entity, const LevelEntity& definition, Result& result, FileManager& file_mgr)
+{
+    const bool model_changed = entity.GetModelName() != definition.GetModelName();
+    entity.CopyDefinition(definition);
+    if (model_changed) {
+        SwapModel(entity, *result.imports.at(entity.GetModelName()), file_mgr);
+    }
+    else {
+        // technique, color and material only
+        entity.Setup(entity.GetModel());
+    }
+}
+
+void HotReloader::SwapModel(LevelEntity& entity, const FileManager::ModelImport& import, FileManager& file_mgr)
+{
+    // merged before the old tree goes, so the textures and meshes both trees use stay resident
+    RenderModel* old_model = entity.GetModel();
+    entity.Setup(file_mgr.MergeModel(import));
+    file_mgr.ReleaseModel(old_model);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <filesystem>
+#include "FileWatcher.h"
+#include "FileManager.h"
+#include "Level.h"
+
+class logger;
+
+// Reloads content files edited while running. Changed models, textures, entity definitions and the level file are
+// re-imported or decoded on a background thread; the results are swapped in at the next frame boundary, after the
+// queues drained, into the entities and models using them only. Cooked output is ignored, the importers write it.
+class HotReloader {
+public:
+    struct Stats {
+        uint32_t changes_num{ 0 }; // files the watcher reported, used or not
+        uint32_t models_num{ 0 };
+        uint32_t textures_num{ 0 };
+        uint32_t definitions_num{ 0 };
+        uint32_t levels_num{ 0 };
+        uint32_t instances_num{ 0 }; // entities and texture slots swapped
+        uint32_t failures_num{ 0 };
+        double last_prepare_ms{ 0.0 }; // background
+        double last_swap_ms{ 0.0 }; // frame boundary
+    };
+
+    HotReloader() = default;
+    HotReloader(const HotReloader&) = delete;
+    HotReloader& operator=(const HotReloader&) = delete;
+    ~HotReloader();
+
+    bool Start(const std::filesystem::path& content_dir, logger* log, FileWatcher::Mode mode = FileWatcher::Mode::fw_auto);
+    void Stop();
+    bool IsNative() const { return m_watcher.IsNative(); }
+
+    // main thread, between frames: queues what changed and swaps in what the worker finished
+    void Update();
+    const Stats& GetStats() const;
+
+private:
+    enum class AssetType { at_model, at_texture, at_definition, at_level };
+
+    struct Job {
+        AssetType type{ AssetType::at_model };
+        std::filesystem::path path;
+        std::wstring name; // model name, texture or definition file name
+        std::filesystem::path entities_dir;
+        std::vector<std::wstring> entity_definitions; // per entity when queued
+        std::unordered_map<std::wstring, LevelEntity> cached_definitions; // level jobs only, unchanged files are not read again
+    };
+
+    struct Result {
+        Job job;
+        bool ok{ false };
+        image_decoder::Image image;
+        level_file::LevelDesc desc;
+        std::unordered_map<std::wstring, LevelEntity> definitions;
+        std::unordered_map<std::wstring, std::unique_ptr<FileManager::ModelImport>> imports; // by model name
+        double prepare_ms{ 0.0 };
+    };
+
+    bool Classify(const std::filesystem::path& path, Level& level, FileManager& file_mgr, Job& job) const;
+    void WorkerLoop();
+    void Prepare(Result& result);
+    bool PrepareDefinition(const std::wstring& definition, Result& result);
+    void Apply(Result& result, Level& level, FileManager& file_mgr);
+    void ApplyDefinition(LevelEntity& entity, const LevelEntity& definition, Result& result, FileManager& file_mgr);
+    void SwapModel(LevelEntity& entity, const FileManager::ModelImport& import, FileManager& file_mgr);
+
+    FileWatcher m_watcher;
+    std::filesystem::path m_content_dir;
+    logger* m_log{ nullptr };
+
+    std::thread m_worker;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Job> m_jobs;
+    std::vector<std::unique_ptr<Result>> m_results;
+    bool m_stop{ false };
+    Stats m_stats;
+};
@@ -1,21 +1,13 @@
 #include "Level.h"
 
-#if defined(min)
-#undef min
-#endif
- 
-#if defined(max)
-#undef max
-#endif
-
-#include <rapidjson/document.h>
-#include <rapidjson/writer.h>
-#include <rapidjson/stringbuffer.h>
-#include <fstream>
+#include <cassert>
+#include <chrono>
+#include <unordered_map>
 
 #include "defines.h"
 #include "FreeCamera.h"
 #include "FileManager.h"
+#include "VirtualFileSystem.h"
 #include "IGpuResource.h"
 #include "RenderHelper.h"
 #include "ITechniques.h"
@@ -30,155 +22,202 @@
 #include "ICommandList.h"
 #include "ICommandQueue.h"
 #include "Frontend.h"
+#include "ThreadPool.h"
+#include "LevelStreamer.h"
+#include "StartupProfiler.h"
+#include "Logger.h"
 
 extern Frontend *gFrontend;
-using rapidjson::Document;
-using rapidjson::Value;
 
 Level::Level()
 {
     m_levels_dir = gFrontend->GetRootDir() / L"content" / L"levels";
     m_entities_dir = gFrontend->GetRootDir() / L"content" / L"entities";
+    m_cooked_dir = gFrontend->GetRootDir() / L"content" / L"cooked" / L"levels";
 }
 Level::~Level() = default;
 
 void Level::Load(const std::wstring& name) {
+    using clock = std::chrono::steady_clock;
+    auto ms_since = [](clock::time_point start) { return std::chrono::duration<double, std::milli>(clock::now() - start).count(); };
+    const clock::time_point load_start = clock::now();
+    m_load_timings = LoadTimings{};
     m_name = name;
-
-    // read file
-    std::string content;
-    {
-        const std::filesystem::path fullPath = (m_levels_dir / name);
-        std::ifstream ifs(fullPath.string().c_str());
-        content.assign((std::istreambuf_iterator<char>(ifs)), (std::istreambuf_iterator<char>()));
+    m_definitions.clear();
+    StartupProfiler& profiler = StartupProfiler::Get();
+    uint32_t phase = profiler.Begin("level parse", &name);
+
+    // read file: the cooked copy when it is fresh, otherwise streamed through the SAX parser and cooked for next time
+    level_file::LevelDesc desc;
+    const std::filesystem::path cooked_path = level_file::GetCookedPath(m_cooked_dir, name);
+    bool cook_failed = false;
+    const bool loaded = level_file::Load(m_levels_dir / name, cooked_path, desc, &m_load_timings.cooked, &cook_failed);
+    assert(loaded);
+    if (cook_failed) {
+        gFrontend->GetLogger()->hlog(logger::ll_WARNING, "cook: %s could not be written, the level parses again next load", cooked_path.u8string().c_str());
     }
 
-    // parse file
-    Document d;
-    d.Parse(content.c_str());
-
     // camera
     {
-        const Value& camera = d["camera"];
-        const Value& camera_pos = camera["pos"];
-        const Value& camera_dir = camera["dir"];
-        const DirectX::XMFLOAT3 pos(camera_pos[0].GetFloat(), camera_pos[1].GetFloat(), camera_pos[2].GetFloat());
-        const DirectX::XMFLOAT3 dir(camera_dir[0].GetFloat(), camera_dir[1].GetFloat(), camera_dir[2].GetFloat());
-
-        const Value& camera_fov = camera["fov"];
-        const Value& camera_near = camera["near"];
-        const Value& camera_far = camera["far"];
-
-        m_camera = std::make_shared<FreeCamera>(camera_fov.GetFloat(), camera_near.GetFloat(), camera_far.GetFloat(), gFrontend->GetAspectRatio());
-        m_camera->Move(pos);
-        m_camera->Rotate(dir);
+        m_camera = std::make_shared<FreeCamera>(desc.camera_fov, desc.camera_near, desc.camera_far, gFrontend->GetAspectRatio());
+        m_camera->Move(desc.camera_pos);
+        m_camera->Rotate(desc.camera_dir);
     }
 
-    // entities
-    {
-        const Value& entities = d["entities"];
-        for (uint32_t i = 0; i < entities.Size(); i++) {
-            const Value& entity = entities[i];
-            const char* model_name_8 = entity["model"].GetString();
-            const std::wstring model_name(&model_name_8[0], &model_name_8[strlen(model_name_8)]);
-
-            const Value& model_pos = entity["pos"];
-            const Value& model_rot = entity["rot"];
-            const Value& model_scale = entity["scale"];
-            const DirectX::XMFLOAT3 pos(model_pos[0].GetFloat(), model_pos[1].GetFloat(), model_pos[2].GetFloat());
-            const DirectX::XMFLOAT3 rot(model_rot[0].GetFloat(), model_rot[1].GetFloat(), model_rot[2].GetFloat());
-            const DirectX::XMFLOAT3 scale(model_scale[0].GetFloat(), model_scale[1].GetFloat(), model_scale[2].GetFloat());
-
-            LevelEntity lev_ent{ pos, rot, scale };
-            lev_ent.SetPos(pos);
-            lev_ent.SetRot(rot);
-            lev_ent.SetScale(scale);
-            lev_ent.Load(model_name);
+    m_load_timings.parse_ms = ms_since(load_start);
+    profiler.End(phase);
+
+    // entities: definitions, model imports and texture decodes run on the thread pool,
+    // everything that inserts into pools is merged serially in level order so ids stay deterministic
+    std::shared_ptr<ThreadPool> thread_pool = gFrontend->GetThreadPool().lock();
+    std::shared_ptr<FileManager> file_mgr = gFrontend->GetFileManager().lock();
+    if (thread_pool && file_mgr) {
+        // every definition is read once, however many entities place it
+        clock::time_point phase_start = clock::now();
+        phase = profiler.Begin("definitions", nullptr);
+        std::vector<LevelEntity> definitions(desc.definitions.size());
+        thread_pool->ParallelFor((uint32_t)definitions.size(), [this, &definitions, &desc](uint32_t idx) {
+            StartupScope scope("definition", desc.definitions[idx]);
+            definitions[idx].ReadDefinition(m_entities_dir / desc.definitions[idx]);
+        });
+        for (LevelEntity& definition : definitions) {
+            CacheDefinition(definition);
+        }
+        m_load_timings.definitions_num = (uint32_t)definitions.size();
+
+        // big levels stream their entities around the camera from the first update on
+        if (desc.stream_cell_size > 0.f) {
+            WorldPartition::Settings settings;
+            settings.cell_size = desc.stream_cell_size;
+            settings.load_radius = (desc.stream_load_radius > 0.f) ? desc.stream_load_radius : desc.stream_cell_size * 2.f;
+            settings.unload_radius = (desc.stream_unload_radius > 0.f) ? desc.stream_unload_radius : settings.load_radius * 1.25f;
+            if (desc.stream_budget_mb) {
+                settings.memory_budget = (uint64_t)desc.stream_budget_mb << 20;
+            }
+            m_streamer = std::make_unique<LevelStreamer>();
+            m_streamer->Start(desc, m_definitions, settings);
+            desc.placements.clear();
+            m_load_timings.stream_cells_num = m_streamer->GetPartition().GetCellsNum();
+        }
+
+        std::vector<LevelEntity> level_entities;
+        level_entities.reserve(desc.placements.size());
+        for (const level_file::Placement& placement : desc.placements) {
+            level_entities.emplace_back(placement.pos, placement.rot, placement.scale);
+            level_entities.back().CopyDefinition(definitions[placement.definition]);
+        }
+        m_load_timings.definitions_ms = ms_since(phase_start);
+        profiler.End(phase);
+
+        // every model is imported once, in order of first use
+        std::vector<std::wstring> model_names;
+        std::vector<uint32_t> entity_models(level_entities.size());
+        std::unordered_map<std::wstring, uint32_t> model_ids;
+        for (uint32_t i = 0; i < level_entities.size(); i++) {
+            const auto res = model_ids.emplace(level_entities[i].GetModelName(), (uint32_t)model_names.size());
+            if (res.second) {
+                model_names.push_back(level_entities[i].GetModelName());
+            }
+            entity_models[i] = res.first->second;
+        }
+
+        phase_start = clock::now();
+        phase = profiler.Begin("model imports", nullptr);
+        std::vector<std::unique_ptr<FileManager::ModelImport>> imports(model_names.size());
+        // textures decode right after their model imports, overlapping the imports still running
+        thread_pool->ParallelFor((uint32_t)model_names.size(), [&file_mgr, &imports, &model_names](uint32_t idx) {
+            imports[idx] = file_mgr->ImportModel(model_names[idx]);
+            file_mgr->PrefetchTextures(*imports[idx]);
+        });
+        m_load_timings.import_ms = ms_since(phase_start);
+        profiler.End(phase);
+
+        phase_start = clock::now();
+        phase = profiler.Begin("textures", nullptr);
+        m_load_timings.textures_num = file_mgr->LoadTexturesOnCPU(imports, *thread_pool);
+        m_load_timings.textures_ms = ms_since(phase_start);
+        profiler.End(phase);
+
+        phase_start = clock::now();
+        phase = profiler.Begin("merge", nullptr);
+        for (uint32_t i = 0; i < model_names.size(); i++) {
+            if (imports[i]->nodes.empty()) {
+                gFrontend->GetLogger()->hlog(logger::ll_WARNING, "level: model %s did not load, its entities stay empty", std::filesystem::path(model_names[i]).u8string().c_str());
+            }
+        }
+        for (uint32_t i = 0; i < level_entities.size(); i++) {
+            LevelEntity& lev_ent = level_entities[i];
+            // entity ids stay the placement indices hot reload matches on, a failed model merges to an empty placeholder
+            if (imports[entity_models[i]]->nodes.empty()) {
+                m_load_timings.failures_num++;
+            }
+            lev_ent.Setup(file_mgr->MergeModel(*imports[entity_models[i]]));
 
             uint32_t id = m_entites.push_back(lev_ent);
             m_entites[id].SetId(id);
         }
+        m_load_timings.merge_ms = ms_since(phase_start);
+        profiler.End(phase);
+
+        m_load_timings.threads_num = thread_pool->GetThreadsNum();
+        m_load_timings.entities_num = (uint32_t)level_entities.size();
+        m_load_timings.models_num = (uint32_t)model_names.size();
     }
 
     // Lights
     {
-        const Value& lights = d["lights"];
-        for (uint32_t i = 0; i < lights.Size(); i++) {
-            const Value& light = lights[i];
-            const LevelLight::LightType ltype = static_cast<LevelLight::LightType>(light["type"].GetInt());
+        for (const level_file::Light& light : desc.lights) {
+            const LevelLight::LightType ltype = static_cast<LevelLight::LightType>(light.type);
+            if (ltype != LevelLight::LightType::lt_direct && ltype != LevelLight::LightType::lt_point) {
+                continue;
+            }
 
+            LevelLight level_light;
+            level_light.type = ltype;
+            level_light.color = light.color;
             if (ltype == LevelLight::LightType::lt_direct) {
-                const Value& light_dir = light["dir"];
-                const Value& light_color = light["color"];
-                const DirectX::XMFLOAT3 dir(light_dir[0].GetFloat(), light_dir[1].GetFloat(), light_dir[2].GetFloat());
-                const DirectX::XMFLOAT3 color(light_color[0].GetFloat(), light_color[1].GetFloat(), light_color[2].GetFloat());
-
-                LevelLight level_light;
-                level_light.type = ltype;
-                level_light.color = color;
-                level_light.dir = dir;
-                uint32_t id = m_lights.push_back(level_light);
-                m_lights[id].id = id;
+                level_light.dir = light.dir;
             }
-            else if (ltype == LevelLight::LightType::lt_point) {
-                const Value& light_pos = light["pos"];
-                const Value& light_color = light["color"];
-                const DirectX::XMFLOAT3 pos(light_pos[0].GetFloat(), light_pos[1].GetFloat(), light_pos[2].GetFloat());
-                const DirectX::XMFLOAT3 color(light_color[0].GetFloat(), light_color[1].GetFloat(), light_color[2].GetFloat());
-
-                LevelLight level_light;
-                level_light.type = ltype;
-                level_light.color = color;
-                level_light.pos = pos;
-                uint32_t id = m_lights.push_back(level_light);
-                m_lights[id].id = id;
+            else {
+                level_light.pos = light.pos;
             }
+            uint32_t id = m_lights.push_back(level_light);
+            m_lights[id].id = id;
         }
 
         m_lights_res.reset(CreateGpuResource());
         uint32_t cb_size = calc_cb_size(LightsNum * sizeof(LevelLight));
         m_lights_res->CreateBuffer(HeapType::ht_default, cb_size, ResourceState::rs_resource_state_vertex_and_constant_buffer, std::wstring(L"lights_buffer_").append(m_name));
-        CBVdesc desc;
-        desc.size_in_bytes = cb_size;
-        m_lights_res->Create_CBV(desc);
+        CBVdesc cbv_desc;
+        cbv_desc.size_in_bytes = cb_size;
+        m_lights_res->Create_CBV(cbv_desc);
 
         m_sun = std::make_unique<Sun>();
     }
 
     // Skybox
     {
-        const Value& skybox = d["skybox"];
-        const char* skybox_name_8 = skybox["entity"].GetString();
-        const std::wstring skybox_name(&skybox_name_8[0], &skybox_name_8[strlen(skybox_name_8)]);
+        StartupScope scope("skybox", desc.skybox);
         m_skybox_ent.reset(new SkyBox);
-        m_skybox_ent->Load(skybox_name);
+        m_skybox_ent->Load(desc.skybox);
     }
 
     // Terrain
     {
-        const Value& terrain = d["terrain"];
-        const char* terrain_hm_name_8 = terrain["height_map"].GetString();
-        const std::wstring terrain_hm_name(&terrain_hm_name_8[0], &terrain_hm_name_8[strlen(terrain_hm_name_8)]);
-        const Value& terrain_pos = terrain["pos"];
-        const DirectX::XMFLOAT4 pos(terrain_pos[0].GetFloat(), terrain_pos[1].GetFloat(), terrain_pos[2].GetFloat(), 1);
-        const uint32_t terrain_dim = terrain["dim"].GetUint();
-        const uint32_t terrain_tech_id = terrain["tech_id"].GetUint();
-
+        const DirectX::XMFLOAT4 pos(desc.terrain_pos.x, desc.terrain_pos.y, desc.terrain_pos.z, 1);
+        StartupScope scope("terrain", desc.terrain_height_map);
         m_terrain.reset(new Plane);
-        m_terrain->Load(terrain_hm_name, terrain_dim, terrain_tech_id, pos);
+        m_terrain->Load(desc.terrain_height_map, desc.terrain_dim, desc.terrain_tech_id, pos);
     }
 
 	// Water
     {
-        const Value& water = d["water"];
-        const uint32_t water_dim = water["dim"].GetUint();
-        const uint32_t water_tech_id = water["tech_id"].GetUint();
-		const Value& water_pos = water["pos"];
-		const DirectX::XMFLOAT4 pos(water_pos[0].GetFloat(), water_pos[1].GetFloat(), water_pos[2].GetFloat(), 1);
-
+		const DirectX::XMFLOAT4 pos(desc.water_pos.x, desc.water_pos.y, desc.water_pos.z, 1);
         m_water.reset(new Plane);
-        m_water->Load(L"", water_dim, water_tech_id, pos);
+        m_water->Load(L"", desc.water_dim, desc.water_tech_id, pos);
     }
+
+    m_load_timings.total_ms = ms_since(load_start);
 }
 
 void Level::Update(float dt){
@@ -189,6 +228,14 @@ void Level::Update(float dt){
     for (auto &entity : m_entites){
         entity.Update(dt);
     }
+    if (m_streamer) {
+        m_streamer->Update(m_camera->GetPosition());
+        for (uint32_t cell : m_streamer->GetResidentCells()) {
+            for (LevelEntity &entity : m_streamer->GetCellEntities(cell)) {
+                entity.Update(dt);
+            }
+        }
+    }
 
     // sun
     m_sun->Update(dt);
@@ -202,6 +249,13 @@ void Level::Render(ICommandList* command_list){
         LevelEntity &ent = m_entites[id];
         RenderEntity(command_list, ent, is_scene_constants_set);
     }
+    if (m_streamer) {
+        for (uint32_t cell : m_streamer->GetResidentCells()) {
+            for (LevelEntity &ent : m_streamer->GetCellEntities(cell)) {
+                RenderEntity(command_list, ent, is_scene_constants_set);
+            }
+        }
+    }
 
     RenderEntity(command_list, *m_skybox_ent, is_scene_constants_set);
     {
@@ -319,12 +373,40 @@ void Level::RenderShadowMap(ICommandList* command_list)
         LevelEntity& ent = m_entites[id];
         ent.Render(command_list);
     }
+    if (m_streamer) {
+        for (uint32_t cell : m_streamer->GetResidentCells()) {
+            for (LevelEntity &ent : m_streamer->GetCellEntities(cell)) {
+                ent.Render(command_list);
+            }
+        }
+    }
 }
 
 void Level::BindLights(ICommandList* command_list){
     ConstantBufferManager::SyncCpuDataToCB(command_list, m_lights_res.get(), m_lights.data(), (LightsNum * sizeof(LevelLight)), bi_lights_cb);
 }
 
+bool Level::ReadDesc(level_file::LevelDesc &desc) const{
+    std::shared_ptr<VfsFile> file = VirtualFileSystem::Get().Open(m_levels_dir / m_name);
+    if (!file) {
+        return false;
+    }
+
+    // a half written file is skipped, the next save brings it back
+    return level_file::ParseJson((const char*)file->GetData(), file->GetSize(), desc);
+}
+
+void Level::CacheDefinition(const LevelEntity &definition){
+    m_definitions[definition.GetDefinitionName()] = definition;
+}
+
+uint32_t Level::AddEntity(const LevelEntity &entity){
+    const uint32_t id = m_entites.push_back(entity);
+    m_entites[id].SetId(id);
+
+    return id;
+}
+
 const std::filesystem::path& Level::GetLevelsDir() const{
     return m_levels_dir;
 }
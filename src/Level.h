@@ -5,9 +5,11 @@
 #include <filesystem>
 #include <DirectXMath.h>
 #include <vector>
+#include <unordered_map>
 #include "simple_object_pool.h"
 #include "LevelEntity.h"
 #include "LevelLight.h"
+#include "LevelFile.h"
 
 class FreeCamera;
 class RenderModel;
@@ -16,9 +18,27 @@ class SkyBox;
 class Plane;
 class ICommandList;
 class Sun;
+class LevelStreamer;
 
 class Level {
 public:
+    struct LoadTimings {
+        double parse_ms{ 0.0 };
+        double definitions_ms{ 0.0 };
+        double import_ms{ 0.0 };
+        double textures_ms{ 0.0 };
+        double merge_ms{ 0.0 };
+        double total_ms{ 0.0 };
+        uint32_t threads_num{ 0 };
+        uint32_t entities_num{ 0 };
+        uint32_t definitions_num{ 0 };
+        uint32_t models_num{ 0 };
+        uint32_t textures_num{ 0 };
+        uint32_t failures_num{ 0 }; // entities left with an empty model because theirs did not load
+        bool cooked{ false }; // level description came from content/cooked/levels
+        uint32_t stream_cells_num{ 0 }; // entities of a streamed level load later, by cell
+    };
+
     Level();
     ~Level();
     void Load(const std::wstring &name);
@@ -29,15 +49,29 @@ public:
     void BindLights(ICommandList* command_list);
 
     std::weak_ptr<FreeCamera> GetCamera() { return m_camera; }
+    const std::wstring& GetName() const { return m_name; }
     const std::filesystem::path& GetLevelsDir() const;
     const std::filesystem::path& GetEntitiesDir() const;
 
     const LevelLight& GetSunParams() const { return m_lights[0]; }
+    const LoadTimings& GetLoadTimings() const { return m_load_timings; }
     IGpuResource& GetSunShadowMap();
 
+    // hot reload; ReadDesc is thread safe and parses the level file as it is now, skipping the cooked copy
+    bool ReadDesc(level_file::LevelDesc &desc) const;
+    // entity definitions are read once per level and copied into every entity using them
+    const std::unordered_map<std::wstring, LevelEntity>& GetDefinitions() const { return m_definitions; }
+    void CacheDefinition(const LevelEntity &definition);
+    uint32_t GetEntitiesNum() const { return m_entites.size(); }
+    // null when every entity loads with the level
+    const LevelStreamer* GetStreamer() const { return m_streamer.get(); }
+    LevelEntity& GetEntity(uint32_t id) { return m_entites[id]; }
+    uint32_t AddEntity(const LevelEntity &entity);
+    // capacity of the entity pool, AddEntity past it is an error
+    static const uint32_t entities_num = 256;
+
 private:
     void RenderEntity(ICommandList* command_list, LevelEntity & ent, bool &is_scene_constants_set);
-    static const uint32_t entities_num = 256;
     std::wstring m_name;
     pro_game_containers::simple_object_pool<LevelEntity, entities_num> m_entites;
     pro_game_containers::simple_object_pool<LevelLight, LightsNum> m_lights;
@@ -47,6 +81,10 @@ private:
     std::unique_ptr<IGpuResource> m_lights_res;
     std::shared_ptr<FreeCamera> m_camera;
     std::unique_ptr<Sun> m_sun;
+    std::unique_ptr<LevelStreamer> m_streamer;
     std::filesystem::path m_levels_dir;
     std::filesystem::path m_entities_dir; 
+    std::filesystem::path m_cooked_dir;
+    std::unordered_map<std::wstring, LevelEntity> m_definitions;
+    LoadTimings m_load_timings;
 };
\ No newline at end of file
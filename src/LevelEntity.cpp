@@ -9,13 +9,14 @@
 #include <rapidjson/document.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/stringbuffer.h>
-#include <fstream>
+#include <cassert>
 
 #include "Frontend.h"
 #include "RenderModel.h"
 #include "FileManager.h"
 #include "Level.h"
 #include "MaterialManager.h"
+#include "VirtualFileSystem.h"
 
 extern Frontend* gFrontend;
 using rapidjson::Document;
@@ -30,53 +31,79 @@ LevelEntity::LevelEntity(const DirectX::XMFLOAT3 &pos, const DirectX::XMFLOAT3 &
 
 }
 
+// TODO: gFrontend->TechHasColor(m_tech_id)
+static bool temp_hack(uint32_t id) {
+    return (id == 0);
+}
+
 void LevelEntity::Load(const std::wstring &name){
-    // read file
-    std::string content;
-    {
-        if (std::shared_ptr<Level> level =  gFrontend->GetLevel().lock()){
-            const std::filesystem::path fullPath = (level->GetEntitiesDir() / name);
-            std::ifstream ifs(fullPath.string().c_str());
-            content.assign((std::istreambuf_iterator<char>(ifs)), (std::istreambuf_iterator<char>()));
-        }
+    if (std::shared_ptr<Level> level =  gFrontend->GetLevel().lock()){
+        ReadDefinition(level->GetEntitiesDir() / name);
     }
 
+    if (std::shared_ptr<FileManager> fileMgr = gFrontend->GetFileManager().lock()){
+        Setup(fileMgr->LoadModel(m_model_name));
+    }
+}
+
+bool LevelEntity::ReadDefinition(const std::filesystem::path &path){
+    // read file
+    std::shared_ptr<VfsFile> file = VirtualFileSystem::Get().Open(path);
+    assert(file);
+    m_definition_name = path.filename().wstring();
+
     // parse file
     Document d;
-    d.Parse(content.c_str());
+    d.Parse((const char*)file->GetData(), file->GetSize());
+    if (d.HasParseError() || !d.IsObject()) {
+        return false;
+    }
 
     const Value &shaders = d["technique"];
     m_tech_id = shaders.GetInt();
 
     const char * model_name_8 = d["model"].GetString();
-    const std::wstring model_name(&model_name_8[0], &model_name_8[strlen(model_name_8)]);
-    if (std::shared_ptr<FileManager> fileMgr = gFrontend->GetFileManager().lock()){
-        m_model = fileMgr->LoadModel(model_name);
-        m_model->SetName(model_name);
-        m_model->SetTechniqueId(m_tech_id);
-        auto temp_hack = [](uint32_t id) {
-            return (id == 0);
-        };
-
-        //if (gFrontend->TechHasColor(m_tech_id)){
-        if (temp_hack(m_tech_id)){
-            const Value &color_val = d["color"];
-            const DirectX::XMFLOAT3 color(color_val[0].GetFloat(), color_val[1].GetFloat(), color_val[2].GetFloat());
-            m_model->SetColor(color);
-
-            // load material
-			const Value& material = d["material"];
-			const Value& metallic = material["metallic"];
-			const Value& roughness = material["roughness"];
-            const Value& reflectivity = material["reflectivity"];
-			if (std::shared_ptr<MaterialManager> mat_mgr = gFrontend->GetMaterialManager().lock()) {
-				uint32_t mat_id = mat_mgr->CreateMaterial(metallic.GetFloat(), roughness.GetFloat(), reflectivity.GetFloat());
-				m_model->SetMaterial(mat_id);
-			}
+    m_model_name.assign(&model_name_8[0], &model_name_8[strlen(model_name_8)]);
+
+    if (temp_hack(m_tech_id)){
+        const Value &color_val = d["color"];
+        m_color = DirectX::XMFLOAT3(color_val[0].GetFloat(), color_val[1].GetFloat(), color_val[2].GetFloat());
+
+        const Value& material = d["material"];
+        m_metallic = material["metallic"].GetFloat();
+        m_roughness = material["roughness"].GetFloat();
+        m_reflectivity = material["reflectivity"].GetFloat();
+    }
+
+    return true;
+}
+
+void LevelEntity::Setup(RenderModel* model){
+    m_model = model;
+    m_model->SetName(m_model_name);
+    m_model->SetTechniqueId(m_tech_id);
+
+    if (temp_hack(m_tech_id)){
+        m_model->SetColor(m_color);
+
+        // load material
+        if (std::shared_ptr<MaterialManager> mat_mgr = gFrontend->GetMaterialManager().lock()) {
+            uint32_t mat_id = mat_mgr->CreateMaterial(m_metallic, m_roughness, m_reflectivity);
+            m_model->SetMaterial(mat_id);
         }
     }
 }
 
+void LevelEntity::CopyDefinition(const LevelEntity& definition){
+    m_definition_name = definition.m_definition_name;
+    m_model_name = definition.m_model_name;
+    m_tech_id = definition.m_tech_id;
+    m_color = definition.m_color;
+    m_metallic = definition.m_metallic;
+    m_roughness = definition.m_roughness;
+    m_reflectivity = definition.m_reflectivity;
+}
+
 void LevelEntity::Update(float dt){
     DirectX::XMMATRIX rot = DirectX::XMMatrixRotationRollPitchYaw(DirectX::XMConvertToRadians(m_rot.x), DirectX::XMConvertToRadians(m_rot.y), DirectX::XMConvertToRadians(m_rot.z));
     DirectX::XMMATRIX pos = DirectX::XMMatrixTranslation(m_pos.x, m_pos.y, m_pos.z);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <filesystem>
 #include <DirectXMath.h>
 #include "simple_object_pool.h"
 
@@ -12,6 +13,15 @@ public:
     LevelEntity() = default;
     LevelEntity(const DirectX::XMFLOAT3 &pos, const DirectX::XMFLOAT3 &rot, const DirectX::XMFLOAT3 &scale);
     virtual void Load(const std::wstring &name);
+    // Load in two steps for the parallel level loader: ReadDefinition touches no shared state, Setup does
+    // false when the file does not parse, a hot reload can catch it half written
+    bool ReadDefinition(const std::filesystem::path &path);
+    void Setup(RenderModel* model);
+    // hot reload: takes the technique, model name and material of a re-read definition, Setup follows
+    void CopyDefinition(const LevelEntity& definition);
+    const std::wstring& GetModelName() const { return m_model_name; }
+    const std::wstring& GetDefinitionName() const { return m_definition_name; }
+    RenderModel* GetModel() const { return m_model; }
     virtual void Update(float dt);
     virtual void Render(ICommandList* command_list);
     const DirectX::XMFLOAT4X4& GetXform() const { return m_xform; }
@@ -24,13 +34,18 @@ public:
     void SetScale(const DirectX::XMFLOAT3& scale) { m_scale = scale; }
     virtual ~LevelEntity() = default;
 protected:
+    std::wstring m_definition_name;
     std::wstring m_model_name;
-    RenderModel* m_model;
+    RenderModel* m_model{ nullptr };
     DirectX::XMFLOAT3 m_pos;
     DirectX::XMFLOAT3 m_rot;
     DirectX::XMFLOAT3 m_scale;
     uint32_t m_id;
     uint32_t m_tech_id{(uint32_t)(-1)};
+    DirectX::XMFLOAT3 m_color{ 0.f, 0.f, 0.f };
+    float m_metallic{ 0.f };
+    float m_roughness{ 0.f };
+    float m_reflectivity{ 0.f };
     //
     DirectX::XMFLOAT4X4 m_xform;
 };
\ No newline at end of file
@@ -0,0 +1,502 @@
+#include "LevelFile.h"
+
+#if defined(min)
+#undef min
+#endif
+
+#if defined(max)
+#undef max
+#endif
+
+#include <rapidjson/reader.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/document.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#include "CookedLevel.h"
+#include "VirtualFileSystem.h"
+
+namespace level_file {
+
+namespace {
+    enum Key : uint8_t {
+        k_unknown = 0, k_camera, k_entities, k_lights, k_skybox, k_terrain, k_water,
+        k_pos, k_dir, k_rot, k_scale, k_color, k_fov, k_near, k_far, k_model, k_type, k_entity, k_height_map, k_dim, k_tech_id,
+        k_streaming, k_cell_size, k_load_radius, k_unload_radius, k_budget_mb
+    };
+
+    Key FindKey(const char* str, rapidjson::SizeType len) {
+        static const std::pair<const char*, Key> keys[] = {
+            { "camera", k_camera }, { "entities", k_entities }, { "lights", k_lights }, { "skybox", k_skybox }, { "terrain", k_terrain }, { "water", k_water },
+            { "pos", k_pos }, { "dir", k_dir }, { "rot", k_rot }, { "scale", k_scale }, { "color", k_color }, { "fov", k_fov }, { "near", k_near }, { "far", k_far },
+            { "model", k_model }, { "type", k_type }, { "entity", k_entity }, { "height_map", k_height_map }, { "dim", k_dim }, { "tech_id", k_tech_id },
+            { "streaming", k_streaming }, { "cell_size", k_cell_size }, { "load_radius", k_load_radius }, { "unload_radius", k_unload_radius }, { "budget_mb", k_budget_mb }
+        };
+        for (const auto& key : keys) {
+            if (strlen(key.first) == len && memcmp(key.first, str, len) == 0) {
+                return key.second;
+            }
+        }
+
+        return k_unknown;
+    }
+
+    void SetComponent(DirectX::XMFLOAT3& vec, uint32_t comp, float val) {
+        if (comp < 3) {
+            (&vec.x)[comp] = val;
+        }
+    }
+
+    // Fills a LevelDesc straight from the parser events. Each open object or array is one depth level; keys[1] is the
+    // section, a value's field is the key of its object or, inside an array of numbers, the key of that array.
+    // Unknown keys are skipped with whatever they hold.
+    class LevelHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, LevelHandler> {
+    public:
+        explicit LevelHandler(LevelDesc& desc) : m_desc(desc) {}
+
+        bool Null() { return true; }
+        bool Bool(bool) { return true; }
+        bool Int(int val) { return Number((float)val); }
+        bool Uint(unsigned val) { return Number((float)val); }
+        bool Int64(int64_t val) { return Number((float)val); }
+        bool Uint64(uint64_t val) { return Number((float)val); }
+        bool Double(double val) { return Number((float)val); }
+
+        bool String(const char* str, rapidjson::SizeType len, bool) {
+            const std::wstring val(str, str + len);
+            switch (m_keys[1]) {
+            case k_entities:
+                if (m_depth == 3 && m_keys[3] == k_model && !m_desc.placements.empty()) {
+                    // definitions are found by name once here, entities only keep the index
+                    const auto res = m_definitions.emplace(val, (uint32_t)m_desc.definitions.size());
+                    if (res.second) {
+                        m_desc.definitions.push_back(val);
+                    }
+                    m_desc.placements.back().definition = res.first->second;
+                }
+                break;
+            case k_skybox:
+                if (m_depth == 2 && m_keys[2] == k_entity) {
+                    m_desc.skybox = val;
+                }
+                break;
+            case k_terrain:
+                if (m_depth == 2 && m_keys[2] == k_height_map) {
+                    m_desc.terrain_height_map = val;
+                }
+                break;
+            default:
+                break;
+            }
+
+            return true;
+        }
+
+        bool Key(const char* str, rapidjson::SizeType len, bool) {
+            m_keys[m_depth] = FindKey(str, len);
+            return true;
+        }
+
+        bool StartObject() {
+            if (m_depth == 2 && m_arrays[2]) {
+                if (m_keys[1] == k_entities) {
+                    m_desc.placements.emplace_back();
+                    m_desc.placements.back().definition = (uint32_t)-1; // until its model shows up
+                }
+                else if (m_keys[1] == k_lights) {
+                    m_desc.lights.emplace_back();
+                }
+            }
+            return Push(false);
+        }
+
+        bool EndObject(rapidjson::SizeType) { return Pop(); }
+        bool StartArray() { return Push(true); }
+        bool EndArray(rapidjson::SizeType) { return Pop(); }
+
+    private:
+        static constexpr uint32_t max_depth = 16;
+
+        bool Push(bool is_array) {
+            if (m_depth + 1 >= max_depth) {
+                return false;
+            }
+            m_depth++;
+            m_arrays[m_depth] = is_array;
+            m_keys[m_depth] = k_unknown;
+            m_index[m_depth] = 0;
+            return true;
+        }
+
+        bool Pop() {
+            m_depth--;
+            return true;
+        }
+
+        bool Number(float val) {
+            const bool in_array = m_arrays[m_depth];
+            const uint8_t field = in_array ? m_keys[m_depth - 1] : m_keys[m_depth];
+            const uint32_t comp = in_array ? m_index[m_depth]++ : 0;
+            // vectors are the innermost arrays: depth 3 in a section object, depth 4 in an entity or a light
+            const uint32_t vec_depth = (m_keys[1] == k_entities || m_keys[1] == k_lights) ? 4 : 3;
+            if (in_array && m_depth != vec_depth) {
+                return true;
+            }
+            if (!in_array && m_depth != vec_depth - 1) {
+                return true;
+            }
+
+            switch (m_keys[1]) {
+            case k_camera:
+                switch (field) {
+                case k_pos: SetComponent(m_desc.camera_pos, comp, val); break;
+                case k_dir: SetComponent(m_desc.camera_dir, comp, val); break;
+                case k_fov: m_desc.camera_fov = val; break;
+                case k_near: m_desc.camera_near = val; break;
+                case k_far: m_desc.camera_far = val; break;
+                default: break;
+                }
+                break;
+            case k_entities:
+                if (!m_desc.placements.empty()) {
+                    Placement& placement = m_desc.placements.back();
+                    switch (field) {
+                    case k_pos: SetComponent(placement.pos, comp, val); break;
+                    case k_rot: SetComponent(placement.rot, comp, val); break;
+                    case k_scale: SetComponent(placement.scale, comp, val); break;
+                    default: break;
+                    }
+                }
+                break;
+            case k_lights:
+                if (!m_desc.lights.empty()) {
+                    Light& light = m_desc.lights.back();
+                    switch (field) {
+                    case k_type: light.type = (uint32_t)val; break;
+                    case k_pos: SetComponent(light.pos, comp, val); break;
+                    case k_dir: SetComponent(light.dir, comp, val); break;
+                    case k_color: SetComponent(light.color, comp, val); break;
+                    default: break;
+                    }
+                }
+                break;
+            case k_terrain:
+                switch (field) {
+                case k_pos: SetComponent(m_desc.terrain_pos, comp, val); break;
+                case k_dim: m_desc.terrain_dim = (uint32_t)val; break;
+                case k_tech_id: m_desc.terrain_tech_id = (uint32_t)val; break;
+                default: break;
+                }
+                break;
+            case k_water:
+                switch (field) {
+                case k_pos: SetComponent(m_desc.water_pos, comp, val); break;
+                case k_dim: m_desc.water_dim = (uint32_t)val; break;
+                case k_tech_id: m_desc.water_tech_id = (uint32_t)val; break;
+                default: break;
+                }
+                break;
+            case k_streaming:
+                switch (field) {
+                case k_cell_size: m_desc.stream_cell_size = val; break;
+                case k_load_radius: m_desc.stream_load_radius = val; break;
+                case k_unload_radius: m_desc.stream_unload_radius = val; break;
+                case k_budget_mb: m_desc.stream_budget_mb = (uint32_t)val; break;
+                default: break;
+                }
+                break;
+            default:
+                break;
+            }
+
+            return true;
+        }
+
+        LevelDesc& m_desc;
+        std::unordered_map<std::wstring, uint32_t> m_definitions;
+        uint32_t m_depth{ 0 };
+        uint8_t m_keys[max_depth] = {};
+        bool m_arrays[max_depth] = {};
+        uint32_t m_index[max_depth] = {};
+    };
+
+    bool IsRangeValid(uint64_t offset, uint64_t size, uint64_t total) {
+        return offset <= total && size <= total - offset;
+    }
+
+    std::string BuildSyntheticLevel(uint32_t entities_num, uint32_t definitions_num) {
+        std::string json = "{\n    \"camera\": { \"pos\": [-4, 11, -15], \"dir\": [0.0, 0.0, 1.0], \"fov\": 45.0, \"near\": 0.1, \"far\": 500.0 },\n    \"entities\": [\n";
+        char line[256];
+        for (uint32_t i = 0; i < entities_num; i++) {
+            snprintf(line, sizeof(line), "        { \"model\": \"sphere_%u.json\", \"pos\": [%.2f, %.2f, %.2f], \"rot\": [0.0, %.1f, 0.0], \"scale\": [0.01, 0.01, 0.01] }%s\n",
+                i % definitions_num, (float)(i % 317), (float)(i / 317 % 317), 1.f, (float)(i % 360), (i + 1 < entities_num) ? "," : "");
+            json += line;
+        }
+        json += "    ],\n    \"lights\": [ { \"type\": 2, \"dir\": [1.7, -1, -0.95], \"color\": [1.8, 1.8, 1.8] } ],\n    \"skybox\": { \"entity\": \"skybox.json\" },\n";
+        json += "    \"terrain\": { \"height_map\": \"terrain_hm.png\", \"dim\": 512, \"tech_id\": 7, \"pos\": [0, 0, 0] },\n    \"water\": { \"dim\": 512, \"tech_id\": 8, \"pos\": [0, 0.3, 0] }\n}\n";
+
+        return json;
+    }
+}
+
+bool ParseJson(const char* data, uint64_t size, LevelDesc& desc) {
+    LevelHandler handler(desc);
+    rapidjson::MemoryStream stream(data, (size_t)size);
+    rapidjson::Reader reader;
+
+    if (reader.Parse(stream, handler).IsError()) {
+        return false;
+    }
+
+    // an entity without a model has nothing to place
+    for (const Placement& placement : desc.placements) {
+        if (placement.definition >= desc.definitions.size()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::vector<uint8_t> Cook(const LevelDesc& desc, uint64_t source_size, int64_t source_time) {
+    using namespace cooked_level;
+    static_assert(sizeof(Placement) == 40 && sizeof(Light) == 40, "cooked placements and lights are memcpy'd");
+
+    std::string strings;
+    // names were widened char by char when parsed, narrowing back is lossless
+    auto add_string = [&strings](const std::wstring& str) {
+        String res{ (uint32_t)strings.size(), (uint32_t)str.size() };
+        for (wchar_t c : str) {
+            strings.push_back((char)c);
+        }
+        return res;
+    };
+
+    std::vector<String> definitions(desc.definitions.size());
+    for (uint32_t i = 0; i < desc.definitions.size(); i++) {
+        definitions[i] = add_string(desc.definitions[i]);
+    }
+
+    Header header{};
+    header.magic = magic;
+    header.version = version;
+    header.source_size = source_size;
+    header.source_time = source_time;
+    header.definitions_num = (uint32_t)definitions.size();
+    header.placements_num = (uint32_t)desc.placements.size();
+    header.lights_num = (uint32_t)desc.lights.size();
+    memcpy(header.camera_pos, &desc.camera_pos, sizeof(header.camera_pos));
+    memcpy(header.camera_dir, &desc.camera_dir, sizeof(header.camera_dir));
+    header.camera_fov = desc.camera_fov;
+    header.camera_near = desc.camera_near;
+    header.camera_far = desc.camera_far;
+    header.skybox = add_string(desc.skybox);
+    header.terrain_height_map = add_string(desc.terrain_height_map);
+    memcpy(header.terrain_pos, &desc.terrain_pos, sizeof(header.terrain_pos));
+    header.terrain_dim = desc.terrain_dim;
+    header.terrain_tech_id = desc.terrain_tech_id;
+    memcpy(header.water_pos, &desc.water_pos, sizeof(header.water_pos));
+    header.water_dim = desc.water_dim;
+    header.water_tech_id = desc.water_tech_id;
+    header.stream_cell_size = desc.stream_cell_size;
+    header.stream_load_radius = desc.stream_load_radius;
+    header.stream_unload_radius = desc.stream_unload_radius;
+    header.stream_budget_mb = desc.stream_budget_mb;
+
+    header.definitions_offset = align(sizeof(Header));
+    header.placements_offset = align(header.definitions_offset + definitions.size() * sizeof(String));
+    header.lights_offset = align(header.placements_offset + desc.placements.size() * sizeof(Placement));
+    header.strings_offset = align(header.lights_offset + desc.lights.size() * sizeof(Light));
+    header.strings_size = strings.size();
+    header.file_size = align(header.strings_offset + header.strings_size);
+
+    std::vector<uint8_t> blob(header.file_size, 0);
+    auto write = [&blob](uint64_t at, const void* src, uint64_t size) {
+        if (size) {
+            memcpy(blob.data() + at, src, size);
+        }
+    };
+    write(0, &header, sizeof(header));
+    write(header.definitions_offset, definitions.data(), definitions.size() * sizeof(String));
+    write(header.placements_offset, desc.placements.data(), desc.placements.size() * sizeof(Placement));
+    write(header.lights_offset, desc.lights.data(), desc.lights.size() * sizeof(Light));
+    write(header.strings_offset, strings.data(), strings.size());
+
+    return blob;
+}
+
+bool ReadCooked(const uint8_t* data, uint64_t size, uint64_t source_size, int64_t source_time, LevelDesc& desc) {
+    using namespace cooked_level;
+    if (size < sizeof(Header)) {
+        return false;
+    }
+
+    const Header* header = (const Header*)data;
+    if (header->magic != magic || header->version != version || header->file_size != size ||
+        header->source_size != source_size || header->source_time != source_time) {
+        return false;
+    }
+
+    if (!IsRangeValid(header->definitions_offset, (uint64_t)header->definitions_num * sizeof(String), size) ||
+        !IsRangeValid(header->placements_offset, (uint64_t)header->placements_num * sizeof(Placement), size) ||
+        !IsRangeValid(header->lights_offset, (uint64_t)header->lights_num * sizeof(Light), size) ||
+        !IsRangeValid(header->strings_offset, header->strings_size, size)) {
+        return false;
+    }
+
+    const char* strings = (const char*)(data + header->strings_offset);
+    auto is_string_valid = [header](const String& str) { return IsRangeValid(str.offset, str.size, header->strings_size); };
+    auto get_string = [strings](const String& str) { return std::wstring(&strings[str.offset], &strings[str.offset + str.size]); };
+    if (!is_string_valid(header->skybox) || !is_string_valid(header->terrain_height_map)) {
+        return false;
+    }
+
+    const String* definitions = (const String*)(data + header->definitions_offset);
+    desc.definitions.resize(header->definitions_num);
+    for (uint32_t i = 0; i < header->definitions_num; i++) {
+        if (!is_string_valid(definitions[i])) {
+            return false;
+        }
+        desc.definitions[i] = get_string(definitions[i]);
+    }
+
+    desc.placements.resize(header->placements_num);
+    memcpy(desc.placements.data(), data + header->placements_offset, desc.placements.size() * sizeof(Placement));
+    for (const Placement& placement : desc.placements) {
+        if (placement.definition >= header->definitions_num) {
+            return false;
+        }
+    }
+    desc.lights.resize(header->lights_num);
+    memcpy(desc.lights.data(), data + header->lights_offset, desc.lights.size() * sizeof(Light));
+
+    desc.camera_pos = DirectX::XMFLOAT3(header->camera_pos);
+    desc.camera_dir = DirectX::XMFLOAT3(header->camera_dir);
+    desc.camera_fov = header->camera_fov;
+    desc.camera_near = header->camera_near;
+    desc.camera_far = header->camera_far;
+    desc.skybox = get_string(header->skybox);
+    desc.terrain_height_map = get_string(header->terrain_height_map);
+    desc.terrain_pos = DirectX::XMFLOAT3(header->terrain_pos);
+    desc.terrain_dim = header->terrain_dim;
+    desc.terrain_tech_id = header->terrain_tech_id;
+    desc.water_pos = DirectX::XMFLOAT3(header->water_pos);
+    desc.water_dim = header->water_dim;
+    desc.water_tech_id = header->water_tech_id;
+    desc.stream_cell_size = header->stream_cell_size;
+    desc.stream_load_radius = header->stream_load_radius;
+    desc.stream_unload_radius = header->stream_unload_radius;
+    desc.stream_budget_mb = header->stream_budget_mb;
+
+    return true;
+}
+
+std::filesystem::path GetCookedPath(const std::filesystem::path& cooked_dir, const std::wstring& name) {
+    std::filesystem::path cooked_path = cooked_dir / name;
+    cooked_path += L".cooked";
+
+    return cooked_path;
+}
+
+bool Load(const std::filesystem::path& source_path, const std::filesystem::path& cooked_path, LevelDesc& desc, bool* from_cooked, bool* cook_failed) {
+    VirtualFileSystem& vfs = VirtualFileSystem::Get();
+    uint64_t source_size = 0;
+    int64_t source_time = 0;
+    if (!vfs.Stat(source_path, source_size, source_time)) {
+        return false;
+    }
+
+    if (std::shared_ptr<VfsFile> cooked = vfs.Open(cooked_path)) {
+        LevelDesc cooked_desc;
+        if (ReadCooked(cooked->GetData(), cooked->GetSize(), source_size, source_time, cooked_desc)) {
+            desc = std::move(cooked_desc);
+            if (from_cooked) {
+                *from_cooked = true;
+            }
+            return true;
+        }
+    }
+
+    std::shared_ptr<VfsFile> source = vfs.Open(source_path);
+    if (!source || !ParseJson((const char*)source->GetData(), source->GetSize(), desc)) {
+        return false;
+    }
+    if (from_cooked) {
+        *from_cooked = false;
+    }
+
+    // best effort, a read only content dir just means parsing every time; written aside and swapped in, each write
+    // gets its own file so two loads cooking the same level never share one
+    static std::atomic<uint32_t> writes_num{ 0 };
+    const std::vector<uint8_t> blob = Cook(desc, source_size, source_time);
+    std::filesystem::path tmp_path = cooked_path;
+    tmp_path += L"." + std::to_wstring(writes_num++) + L".tmp";
+    std::error_code ec;
+    std::filesystem::create_directories(cooked_path.parent_path(), ec);
+    bool written = false;
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        written = (bool)file.write((const char*)blob.data(), blob.size());
+    }
+    if (written) {
+        std::filesystem::rename(tmp_path, cooked_path, ec);
+        written = !ec;
+    }
+    if (!written) {
+        std::filesystem::remove(tmp_path, ec);
+        if (cook_failed) {
+            *cook_failed = true;
+        }
+    }
+
+    return true;
+}
+
+std::vector<BenchmarkResult> Benchmark(uint32_t entities_num, uint32_t repeats) {
+    using clock = std::chrono::steady_clock;
+    auto best_ms = [repeats](auto&& run) {
+        double best = 0.0;
+        for (uint32_t it = 0; it < std::max(repeats, 1u); it++) {
+            const clock::time_point start = clock::now();
+            run();
+            const double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+            best = (it == 0) ? ms : std::min(best, ms);
+        }
+        return best;
+    };
+
+    std::vector<BenchmarkResult> results;
+    for (uint32_t div : { 100u, 10u, 1u }) {
+        BenchmarkResult res;
+        res.entities_num = std::max(entities_num / div, 1u);
+        const std::string json = BuildSyntheticLevel(res.entities_num, 16);
+        res.json_size = json.size();
+
+        LevelDesc desc;
+        res.sax_ms = best_ms([&] {
+            desc = LevelDesc{};
+            ParseJson(json.data(), json.size(), desc);
+        });
+        res.dom_ms = best_ms([&] {
+            rapidjson::Document d;
+            d.Parse(json.data(), json.size());
+        });
+
+        const std::vector<uint8_t> blob = Cook(desc, json.size(), 0);
+        res.cooked_size = blob.size();
+        res.cooked_ms = best_ms([&] {
+            LevelDesc cooked_desc;
+            ReadCooked(blob.data(), blob.size(), json.size(), 0, cooked_desc);
+        });
+        results.push_back(res);
+    }
+
+    return results;
+}
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <DirectXMath.h>
+
+// Level description without any engine state: what Level::Load builds the level from.
+// Source levels are JSON read with a SAX parser, no DOM is built; a cooked copy next to the other cooked data loads
+// with a memcpy per array and is used while its source size and time still match.
+namespace level_file {
+    // stored as is in cooked levels
+    struct Placement {
+        uint32_t definition{ 0 }; // into LevelDesc::definitions
+        DirectX::XMFLOAT3 pos{ 0.f, 0.f, 0.f };
+        DirectX::XMFLOAT3 rot{ 0.f, 0.f, 0.f };
+        DirectX::XMFLOAT3 scale{ 1.f, 1.f, 1.f };
+    };
+
+    struct Light {
+        uint32_t type{ 0 }; // LevelLight::LightType
+        DirectX::XMFLOAT3 pos{ 0.f, 0.f, 0.f };
+        DirectX::XMFLOAT3 dir{ 0.f, 0.f, 0.f };
+        DirectX::XMFLOAT3 color{ 0.f, 0.f, 0.f };
+    };
+
+    struct LevelDesc {
+        DirectX::XMFLOAT3 camera_pos{ 0.f, 0.f, 0.f };
+        DirectX::XMFLOAT3 camera_dir{ 0.f, 0.f, 1.f };
+        float camera_fov{ 45.f };
+        float camera_near{ 0.1f };
+        float camera_far{ 500.f };
+        std::vector<std::wstring> definitions; // entity definition files, each once in order of first use
+        std::vector<Placement> placements;
+        std::vector<Light> lights;
+        std::wstring skybox;
+        std::wstring terrain_height_map;
+        DirectX::XMFLOAT3 terrain_pos{ 0.f, 0.f, 0.f };
+        uint32_t terrain_dim{ 0 };
+        uint32_t terrain_tech_id{ 0 };
+        DirectX::XMFLOAT3 water_pos{ 0.f, 0.f, 0.f };
+        uint32_t water_dim{ 0 };
+        uint32_t water_tech_id{ 0 };
+        // entities stream in by grid cell around the camera when stream_cell_size is set, 0 radii and budget pick defaults
+        float stream_cell_size{ 0.f };
+        float stream_load_radius{ 0.f };
+        float stream_unload_radius{ 0.f };
+        uint32_t stream_budget_mb{ 0 };
+    };
+
+    struct BenchmarkResult {
+        uint32_t entities_num{ 0 };
+        uint64_t json_size{ 0 };
+        uint64_t cooked_size{ 0 };
+        double sax_ms{ 0.0 };
+        double dom_ms{ 0.0 }; // rapidjson Document parse alone, before anything reads it
+        double cooked_ms{ 0.0 };
+    };
+
+    // false for malformed JSON, desc is left partly filled
+    bool ParseJson(const char* data, uint64_t size, LevelDesc& desc);
+    std::vector<uint8_t> Cook(const LevelDesc& desc, uint64_t source_size, int64_t source_time);
+    // false when the blob is damaged or was cooked from another version of the source
+    bool ReadCooked(const uint8_t* data, uint64_t size, uint64_t source_size, int64_t source_time, LevelDesc& desc);
+
+    std::filesystem::path GetCookedPath(const std::filesystem::path& cooked_dir, const std::wstring& name);
+    // cooked copy when fresh, otherwise the source, cooked again for the next load; thread safe. cook_failed is set
+    // when that cook could not be written or swapped in, the load itself still succeeds
+    bool Load(const std::filesystem::path& source_path, const std::filesystem::path& cooked_path, LevelDesc& desc, bool* from_cooked = nullptr, bool* cook_failed = nullptr);
+
+    // synthetic levels of entities_num / 100, / 10 and entities_num entities over a few definitions
+    std::vector<BenchmarkResult> Benchmark(uint32_t entities_num, uint32_t repeats);
+}
@@ -0,0 +1,196 @@
+#include "LevelStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+#include "Frontend.h"
+#include "ThreadPool.h"
+
+extern Frontend* gFrontend;
+
+LevelStreamer::~LevelStreamer()
+{
+    Stop();
+}
+
+void LevelStreamer::Start(const level_file::LevelDesc &desc, const std::unordered_map<std::wstring, LevelEntity> &definitions, const WorldPartition::Settings &settings)
+{
+    Stop();
+
+    m_placements = desc.placements;
+    m_definitions.clear();
+    m_definitions.resize(desc.definitions.size());
+    for (uint32_t i = 0; i < desc.definitions.size(); i++) {
+        const auto it = definitions.find(desc.definitions[i]);
+        if (it != definitions.end()) {
+            m_definitions[i].CopyDefinition(it->second);
+        }
+    }
+
+    std::vector<DirectX::XMFLOAT3> positions(m_placements.size());
+    for (uint32_t i = 0; i < m_placements.size(); i++) {
+        positions[i] = m_placements[i].pos;
+    }
+    m_partition.Build(positions, {}, settings);
+
+    // a cell costs the models it places, each counted once however many of its entities share it
+    std::shared_ptr<FileManager> file_mgr = gFrontend->GetFileManager().lock();
+    std::unordered_map<std::wstring, uint64_t> model_bytes;
+    for (uint32_t cell = 0; file_mgr && cell < m_partition.GetCellsNum(); cell++) {
+        std::unordered_set<std::wstring> models;
+        uint64_t bytes = 0;
+        for (uint32_t entity : m_partition.GetCell(cell).entities) {
+            const std::wstring& model_name = m_definitions[m_placements[entity].definition].GetModelName();
+            if (models.insert(model_name).second) {
+                const auto res = model_bytes.emplace(model_name, 0);
+                if (res.second) {
+                    res.first->second = file_mgr->EstimateModelBytes(model_name);
+                }
+                bytes += res.first->second;
+            }
+        }
+        m_partition.SetCellBytes(cell, bytes);
+    }
+
+    m_cell_entities.clear();
+    m_cell_entities.resize(m_partition.GetCellsNum());
+    m_resident_cells.clear();
+    m_stats = Stats{};
+
+    m_stop = false;
+    m_worker = std::thread(&LevelStreamer::WorkerLoop, this);
+}
+
+void LevelStreamer::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_jobs.clear();
+    }
+    m_cv.notify_all();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+    m_results.clear();
+}
+
+void LevelStreamer::Update(const DirectX::XMFLOAT3 &camera_pos)
+{
+    std::shared_ptr<FileManager> file_mgr = gFrontend->GetFileManager().lock();
+    if (!file_mgr || !m_worker.joinable()) {
+        return;
+    }
+
+    std::vector<std::unique_ptr<Result>> results;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        results.swap(m_results);
+    }
+    if (!results.empty()) {
+        const std::chrono::steady_clock::time_point merge_start = std::chrono::steady_clock::now();
+        for (std::unique_ptr<Result> &result : results) {
+            Merge(*result, *file_mgr);
+        }
+        m_stats.last_merge_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - merge_start).count();
+    }
+
+    m_partition.Update(camera_pos, m_loads, m_unloads);
+    for (uint32_t cell : m_unloads) {
+        Unload(cell, *file_mgr);
+    }
+
+    if (!m_loads.empty()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (uint32_t cell : m_loads) {
+            Job job;
+            job.cell = cell;
+            for (uint32_t entity : m_partition.GetCell(cell).entities) {
+                const std::wstring& model_name = m_definitions[m_placements[entity].definition].GetModelName();
+                if (std::find(job.model_names.begin(), job.model_names.end(), model_name) == job.model_names.end()) {
+                    job.model_names.push_back(model_name);
+                }
+            }
+            m_jobs.push_back(std::move(job));
+        }
+    }
+    m_cv.notify_one();
+}
+
+void LevelStreamer::WorkerLoop()
+{
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+            if (m_stop) {
+                return;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        std::shared_ptr<FileManager> file_mgr = gFrontend->GetFileManager().lock();
+        if (!file_mgr) {
+            return;
+        }
+
+        std::unique_ptr<Result> result = std::make_unique<Result>();
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        result->cell = job.cell;
+        for (const std::wstring& model_name : job.model_names) {
+            std::unique_ptr<FileManager::ModelImport> import = file_mgr->ImportModel(model_name);
+            file_mgr->PrefetchTextures(*import);
+            result->imports.push_back(std::move(import));
+        }
+        result->model_names = std::move(job.model_names);
+        result->prepare_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_results.push_back(std::move(result));
+    }
+}
+
+void LevelStreamer::Merge(Result &result, FileManager &file_mgr)
+{
+    // textures the worker decoded go to the registry, the rest decode here
+    if (std::shared_ptr<ThreadPool> thread_pool = gFrontend->GetThreadPool().lock()) {
+        file_mgr.LoadTexturesOnCPU(result.imports, *thread_pool);
+    }
+
+    std::vector<LevelEntity> &entities = m_cell_entities[result.cell];
+    for (uint32_t entity : m_partition.GetCell(result.cell).entities) {
+        const level_file::Placement &placement = m_placements[entity];
+        const LevelEntity &definition = m_definitions[placement.definition];
+        const uint32_t model = (uint32_t)(std::find(result.model_names.begin(), result.model_names.end(), definition.GetModelName()) - result.model_names.begin());
+        if (result.imports[model]->nodes.empty()) {
+            m_stats.failures_num++;
+            continue;
+        }
+
+        entities.emplace_back(placement.pos, placement.rot, placement.scale);
+        entities.back().CopyDefinition(definition);
+        entities.back().Setup(file_mgr.MergeModel(*result.imports[model]));
+        entities.back().SetId(entity);
+    }
+
+    m_partition.OnLoaded(result.cell);
+    m_resident_cells.push_back(result.cell);
+    m_stats.resident_cells = (uint32_t)m_resident_cells.size();
+    m_stats.entities_num += (uint32_t)entities.size();
+    m_stats.last_prepare_ms = result.prepare_ms;
+}
+
+void LevelStreamer::Unload(uint32_t cell, FileManager &file_mgr)
+{
+    std::vector<LevelEntity> &entities = m_cell_entities[cell];
+    for (LevelEntity &entity : entities) {
+        file_mgr.ReleaseModelDeferred(entity.GetModel());
+    }
+    m_stats.entities_num -= (uint32_t)entities.size();
+    entities.clear();
+
+    m_resident_cells.erase(std::find(m_resident_cells.begin(), m_resident_cells.end(), cell));
+    m_stats.resident_cells = (uint32_t)m_resident_cells.size();
+}
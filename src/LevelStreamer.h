@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <DirectXMath.h>
+#include "WorldPartition.h"
+#include "LevelFile.h"
+#include "LevelEntity.h"
+#include "FileManager.h"
+
+// Streams the entities of a level in and out by WorldPartition cell around the camera. Models of a cell are
+// imported and their textures decoded on a background thread, merged into the pools at the next frame boundary;
+// models of unloaded cells go to FileManager::ReleaseModelDeferred so frames still in flight can draw them.
+class LevelStreamer {
+public:
+    struct Stats {
+        uint32_t resident_cells{ 0 };   // merged and drawn
+        uint32_t entities_num{ 0 };     // of the resident cells
+        uint32_t failures_num{ 0 };     // models that did not import, their entities are skipped
+        double last_prepare_ms{ 0.0 };  // background
+        double last_merge_ms{ 0.0 };    // frame boundary
+    };
+
+    LevelStreamer() = default;
+    LevelStreamer(const LevelStreamer&) = delete;
+    LevelStreamer& operator=(const LevelStreamer&) = delete;
+    ~LevelStreamer();
+
+    // definitions holds every definition the level places, read by Level::Load
+    void Start(const level_file::LevelDesc &desc, const std::unordered_map<std::wstring, LevelEntity> &definitions, const WorldPartition::Settings &settings);
+    void Stop();
+
+    // main thread, between frames
+    void Update(const DirectX::XMFLOAT3 &camera_pos);
+    const std::vector<uint32_t>& GetResidentCells() const { return m_resident_cells; }
+    std::vector<LevelEntity>& GetCellEntities(uint32_t cell) { return m_cell_entities[cell]; }
+    const WorldPartition& GetPartition() const { return m_partition; }
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    struct Job {
+        uint32_t cell{ 0 };
+        std::vector<std::wstring> model_names;
+    };
+
+    struct Result {
+        uint32_t cell{ 0 };
+        std::vector<std::wstring> model_names;
+        std::vector<std::unique_ptr<FileManager::ModelImport>> imports; // per model name
+        double prepare_ms{ 0.0 };
+    };
+
+    void WorkerLoop();
+    void Merge(Result &result, FileManager &file_mgr);
+    void Unload(uint32_t cell, FileManager &file_mgr);
+
+    WorldPartition m_partition;
+    std::vector<level_file::Placement> m_placements;
+    std::vector<LevelEntity> m_definitions; // per definition index of the placements
+    std::vector<std::vector<LevelEntity>> m_cell_entities;
+    std::vector<uint32_t> m_resident_cells;
+    std::vector<uint32_t> m_loads;
+    std::vector<uint32_t> m_unloads;
+
+    std::thread m_worker;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Job> m_jobs;
+    std::vector<std::unique_ptr<Result>> m_results;
+    bool m_stop{ false };
+    Stats m_stats;
+};
@@ -0,0 +1,599 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace mesh_optimizer {
+
+namespace {
+    // Forsyth, "Linear-Speed Vertex Cache Optimisation"
+    constexpr uint32_t forsyth_cache_size = 32;
+    constexpr float cache_decay_power = 1.5f;
+    constexpr float last_tri_score = 0.75f;
+    constexpr float valence_boost_scale = 2.0f;
+    constexpr float valence_boost_power = 0.5f;
+
+    float VertexScore(int32_t cache_pos, uint32_t live_tris) {
+        if (live_tris == 0) {
+            return -1.f;
+        }
+
+        float score = 0.f;
+        if (cache_pos >= 0) {
+            if (cache_pos < 3) {
+                // the last triangle's vertices get a fixed score so the same triangle fan is not walked twice
+                score = last_tri_score;
+            }
+            else {
+                const float scaler = 1.f / (forsyth_cache_size - 3);
+                score = powf(1.f - (cache_pos - 3) * scaler, cache_decay_power);
+            }
+        }
+
+        // vertices with few triangles left are prioritized to get rid of lone triangles
+        return score + valence_boost_scale * powf((float)live_tris, -valence_boost_power);
+    }
+
+    DirectX::XMFLOAT3 Sub(const DirectX::XMFLOAT3 &lhs, const DirectX::XMFLOAT3 &rhs) {
+        return DirectX::XMFLOAT3(lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z);
+    }
+
+    DirectX::XMFLOAT3 Cross(const DirectX::XMFLOAT3 &lhs, const DirectX::XMFLOAT3 &rhs) {
+        return DirectX::XMFLOAT3(lhs.y * rhs.z - lhs.z * rhs.y, lhs.z * rhs.x - lhs.x * rhs.z, lhs.x * rhs.y - lhs.y * rhs.x);
+    }
+
+    float Dot(const DirectX::XMFLOAT3 &lhs, const DirectX::XMFLOAT3 &rhs) {
+        return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
+    }
+
+    // Garland, Heckbert, "Surface Simplification Using Quadric Error Metrics"; symmetric 4x4 as A, b, c
+    struct Quadric {
+        double a00{ 0 }, a11{ 0 }, a22{ 0 }, a01{ 0 }, a02{ 0 }, a12{ 0 };
+        double b0{ 0 }, b1{ 0 }, b2{ 0 };
+        double c{ 0 };
+
+        void AddPlane(double nx, double ny, double nz, double d) {
+            a00 += nx * nx; a11 += ny * ny; a22 += nz * nz;
+            a01 += nx * ny; a02 += nx * nz; a12 += ny * nz;
+            b0 += nx * d; b1 += ny * d; b2 += nz * d;
+            c += d * d;
+        }
+
+        void Add(const Quadric &q) {
+            a00 += q.a00; a11 += q.a11; a22 += q.a22;
+            a01 += q.a01; a02 += q.a02; a12 += q.a12;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2;
+            c += q.c;
+        }
+
+        // sum of squared distances to the accumulated planes
+        double Evaluate(const DirectX::XMFLOAT3 &p) const {
+            const double x = p.x, y = p.y, z = p.z;
+            const double r = a00 * x * x + a11 * y * y + a22 * z * z + 2 * (a01 * x * y + a02 * x * z + a12 * y * z) + 2 * (b0 * x + b1 * y + b2 * z) + c;
+            return r > 0 ? r : 0;
+        }
+    };
+
+    struct Collapse {
+        uint32_t from;
+        uint32_t to;
+        double cost;
+    };
+}
+
+template<class Index>
+VertexCacheStats AnalyzeVertexCache(const Index* indices, size_t indices_num, uint32_t vertices_num, uint32_t cache_size) {
+    VertexCacheStats stats;
+    const size_t tris_num = indices_num / 3;
+    if (!tris_num || !vertices_num) {
+        return stats;
+    }
+
+    // a vertex is in the fifo while less than cache_size misses happened since it was loaded
+    std::vector<uint32_t> timestamps(vertices_num, 0);
+    std::vector<uint8_t> referenced(vertices_num, 0);
+    uint32_t timestamp = cache_size + 1;
+    uint32_t referenced_num = 0;
+    for (size_t i = 0; i < indices_num; i++) {
+        const Index v = indices[i];
+        if (timestamp - timestamps[v] > cache_size) {
+            timestamps[v] = timestamp++;
+            stats.transformed++;
+        }
+        if (!referenced[v]) {
+            referenced[v] = 1;
+            referenced_num++;
+        }
+    }
+
+    stats.acmr = (float)stats.transformed / tris_num;
+    stats.atvr = (float)stats.transformed / referenced_num;
+
+    return stats;
+}
+
+template<class Index>
+void OptimizeVertexCache(Index* indices, size_t indices_num, uint32_t vertices_num) {
+    const size_t tris_num = indices_num / 3;
+    if (tris_num < 2 || !vertices_num) {
+        return;
+    }
+
+    // vertex -> triangles adjacency, live part of each list is [offsets[v], offsets[v] + live[v])
+    std::vector<uint32_t> live(vertices_num, 0);
+    for (size_t i = 0; i < tris_num * 3; i++) {
+        live[indices[i]]++;
+    }
+    std::vector<uint32_t> offsets(vertices_num, 0);
+    for (uint32_t v = 1; v < vertices_num; v++) {
+        offsets[v] = offsets[v - 1] + live[v - 1];
+    }
+    std::vector<uint32_t> adjacency(tris_num * 3);
+    {
+        std::vector<uint32_t> fill(offsets);
+        for (size_t i = 0; i < tris_num * 3; i++) {
+            adjacency[fill[indices[i]]++] = uint32_t(i / 3);
+        }
+    }
+
+    std::vector<int32_t> cache_pos(vertices_num, -1);
+    std::vector<float> vertex_score(vertices_num);
+    for (uint32_t v = 0; v < vertices_num; v++) {
+        vertex_score[v] = VertexScore(-1, live[v]);
+    }
+
+    std::vector<float> tri_score(tris_num);
+    uint32_t best_tri = 0;
+    for (size_t t = 0; t < tris_num; t++) {
+        tri_score[t] = vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] + vertex_score[indices[t * 3 + 2]];
+        if (tri_score[t] > tri_score[best_tri]) {
+            best_tri = uint32_t(t);
+        }
+    }
+
+    std::vector<uint8_t> emitted(tris_num, 0);
+    std::vector<Index> result;
+    result.reserve(tris_num * 3);
+    std::array<uint32_t, forsyth_cache_size + 3> cache;
+    std::array<uint32_t, forsyth_cache_size + 3> new_cache;
+    uint32_t cache_num = 0;
+    size_t next_unemitted = 0;
+
+    for (size_t emitted_num = 0; emitted_num < tris_num; emitted_num++) {
+        if (best_tri == no_vertex) {
+            // nothing left around the cache, continue in input order
+            while (emitted[next_unemitted]) {
+                next_unemitted++;
+            }
+            best_tri = uint32_t(next_unemitted);
+        }
+
+        emitted[best_tri] = 1;
+        const Index* tri = &indices[best_tri * 3];
+        result.insert(result.end(), tri, tri + 3);
+
+        // most recent first, then what is left of the old cache
+        uint32_t new_cache_num = 0;
+        for (uint32_t k = 0; k < 3; k++) {
+            if (std::find(new_cache.begin(), new_cache.begin() + new_cache_num, (uint32_t)tri[k]) == new_cache.begin() + new_cache_num) {
+                new_cache[new_cache_num++] = tri[k];
+            }
+        }
+        for (uint32_t i = 0; i < cache_num; i++) {
+            const uint32_t v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                new_cache[new_cache_num++] = v;
+            }
+        }
+
+        for (uint32_t k = 0; k < 3; k++) {
+            const uint32_t v = tri[k];
+            uint32_t* adj = &adjacency[offsets[v]];
+            for (uint32_t j = 0; j < live[v]; j++) {
+                if (adj[j] == best_tri) {
+                    adj[j] = adj[live[v] - 1];
+                    live[v]--;
+                    break;
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < new_cache_num; i++) {
+            const uint32_t v = new_cache[i];
+            cache_pos[v] = (i < forsyth_cache_size) ? int32_t(i) : -1;
+            vertex_score[v] = VertexScore(cache_pos[v], live[v]);
+        }
+
+        // only triangles touching the cache changed score
+        best_tri = no_vertex;
+        float best_score = -1.f;
+        for (uint32_t i = 0; i < new_cache_num; i++) {
+            const uint32_t v = new_cache[i];
+            for (uint32_t j = 0; j < live[v]; j++) {
+                const uint32_t t = adjacency[offsets[v] + j];
+                tri_score[t] = vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] + vertex_score[indices[t * 3 + 2]];
+                if (tri_score[t] > best_score) {
+                    best_score = tri_score[t];
+                    best_tri = t;
+                }
+            }
+        }
+
+        cache_num = std::min(new_cache_num, forsyth_cache_size);
+        std::copy(new_cache.begin(), new_cache.begin() + cache_num, cache.begin());
+    }
+
+    std::copy(result.begin(), result.end(), indices);
+}
+
+template<class Index>
+void OptimizeOverdraw(Index* indices, size_t indices_num, const DirectX::XMFLOAT3* vertices, uint32_t vertices_num, float threshold) {
+    const size_t tris_num = indices_num / 3;
+    if (tris_num < 2 || !vertices_num) {
+        return;
+    }
+
+    const VertexCacheStats before = AnalyzeVertexCache(indices, tris_num * 3, vertices_num);
+
+    // a triangle missing the cache on all three vertices starts a new run, moving whole runs costs little acmr
+    std::vector<uint32_t> clusters;
+    {
+        std::vector<uint32_t> timestamps(vertices_num, 0);
+        uint32_t timestamp = fifo_cache_size + 1;
+        for (size_t t = 0; t < tris_num; t++) {
+            uint32_t misses = 0;
+            for (uint32_t k = 0; k < 3; k++) {
+                const Index v = indices[t * 3 + k];
+                if (timestamp - timestamps[v] > fifo_cache_size) {
+                    timestamps[v] = timestamp++;
+                    misses++;
+                }
+            }
+            if (t == 0 || misses == 3) {
+                clusters.push_back(uint32_t(t));
+            }
+        }
+    }
+    if (clusters.size() < 2) {
+        return;
+    }
+
+    DirectX::XMFLOAT3 mesh_center(0.f, 0.f, 0.f);
+    float mesh_area = 0.f;
+    std::vector<float> sort_keys(clusters.size());
+    std::vector<DirectX::XMFLOAT3> cluster_centers(clusters.size());
+    std::vector<DirectX::XMFLOAT3> cluster_normals(clusters.size());
+    for (size_t c = 0; c < clusters.size(); c++) {
+        const size_t end = (c + 1 < clusters.size()) ? clusters[c + 1] : tris_num;
+        DirectX::XMFLOAT3 center(0.f, 0.f, 0.f);
+        DirectX::XMFLOAT3 normal(0.f, 0.f, 0.f);
+        float area = 0.f;
+        for (size_t t = clusters[c]; t < end; t++) {
+            const DirectX::XMFLOAT3 &p0 = vertices[indices[t * 3]];
+            const DirectX::XMFLOAT3 &p1 = vertices[indices[t * 3 + 1]];
+            const DirectX::XMFLOAT3 &p2 = vertices[indices[t * 3 + 2]];
+            const DirectX::XMFLOAT3 n = Cross(Sub(p1, p0), Sub(p2, p0));
+            const float tri_area = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+
+            center.x += (p0.x + p1.x + p2.x) / 3.f * tri_area;
+            center.y += (p0.y + p1.y + p2.y) / 3.f * tri_area;
+            center.z += (p0.z + p1.z + p2.z) / 3.f * tri_area;
+            normal.x += n.x;
+            normal.y += n.y;
+            normal.z += n.z;
+            area += tri_area;
+        }
+
+        mesh_center.x += center.x;
+        mesh_center.y += center.y;
+        mesh_center.z += center.z;
+        mesh_area += area;
+
+        const float inv_area = area > 0.f ? 1.f / area : 0.f;
+        cluster_centers[c] = DirectX::XMFLOAT3(center.x * inv_area, center.y * inv_area, center.z * inv_area);
+        const float normal_len = sqrtf(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        const float inv_len = normal_len > 0.f ? 1.f / normal_len : 0.f;
+        cluster_normals[c] = DirectX::XMFLOAT3(normal.x * inv_len, normal.y * inv_len, normal.z * inv_len);
+    }
+
+    const float inv_mesh_area = mesh_area > 0.f ? 1.f / mesh_area : 0.f;
+    mesh_center = DirectX::XMFLOAT3(mesh_center.x * inv_mesh_area, mesh_center.y * inv_mesh_area, mesh_center.z * inv_mesh_area);
+
+    // clusters facing away from the center are likely to occlude the rest, draw them first
+    for (size_t c = 0; c < clusters.size(); c++) {
+        const DirectX::XMFLOAT3 dir = Sub(cluster_centers[c], mesh_center);
+        sort_keys[c] = dir.x * cluster_normals[c].x + dir.y * cluster_normals[c].y + dir.z * cluster_normals[c].z;
+    }
+
+    std::vector<uint32_t> order(clusters.size());
+    for (uint32_t c = 0; c < order.size(); c++) {
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&sort_keys](uint32_t lhs, uint32_t rhs) { return sort_keys[lhs] > sort_keys[rhs]; });
+
+    std::vector<Index> result;
+    result.reserve(tris_num * 3);
+    for (uint32_t c : order) {
+        const size_t end = (c + 1 < clusters.size()) ? clusters[c + 1] : tris_num;
+        result.insert(result.end(), indices + clusters[c] * 3, indices + end * 3);
+    }
+
+    const VertexCacheStats after = AnalyzeVertexCache(result.data(), result.size(), vertices_num);
+    if (after.acmr <= before.acmr * threshold) {
+        std::copy(result.begin(), result.end(), indices);
+    }
+}
+
+template<class Index>
+uint32_t OptimizeVertexFetchRemap(Index* indices, size_t indices_num, uint32_t vertices_num, std::vector<uint32_t> &remap) {
+    remap.assign(vertices_num, no_vertex);
+    uint32_t next = 0;
+    for (size_t i = 0; i < indices_num; i++) {
+        const Index v = indices[i];
+        if (remap[v] == no_vertex) {
+            remap[v] = next++;
+        }
+        indices[i] = Index(remap[v]);
+    }
+
+    return next;
+}
+
+template<class Index>
+size_t Simplify(Index* destination, const Index* indices, size_t indices_num, const DirectX::XMFLOAT3* vertices, uint32_t vertices_num,
+    size_t target_indices_num, float target_error, float* result_error) {
+    std::vector<uint32_t> result(indices, indices + indices_num - indices_num % 3);
+    double max_cost = 0.0;
+    float extent = 0.f;
+
+    if (result.size() > target_indices_num && vertices_num) {
+        // work in a unit box so target_error does not depend on the mesh scale
+        DirectX::XMFLOAT3 min_p = vertices[0];
+        DirectX::XMFLOAT3 max_p = vertices[0];
+        for (uint32_t v = 1; v < vertices_num; v++) {
+            min_p = DirectX::XMFLOAT3(std::min(min_p.x, vertices[v].x), std::min(min_p.y, vertices[v].y), std::min(min_p.z, vertices[v].z));
+            max_p = DirectX::XMFLOAT3(std::max(max_p.x, vertices[v].x), std::max(max_p.y, vertices[v].y), std::max(max_p.z, vertices[v].z));
+        }
+        extent = std::max(max_p.x - min_p.x, std::max(max_p.y - min_p.y, max_p.z - min_p.z));
+        const float inv_extent = extent > 0.f ? 1.f / extent : 0.f;
+        std::vector<DirectX::XMFLOAT3> positions(vertices_num);
+        for (uint32_t v = 0; v < vertices_num; v++) {
+            positions[v] = DirectX::XMFLOAT3((vertices[v].x - min_p.x) * inv_extent, (vertices[v].y - min_p.y) * inv_extent, (vertices[v].z - min_p.z) * inv_extent);
+        }
+
+        // vertices sharing a position are attribute seams, they and everything on an open border stay in place
+        std::vector<uint32_t> canonical(vertices_num);
+        std::vector<uint8_t> locked(vertices_num, 0);
+        {
+            std::vector<uint32_t> order(vertices_num);
+            for (uint32_t v = 0; v < vertices_num; v++) {
+                order[v] = v;
+            }
+            auto less = [&vertices](uint32_t lhs, uint32_t rhs) {
+                const DirectX::XMFLOAT3 &l = vertices[lhs];
+                const DirectX::XMFLOAT3 &r = vertices[rhs];
+                return (l.x != r.x) ? l.x < r.x : (l.y != r.y) ? l.y < r.y : l.z < r.z;
+            };
+            std::sort(order.begin(), order.end(), less);
+            for (uint32_t i = 0; i < vertices_num;) {
+                uint32_t end = i + 1;
+                while (end < vertices_num && !less(order[i], order[end])) {
+                    end++;
+                }
+                for (uint32_t k = i; k < end; k++) {
+                    canonical[order[k]] = order[i];
+                    locked[order[k]] = (end - i) > 1;
+                }
+                i = end;
+            }
+
+            std::vector<uint64_t> edges;
+            edges.reserve(result.size());
+            for (size_t i = 0; i < result.size(); i += 3) {
+                for (uint32_t k = 0; k < 3; k++) {
+                    edges.push_back(uint64_t(canonical[result[i + k]]) << 32 | canonical[result[i + (k + 1) % 3]]);
+                }
+            }
+            std::sort(edges.begin(), edges.end());
+            for (uint64_t edge : edges) {
+                const uint64_t reverse = (edge << 32) | (edge >> 32);
+                if (!std::binary_search(edges.begin(), edges.end(), reverse)) {
+                    locked[uint32_t(edge >> 32)] = 1;
+                    locked[uint32_t(edge)] = 1;
+                }
+            }
+            for (uint32_t v = 0; v < vertices_num; v++) {
+                locked[v] = locked[v] || locked[canonical[v]];
+            }
+        }
+
+        std::vector<Quadric> quadrics(vertices_num);
+        for (size_t i = 0; i < result.size(); i += 3) {
+            const DirectX::XMFLOAT3 &p0 = positions[result[i]];
+            DirectX::XMFLOAT3 n = Cross(Sub(positions[result[i + 1]], p0), Sub(positions[result[i + 2]], p0));
+            const float len = sqrtf(Dot(n, n));
+            if (len <= 0.f) {
+                continue;
+            }
+            n = DirectX::XMFLOAT3(n.x / len, n.y / len, n.z / len);
+            for (uint32_t k = 0; k < 3; k++) {
+                quadrics[result[i + k]].AddPlane(n.x, n.y, n.z, -Dot(n, p0));
+            }
+        }
+
+        const double max_allowed_cost = double(target_error) * double(target_error);
+        std::vector<uint32_t> tri_offsets(vertices_num + 1);
+        std::vector<uint32_t> vertex_tris;
+        std::vector<Collapse> best(vertices_num);
+        std::vector<Collapse> collapses;
+        std::vector<uint32_t> remap(vertices_num);
+        std::vector<uint8_t> touched(vertices_num);
+
+        // each pass collapses independent edges cheapest first, then rebuilds the index list
+        while (result.size() > target_indices_num) {
+            const size_t tris_num = result.size() / 3;
+            std::fill(tri_offsets.begin(), tri_offsets.end(), 0);
+            for (uint32_t v : result) {
+                tri_offsets[v + 1]++;
+            }
+            for (uint32_t v = 0; v < vertices_num; v++) {
+                tri_offsets[v + 1] += tri_offsets[v];
+            }
+            vertex_tris.resize(result.size());
+            {
+                std::vector<uint32_t> fill(tri_offsets.begin(), tri_offsets.end() - 1);
+                for (size_t i = 0; i < result.size(); i++) {
+                    vertex_tris[fill[result[i]]++] = uint32_t(i / 3);
+                }
+            }
+
+            for (Collapse &c : best) {
+                c.cost = -1.0;
+            }
+            for (size_t t = 0; t < tris_num; t++) {
+                for (uint32_t k = 0; k < 6; k++) {
+                    const uint32_t from = result[t * 3 + k % 3];
+                    const uint32_t to = result[t * 3 + (k + 1 + k / 3) % 3];
+                    if (locked[from] || from == to) {
+                        continue;
+                    }
+                    const double cost = quadrics[from].Evaluate(positions[to]);
+                    if (best[from].cost < 0.0 || cost < best[from].cost) {
+                        best[from] = Collapse{ from, to, cost };
+                    }
+                }
+            }
+            collapses.clear();
+            for (uint32_t v = 0; v < vertices_num; v++) {
+                if (best[v].cost >= 0.0 && best[v].cost <= max_allowed_cost) {
+                    collapses.push_back(best[v]);
+                }
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse &lhs, const Collapse &rhs) {
+                return (lhs.cost != rhs.cost) ? lhs.cost < rhs.cost : lhs.from < rhs.from;
+            });
+
+            for (uint32_t v = 0; v < vertices_num; v++) {
+                remap[v] = v;
+            }
+            std::fill(touched.begin(), touched.end(), 0);
+            // a collapse removes two triangles on a closed surface
+            const size_t budget = (result.size() - target_indices_num) / 6 + 1;
+            size_t collapsed = 0;
+            for (const Collapse &c : collapses) {
+                if (touched[c.from] || touched[c.to]) {
+                    continue;
+                }
+
+                // the fan around from must not fold over when it moves to to
+                bool flips = false;
+                for (uint32_t i = tri_offsets[c.from]; i < tri_offsets[c.from + 1] && !flips; i++) {
+                    const uint32_t* tri = &result[vertex_tris[i] * 3];
+                    if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+                        continue;
+                    }
+                    DirectX::XMFLOAT3 before[3];
+                    DirectX::XMFLOAT3 after[3];
+                    for (uint32_t k = 0; k < 3; k++) {
+                        before[k] = positions[tri[k]];
+                        after[k] = positions[(tri[k] == c.from) ? c.to : tri[k]];
+                    }
+                    const DirectX::XMFLOAT3 n0 = Cross(Sub(before[1], before[0]), Sub(before[2], before[0]));
+                    const DirectX::XMFLOAT3 n1 = Cross(Sub(after[1], after[0]), Sub(after[2], after[0]));
+                    flips = Dot(n0, n1) <= 0.f;
+                }
+                if (flips) {
+                    continue;
+                }
+
+                remap[c.from] = c.to;
+                quadrics[c.to].Add(quadrics[c.from]);
+                max_cost = std::max(max_cost, c.cost);
+                for (uint32_t i = tri_offsets[c.from]; i < tri_offsets[c.from + 1]; i++) {
+                    const uint32_t* tri = &result[vertex_tris[i] * 3];
+                    touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+                }
+                if (++collapsed >= budget) {
+                    break;
+                }
+            }
+            if (!collapsed) {
+                break;
+            }
+
+            size_t write = 0;
+            for (size_t i = 0; i < result.size(); i += 3) {
+                const uint32_t a = remap[result[i]];
+                const uint32_t b = remap[result[i + 1]];
+                const uint32_t c = remap[result[i + 2]];
+                if (a != b && b != c && a != c) {
+                    result[write++] = a;
+                    result[write++] = b;
+                    result[write++] = c;
+                }
+            }
+            result.resize(write);
+        }
+    }
+
+    if (result_error) {
+        *result_error = float(sqrt(max_cost)) * extent;
+    }
+    for (size_t i = 0; i < result.size(); i++) {
+        destination[i] = Index(result[i]);
+    }
+
+    return result.size();
+}
+
+DirectX::XMFLOAT4 ComputeBoundingSphere(const DirectX::XMFLOAT3* vertices, uint32_t vertices_num) {
+    if (!vertices_num) {
+        return DirectX::XMFLOAT4(0.f, 0.f, 0.f, 0.f);
+    }
+
+    auto distance_sq = [](const DirectX::XMFLOAT3 &lhs, const DirectX::XMFLOAT3 &rhs) {
+        const DirectX::XMFLOAT3 d = Sub(lhs, rhs);
+        return Dot(d, d);
+    };
+    auto farthest = [&](const DirectX::XMFLOAT3 &from) {
+        uint32_t res = 0;
+        for (uint32_t v = 1; v < vertices_num; v++) {
+            if (distance_sq(vertices[v], from) > distance_sq(vertices[res], from)) {
+                res = v;
+            }
+        }
+        return vertices[res];
+    };
+
+    // start from two far apart points, then grow to cover whatever is left outside
+    const DirectX::XMFLOAT3 p0 = farthest(vertices[0]);
+    const DirectX::XMFLOAT3 p1 = farthest(p0);
+    DirectX::XMFLOAT3 center((p0.x + p1.x) * 0.5f, (p0.y + p1.y) * 0.5f, (p0.z + p1.z) * 0.5f);
+    float radius = sqrtf(distance_sq(p0, p1)) * 0.5f;
+    for (uint32_t v = 0; v < vertices_num; v++) {
+        const float dist = sqrtf(distance_sq(vertices[v], center));
+        if (dist > radius) {
+            const float new_radius = (radius + dist) * 0.5f;
+            const float k = (new_radius - radius) / dist;
+            const DirectX::XMFLOAT3 d = Sub(vertices[v], center);
+            center = DirectX::XMFLOAT3(center.x + d.x * k, center.y + d.y * k, center.z + d.z * k);
+            radius = new_radius;
+        }
+    }
+
+    return DirectX::XMFLOAT4(center.x, center.y, center.z, radius);
+}
+
+template VertexCacheStats AnalyzeVertexCache<uint16_t>(const uint16_t*, size_t, uint32_t, uint32_t);
+template VertexCacheStats AnalyzeVertexCache<uint32_t>(const uint32_t*, size_t, uint32_t, uint32_t);
+template void OptimizeVertexCache<uint16_t>(uint16_t*, size_t, uint32_t);
+template void OptimizeVertexCache<uint32_t>(uint32_t*, size_t, uint32_t);
+template void OptimizeOverdraw<uint16_t>(uint16_t*, size_t, const DirectX::XMFLOAT3*, uint32_t, float);
+template void OptimizeOverdraw<uint32_t>(uint32_t*, size_t, const DirectX::XMFLOAT3*, uint32_t, float);
+template uint32_t OptimizeVertexFetchRemap<uint16_t>(uint16_t*, size_t, uint32_t, std::vector<uint32_t>&);
+template uint32_t OptimizeVertexFetchRemap<uint32_t>(uint32_t*, size_t, uint32_t, std::vector<uint32_t>&);
+template size_t Simplify<uint16_t>(uint16_t*, const uint16_t*, size_t, const DirectX::XMFLOAT3*, uint32_t, size_t, float, float*);
+template size_t Simplify<uint32_t>(uint32_t*, const uint32_t*, size_t, const DirectX::XMFLOAT3*, uint32_t, size_t, float, float*);
+
+}
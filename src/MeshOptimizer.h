@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <DirectXMath.h>
+
+// import time index/vertex reordering for the post-transform cache, overdraw and vertex fetch
+namespace mesh_optimizer {
+    static constexpr uint32_t no_vertex = uint32_t(-1);
+    static constexpr uint32_t fifo_cache_size = 16;
+
+    struct VertexCacheStats {
+        float acmr{ 0.f }; // transformed vertices per triangle, 0.5 is ideal for a regular grid, 3 is worst
+        float atvr{ 0.f }; // transformed vertices per referenced vertex, 1 is ideal
+        uint32_t transformed{ 0 };
+    };
+
+    // fifo post-transform cache simulation
+    template<class Index>
+    VertexCacheStats AnalyzeVertexCache(const Index* indices, size_t indices_num, uint32_t vertices_num, uint32_t cache_size = fifo_cache_size);
+
+    // Forsyth's linear-speed vertex cache optimization, reorders triangles
+    template<class Index>
+    void OptimizeVertexCache(Index* indices, size_t indices_num, uint32_t vertices_num);
+
+    // reorders runs of cache optimized triangles front to back from the outside in,
+    // keeps the input order when acmr would grow more than threshold times
+    template<class Index>
+    void OptimizeOverdraw(Index* indices, size_t indices_num, const DirectX::XMFLOAT3* vertices, uint32_t vertices_num, float threshold = 1.05f);
+
+    // renumbers vertices in first use order so vertex data is read sequentially; returns the new vertex count,
+    // remap[old] is the new index or no_vertex for vertices no triangle uses
+    template<class Index>
+    uint32_t OptimizeVertexFetchRemap(Index* indices, size_t indices_num, uint32_t vertices_num, std::vector<uint32_t> &remap);
+
+    // quadric error edge collapse onto existing vertices, so every vertex attribute stays valid; seams and open borders are kept.
+    // target_error is relative to the mesh extent, result_error is in mesh units; returns the destination index count
+    template<class Index>
+    size_t Simplify(Index* destination, const Index* indices, size_t indices_num, const DirectX::XMFLOAT3* vertices, uint32_t vertices_num,
+        size_t target_indices_num, float target_error, float* result_error = nullptr);
+
+    // Ritter's bounding sphere, xyz is the center and w the radius
+    DirectX::XMFLOAT4 ComputeBoundingSphere(const DirectX::XMFLOAT3* vertices, uint32_t vertices_num);
+
+    template<class T>
+    void RemapStream(std::vector<T> &stream, const std::vector<uint32_t> &remap, uint32_t new_vertices_num) {
+        if (stream.empty()) {
+            return;
+        }
+
+        std::vector<T> remapped(new_vertices_num);
+        for (size_t i = 0; i < stream.size(); i++) {
+            if (remap[i] != no_vertex) {
+                remapped[remap[i]] = stream[i];
+            }
+        }
+        stream.swap(remapped);
+    }
+}
@@ -0,0 +1,288 @@
+#include "PoolBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include "simple_object_pool.h"
+#include "generational_pool.h"
+
+using pro_game_containers::pool_handle;
+
+namespace {
+    constexpr uint32_t elements_num = 64 * 1024;
+
+    struct Element {
+        uint32_t id{ 0 };
+        float payload[15]{};
+    };
+    static_assert(sizeof(Element) == 64, "benchmark element is a cache line");
+
+    // elements alive right now, the pool has to construct and destroy exactly once
+    int32_t live_elements = 0;
+
+    struct Counted {
+        explicit Counted(uint32_t val) : id(val) { live_elements++; }
+        ~Counted() { live_elements--; }
+        uint32_t id;
+    };
+
+    using SimplePool = pro_game_containers::simple_object_pool<Element, elements_num>;
+    using GenerationalPool = pro_game_containers::generational_pool<Element, elements_num / 16, 16>;
+
+    // simple_object_pool has no erase: freed indices go to a side list and a flag per slot, iteration skips them
+    struct SimpleWithFreeList {
+        std::unique_ptr<SimplePool> pool = std::make_unique<SimplePool>();
+        std::vector<uint32_t> free;
+        std::vector<bool> alive = std::vector<bool>(elements_num, false);
+
+        uint32_t Insert(uint32_t id) {
+            uint32_t idx = 0;
+            if (free.empty()) {
+                idx = pool->push_back();
+            }
+            else {
+                idx = free.back();
+                free.pop_back();
+            }
+            (*pool)[idx].id = id;
+            alive[idx] = true;
+            return idx;
+        }
+        void Erase(uint32_t idx) {
+            alive[idx] = false;
+            free.push_back(idx);
+        }
+        uint64_t Sum() {
+            uint64_t sum = 0;
+            uint32_t idx = 0;
+            for (Element& element : *pool) {
+                sum += alive[idx++] ? element.id : 0;
+            }
+            return sum;
+        }
+    };
+
+    uint64_t Sum(GenerationalPool& pool) {
+        uint64_t sum = 0;
+        for (Element& element : pool) {
+            sum += element.id;
+        }
+        return sum;
+    }
+
+    template <class F>
+    double BestNs(uint32_t repeats, uint32_t ops_num, F&& func) {
+        using clock = std::chrono::steady_clock;
+        double best = 0.0;
+        for (uint32_t i = 0; i < repeats; i++) {
+            const clock::time_point start = clock::now();
+            func();
+            const double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / std::max(ops_num, 1u);
+            best = (i == 0) ? ns : std::min(best, ns);
+        }
+        return best;
+    }
+}
+
+namespace pool_benchmark {
+    std::vector<BenchmarkResult> Benchmark(uint32_t ops_num, uint32_t repeats) {
+        std::vector<BenchmarkResult> results;
+        std::mt19937 rng(11);
+        volatile uint64_t sink = 0;
+
+        // the erases of the churn pass, half of the slots at random
+        std::vector<uint32_t> victims(elements_num);
+        for (uint32_t i = 0; i < elements_num; i++) {
+            victims[i] = i;
+        }
+        std::shuffle(victims.begin(), victims.end(), rng);
+        std::vector<uint32_t> lookups(ops_num);
+        std::uniform_int_distribution<uint32_t> any(0, elements_num / 2 - 1);
+        for (uint32_t& lookup : lookups) {
+            lookup = any(rng);
+        }
+
+        BenchmarkResult fill{ "fill", elements_num };
+        fill.simple_ns = BestNs(repeats, elements_num, [&]() {
+            SimpleWithFreeList simple;
+            for (uint32_t i = 0; i < elements_num; i++) {
+                simple.Insert(i);
+            }
+            sink = sink + simple.Sum();
+        });
+        fill.generational_ns = BestNs(repeats, elements_num, [&]() {
+            GenerationalPool pool;
+            for (uint32_t i = 0; i < elements_num; i++) {
+                pool[pool.insert()].id = i;
+            }
+            sink = sink + pool.size();
+        });
+        results.push_back(fill);
+
+        // long lived pools for the rest: full, then half erased and refilled in random order ops_num times
+        SimpleWithFreeList simple;
+        GenerationalPool pool;
+        std::vector<pool_handle> handles(elements_num);
+        for (uint32_t i = 0; i < elements_num; i++) {
+            simple.Insert(i);
+            handles[i] = pool.insert();
+            pool[handles[i]].id = i;
+        }
+
+        BenchmarkResult iterate{ "iterate full", elements_num };
+        iterate.simple_ns = BestNs(repeats, elements_num, [&]() { sink = sink + simple.Sum(); });
+        iterate.generational_ns = BestNs(repeats, elements_num, [&]() { sink = sink + Sum(pool); });
+        results.push_back(iterate);
+
+        // erase half, then cycle: erase one, insert one
+        std::vector<uint32_t> simple_live(elements_num / 2);
+        std::vector<pool_handle> pool_live(elements_num / 2);
+        for (uint32_t i = 0; i < elements_num / 2; i++) {
+            simple.Erase(victims[i]);
+            pool.erase(handles[victims[i]]);
+            simple_live[i] = victims[elements_num / 2 + i];
+            pool_live[i] = handles[victims[elements_num / 2 + i]];
+        }
+
+        BenchmarkResult churn{ "erase+insert", ops_num };
+        churn.simple_ns = BestNs(repeats, ops_num, [&]() {
+            for (uint32_t i = 0; i < ops_num; i++) {
+                uint32_t& slot = simple_live[lookups[i]];
+                simple.Erase(slot);
+                slot = simple.Insert(i);
+            }
+        });
+        churn.generational_ns = BestNs(repeats, ops_num, [&]() {
+            for (uint32_t i = 0; i < ops_num; i++) {
+                pool_handle& handle = pool_live[lookups[i]];
+                pool.erase(handle);
+                handle = pool.insert();
+                pool[handle].id = i;
+            }
+        });
+        results.push_back(churn);
+
+        BenchmarkResult holes{ "iterate half", elements_num / 2 };
+        holes.simple_ns = BestNs(repeats, elements_num / 2, [&]() { sink = sink + simple.Sum(); });
+        holes.generational_ns = BestNs(repeats, elements_num / 2, [&]() { sink = sink + Sum(pool); });
+        results.push_back(holes);
+
+        // simple_object_pool indexes without any check, the handles pay for the generation compare
+        BenchmarkResult lookup{ "lookup", ops_num };
+        lookup.simple_ns = BestNs(repeats, ops_num, [&]() {
+            uint64_t sum = 0;
+            for (uint32_t i = 0; i < ops_num; i++) {
+                sum += (*simple.pool)[simple_live[lookups[i]]].id;
+            }
+            sink = sink + sum;
+        });
+        lookup.generational_ns = BestNs(repeats, ops_num, [&]() {
+            uint64_t sum = 0;
+            for (uint32_t i = 0; i < ops_num; i++) {
+                const Element* element = pool.get(pool_live[lookups[i]]);
+                sum += element ? element->id : 0;
+            }
+            sink = sink + sum;
+        });
+        results.push_back(lookup);
+
+        return results;
+    }
+
+    std::vector<std::string> Check() {
+        std::vector<std::string> failures;
+        auto check = [&failures](bool passed, const char* name) {
+            if (!passed) {
+                failures.push_back(name);
+            }
+        };
+
+        {
+            pro_game_containers::generational_pool<Counted, 64, 4> pool;
+            std::unordered_map<uint32_t, uint32_t> reference; // handle value, id
+            std::vector<pool_handle> erased;
+            std::mt19937 rng(5);
+
+            // first chunk full, its first element has to stay put while more chunks come
+            std::vector<pool_handle> handles;
+            for (uint32_t i = 0; i < 64; i++) {
+                handles.push_back(pool.insert(i));
+                reference.emplace(handles.back().value, i);
+            }
+            const Counted* first = pool.get(handles[0]);
+            for (uint32_t i = 64; i < 200; i++) {
+                handles.push_back(pool.insert(i));
+                reference.emplace(handles.back().value, i);
+            }
+            check(pool.get(handles[0]) == first && first->id == 0, "pointers stable across chunks");
+            check(pool.reserved() == 256, "chunks allocated on demand");
+
+            // random erases and inserts against the reference
+            uint32_t next_id = 200;
+            for (uint32_t i = 0; i < 5000; i++) {
+                if (!handles.empty() && (rng() % 2 || pool.size() == pool.capacity())) {
+                    const uint32_t at = rng() % handles.size();
+                    check(pool.erase(handles[at]), "erase live handle");
+                    reference.erase(handles[at].value);
+                    erased.push_back(handles[at]);
+                    handles[at] = handles.back();
+                    handles.pop_back();
+                }
+                else {
+                    const pool_handle handle = pool.insert(next_id);
+                    check(reference.emplace(handle.value, next_id++).second, "fresh handle on insert");
+                    handles.push_back(handle);
+                }
+            }
+            check(pool.size() == reference.size(), "size");
+            check(live_elements == (int32_t)reference.size(), "one construction and destruction per element");
+
+            bool stale = true;
+            for (pool_handle handle : erased) {
+                // generations wrap after 4095 erases of a slot, far more than this run does
+                stale &= reference.count(handle.value) || (!pool.is_valid(handle) && !pool.get(handle));
+            }
+            check(stale, "erased handles stay stale");
+            const pool_handle erased_twice = erased.back();
+            check(reference.count(erased_twice.value) || !pool.erase(erased_twice), "erase of a stale handle");
+
+            uint32_t visited = 0;
+            bool matches = true;
+            for (auto it = pool.begin(); it != pool.end(); ++it) {
+                const auto ref = reference.find(it.get_handle().value);
+                matches &= ref != reference.end() && ref->second == it->id;
+                visited++;
+            }
+            check(visited == reference.size() && matches, "dense iteration visits every live element once");
+
+            bool round_trip = true;
+            for (pool_handle handle : handles) {
+                round_trip &= pool.handle_of(pool.get(handle)) == handle;
+            }
+            const Counted outside(0);
+            check(round_trip && !pool.handle_of(&outside), "handle_of");
+
+            // the slot freed last is the one reused, with the next generation
+            const pool_handle last = handles.back();
+            pool.erase(last);
+            reference.erase(last.value);
+            handles.pop_back();
+            const pool_handle reused = pool.insert(next_id);
+            check(reused.index() == last.index() && reused.generation() != last.generation() && !pool.is_valid(last), "slot reuse bumps the generation");
+            handles.push_back(reused);
+
+            pool.clear();
+            bool cleared = pool.empty() && pool.begin() == pool.end();
+            for (pool_handle handle : handles) {
+                cleared &= !pool.is_valid(handle);
+            }
+            check(cleared && live_elements == 1, "clear"); // outside is still alive
+            check((bool)pool.insert(1) && pool.size() == 1, "insert after clear");
+        }
+        check(live_elements == 0, "destructor erases the rest");
+
+        return failures;
+    }
+}
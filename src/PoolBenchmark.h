@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// simple_object_pool against generational_pool on the operations the engine pools see
+namespace pool_benchmark {
+    struct BenchmarkResult {
+        const char* operation{ nullptr };
+        uint32_t ops_num{ 0 };
+        double simple_ns{ 0.0 };        // per operation; erase is a free index list next to the pool, as FileManager had
+        double generational_ns{ 0.0 };
+    };
+
+    // pools of 64k 64 byte elements, ops_num random erases, inserts and lookups, best of repeats
+    std::vector<BenchmarkResult> Benchmark(uint32_t ops_num, uint32_t repeats);
+
+    // generational_pool against a reference model: stale handles, slot reuse, dense iteration, pointer stability
+    // across chunks, handle_of, clear and element lifetimes; names of the checks that failed
+    std::vector<std::string> Check();
+}
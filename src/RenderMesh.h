@@ -2,53 +2,196 @@
 
 #include <vector>
 #include <string>
+#include <memory>
+#include <array>
 #include <cstdint>
+#include <algorithm>
+#include <cassert>
 #include <DirectXMath.h>
 
+class VfsFile;
+class IGpuResource;
+
 class RenderMesh {
 public:
+    // views on the vertex/index streams, either into the owned vectors or into a mapped cooked file
+    struct Streams {
+        const DirectX::XMFLOAT3* vertices{ nullptr };
+        const void* indices{ nullptr }; // uint16_t or uint32_t, see index_size
+        const DirectX::XMFLOAT2* tex_coords{ nullptr };
+        const DirectX::XMFLOAT3* normals{ nullptr };
+        const DirectX::XMFLOAT3* tangents{ nullptr };
+        const DirectX::XMFLOAT3* bitangents{ nullptr };
+        uint32_t vertices_num{ 0 };
+        uint32_t indices_num{ 0 };
+        uint32_t index_size{ sizeof(uint16_t) };
+    };
+
+    // gpu copy of the vertex data for layouts without per model attributes, shared by every model drawing the mesh
+    struct VertexAllocation {
+        uint64_t start{ 0 };
+        uint32_t size{ 0 };
+        uint32_t refs{ 0 };
+    };
+    static constexpr uint32_t vertex_types_num = 6;
+
+    // dequantization of snorm16 positions: center + snorm * extent
+    struct PositionBounds {
+        DirectX::XMFLOAT4 center{ 0.f, 0.f, 0.f, 0.f };
+        DirectX::XMFLOAT4 extent{ 1.f, 1.f, 1.f, 0.f };
+    };
+
+    // range of the index stream drawn at one level of detail, all levels share the vertices
+    struct Lod {
+        uint32_t index_offset{ 0 };
+        uint32_t indices_num{ 0 };
+        float error{ 0.f }; // simplification error relative to the bounding sphere radius
+    };
+    static constexpr uint32_t max_lods = 4;
+
+    RenderMesh() = default;
+    RenderMesh(const RenderMesh&) = delete;
+    RenderMesh& operator=(const RenderMesh&) = delete;
+
     void SetName(const std::wstring &name) { m_name = name; }
     const std::wstring& GetName() const { return m_name; }
     void SetId(uint32_t id) { m_id = id; }
     uint32_t GetId() const { return m_id; }
-    uint32_t GetIndicesNum() const { return (uint32_t)m_indices.size(); }
-    uint32_t GetVerticesNum() const { return (uint32_t)m_vertices.size(); }
-    void* GetIndicesData() const { return (void*)m_indices.data(); }
-    const DirectX::XMFLOAT3& GetVertex(uint32_t idx) const { return m_vertices[idx]; }
-    const DirectX::XMFLOAT2& GetTexCoord(uint32_t idx) const { return m_textCoords[idx]; }
-    const DirectX::XMFLOAT3& GetNormal(uint32_t idx) const { return m_normals[idx]; }
-    const DirectX::XMFLOAT3& GetTangent(uint32_t idx) const { return m_tangents[idx]; }
-    const DirectX::XMFLOAT3& GetBiTangent(uint32_t idx) const { return m_bitangents[idx]; }
+    void SetContentHash(uint64_t hash) { m_content_hash = hash; }
+    uint64_t GetContentHash() const { return m_content_hash; }
+    // models drawing the mesh, FileManager frees it with the last one
+    void AddModelRef() { m_model_refs++; }
+    uint32_t ReleaseModelRef() { assert(m_model_refs); return --m_model_refs; }
+    std::shared_ptr<IGpuResource>& GetIndexBuffer() { return m_index_buffer; }
+    VertexAllocation& GetVertexAllocation(uint32_t vertex_type) { return m_vertex_allocations[vertex_type]; }
+    uint32_t GetIndicesNum() const { return m_streams.indices_num; }
+    uint32_t GetVerticesNum() const { return m_streams.vertices_num; }
+    uint32_t GetIndexSize() const { return m_streams.index_size; }
+    void* GetIndicesData() const { return (void*)m_streams.indices; }
+    const DirectX::XMFLOAT3& GetVertex(uint32_t idx) const { return m_streams.vertices[idx]; }
+    const DirectX::XMFLOAT2& GetTexCoord(uint32_t idx) const { return m_streams.tex_coords[idx]; }
+    const DirectX::XMFLOAT3& GetNormal(uint32_t idx) const { return m_streams.normals[idx]; }
+    const DirectX::XMFLOAT3& GetTangent(uint32_t idx) const { return m_streams.tangents[idx]; }
+    const DirectX::XMFLOAT3& GetBiTangent(uint32_t idx) const { return m_streams.bitangents[idx]; }
+    bool HasTexCoords() const { return m_streams.tex_coords != nullptr; }
+    bool HasNormals() const { return m_streams.normals != nullptr; }
+    bool HasTangents() const { return m_streams.tangents != nullptr; }
+    const Streams& GetStreams() const { return m_streams; }
+    // cpu side streams, owned or mapped
+    uint64_t GetStreamBytes() const {
+        uint64_t vertex_size = sizeof(DirectX::XMFLOAT3);
+        vertex_size += m_streams.tex_coords ? sizeof(DirectX::XMFLOAT2) : 0;
+        vertex_size += m_streams.normals ? sizeof(DirectX::XMFLOAT3) : 0;
+        vertex_size += m_streams.tangents ? sizeof(DirectX::XMFLOAT3) * 2 : 0;
+        return vertex_size * m_streams.vertices_num + (uint64_t)m_streams.index_size * m_streams.indices_num;
+    }
+    // no lods means the whole index stream is one level
+    uint32_t GetLodsNum() const { return m_lods_num; }
+    const Lod& GetLod(uint32_t idx) const { return m_lods[idx]; }
+    const DirectX::XMFLOAT4& GetBoundingSphere() const { return m_bounding_sphere; }
+
+    // mesh aabb, computed on first use, every model drawing the mesh has to quantize the same way
+    const PositionBounds& GetPositionBounds() {
+        if (!m_position_bounds_valid && m_streams.vertices_num) {
+            DirectX::XMFLOAT3 min_p = m_streams.vertices[0];
+            DirectX::XMFLOAT3 max_p = m_streams.vertices[0];
+            for (uint32_t i = 1; i < m_streams.vertices_num; i++) {
+                const DirectX::XMFLOAT3 &p = m_streams.vertices[i];
+                min_p = DirectX::XMFLOAT3(std::min(min_p.x, p.x), std::min(min_p.y, p.y), std::min(min_p.z, p.z));
+                max_p = DirectX::XMFLOAT3(std::max(max_p.x, p.x), std::max(max_p.y, p.y), std::max(max_p.z, p.z));
+            }
+            // flat meshes still need a non zero extent to divide by
+            auto extent = [](float lo, float hi) { return std::max((hi - lo) * 0.5f, 1e-6f); };
+            m_position_bounds.center = DirectX::XMFLOAT4((min_p.x + max_p.x) * 0.5f, (min_p.y + max_p.y) * 0.5f, (min_p.z + max_p.z) * 0.5f, 0.f);
+            m_position_bounds.extent = DirectX::XMFLOAT4(extent(min_p.x, max_p.x), extent(min_p.y, max_p.y), extent(min_p.z, max_p.z), 0.f);
+            m_position_bounds_valid = true;
+        }
+        return m_position_bounds;
+    }
+
+    void SetLods(const Lod* lods, uint32_t lods_num, const DirectX::XMFLOAT4 &bounding_sphere) {
+        m_lods_num = std::min(lods_num, max_lods);
+        std::copy(lods, lods + m_lods_num, m_lods.begin());
+        m_bounding_sphere = bounding_sphere;
+    }
+
+    // coarsest level whose error stays within max_error_px when the bounding sphere projects to radius_px
+    uint32_t SelectLod(float radius_px, float max_error_px) const {
+        uint32_t lod = 0;
+        while (lod + 1 < m_lods_num && m_lods[lod + 1].error * radius_px <= max_error_px) {
+            lod++;
+        }
+        return lod;
+    }
 
     virtual void SetVertices(std::vector<DirectX::XMFLOAT3> vertices) {
         m_vertices.swap(vertices);
+        m_streams.vertices = m_vertices.data();
+        m_streams.vertices_num = (uint32_t)m_vertices.size();
+        m_position_bounds_valid = false;
     }
 
     virtual void SetIndices(std::vector<uint16_t> indices) {
         m_indices.swap(indices);
+        m_indices32.clear();
+        m_streams.indices = m_indices.data();
+        m_streams.indices_num = (uint32_t)m_indices.size();
+        m_streams.index_size = sizeof(uint16_t);
+    }
+
+    // only for meshes with more than 64k vertices, 16 bit indices take half the bandwidth
+    virtual void SetIndices(std::vector<uint32_t> indices) {
+        m_indices32.swap(indices);
+        m_indices.clear();
+        m_streams.indices = m_indices32.data();
+        m_streams.indices_num = (uint32_t)m_indices32.size();
+        m_streams.index_size = sizeof(uint32_t);
     }
 
     virtual void SetTextureCoords(std::vector<DirectX::XMFLOAT2> textCoords) {
         m_textCoords.swap(textCoords);
+        m_streams.tex_coords = m_textCoords.empty() ? nullptr : m_textCoords.data();
     }
 
     void SetNormals(std::vector<DirectX::XMFLOAT3> normals){
         m_normals.swap(normals);
+        m_streams.normals = m_normals.empty() ? nullptr : m_normals.data();
     }
 
     void SetTangents(std::vector<DirectX::XMFLOAT3> tangents, std::vector<DirectX::XMFLOAT3> bitangents){
         m_tangents.swap(tangents);
         m_bitangents.swap(bitangents);
+        m_streams.tangents = m_tangents.empty() ? nullptr : m_tangents.data();
+        m_streams.bitangents = m_bitangents.empty() ? nullptr : m_bitangents.data();
+    }
+
+    // no copy, the mesh keeps the mapping alive for as long as it points into it
+    void SetMappedStreams(const Streams& streams, std::shared_ptr<VfsFile> mapping) {
+        m_streams = streams;
+        m_mapping = std::move(mapping);
+        m_position_bounds_valid = false;
     }
 
 private:
     std::vector<DirectX::XMFLOAT3> m_vertices;
     std::vector<uint16_t> m_indices;
+    std::vector<uint32_t> m_indices32;
     std::vector<DirectX::XMFLOAT2> m_textCoords;
     std::vector<DirectX::XMFLOAT3> m_normals;
     std::vector<DirectX::XMFLOAT3> m_tangents;
     std::vector<DirectX::XMFLOAT3> m_bitangents;
+    Streams m_streams;
+    std::shared_ptr<VfsFile> m_mapping;
+    std::shared_ptr<IGpuResource> m_index_buffer;
+    std::array<VertexAllocation, vertex_types_num> m_vertex_allocations;
+    uint64_t m_content_hash{ 0 };
+    uint32_t m_model_refs{ 0 };
+    std::array<Lod, max_lods> m_lods;
+    uint32_t m_lods_num{ 0 };
+    DirectX::XMFLOAT4 m_bounding_sphere{ 0.f, 0.f, 0.f, 0.f };
+    PositionBounds m_position_bounds;
+    bool m_position_bounds_valid{ false };
 
     std::wstring m_name;
     uint32_t m_id{uint32_t(-1)};
-};
\ No newline at end of file
+};
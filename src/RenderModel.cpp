@@ -4,9 +4,12 @@
 #include "RenderHelper.h"
 #include "Frontend.h"
 #include "VertexFormats.h"
+#include "VertexAssembly.h"
+#include "ThreadPool.h"
 #include "ICommandQueue.h"
 #include "IDynamicGpuHeap.h"
 #include "GpuDataManager.h"
+#include "Logger.h"
 #include "defines.h"
 #include "ICommandList.h"
 #include "IResourceDescriptor.h"
@@ -17,13 +20,18 @@
 #include "Frontend.h"
 #include "Level.h"
 #include "FileManager.h"
+#include "FreeCamera.h"
+
+#include <algorithm>
 
 extern Frontend* gFrontend;
 
+// a level is used while its simplification error covers at most this many pixels
+static constexpr float lod_max_error_px = 1.f;
+
 RenderModel::RenderModel() :
     m_transformations(std::make_unique<Transformations>())
 {
-    m_dirty |= db_rt_cbv;
 }
 
 RenderModel::~RenderModel() = default;
@@ -44,33 +52,42 @@ void RenderModel::Scale(const DirectX::XMFLOAT3 &scale){
     m_transformations->Scale(scale);
 }
 
-void RenderModel::FormVertexes(){
+bool RenderModel::FormVertexes(){
     const ITechniques::Technique * tech = gFrontend->GetTechniqueById(m_tech_id);
+    const uint32_t vertex_type = tech->vertex_type;
+    const uint32_t size = m_mesh->GetVerticesNum() * GetSizeByVertexType(vertex_type);
+    const bool failed_before = (m_vertex_buffer_start == GpuDataManager::invalid_vertex_offset);
 
-    if (tech->vertex_type == 0) {
-        using Vertex = Vertex0;
-        AllocateVertexBuffer(m_mesh->GetVerticesNum() * sizeof(Vertex));
-        Vertex* vertex_data_buffer = (Vertex*) m_vertex_buffer_start;
-        for (uint32_t i = 0; i < m_mesh->GetVerticesNum(); i++) {
-            vertex_data_buffer[i] = Vertex{ m_mesh->GetVertex(i), m_mesh->GetNormal(i), m_color};
-        }
+    // layouts with per model attributes get their own copy, the rest is assembled once per mesh
+    bool fill = false;
+    if (vertex_type == 0 || vertex_type == 4) {
+        AllocateVertexBuffer(size);
+        fill = true;
     }
-    else if (tech->vertex_type == 1) {
-        using Vertex = Vertex1;
-        AllocateVertexBuffer(m_mesh->GetVerticesNum() * sizeof(Vertex));
-        Vertex* vertex_data_buffer = (Vertex*) m_vertex_buffer_start;
-        for (uint32_t i = 0; i < m_mesh->GetVerticesNum(); i++) {
-            vertex_data_buffer[i] = Vertex{m_mesh->GetVertex(i), m_mesh->GetNormal(i), m_mesh->GetTangent(i), m_mesh->GetBiTangent(i), m_mesh->GetTexCoord(i) };
-        }
+    else if (vertex_type != 2) {
+        fill = AllocateSharedVertexBuffer(vertex_type, size);
     }
-    else if (tech->vertex_type == 3){
-        using Vertex = Vertex3;
-        AllocateVertexBuffer(m_mesh->GetVerticesNum() * sizeof(Vertex));
-        Vertex* vertex_data_buffer = (Vertex*) m_vertex_buffer_start;
-        for (uint32_t i = 0; i < m_mesh->GetVerticesNum(); i++) {
-            vertex_data_buffer[i] = Vertex{m_mesh->GetVertex(i) };
+
+    if (m_vertex_buffer_start == GpuDataManager::invalid_vertex_offset) {
+        if (!failed_before) {
+            gFrontend->GetLogger()->hlog(logger::ll_WARNING, "vertex storage full: %u bytes for a model, not drawn until it fits", size);
         }
+        return false;
+    }
+    if (!fill) {
+        return true;
+    }
+
+    vertex_assembly::Params params;
+    params.color = m_color;
+    if (vertex_type == 4 || vertex_type == 5) {
+        params.bounds = m_mesh->GetPositionBounds();
     }
+
+    std::shared_ptr<ThreadPool> thread_pool = gFrontend->GetThreadPool().lock();
+    std::shared_ptr<GpuDataManager> gpu_res_mgr = gFrontend->GetGpuDataManager().lock();
+    vertex_assembly::AssembleVertices(vertex_type, m_mesh->GetStreams(), params, gpu_res_mgr->GetVertexData(m_vertex_buffer_start), thread_pool.get());
+    return true;
 }
 
 void RenderModel::LoadTextures(ICommandList* command_list){
@@ -78,44 +95,33 @@ void RenderModel::LoadTextures(ICommandList* command_list){
         return;
     }
 
+    std::shared_ptr<FileManager> fm = gFrontend->GetFileManager().lock();
     for (uint32_t idx = 0; idx < TextureType::TextureCount; idx++){
-        IGpuResource *res = nullptr;
+        std::shared_ptr<IGpuResource> *res = nullptr;
         uint8_t flag = 0;
 
         switch(TextureType(idx)){
             case TextureType::DiffuseTexture:
                 flag = db_diffuse_tx;
-                if (m_dirty & flag){
-                    m_diffuse_tex.reset(CreateGpuResource());
-                    res = m_diffuse_tex.get();
-                }
+                res = &m_diffuse_tex;
                 break;
             case TextureType::NormalTexture:
                 flag = db_normals_tx;
-                if (m_dirty & flag){
-                    m_normals_tex.reset(CreateGpuResource());
-                    res = m_normals_tex.get();
-                }
+                res = &m_normals_tex;
                 break;
             case TextureType::MetallicTexture:
                 flag = db_metallic_tx;
-                if(m_dirty & flag){
-                    m_metallic_tex.reset(CreateGpuResource());
-                    res = m_metallic_tex.get();
-                }
+                res = &m_metallic_tex;
                 break;
 			case TextureType::RoughTexture:
 				flag = db_rough_tx;
-				if (m_dirty & flag) {
-                    m_roughness_tex.reset(CreateGpuResource());
-					res = m_roughness_tex.get();
-				}
+				res = &m_roughness_tex;
 				break;
         }
 
         if (res && m_dirty & flag){
-            if (std::shared_ptr<FileManager> fm = gFrontend->GetFileManager().lock()) {
-                fm->LoadTextureOnGPU(command_list, res, m_textures_data[idx]);
+            if (fm && m_textures[idx]) {
+                *res = fm->LoadTextureOnGPU(command_list, m_textures[idx].Get());
             }
 
             m_dirty &= (~flag);
@@ -127,7 +133,8 @@ void RenderModel::Render(ICommandList* command_list, const DirectX::XMFLOAT4X4 &
     DirectX::XMMATRIX parent_xform_mx = DirectX::XMLoadFloat4x4(&parent_xform);
     parent_xform_mx = DirectX::XMMatrixMultiply(m_transformations->GetModel(), parent_xform_mx);
 
-    if (m_mesh && m_mesh->GetIndicesNum() > 0){
+    // no room in the vertex storage, nothing to draw from
+    if (m_mesh && m_mesh->GetIndicesNum() > 0 && m_vertex_buffer_start != GpuDataManager::invalid_vertex_offset){
         if (std::shared_ptr<IndexVufferView> ind_view = m_IndexBuffer->Get_Index_View().lock()){
             command_list->SetIndexBuffer(ind_view.get());
         }
@@ -162,23 +169,29 @@ void RenderModel::Render(ICommandList* command_list, const DirectX::XMFLOAT4X4 &
 
         gfx_queue->GetGpuHeap().CommitRootSignature(command_list);
         
-        if (m_constant_buffer) {
-            const ITechniques::Technique* tech = gFrontend->GetTechniqueById(m_tech_id);
-            gFrontend->SetModelCB(m_constant_buffer.get());
-            gFrontend->SetUint32(Constants::cVertexType, tech->vertex_type);
-            gFrontend->SetMatrix4Constant(Constants::cM, parent_xform_mx);
-            gFrontend->SetUint32(Constants::cMat, m_material_id);
-            if (std::shared_ptr<GpuDataManager> gpu_res_mgr = gFrontend->GetGpuDataManager().lock()) {
-                const uint64_t base = gpu_res_mgr->GetBase();
-                gFrontend->SetUint32(Constants::cVertexBufferOffset, uint32_t(m_vertex_buffer_start - base));
-                gpu_res_mgr->GetVertexBuffer();
-            }
-            
-            gFrontend->CommitCB(command_list, cb_model);
+        const ITechniques::Technique* tech = gFrontend->GetTechniqueById(m_tech_id);
+        gFrontend->SetUint32(Constants::cVertexType, tech->vertex_type);
+        if (tech->vertex_type == 4 || tech->vertex_type == 5) {
+            const RenderMesh::PositionBounds &bounds = m_mesh->GetPositionBounds();
+            gFrontend->SetVector4Constant(Constants::cVertexPosCenter, bounds.center);
+            gFrontend->SetVector4Constant(Constants::cVertexPosExtent, bounds.extent);
+        }
+        gFrontend->SetMatrix4Constant(Constants::cM, parent_xform_mx);
+        gFrontend->SetUint32(Constants::cMat, m_material_id);
+        gFrontend->SetUint32(Constants::cVertexBufferOffset, uint32_t(m_vertex_buffer_start));
+        
+        gFrontend->CommitCB(command_list, cb_model);
+
+        uint32_t start_index = 0;
+        uint32_t indices_num = m_mesh->GetIndicesNum();
+        if (m_mesh->GetLodsNum()) {
+            const RenderMesh::Lod &lod = m_mesh->GetLod(SelectLod(parent_xform_mx));
+            start_index = lod.index_offset;
+            indices_num = lod.indices_num;
         }
 
         //TODO("Major! DrawIndexed should be at upper level where you know there are few such meshes to render");
-        command_list->DrawIndexedInstanced(m_mesh->GetIndicesNum(), m_instance_num, 0, 0, 0);
+        command_list->DrawIndexedInstanced(indices_num, m_instance_num, start_index, 0, 0);
     }
     DirectX::XMFLOAT4X4 new_parent_xform;
     DirectX::XMStoreFloat4x4(&new_parent_xform, parent_xform_mx);
@@ -188,16 +201,41 @@ void RenderModel::Render(ICommandList* command_list, const DirectX::XMFLOAT4X4 &
     }
 }
 
+// the main camera picks the level for every pass, so shadows match what is seen
+uint32_t RenderModel::SelectLod(const DirectX::XMMATRIX &world) const {
+    if (m_mesh->GetLodsNum() < 2) {
+        return 0;
+    }
+
+    std::shared_ptr<Level> level = gFrontend->GetLevel().lock();
+    std::shared_ptr<FreeCamera> camera = level ? level->GetCamera().lock() : nullptr;
+    if (!camera) {
+        return 0;
+    }
+
+    const DirectX::XMFLOAT4 &sphere = m_mesh->GetBoundingSphere();
+    const DirectX::XMVECTOR center = DirectX::XMVector3Transform(DirectX::XMVectorSet(sphere.x, sphere.y, sphere.z, 1.f), world);
+    const float scale = std::max(DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[0])),
+        std::max(DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[1])), DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[2]))));
+    const float radius = sphere.w * scale;
+    const float dist = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(center, DirectX::XMLoadFloat3(&camera->GetPosition()))));
+    if (dist <= radius) {
+        return 0;
+    }
+
+    // _22 is cot(fov / 2), it maps view space height at distance 1 to half the screen
+    const float radius_px = radius / dist * camera->GetProjMx()._22 * 0.5f * (float)gFrontend->GetHeight();
+    return m_mesh->SelectLod(radius_px, lod_max_error_px);
+}
+
 void RenderModel::LoadDataToGpu(ICommandList* command_list){
     if (m_mesh && m_mesh->GetIndicesNum() > 0){
-        if (m_dirty & db_vertex){
-            FormVertexes();
+        if ((m_dirty & db_vertex) && FormVertexes()){
             m_dirty &= (~db_vertex);
         }
         const ITechniques::Technique * tech = gFrontend->GetTechniqueById(m_tech_id);
         LoadIndexDataOnGpu(command_list);
         LoadTextures(command_list);
-        LoadConstantData(command_list);
     }
 
     for (auto &child : m_children){
@@ -205,8 +243,8 @@ void RenderModel::LoadDataToGpu(ICommandList* command_list){
     }
 }
 
-void RenderModel::SetTexture(ITextureLoader::TextureData * texture_data, TextureType type){
-    m_textures_data[type] = texture_data;
+void RenderModel::SetTexture(const TextureHandle &texture, TextureType type){
+    m_textures[type] = texture;
     switch (type){
         case TextureType::DiffuseTexture:
             m_dirty |= db_diffuse_tx;
@@ -223,6 +261,21 @@ void RenderModel::SetTexture(ITextureLoader::TextureData * texture_data, Texture
     }
 }
 
+void RenderModel::Release(){
+    for (auto &child : m_children){
+        child->Release();
+    }
+    m_children.clear();
+
+    for (TextureHandle &texture : m_textures){
+        texture = TextureHandle();
+    }
+    m_normals_tex.reset();
+    m_metallic_tex.reset();
+    m_roughness_tex.reset();
+    RenderObject::Release();
+}
+
 IGpuResource* RenderModel::GetTexture(TextureType type)
 {
     switch (type) {
@@ -232,19 +285,4 @@ IGpuResource* RenderModel::GetTexture(TextureType type)
 		assert(false);
         return nullptr;
     }
-}
-
-void RenderModel::LoadConstantData(ICommandList* command_list){
-    if (m_dirty & db_rt_cbv){
-        m_constant_buffer.reset(CreateGpuResource());
-        uint32_t cb_size = calc_cb_size(sizeof(ConstantBufferManager::ModelCB));
-        m_constant_buffer->CreateBuffer(HeapType::ht_upload, cb_size, ResourceState::rs_resource_state_generic_read, std::wstring(L"models_cbv_").append(m_name));
-        CBVdesc desc;
-        desc.size_in_bytes = cb_size;
-        m_constant_buffer->Create_CBV(desc);
-		if (std::shared_ptr<IHeapBuffer> buff = m_constant_buffer->GetBuffer().lock()) {
-			buff->Map();
-		}
-        m_dirty &= (~db_rt_cbv);
-    }
 }
\ No newline at end of file
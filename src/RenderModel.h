@@ -3,7 +3,7 @@
 #include <array>
 #include "simple_object_pool.h"
 #include "RenderObject.h"
-#include "ITextureLoader.h"
+#include "TextureRegistry.h"
 
 class Transformations;
 class ICommandList;
@@ -19,12 +19,15 @@ public:
 
     void AddChild(RenderModel* child) { m_children.push_back(child); }
     RenderModel* GetChild(uint32_t idx) { return m_children[idx]; }
+    uint32_t GetChildrenNum() const { return (uint32_t)m_children.size(); }
 
     void Move(const DirectX::XMFLOAT3 &pos);
     void Rotate(const DirectX::XMFLOAT3 &angles);
     void Scale(const DirectX::XMFLOAT3 &scale);
+    const Transformations& GetTransformations() const { return *m_transformations; }
 
-    void SetTexture(ITextureLoader::TextureData * texture_data, TextureType type) override;
+    void SetTexture(const TextureHandle &texture, TextureType type) override;
+    void Release() override;
     void SetTechniqueId(uint32_t id) { m_tech_id = id; for(auto &child : m_children) child->SetTechniqueId(id); }
     void SetColor(const DirectX::XMFLOAT3 &color) { m_color = color; for(auto &child : m_children) child->SetColor(color); }
     void SetMaterial(uint32_t id) { m_material_id = id; for(auto &child : m_children) child->SetMaterial(id); }
@@ -32,18 +35,19 @@ public:
     void SetInstancesNum(uint32_t num) { m_instance_num = num; }
 
     IGpuResource* GetTexture(TextureType type);
+    ITextureLoader::TextureData* GetTextureData(TextureType type) const { return m_textures[type].Get(); }
 
 private:
-    inline void FormVertexes();
+    // false when the vertex storage is full, the model is not drawn until a later try gets room
+    inline bool FormVertexes();
     inline void LoadTextures(ICommandList* command_list);
-    inline void LoadConstantData(ICommandList* command_list);
+    uint32_t SelectLod(const DirectX::XMMATRIX &world) const;
 
-    std::unique_ptr<IGpuResource> m_constant_buffer;
-
-    std::unique_ptr<IGpuResource> m_normals_tex;
-    std::unique_ptr<IGpuResource> m_metallic_tex;
-    std::unique_ptr<IGpuResource> m_roughness_tex;
-    std::array<ITextureLoader::TextureData*, TextureCount> m_textures_data;
+    // gpu textures are shared with every model using the same registry entry
+    std::shared_ptr<IGpuResource> m_normals_tex;
+    std::shared_ptr<IGpuResource> m_metallic_tex;
+    std::shared_ptr<IGpuResource> m_roughness_tex;
+    std::array<TextureHandle, TextureCount> m_textures;
     std::unique_ptr<Transformations> m_transformations;
     std::vector<RenderModel*> m_children;
     uint32_t m_instance_num{ 1 };
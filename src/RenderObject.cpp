@@ -4,19 +4,38 @@
 #include "GpuDataManager.h"
 #include "ICommandList.h"
 
+#include <cassert>
+
 extern Frontend* gFrontend;
 
 RenderObject::~RenderObject() {
     DeallocateVertexBuffer();
 }
 
+void RenderObject::Release() {
+    DeallocateVertexBuffer();
+    m_VertexBuffer.reset();
+    m_IndexBuffer.reset();
+    m_diffuse_tex.reset();
+    m_mesh = nullptr;
+    m_is_initialized = false;
+    m_dirty = 0;
+}
+
 void RenderObject::LoadIndexDataOnGpu(ICommandList* command_list){
     if (m_dirty & db_index && m_mesh->GetIndicesNum()){
-        m_IndexBuffer.reset(CreateGpuResource());
-        m_IndexBuffer->CreateBuffer(HeapType::ht_default, (m_mesh->GetIndicesNum() * sizeof(uint16_t)), ResourceState::rs_resource_state_copy_dest, std::wstring(L"index_buffer").append(m_name));
-        m_IndexBuffer->LoadBuffer(command_list, m_mesh->GetIndicesNum(), sizeof(uint16_t), m_mesh->GetIndicesData());
-        command_list->ResourceBarrier(*m_IndexBuffer, ResourceState::rs_resource_state_index_buffer);
-        m_IndexBuffer->Create_Index_View(ResourceFormat::rf_r16_uint, (m_mesh->GetIndicesNum() * sizeof(uint16_t)));
+        // one index buffer per mesh, uploaded by the first model that draws it
+        std::shared_ptr<IGpuResource>& index_buffer = m_mesh->GetIndexBuffer();
+        if (!index_buffer) {
+            const uint32_t index_size = m_mesh->GetIndexSize();
+            const ResourceFormat index_format = (index_size == sizeof(uint32_t)) ? ResourceFormat::rf_r32_uint : ResourceFormat::rf_r16_uint;
+            index_buffer.reset(CreateGpuResource());
+            index_buffer->CreateBuffer(HeapType::ht_default, (m_mesh->GetIndicesNum() * index_size), ResourceState::rs_resource_state_copy_dest, std::wstring(L"index_buffer").append(m_name));
+            index_buffer->LoadBuffer(command_list, m_mesh->GetIndicesNum(), index_size, m_mesh->GetIndicesData());
+            command_list->ResourceBarrier(*index_buffer, ResourceState::rs_resource_state_index_buffer);
+            index_buffer->Create_Index_View(index_format, (m_mesh->GetIndicesNum() * index_size));
+        }
+        m_IndexBuffer = index_buffer;
         m_dirty &= (~db_index);
     }
 }
@@ -28,10 +47,43 @@ void RenderObject::AllocateVertexBuffer(uint32_t size) {
     }
 }
 
+// returns true when the caller is the first user and has to fill the data
+bool RenderObject::AllocateSharedVertexBuffer(uint32_t vertex_type, uint32_t size) {
+    RenderMesh::VertexAllocation& allocation = m_mesh->GetVertexAllocation(vertex_type);
+    if (allocation.refs++) {
+        assert(allocation.size == size);
+        m_vertex_buffer_start = allocation.start;
+        m_vertex_buffer_size = allocation.size;
+        m_shared_vertex_type = vertex_type;
+        return false;
+    }
+
+    AllocateVertexBuffer(size);
+    if (m_vertex_buffer_start == GpuDataManager::invalid_vertex_offset) {
+        allocation.refs--;
+        return false;
+    }
+    allocation.start = m_vertex_buffer_start;
+    allocation.size = m_vertex_buffer_size;
+    m_shared_vertex_type = vertex_type;
+    return true;
+}
+
 void RenderObject::DeallocateVertexBuffer() {
     if (!gFrontend) {
         return;
     }
+
+    if (m_shared_vertex_type != uint32_t(-1)) {
+        RenderMesh::VertexAllocation& allocation = m_mesh->GetVertexAllocation(m_shared_vertex_type);
+        m_shared_vertex_type = uint32_t(-1);
+        if (--allocation.refs) {
+            m_vertex_buffer_start = 0ull;
+            m_vertex_buffer_size = 0ul;
+            return;
+        }
+        allocation = RenderMesh::VertexAllocation{};
+    }
     
     if (std::shared_ptr<GpuDataManager> gpu_res_mgr = gFrontend->GetGpuDataManager().lock()){
         gpu_res_mgr->DeallocateVertexBuffer(m_vertex_buffer_start, m_vertex_buffer_size);
@@ -4,7 +4,7 @@
 #include <vector>
 #include <string>
 #include <memory>
-#include "ITextureLoader.h"
+#include "TextureRegistry.h"
 #include "RenderMesh.h"
 #include "defines.h"
 
@@ -24,11 +24,15 @@ public:
     virtual bool IsInitialized() const { return m_is_initialized; }
     virtual void LoadDataToGpu(ICommandList* command_list) { };
     virtual void SetMesh(RenderMesh * mesh) { m_mesh = mesh; }
-    virtual void SetTexture(ITextureLoader::TextureData * texture_data, TextureType type) {};
+    RenderMesh* GetMesh() const { return m_mesh; }
+    virtual void SetTexture(const TextureHandle &texture, TextureType type) {};
+    // drops the mesh, buffers and textures of a replaced object, the pool slot stays
+    virtual void Release();
 
 protected:
     virtual void LoadIndexDataOnGpu(ICommandList* command_list);
     void AllocateVertexBuffer(uint32_t size);
+    bool AllocateSharedVertexBuffer(uint32_t vertex_type, uint32_t size);
 
     enum dirty_bits {
         db_vertex       = 1 << 0,
@@ -37,18 +41,18 @@ protected:
         db_normals_tx   = 1 << 3,
         db_metallic_tx  = 1 << 4,
         db_rough_tx     = 1 << 5,
-        db_rt_tx        = 1 << 6,
-        db_rt_cbv       = 1 << 7
+        db_rt_tx        = 1 << 6
     };
 
     RenderMesh* m_mesh {nullptr};
 
-    uint64_t m_vertex_buffer_start{0};
+    uint64_t m_vertex_buffer_start{0};  // offset in GpuDataManager's vertex storage
     uint32_t m_vertex_buffer_size{0};
+    uint32_t m_shared_vertex_type{uint32_t(-1)};
 
     std::unique_ptr<IGpuResource> m_VertexBuffer;
-    std::unique_ptr<IGpuResource> m_IndexBuffer;
-    std::unique_ptr<IGpuResource> m_diffuse_tex;
+    std::shared_ptr<IGpuResource> m_IndexBuffer;
+    std::shared_ptr<IGpuResource> m_diffuse_tex;
 
     std::wstring m_name;
     uint32_t m_id{uint32_t(-1)};
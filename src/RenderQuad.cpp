@@ -23,15 +23,15 @@ void RenderQuad::Initialize() {
 
 RenderQuad::~RenderQuad() = default;
 
-bool RenderQuad::CreateQuadTexture(uint32_t width, uint32_t height, const std::vector<ResourceFormat> &formats, uint32_t texture_num, uint32_t uavs, std::optional<std::wstring> dbg_name) {
+bool RenderQuad::CreateQuadTexture(uint32_t width, uint32_t height, const ResourceFormat* formats, uint32_t formats_num, uint32_t texture_num, uint32_t uavs, const wchar_t* dbg_name) {
     if (m_dirty & db_rt_tx){
         // Create a RTV for each frame.
         m_textures.resize(texture_num);
         for (uint32_t n = 0; n < texture_num; n++)
         {
             std::vector<std::shared_ptr<IGpuResource>> &set_resources = m_textures[n];
-            set_resources.resize(formats.size());
-            for (uint32_t m = 0; m < formats.size(); m++){
+            set_resources.resize(formats_num);
+            for (uint32_t m = 0; m < formats_num; m++){
                 set_resources[m].reset(CreateGpuResource());
                 std::shared_ptr<IGpuResource>& res = set_resources[m];
 
@@ -40,7 +40,7 @@ bool RenderQuad::CreateQuadTexture(uint32_t width, uint32_t height, const std::v
                 if (uavs << m)
                     res_flags |= ResourceDesc::ResourceFlags::rf_allow_unordered_access;
                 ResourceDesc res_desc = ResourceDesc::tex_2d(formats[m], width, height, 1, 0, 1, 0, (ResourceDesc::ResourceFlags)res_flags);
-                res->CreateTexture(HeapType::ht_default, res_desc, ResourceState::rs_resource_state_pixel_shader_resource, nullptr, dbg_name.value_or(L"quad_tex_").append(std::to_wstring(n).append(L"-")).append(std::to_wstring(m)));
+                res->CreateTexture(HeapType::ht_default, res_desc, ResourceState::rs_resource_state_pixel_shader_resource, nullptr, std::wstring(dbg_name ? dbg_name : L"quad_tex_").append(std::to_wstring(n).append(L"-")).append(std::to_wstring(m)));
                 res->CreateRTV();
 
                 SRVdesc srv_desc = {};
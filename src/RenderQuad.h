@@ -10,7 +10,8 @@ public:
     ~RenderQuad();
     void Initialize();
 
-    bool CreateQuadTexture(uint32_t width, uint32_t height, const std::vector<ResourceFormat> &formats, uint32_t texture_num, uint32_t uavs, std::optional<std::wstring> dbg_name = std::nullopt);
+    // called every frame, does the work once: no allocations unless the textures get created
+    bool CreateQuadTexture(uint32_t width, uint32_t height, const ResourceFormat* formats, uint32_t formats_num, uint32_t texture_num, uint32_t uavs, const wchar_t* dbg_name = nullptr);
 
     std::weak_ptr<IGpuResource> GetRt(uint32_t set_idx, uint32_t idx_in_set = 0u);
     std::vector< std::shared_ptr<IGpuResource>>& GetRts(uint32_t set_idx) { return m_textures.at(set_idx); }
@@ -2,6 +2,8 @@
 #include "FileManager.h"
 #include "GpuDataManager.h"
 #include "MaterialManager.h"
+#include "ThreadPool.h"
+#include "VirtualFileSystem.h"
 
 ResourceManager::ResourceManager()
 {
@@ -12,9 +14,16 @@ ResourceManager::~ResourceManager() = default;
 void ResourceManager::OnInit(const std::filesystem::path& root_dir){
     m_root_dir = root_dir;
 
+    // loose files under the root, a packed content.pak on top when there is one
+    VirtualFileSystem& vfs = VirtualFileSystem::Get();
+    vfs.SetRoot(root_dir);
+    vfs.MountDirectory(root_dir);
+    vfs.MountPak(root_dir / L"content.pak");
+
     m_fileMgr = std::make_shared<FileManager>();
     m_gpu_data_mgr = std::make_shared<GpuDataManager>();
     m_material_mgr = std::make_shared<MaterialManager>();
+    m_thread_pool = std::make_shared<ThreadPool>();
 }
 
 const std::filesystem::path& ResourceManager::GetRootDir() const{
@@ -7,6 +7,7 @@ class FileManager;
 class ShaderManager;
 class GpuDataManager;
 class MaterialManager;
+class ThreadPool;
 
 class ResourceManager {
 public:
@@ -17,11 +18,13 @@ public:
     virtual std::weak_ptr<FileManager> GetFileManager() const { return m_fileMgr; }
     virtual std::weak_ptr<GpuDataManager> GetGpuDataManager() const { return m_gpu_data_mgr; }
     virtual std::weak_ptr<MaterialManager> GetMaterialManager() const { return m_material_mgr; }
+    virtual std::weak_ptr<ThreadPool> GetThreadPool() const { return m_thread_pool; }
     virtual const std::filesystem::path& GetRootDir() const;
 
 protected:
     std::shared_ptr<FileManager> m_fileMgr;
     std::shared_ptr<GpuDataManager> m_gpu_data_mgr;
     std::shared_ptr<MaterialManager> m_material_mgr;
+    std::shared_ptr<ThreadPool> m_thread_pool;
     std::filesystem::path m_root_dir;
 };
\ No newline at end of file
@@ -13,12 +13,13 @@
 #include <rapidjson/document.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/stringbuffer.h>
-#include <fstream>
+#include <cassert>
 
 #include "Frontend.h"
 #include "RenderModel.h"
 #include "FileManager.h"
 #include "Level.h"
+#include "VirtualFileSystem.h"
 
 extern Frontend *gFrontend;
 using rapidjson::Document;
@@ -31,18 +32,15 @@ SkyBox::SkyBox() : LevelEntity(DirectX::XMFLOAT3(0,0,0), DirectX::XMFLOAT3(0,0,0
 
 void SkyBox::Load(const std::wstring &name) {
     // read file
-    std::string content;
-    {
-        if (std::shared_ptr<Level> level =  gFrontend->GetLevel().lock()){
-            const std::filesystem::path fullPath = (level->GetEntitiesDir() / name);
-            std::ifstream ifs(fullPath.wstring());
-            content.assign((std::istreambuf_iterator<char>(ifs)), (std::istreambuf_iterator<char>()));
-        }
+    std::shared_ptr<VfsFile> file;
+    if (std::shared_ptr<Level> level =  gFrontend->GetLevel().lock()){
+        file = VirtualFileSystem::Get().Open(level->GetEntitiesDir() / name);
     }
+    assert(file);
 
     // parse file
     Document d;
-    d.Parse(content.c_str());
+    d.Parse((const char*)file->GetData(), file->GetSize());
 
     const Value &shaders = d["technique"];
     m_tech_id = shaders.GetInt();
@@ -102,8 +102,7 @@ void Sun::SetupShadowMap(ICommandList* command_list)
 
 	command_list->ResourceBarrier(*(m_shadow_map[m_current_id]), ResourceState::rs_resource_state_depth_write);
 	command_list->ClearDepthStencilView(m_shadow_map[m_current_id].get(), ClearFlagsDsv::cfdsv_depth, 1.0f, 0, 0, nullptr);
-	std::vector<IGpuResource*> rtvs;
-	command_list->SetRenderTargets(rtvs, m_shadow_map[m_current_id].get());
+	command_list->SetRenderTargets(0, nullptr, m_shadow_map[m_current_id].get());
 
 	const ITechniques::Technique* tech = gFrontend->GetTechniqueById(ITechniques::tt_shadow_map);
 	ICommandQueue* queue = command_list->GetQueue();
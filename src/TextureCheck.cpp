@@ -0,0 +1,251 @@
+#include "TextureCheck.h"
+
+#include <cmath>
+#include <cstring>
+#include "ImageDecoder.h"
+#include "TextureCooker.h"
+
+using image_decoder::Image;
+
+namespace {
+    // fixtures made with zlib, the texels are what went in
+    // 3x3 rgba8, rows filtered with sub, up and paeth
+    const uint8_t png_rgba[] = {
+        0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+        0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x03, 0x08, 0x06, 0x00, 0x00, 0x00, 0x56, 0x28, 0xb5,
+        0xbf, 0x00, 0x00, 0x00, 0x21, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x63, 0x64, 0x60, 0x38, 0xf1,
+        0xdf, 0x4d, 0xee, 0xdc, 0x0d, 0x10, 0x66, 0x12, 0x89, 0xfa, 0x76, 0x04, 0x86, 0x59, 0xc0, 0x0c,
+        0xb9, 0x6f, 0x37, 0x40, 0x18, 0x00, 0x58, 0x0a, 0x12, 0x83, 0x60, 0x7d, 0xcd, 0xab, 0x00, 0x00,
+        0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+    };
+    const uint8_t png_rgba_texels[] = {
+        0x00, 0x00, 0xc8, 0xff, 0x46, 0x1e, 0x96, 0xd7, 0x8c, 0x3c, 0x64, 0xaf, 0x14, 0x5a, 0xbe, 0xc3,
+        0x5a, 0x78, 0x8c, 0x9b, 0xa0, 0x96, 0x5a, 0x73, 0x28, 0xb4, 0xb4, 0x87, 0x6e, 0xd2, 0x82, 0x5f,
+        0xb4, 0xf0, 0x50, 0x37,
+    };
+
+    // 2x2 8 bit palette, tRNS gives the first two entries alpha 0 and 128
+    const uint8_t png_palette[] = {
+        0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+        0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, 0x08, 0x03, 0x00, 0x00, 0x00, 0x45, 0x68, 0xfd,
+        0x16, 0x00, 0x00, 0x00, 0x09, 0x50, 0x4c, 0x54, 0x45, 0xff, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00,
+        0x00, 0xff, 0x2d, 0x4a, 0xcd, 0x8a, 0x00, 0x00, 0x00, 0x02, 0x74, 0x52, 0x4e, 0x53, 0x00, 0x80,
+        0x9b, 0x2b, 0x4e, 0x18, 0x00, 0x00, 0x00, 0x0e, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x63, 0x60,
+        0x60, 0x64, 0x60, 0x62, 0x04, 0x00, 0x00, 0x0f, 0x00, 0x05, 0x36, 0xb4, 0x2a, 0x39, 0x00, 0x00,
+        0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+    };
+    const uint8_t png_palette_texels[] = {
+        0xff, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x80, 0x00, 0x00, 0xff, 0xff, 0x00, 0xff, 0x00, 0x80,
+    };
+
+    // 3x3 8 bit gray, Adam7
+    const uint8_t png_interlaced[] = {
+        0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+        0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x03, 0x08, 0x00, 0x00, 0x00, 0x01, 0x04, 0x44, 0xda,
+        0xf5, 0x00, 0x00, 0x00, 0x17, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x63, 0xe0, 0x62, 0xe0, 0x61,
+        0x10, 0x10, 0x62, 0xe0, 0x66, 0x10, 0x64, 0xe0, 0xe5, 0xe3, 0x07, 0x00, 0x03, 0x61, 0x00, 0x7f,
+        0x02, 0x9f, 0x4e, 0xac, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+    };
+    const uint8_t png_interlaced_texels[] = {
+        0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12,
+    };
+
+    // 1x1 gray whose IDAT inflates to 64 KB
+    const uint8_t png_bomb[] = {
+        0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+        0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x08, 0x00, 0x00, 0x00, 0x00, 0x3a, 0x7e, 0x9b,
+        0x55, 0x00, 0x00, 0x00, 0x54, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0xed, 0xc1, 0x01, 0x01, 0x00,
+        0x00, 0x00, 0x80, 0x90, 0xfe, 0xaf, 0xee, 0x08, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x6a, 0x00, 0x0f, 0x00, 0x01, 0x27, 0xdc, 0xdd,
+        0x09, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+    };
+
+    // 3x2 24 bit, bottom-up: a run packet for the bottom row, a raw one for the top
+    const uint8_t tga_rle[] = {
+        0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x02, 0x00,
+        0x18, 0x00, 0x82, 0x0a, 0x14, 0x1e, 0x02, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+    };
+    const uint8_t tga_rle_texels[] = {
+        0x03, 0x02, 0x01, 0xff, 0x06, 0x05, 0x04, 0xff, 0x09, 0x08, 0x07, 0xff, 0x1e, 0x14, 0x0a, 0xff,
+        0x1e, 0x14, 0x0a, 0xff, 0x1e, 0x14, 0x0a, 0xff,
+    };
+
+    // 8x1 new style rle: red a run of 4, green literals 0 to 7, blue a run of 0, exponent a run of 136 (scale 1)
+    const uint8_t hdr_rle[] = {
+        0x23, 0x3f, 0x52, 0x41, 0x44, 0x49, 0x41, 0x4e, 0x43, 0x45, 0x0a, 0x46, 0x4f, 0x52, 0x4d, 0x41,
+        0x54, 0x3d, 0x33, 0x32, 0x2d, 0x62, 0x69, 0x74, 0x5f, 0x72, 0x6c, 0x65, 0x5f, 0x72, 0x67, 0x62,
+        0x65, 0x0a, 0x0a, 0x2d, 0x59, 0x20, 0x31, 0x20, 0x2b, 0x58, 0x20, 0x38, 0x0a, 0x02, 0x02, 0x00,
+        0x08, 0x88, 0x04, 0x08, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x88, 0x00, 0x88, 0x88,
+    };
+    bool DecodesTo(const uint8_t* data, uint64_t size, const char* extension, ResourceFormat format, uint32_t width, uint32_t height, const void* texels,
+        uint64_t texels_size) {
+        Image image;
+        return image_decoder::Decode(data, size, extension, image) && image.format == format && image.width == width && image.height == height &&
+            image.pixels.size() == texels_size && memcmp(image.pixels.data(), texels, texels_size) == 0;
+    }
+
+    bool Rejects(const std::vector<uint8_t>& data, const char* extension) {
+        Image image;
+        return !image_decoder::Decode(data.data(), data.size(), extension, image);
+    }
+
+    void WriteLe32(std::vector<uint8_t>& data, uint64_t offset, uint32_t value) {
+        for (uint32_t i = 0; i < 4; i++) {
+            data[offset + i] = (uint8_t)(value >> (i * 8));
+        }
+    }
+
+    // header, pixel format and, for fourcc DX10, the extension; payload after it
+    std::vector<uint8_t> MakeDds(uint32_t width, uint32_t height, uint32_t mip_levels, uint32_t pf_flags, uint32_t fourcc, uint32_t bits, const uint32_t masks[4],
+        uint32_t dx10_format, uint32_t dx10_array_size, uint32_t dx10_misc, const std::vector<uint8_t>& payload) {
+        const bool dx10 = fourcc == 0x30315844;
+        std::vector<uint8_t> data(4 + 124 + (dx10 ? 20 : 0));
+        memcpy(data.data(), "DDS ", 4);
+        WriteLe32(data, 4, 124);
+        WriteLe32(data, 8, 0x1007 | 0x20000);
+        WriteLe32(data, 12, height);
+        WriteLe32(data, 16, width);
+        WriteLe32(data, 28, mip_levels);
+        WriteLe32(data, 76, 32);
+        WriteLe32(data, 80, pf_flags);
+        WriteLe32(data, 84, fourcc);
+        WriteLe32(data, 88, bits);
+        for (uint32_t i = 0; i < 4; i++) {
+            WriteLe32(data, 92 + i * 4, masks[i]);
+        }
+        if (dx10) {
+            WriteLe32(data, 128, dx10_format);
+            WriteLe32(data, 132, 3);
+            WriteLe32(data, 136, dx10_misc);
+            WriteLe32(data, 140, dx10_array_size);
+        }
+        data.insert(data.end(), payload.begin(), payload.end());
+        return data;
+    }
+
+    void CheckDecoders(std::vector<std::string>& failures) {
+        auto check = [&failures](bool passed, const char* name) {
+            if (!passed) {
+                failures.push_back(name);
+            }
+        };
+
+        check(DecodesTo(png_rgba, sizeof(png_rgba), "png", ResourceFormat::rf_r8g8b8a8_unorm, 3, 3, png_rgba_texels, sizeof(png_rgba_texels)), "png filtered rows");
+        check(DecodesTo(png_palette, sizeof(png_palette), "png", ResourceFormat::rf_r8g8b8a8_unorm, 2, 2, png_palette_texels, sizeof(png_palette_texels)), "png palette");
+        check(DecodesTo(png_interlaced, sizeof(png_interlaced), "png", ResourceFormat::rf_r8_unorm, 3, 3, png_interlaced_texels, sizeof(png_interlaced_texels)),
+            "png adam7");
+        check(DecodesTo(tga_rle, sizeof(tga_rle), "tga", ResourceFormat::rf_r8g8b8a8_unorm, 3, 2, tga_rle_texels, sizeof(tga_rle_texels)), "tga rle");
+
+        float hdr_texels[8 * 4];
+        for (uint32_t x = 0; x < 8; x++) {
+            hdr_texels[x * 4] = 4.f;
+            hdr_texels[x * 4 + 1] = (float)x;
+            hdr_texels[x * 4 + 2] = 0.f;
+            hdr_texels[x * 4 + 3] = 1.f;
+        }
+        check(DecodesTo(hdr_rle, sizeof(hdr_rle), "hdr", ResourceFormat::rf_r32g32b32a32_float, 8, 1, hdr_texels, sizeof(hdr_texels)), "hdr rle");
+
+        const uint32_t bgr_masks[4] = { 0xff0000, 0xff00, 0xff, 0 };
+        const std::vector<uint8_t> bgr = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+        const std::vector<uint8_t> dds_bgr = MakeDds(2, 2, 1, 0x40, 0, 24, bgr_masks, 0, 0, 0, bgr);
+        const uint8_t bgr_texels[] = { 3, 2, 1, 255, 6, 5, 4, 255, 9, 8, 7, 255, 12, 11, 10, 255 };
+        check(DecodesTo(dds_bgr.data(), dds_bgr.size(), "dds", ResourceFormat::rf_r8g8b8a8_unorm, 2, 2, bgr_texels, sizeof(bgr_texels)), "dds 24 bit");
+
+        const uint32_t no_masks[4] = {};
+        std::vector<uint8_t> bc1(16);
+        for (uint32_t i = 0; i < bc1.size(); i++) {
+            bc1[i] = (uint8_t)(i * 17);
+        }
+        const std::vector<uint8_t> dds_bc1 = MakeDds(4, 4, 2, 0x4, 0x30315844, 0, no_masks, (uint32_t)ResourceFormat::rf_bc1_unorm, 1, 0, bc1);
+        Image image;
+        check(image_decoder::Decode(dds_bc1.data(), dds_bc1.size(), "dds", image) && image.format == ResourceFormat::rf_bc1_unorm && image.mip_levels == 2 &&
+            image.subresources.size() == 2 && image.subresources[1].offset == 8 && image.subresources[1].width == 2 && image.pixels == bc1, "dds dx10 bc1 mips");
+
+        // broken and hostile inputs
+        std::vector<uint8_t> data(png_rgba, png_rgba + sizeof(png_rgba));
+        WriteLe32(data, 16, 0x01400000); // big endian 16385
+        check(Rejects(data, "png"), "png over max dimension");
+        data.assign(png_rgba, png_rgba + sizeof(png_rgba) - 20);
+        check(Rejects(data, "png"), "png truncated");
+        check(Rejects(std::vector<uint8_t>(png_bomb, png_bomb + sizeof(png_bomb)), "png"), "png deflate bomb");
+        data.assign(tga_rle, tga_rle + sizeof(tga_rle));
+        data[12] = 0x01;
+        data[13] = 0x40;
+        check(Rejects(data, "tga"), "tga over max dimension");
+        data.assign(tga_rle, tga_rle + sizeof(tga_rle) - 3);
+        check(Rejects(data, "tga"), "tga truncated");
+        const char hdr_big[] = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y 1 +X 16385\n";
+        check(Rejects(std::vector<uint8_t>(hdr_big, hdr_big + sizeof(hdr_big) - 1), "hdr"), "hdr over max dimension");
+        check(Rejects(MakeDds(16385, 4, 1, 0x40, 0, 24, bgr_masks, 0, 0, 0, bgr), "dds"), "dds over max dimension");
+        check(Rejects(MakeDds(4, 4, 1, 0x4, 0x30315844, 0, no_masks, (uint32_t)ResourceFormat::rf_bc1_unorm, 0x40000000, 0x4, bc1), "dds"), "dds over max array size");
+    }
+
+    void CheckBlockCodecs(std::vector<std::string>& failures, std::vector<texture_check::CodecResult>& codecs) {
+        // gradients, a hard edge and a little noise, alpha its own ramp
+        constexpr uint32_t size = 64;
+        std::vector<uint8_t> reference(size * size * 4);
+        uint32_t seed = 1;
+        for (uint32_t y = 0; y < size; y++) {
+            for (uint32_t x = 0; x < size; x++) {
+                seed = seed * 1664525u + 1013904223u;
+                const int32_t noise = (int32_t)(seed >> 28) - 8;
+                uint8_t* texel = &reference[(y * size + x) * 4];
+                texel[0] = (uint8_t)std::min(std::max((int32_t)(x * 4) + noise, 0), 255);
+                texel[1] = (uint8_t)std::min(std::max((int32_t)(y * 4) - noise, 0), 255);
+                texel[2] = (x + y < size) ? 40 : 220;
+                texel[3] = (uint8_t)(255 - (x + y) * 2);
+            }
+        }
+
+        struct Codec {
+            const char* name;
+            ResourceFormat format;
+            uint32_t channels;
+            double floor;
+        };
+        static const Codec formats[] = {
+            { "bc1", ResourceFormat::rf_bc1_unorm, 3, 35.0 },
+            { "bc3", ResourceFormat::rf_bc3_unorm, 4, 36.0 },
+            { "bc4", ResourceFormat::rf_bc4_unorm, 1, 45.0 },
+            { "bc5", ResourceFormat::rf_bc5_unorm, 2, 45.0 },
+            { "bc7", ResourceFormat::rf_bc7_unorm, 4, 37.0 },
+        };
+        for (const Codec& codec : formats) {
+            std::vector<uint8_t> decoded(reference.size());
+            for (uint32_t by = 0; by < size; by += 4) {
+                for (uint32_t bx = 0; bx < size; bx += 4) {
+                    uint8_t texels[64];
+                    for (uint32_t row = 0; row < 4; row++) {
+                        memcpy(texels + row * 16, &reference[((by + row) * size + bx) * 4], 16);
+                    }
+                    uint8_t block[16];
+                    texture_cooker::EncodeBlock(codec.format, texels, block);
+                    if (!texture_cooker::DecodeBlock(codec.format, block, texels)) {
+                        memset(texels, 0, sizeof(texels));
+                    }
+                    for (uint32_t row = 0; row < 4; row++) {
+                        memcpy(&decoded[((by + row) * size + bx) * 4], texels + row * 16, 16);
+                    }
+                }
+            }
+
+            const double psnr = texture_cooker::ComputePSNR(reference.data(), decoded.data(), size * size, codec.channels);
+            codecs.push_back({ codec.name, psnr, codec.floor });
+            if (!(psnr >= codec.floor)) {
+                failures.push_back(std::string(codec.name) + " round trip psnr");
+            }
+        }
+    }
+}
+
+namespace texture_check {
+    std::vector<std::string> Check(std::vector<CodecResult>& codecs) {
+        std::vector<std::string> failures;
+        CheckDecoders(failures);
+        CheckBlockCodecs(failures, codecs);
+        return failures;
+    }
+}
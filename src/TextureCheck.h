@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// image_decoder on small fixtures and the block codecs of texture_cooker, no files or gpu needed
+namespace texture_check {
+    struct CodecResult {
+        const char* format{ nullptr };
+        double psnr{ 0.0 };     // dB over the channels the format keeps
+        double floor{ 0.0 };    // the check fails below it
+    };
+
+    // PNG (filtered rows, palette with tRNS, Adam7), RLE TGA, RLE HDR and DDS (24 bit expansion, DX10 BC1 with mips)
+    // fixtures against their texels; oversized, truncated and deflate bomb inputs rejected; BC1/BC3/BC4/BC5/BC7
+    // round trips of a synthetic image above a PSNR floor each. Names of the checks that failed
+    std::vector<std::string> Check(std::vector<CodecResult>& codecs);
+}
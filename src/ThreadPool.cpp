@@ -0,0 +1,98 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t threads_num)
+{
+    if (!threads_num) {
+        threads_num = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // the caller is one of the threads
+    for (uint32_t i = 1; i < threads_num; i++) {
+        m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_job_cv.notify_all();
+    for (std::thread &worker : m_workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)> &job)
+{
+    if (!count) {
+        return;
+    }
+
+    if (m_workers.empty() || count == 1) {
+        for (uint32_t i = 0; i < count; i++) {
+            job(i);
+        }
+        return;
+    }
+
+    Job parallel_job;
+    parallel_job.func = &job;
+    parallel_job.count = count;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(&parallel_job);
+    }
+    m_job_cv.notify_all();
+
+    // with every worker taken the caller runs all of it, nested calls can't wait on each other
+    RunJobs(parallel_job);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Dequeue(parallel_job);
+    m_done_cv.wait(lock, [&parallel_job] { return parallel_job.busy == 0; });
+}
+
+void ThreadPool::RunJobs(Job &job)
+{
+    for (uint32_t idx = job.next++; idx < job.count; idx = job.next++) {
+        (*job.func)(idx);
+    }
+}
+
+void ThreadPool::Dequeue(Job &job)
+{
+    auto it = std::find(m_jobs.begin(), m_jobs.end(), &job);
+    if (it != m_jobs.end()) {
+        m_jobs.erase(it);
+    }
+}
+
+void ThreadPool::WorkerLoop()
+{
+    while (true) {
+        Job* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_job_cv.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+            if (m_stop) {
+                return;
+            }
+            job = m_jobs.front();
+            job->busy++;
+        }
+
+        RunJobs(*job);
+
+        {
+            // out of indices, nobody else should join it; its caller may return once busy drops to 0
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Dequeue(*job);
+            job->busy--;
+        }
+        m_done_cv.notify_all();
+    }
+}
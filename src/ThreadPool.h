@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+// fixed set of workers for load-time fan out; the calling thread joins the work and blocks until it is done
+class ThreadPool {
+public:
+    explicit ThreadPool(uint32_t threads_num = 0);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    // runs job(0..count-1), indices are handed out in order but may finish in any order; any thread may call it,
+    // a job may call it again
+    void ParallelFor(uint32_t count, const std::function<void(uint32_t)> &job);
+    uint32_t GetThreadsNum() const { return (uint32_t)m_workers.size() + 1; }
+
+private:
+    // lives on the stack of its ParallelFor, workers join it while it is queued
+    struct Job {
+        const std::function<void(uint32_t)>* func{ nullptr };
+        uint32_t count{ 0 };
+        std::atomic<uint32_t> next{ 0 };
+        uint32_t busy{ 0 };
+    };
+
+    void WorkerLoop();
+    static void RunJobs(Job &job);
+    void Dequeue(Job &job);
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_job_cv;
+    std::condition_variable m_done_cv;
+    std::vector<Job*> m_jobs;
+    bool m_stop{ false };
+};
@@ -14,6 +14,10 @@ public:
     void Rotate(const DirectX::XMFLOAT3 &rotation);
     void Scale(const DirectX::XMFLOAT3 &scale);
 
+    const DirectX::XMFLOAT3& GetPosition() const { return m_position; }
+    const DirectX::XMFLOAT3& GetRotation() const { return m_rotation; }
+    const DirectX::XMFLOAT3& GetScale() const { return m_scale; }
+
 private:
     DirectX::XMFLOAT4X4 m_model;
     DirectX::XMFLOAT3 m_position;
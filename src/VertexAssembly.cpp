@@ -0,0 +1,399 @@
+#include "VertexAssembly.h"
+
+#include <cassert>
+#include "VertexFormats.h"
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <cstring>
+#include <random>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VERTEX_ASSEMBLY_SSE 1
+#include <emmintrin.h>
+#if defined(__F16C__) || defined(__AVX2__)
+#define VERTEX_ASSEMBLY_F16C 1
+#include <immintrin.h>
+#endif
+#endif
+
+namespace vertex_assembly {
+
+namespace {
+    constexpr uint32_t parallel_chunk = 16 * 1024;
+    const DirectX::XMFLOAT3 zero3(0.f, 0.f, 0.f);
+    const DirectX::XMFLOAT2 zero2(0.f, 0.f);
+
+    struct Quantization {
+        DirectX::XMFLOAT3 center;
+        DirectX::XMFLOAT3 inv_extent;
+
+        explicit Quantization(const RenderMesh::PositionBounds &bounds) :
+            center(bounds.center.x, bounds.center.y, bounds.center.z),
+            inv_extent(1.f / bounds.extent.x, 1.f / bounds.extent.y, 1.f / bounds.extent.z) {}
+    };
+
+    bool IsBitangentFlipped(const DirectX::XMFLOAT3 &n, const DirectX::XMFLOAT3 &t, const DirectX::XMFLOAT3 &b) {
+        const DirectX::XMFLOAT3 c(n.y * t.z - n.z * t.y, n.z * t.x - n.x * t.z, n.x * t.y - n.y * t.x);
+        return c.x * b.x + c.y * b.y + c.z * b.z < 0.f;
+    }
+
+#if VERTEX_ASSEMBLY_SSE
+    struct Float3x4 {
+        __m128 x;
+        __m128 y;
+        __m128 z;
+    };
+
+    // 4 xyz in a row to x, y and z registers
+    Float3x4 Load4(const DirectX::XMFLOAT3* src) {
+        const float* f = &src->x;
+        const __m128 a = _mm_loadu_ps(f);       // x0 y0 z0 x1
+        const __m128 b = _mm_loadu_ps(f + 4);   // y1 z1 x2 y2
+        const __m128 c = _mm_loadu_ps(f + 8);   // z2 x3 y3 z3
+        Float3x4 res;
+        res.x = _mm_shuffle_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 0, 0)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+        res.y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+        res.z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+        return res;
+    }
+
+    void Load4(const DirectX::XMFLOAT2* src, __m128 &u, __m128 &v) {
+        const float* f = &src->x;
+        const __m128 a = _mm_loadu_ps(f);
+        const __m128 b = _mm_loadu_ps(f + 4);
+        u = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        v = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    }
+
+    __m128 Select(__m128 mask, __m128 a, __m128 b) {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    __m128 Abs(__m128 v) {
+        return _mm_andnot_ps(_mm_set1_ps(-0.f), v);
+    }
+
+    // same rounding as vertex_packing::PackSnorm16
+    __m128i Snorm16(__m128 v) {
+        v = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-1.f)), _mm_set1_ps(1.f));
+        v = _mm_mul_ps(v, _mm_set1_ps(32767.f));
+        const __m128 half = _mm_or_ps(_mm_and_ps(v, _mm_set1_ps(-0.f)), _mm_set1_ps(0.5f));
+        return _mm_cvttps_epi32(_mm_add_ps(v, half));
+    }
+
+    __m128i Pack16x2(__m128i lo, __m128i hi) {
+        return _mm_or_si128(_mm_and_si128(lo, _mm_set1_epi32(0xffff)), _mm_slli_epi32(hi, 16));
+    }
+
+    __m128i Octahedral(const Float3x4 &n) {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+        const __m128 minus_one = _mm_set1_ps(-1.f);
+        const __m128 l1 = _mm_add_ps(_mm_add_ps(Abs(n.x), Abs(n.y)), Abs(n.z));
+        const __m128 valid = _mm_cmpgt_ps(l1, zero);
+        const __m128 x = _mm_and_ps(valid, _mm_div_ps(n.x, l1));
+        const __m128 y = _mm_and_ps(valid, _mm_div_ps(n.y, l1));
+        const __m128 fx = _mm_mul_ps(_mm_sub_ps(one, Abs(y)), Select(_mm_cmpge_ps(x, zero), one, minus_one));
+        const __m128 fy = _mm_mul_ps(_mm_sub_ps(one, Abs(x)), Select(_mm_cmpge_ps(y, zero), one, minus_one));
+        const __m128 lower = _mm_cmplt_ps(n.z, zero);
+        return Pack16x2(Snorm16(Select(lower, fx, x)), Snorm16(Select(lower, fy, y)));
+    }
+
+    void PackPositions(const DirectX::XMFLOAT3* src, const Quantization &q, __m128i w, __m128i &lo, __m128i &hi) {
+        const Float3x4 p = Load4(src);
+        const __m128i x = Snorm16(_mm_mul_ps(_mm_sub_ps(p.x, _mm_set1_ps(q.center.x)), _mm_set1_ps(q.inv_extent.x)));
+        const __m128i y = Snorm16(_mm_mul_ps(_mm_sub_ps(p.y, _mm_set1_ps(q.center.y)), _mm_set1_ps(q.inv_extent.y)));
+        const __m128i z = Snorm16(_mm_mul_ps(_mm_sub_ps(p.z, _mm_set1_ps(q.center.z)), _mm_set1_ps(q.inv_extent.z)));
+        lo = Pack16x2(x, y);
+        hi = Pack16x2(z, w);
+    }
+
+    void StorePosition(int16_t (&dst)[4], uint32_t lo, uint32_t hi) {
+        memcpy(&dst[0], &lo, sizeof(lo));
+        memcpy(&dst[2], &hi, sizeof(hi));
+    }
+#endif
+
+    template<class Vertex>
+    struct Layout;
+
+    template<>
+    struct Layout<Vertex0> {
+        static void Scalar(const RenderMesh::Streams &s, const Params &p, Vertex0* dst, uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                dst[i] = Vertex0{ s.vertices[i], s.normals ? s.normals[i] : zero3, p.color };
+            }
+        }
+
+        // plain float copies, the compiler does as well as hand written shuffles
+        static void Simd(const RenderMesh::Streams &s, const Params &p, Vertex0* dst, uint32_t begin, uint32_t end) {
+            Scalar(s, p, dst, begin, end);
+        }
+    };
+
+    template<>
+    struct Layout<Vertex1> {
+        static void Scalar(const RenderMesh::Streams &s, const Params &p, Vertex1* dst, uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                dst[i] = Vertex1{ s.vertices[i], s.normals ? s.normals[i] : zero3, s.tangents ? s.tangents[i] : zero3,
+                    s.bitangents ? s.bitangents[i] : zero3, s.tex_coords ? s.tex_coords[i] : zero2 };
+            }
+        }
+
+        static void Simd(const RenderMesh::Streams &s, const Params &p, Vertex1* dst, uint32_t begin, uint32_t end) {
+            Scalar(s, p, dst, begin, end);
+        }
+    };
+
+    template<>
+    struct Layout<Vertex3> {
+        static void Scalar(const RenderMesh::Streams &s, const Params &p, Vertex3* dst, uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                dst[i] = Vertex3{ s.vertices[i] };
+            }
+        }
+
+        static void Simd(const RenderMesh::Streams &s, const Params &p, Vertex3* dst, uint32_t begin, uint32_t end) {
+            Scalar(s, p, dst, begin, end);
+        }
+    };
+
+    template<>
+    struct Layout<Vertex4> {
+        static void Scalar(const RenderMesh::Streams &s, const Params &p, Vertex4* dst, uint32_t begin, uint32_t end) {
+            const Quantization q(p.bounds);
+            const uint32_t color = vertex_packing::PackUnorm8x4(p.color);
+            for (uint32_t i = begin; i < end; i++) {
+                Vertex4 &vertex = dst[i];
+                vertex_packing::PackPosition(s.vertices[i], q.center, q.inv_extent, vertex.Position, 0);
+                vertex.Normal = vertex_packing::PackOctahedral(s.normals ? s.normals[i] : zero3);
+                vertex.Color = color;
+            }
+        }
+
+        static void Simd(const RenderMesh::Streams &s, const Params &p, Vertex4* dst, uint32_t begin, uint32_t end) {
+#if VERTEX_ASSEMBLY_SSE
+            if (s.normals) {
+                const Quantization q(p.bounds);
+                const uint32_t color = vertex_packing::PackUnorm8x4(p.color);
+                alignas(16) uint32_t pos_lo[4];
+                alignas(16) uint32_t pos_hi[4];
+                alignas(16) uint32_t normals[4];
+                for (; begin + 4 <= end; begin += 4) {
+                    __m128i lo;
+                    __m128i hi;
+                    PackPositions(&s.vertices[begin], q, _mm_setzero_si128(), lo, hi);
+                    _mm_store_si128((__m128i*)pos_lo, lo);
+                    _mm_store_si128((__m128i*)pos_hi, hi);
+                    _mm_store_si128((__m128i*)normals, Octahedral(Load4(&s.normals[begin])));
+                    for (uint32_t k = 0; k < 4; k++) {
+                        Vertex4 &vertex = dst[begin + k];
+                        StorePosition(vertex.Position, pos_lo[k], pos_hi[k]);
+                        vertex.Normal = normals[k];
+                        vertex.Color = color;
+                    }
+                }
+            }
+#endif
+            Scalar(s, p, dst, begin, end);
+        }
+    };
+
+    template<>
+    struct Layout<Vertex5> {
+        static void Scalar(const RenderMesh::Streams &s, const Params &p, Vertex5* dst, uint32_t begin, uint32_t end) {
+            const Quantization q(p.bounds);
+            for (uint32_t i = begin; i < end; i++) {
+                const DirectX::XMFLOAT3 &n = s.normals ? s.normals[i] : zero3;
+                const DirectX::XMFLOAT3 &t = s.tangents ? s.tangents[i] : zero3;
+                const DirectX::XMFLOAT3 &b = s.bitangents ? s.bitangents[i] : zero3;
+                Vertex5 &vertex = dst[i];
+                vertex_packing::PackPosition(s.vertices[i], q.center, q.inv_extent, vertex.Position, IsBitangentFlipped(n, t, b) ? -32767 : 32767);
+                vertex.Normal = vertex_packing::PackOctahedral(n);
+                vertex.Tangent = vertex_packing::PackOctahedral(t);
+                vertex.TextCoord = vertex_packing::PackHalf2(s.tex_coords ? s.tex_coords[i] : zero2);
+            }
+        }
+
+        static void Simd(const RenderMesh::Streams &s, const Params &p, Vertex5* dst, uint32_t begin, uint32_t end) {
+#if VERTEX_ASSEMBLY_SSE
+            if (s.normals && s.tangents && s.bitangents && s.tex_coords) {
+                const Quantization q(p.bounds);
+                alignas(16) uint32_t pos_lo[4];
+                alignas(16) uint32_t pos_hi[4];
+                alignas(16) uint32_t normals[4];
+                alignas(16) uint32_t tangents[4];
+                alignas(16) uint32_t tex_coords[4];
+                for (; begin + 4 <= end; begin += 4) {
+                    const Float3x4 n = Load4(&s.normals[begin]);
+                    const Float3x4 t = Load4(&s.tangents[begin]);
+                    const Float3x4 b = Load4(&s.bitangents[begin]);
+                    const __m128 cx = _mm_sub_ps(_mm_mul_ps(n.y, t.z), _mm_mul_ps(n.z, t.y));
+                    const __m128 cy = _mm_sub_ps(_mm_mul_ps(n.z, t.x), _mm_mul_ps(n.x, t.z));
+                    const __m128 cz = _mm_sub_ps(_mm_mul_ps(n.x, t.y), _mm_mul_ps(n.y, t.x));
+                    const __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, b.x), _mm_mul_ps(cy, b.y)), _mm_mul_ps(cz, b.z));
+                    const __m128i flipped = _mm_castps_si128(_mm_cmplt_ps(dot, _mm_setzero_ps()));
+                    const __m128i w = _mm_or_si128(_mm_and_si128(flipped, _mm_set1_epi32(-32767)), _mm_andnot_si128(flipped, _mm_set1_epi32(32767)));
+
+                    __m128i lo;
+                    __m128i hi;
+                    PackPositions(&s.vertices[begin], q, w, lo, hi);
+                    _mm_store_si128((__m128i*)pos_lo, lo);
+                    _mm_store_si128((__m128i*)pos_hi, hi);
+                    _mm_store_si128((__m128i*)normals, Octahedral(n));
+                    _mm_store_si128((__m128i*)tangents, Octahedral(t));
+#if VERTEX_ASSEMBLY_F16C
+                    __m128 u;
+                    __m128 v;
+                    Load4(&s.tex_coords[begin], u, v);
+                    _mm_store_si128((__m128i*)tex_coords, _mm_unpacklo_epi16(_mm_cvtps_ph(u, _MM_FROUND_TO_NEAREST_INT), _mm_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT)));
+#else
+                    for (uint32_t k = 0; k < 4; k++) {
+                        tex_coords[k] = vertex_packing::PackHalf2(s.tex_coords[begin + k]);
+                    }
+#endif
+                    for (uint32_t k = 0; k < 4; k++) {
+                        Vertex5 &vertex = dst[begin + k];
+                        StorePosition(vertex.Position, pos_lo[k], pos_hi[k]);
+                        vertex.Normal = normals[k];
+                        vertex.Tangent = tangents[k];
+                        vertex.TextCoord = tex_coords[k];
+                    }
+                }
+            }
+#endif
+            Scalar(s, p, dst, begin, end);
+        }
+    };
+
+    template<class Vertex>
+    void AssembleParallel(const RenderMesh::Streams &streams, const Params &params, Vertex* dst, ThreadPool* thread_pool) {
+        const uint32_t vertices_num = streams.vertices_num;
+        if (!thread_pool || vertices_num < parallel_chunk * 2) {
+            Assemble<Vertex>(streams, params, dst, 0, vertices_num);
+            return;
+        }
+
+        const uint32_t chunks = (vertices_num + parallel_chunk - 1) / parallel_chunk;
+        thread_pool->ParallelFor(chunks, [&streams, &params, dst, vertices_num](uint32_t chunk) {
+            const uint32_t begin = chunk * parallel_chunk;
+            Assemble<Vertex>(streams, params, dst, begin, std::min(vertices_num, begin + parallel_chunk));
+        });
+    }
+
+    template<class Vertex>
+    BenchmarkResult BenchmarkLayout(uint32_t vertex_type, const RenderMesh::Streams &streams, const Params &params, uint32_t iterations, ThreadPool* thread_pool) {
+        using clock = std::chrono::steady_clock;
+        std::vector<Vertex> dst(streams.vertices_num);
+        auto best_vps = [&](auto &&run) {
+            double best_s = 0.0;
+            for (uint32_t it = 0; it < iterations; it++) {
+                const clock::time_point start = clock::now();
+                run();
+                const double s = std::chrono::duration<double>(clock::now() - start).count();
+                best_s = (it == 0) ? s : std::min(best_s, s);
+            }
+            return best_s > 0.0 ? streams.vertices_num / best_s : 0.0;
+        };
+
+        BenchmarkResult res;
+        res.vertex_type = vertex_type;
+        res.vertex_size = sizeof(Vertex);
+        res.scalar_vps = best_vps([&] { Assemble<Vertex, false>(streams, params, dst.data(), 0, streams.vertices_num); });
+        res.simd_vps = best_vps([&] { Assemble<Vertex, true>(streams, params, dst.data(), 0, streams.vertices_num); });
+        res.parallel_vps = best_vps([&] { AssembleParallel(streams, params, dst.data(), thread_pool); });
+        return res;
+    }
+}
+
+template<class Vertex, bool simd>
+void Assemble(const RenderMesh::Streams &streams, const Params &params, Vertex* dst, uint32_t begin, uint32_t end) {
+    if constexpr (simd) {
+        Layout<Vertex>::Simd(streams, params, dst, begin, end);
+    }
+    else {
+        Layout<Vertex>::Scalar(streams, params, dst, begin, end);
+    }
+}
+
+void AssembleVertices(uint32_t vertex_type, const RenderMesh::Streams &streams, const Params &params, void* dst, ThreadPool* thread_pool) {
+    switch (vertex_type) {
+        case 0:
+            AssembleParallel(streams, params, (Vertex0*)dst, thread_pool);
+            break;
+        case 1:
+            AssembleParallel(streams, params, (Vertex1*)dst, thread_pool);
+            break;
+        case 3:
+            AssembleParallel(streams, params, (Vertex3*)dst, thread_pool);
+            break;
+        case 4:
+            AssembleParallel(streams, params, (Vertex4*)dst, thread_pool);
+            break;
+        case 5:
+            AssembleParallel(streams, params, (Vertex5*)dst, thread_pool);
+            break;
+        default:
+            assert(false);
+            break;
+    }
+}
+
+std::vector<BenchmarkResult> Benchmark(uint32_t vertices_num, uint32_t iterations, ThreadPool* thread_pool) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> pos(-10.f, 10.f);
+    std::normal_distribution<float> dir;
+    auto unit = [&]() {
+        const DirectX::XMFLOAT3 v(dir(rng), dir(rng), dir(rng));
+        const float len = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+        return len > 0.f ? DirectX::XMFLOAT3(v.x / len, v.y / len, v.z / len) : DirectX::XMFLOAT3(0.f, 0.f, 1.f);
+    };
+
+    std::vector<DirectX::XMFLOAT3> vertices(vertices_num);
+    std::vector<DirectX::XMFLOAT3> normals(vertices_num);
+    std::vector<DirectX::XMFLOAT3> tangents(vertices_num);
+    std::vector<DirectX::XMFLOAT3> bitangents(vertices_num);
+    std::vector<DirectX::XMFLOAT2> tex_coords(vertices_num);
+    for (uint32_t i = 0; i < vertices_num; i++) {
+        vertices[i] = DirectX::XMFLOAT3(pos(rng), pos(rng), pos(rng));
+        normals[i] = unit();
+        tangents[i] = unit();
+        bitangents[i] = unit();
+        tex_coords[i] = DirectX::XMFLOAT2(pos(rng), pos(rng));
+    }
+
+    RenderMesh::Streams streams;
+    streams.vertices = vertices.data();
+    streams.normals = normals.data();
+    streams.tangents = tangents.data();
+    streams.bitangents = bitangents.data();
+    streams.tex_coords = tex_coords.data();
+    streams.vertices_num = vertices_num;
+
+    Params params;
+    params.color = DirectX::XMFLOAT3(0.5f, 0.3f, 0.7f);
+    params.bounds.center = DirectX::XMFLOAT4(0.f, 0.f, 0.f, 0.f);
+    params.bounds.extent = DirectX::XMFLOAT4(10.f, 10.f, 10.f, 0.f);
+
+    std::vector<BenchmarkResult> results;
+    results.push_back(BenchmarkLayout<Vertex0>(0, streams, params, iterations, thread_pool));
+    results.push_back(BenchmarkLayout<Vertex1>(1, streams, params, iterations, thread_pool));
+    results.push_back(BenchmarkLayout<Vertex3>(3, streams, params, iterations, thread_pool));
+    results.push_back(BenchmarkLayout<Vertex4>(4, streams, params, iterations, thread_pool));
+    results.push_back(BenchmarkLayout<Vertex5>(5, streams, params, iterations, thread_pool));
+    return results;
+}
+
+template void Assemble<Vertex0, false>(const RenderMesh::Streams&, const Params&, Vertex0*, uint32_t, uint32_t);
+template void Assemble<Vertex0, true>(const RenderMesh::Streams&, const Params&, Vertex0*, uint32_t, uint32_t);
+template void Assemble<Vertex1, false>(const RenderMesh::Streams&, const Params&, Vertex1*, uint32_t, uint32_t);
+template void Assemble<Vertex1, true>(const RenderMesh::Streams&, const Params&, Vertex1*, uint32_t, uint32_t);
+template void Assemble<Vertex3, false>(const RenderMesh::Streams&, const Params&, Vertex3*, uint32_t, uint32_t);
+template void Assemble<Vertex3, true>(const RenderMesh::Streams&, const Params&, Vertex3*, uint32_t, uint32_t);
+template void Assemble<Vertex4, false>(const RenderMesh::Streams&, const Params&, Vertex4*, uint32_t, uint32_t);
+template void Assemble<Vertex4, true>(const RenderMesh::Streams&, const Params&, Vertex4*, uint32_t, uint32_t);
+template void Assemble<Vertex5, false>(const RenderMesh::Streams&, const Params&, Vertex5*, uint32_t, uint32_t);
+template void Assemble<Vertex5, true>(const RenderMesh::Streams&, const Params&, Vertex5*, uint32_t, uint32_t);
+
+}
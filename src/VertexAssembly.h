@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include "RenderMesh.h"
+
+class ThreadPool;
+
+// SoA mesh streams to the interleaved layouts of VertexFormats.h, one kernel per layout picked at compile time
+namespace vertex_assembly {
+    // what a layout needs besides the mesh streams
+    struct Params {
+        DirectX::XMFLOAT3 color{ 0.f, 0.f, 0.f };
+        RenderMesh::PositionBounds bounds; // packed layouts only
+    };
+
+    // fills dst[begin, end), dst points at vertex 0; disjoint ranges can be assembled on any thread at the same time
+    template<class Vertex, bool simd = true>
+    void Assemble(const RenderMesh::Streams &streams, const Params &params, Vertex* dst, uint32_t begin, uint32_t end);
+
+    // whole mesh for a technique vertex type, big meshes are split over thread_pool when there is one
+    void AssembleVertices(uint32_t vertex_type, const RenderMesh::Streams &streams, const Params &params, void* dst, ThreadPool* thread_pool);
+
+    struct BenchmarkResult {
+        uint32_t vertex_type{ 0 };
+        uint32_t vertex_size{ 0 };
+        double scalar_vps{ 0.0 };   // vertices per second
+        double simd_vps{ 0.0 };
+        double parallel_vps{ 0.0 };
+    };
+
+    // synthetic mesh with every stream, best of iterations
+    std::vector<BenchmarkResult> Benchmark(uint32_t vertices_num, uint32_t iterations, ThreadPool* thread_pool);
+}
@@ -1,5 +1,9 @@
 #pragma once
 #include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
 
 struct Vertex0
 {
@@ -27,6 +31,69 @@ struct Vertex3
     DirectX::XMFLOAT3 Position;
 };
 
+// packed Vertex0, positions are snorm16 in the mesh bounds (see RenderMesh::GetPositionBounds)
+struct Vertex4
+{
+    int16_t Position[4]; // w unused
+    uint32_t Normal;     // octahedral snorm16x2
+    uint32_t Color;      // rgba8 unorm
+};
+
+// packed Vertex1, the bitangent is cross(normal, tangent) * sign(Position[3])
+struct Vertex5
+{
+    int16_t Position[4];
+    uint32_t Normal;     // octahedral snorm16x2
+    uint32_t Tangent;    // octahedral snorm16x2
+    uint32_t TextCoord;  // half2
+};
+
+namespace vertex_packing {
+    inline int16_t PackSnorm16(float v) {
+        return int16_t(lroundf(std::min(std::max(v, -1.f), 1.f) * 32767.f));
+    }
+
+    inline uint32_t PackSnorm16x2(float x, float y) {
+        return uint32_t(uint16_t(PackSnorm16(x))) | (uint32_t(uint16_t(PackSnorm16(y))) << 16);
+    }
+
+    // unit vector onto the octahedron, the lower half folded over the diagonals
+    inline uint32_t PackOctahedral(const DirectX::XMFLOAT3 &n) {
+        const float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+        if (l1 <= 0.f) {
+            return PackSnorm16x2(0.f, 0.f);
+        }
+
+        float x = n.x / l1;
+        float y = n.y / l1;
+        if (n.z < 0.f) {
+            const float fx = (1.f - fabsf(y)) * (x >= 0.f ? 1.f : -1.f);
+            const float fy = (1.f - fabsf(x)) * (y >= 0.f ? 1.f : -1.f);
+            x = fx;
+            y = fy;
+        }
+
+        return PackSnorm16x2(x, y);
+    }
+
+    inline uint32_t PackHalf2(const DirectX::XMFLOAT2 &v) {
+        return uint32_t(DirectX::PackedVector::XMConvertFloatToHalf(v.x)) | (uint32_t(DirectX::PackedVector::XMConvertFloatToHalf(v.y)) << 16);
+    }
+
+    inline uint32_t PackUnorm8x4(const DirectX::XMFLOAT3 &c) {
+        auto unorm8 = [](float v) { return uint32_t(lroundf(std::min(std::max(v, 0.f), 1.f) * 255.f)); };
+        return unorm8(c.x) | (unorm8(c.y) << 8) | (unorm8(c.z) << 16) | (255u << 24);
+    }
+
+    // center/extent as in RenderMesh::PositionBounds
+    inline void PackPosition(const DirectX::XMFLOAT3 &p, const DirectX::XMFLOAT3 &center, const DirectX::XMFLOAT3 &inv_extent, int16_t (&res)[4], int16_t w) {
+        res[0] = PackSnorm16((p.x - center.x) * inv_extent.x);
+        res[1] = PackSnorm16((p.y - center.y) * inv_extent.y);
+        res[2] = PackSnorm16((p.z - center.z) * inv_extent.z);
+        res[3] = w;
+    }
+}
+
 inline uint32_t GetSizeByVertexType(uint32_t id) {
     switch (id) {
         case 0:
@@ -41,6 +108,12 @@ inline uint32_t GetSizeByVertexType(uint32_t id) {
         case 3:
             return sizeof(Vertex3);
             break;
+        case 4:
+            return sizeof(Vertex4);
+            break;
+        case 5:
+            return sizeof(Vertex5);
+            break;
         default:
             assert(false);
             return uint32_t(-1);
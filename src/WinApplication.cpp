@@ -3,6 +3,8 @@
 #include "WinApplication.h"
 #include "Frontend.h"
 #include "defines.h"
+#include "Logger.h"
+#include "StartupProfiler.h"
 
 #ifndef GET_X_LPARAM
 #define GET_X_LPARAM(lp)                        ((int)(short)LOWORD(lp))
@@ -98,6 +100,8 @@ int WinApplication::Run(HINSTANCE hInstance, int nCmdShow)
 
     // Main sample loop.
     MSG msg = {};
+    bool budget_checked = false;
+    int exit_code = 0;
     while (msg.message != WM_QUIT && !m_frontend->ShouldClose())
     {
         // Process any messages in the queue.
@@ -106,17 +110,46 @@ int WinApplication::Run(HINSTANCE hInstance, int nCmdShow)
             TranslateMessage(&msg);
             DispatchMessage(&msg);
         }
+
+        // frames are drawn on WM_PAINT, the first one counted is on screen
+        if (!budget_checked && m_frontend->FrameNumber() > 0) {
+            budget_checked = true;
+            if (!CheckStartupBudget()) {
+                exit_code = 1;
+                break;
+            }
+        }
     }
 
     m_frontend->OnDestroy();
 
+    if (exit_code) {
+        return exit_code;
+    }
     // Return this part of the WM_QUIT message to Windows.
     return static_cast<char>(msg.wParam);
 }
 
+bool WinApplication::CheckStartupBudget()
+{
+    const double total_ms = StartupProfiler::Get().GetTotalMs();
+    if (m_startup_budget_ms && total_ms > m_startup_budget_ms) {
+        m_frontend->GetLogger()->hlog(logger::ll_ERROR, "startup budget exceeded: %.3f ms, budget %u ms (see startup_profile.json, startup_trace.json)", total_ms, m_startup_budget_ms);
+        return false;
+    }
+    return true;
+}
+
 // Helper function for parsing any supplied command line args.
 void WinApplication::ParseCommandLineArgs(wchar_t* argv[], int argc)
 {
+    for (int i = 1; i < argc; ++i)
+    {
+        if (wcscmp(argv[i], L"--startup-budget-ms") == 0 && i + 1 < argc) {
+            m_startup_budget_ms = (uint32_t)wcstoul(argv[++i], nullptr, 10);
+        }
+    }
+
     //for (int i = 1; i < argc; ++i)
     //{
     //    if (_wcsnicmp(argv[i], L"-warp", wcslen(argv[i])) == 0 ||
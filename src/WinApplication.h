@@ -22,8 +22,10 @@ protected:
 
 private:
     void ParseCommandLineArgs(wchar_t* argv[], int argc);
+    bool CheckStartupBudget();
     std::unique_ptr<Frontend> m_frontend;
     HWND m_hwnd;
+    uint32_t m_startup_budget_ms{ 0 }; // checked once the first frame is presented, 0 only reports
 };
 
 #endif // WIN32
\ No newline at end of file
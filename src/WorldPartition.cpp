@@ -0,0 +1,242 @@
+#include "WorldPartition.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+    float DistanceToCell(const WorldPartition::Cell &cell, float cell_size, float x, float z) {
+        const float min_x = cell.x * cell_size;
+        const float min_z = cell.z * cell_size;
+        const float dx = std::max(std::max(min_x - x, x - (min_x + cell_size)), 0.f);
+        const float dz = std::max(std::max(min_z - z, z - (min_z + cell_size)), 0.f);
+        return sqrtf(dx * dx + dz * dz);
+    }
+
+    struct CameraPath {
+        const char* name;
+        uint32_t frames_num;
+        DirectX::XMFLOAT3 (*pos)(uint32_t frame, float extent, float cell_size);
+    };
+
+    // world spans [0, extent) on x and z
+    const CameraPath camera_paths[] = {
+        { "line", 1200, [](uint32_t frame, float extent, float) {
+            // across and back along the diagonal
+            const float t = (frame < 600) ? frame / 600.f : (1200 - frame) / 600.f;
+            return DirectX::XMFLOAT3(t * extent, 10.f, t * extent);
+        } },
+        { "circle", 1200, [](uint32_t frame, float extent, float) {
+            const float a = frame / 1200.f * 6.2831853f;
+            return DirectX::XMFLOAT3(extent * (0.5f + 0.35f * cosf(a)), 10.f, extent * (0.5f + 0.35f * sinf(a)));
+        } },
+        { "border", 1200, [](uint32_t frame, float extent, float cell_size) {
+            // back and forth over a cell border, well inside the hysteresis band
+            const float x = floorf(extent * 0.5f / cell_size) * cell_size + cell_size * 0.2f * sinf(frame * 0.1f);
+            return DirectX::XMFLOAT3(x, 10.f, extent * 0.5f);
+        } },
+        { "teleport", 1200, [](uint32_t frame, float extent, float) {
+            static const float spots[][2] = { { 0.2f, 0.2f }, { 0.8f, 0.7f }, { 0.3f, 0.9f }, { 0.9f, 0.1f }, { 0.5f, 0.5f } };
+            const float* spot = spots[(frame / 120) % 5];
+            return DirectX::XMFLOAT3(spot[0] * extent, 10.f, spot[1] * extent);
+        } },
+    };
+}
+
+void WorldPartition::Build(const std::vector<DirectX::XMFLOAT3> &positions, const std::vector<uint64_t> &entity_bytes, const Settings &settings) {
+    m_settings = settings;
+    m_settings.unload_radius = std::max(m_settings.unload_radius, m_settings.load_radius);
+    m_settings.max_loads_in_flight = std::max(m_settings.max_loads_in_flight, 1u);
+    m_cells.clear();
+    m_cell_ids.clear();
+    m_stats = Stats{};
+
+    for (uint32_t i = 0; i < positions.size(); i++) {
+        const int32_t x = (int32_t)floorf(positions[i].x / m_settings.cell_size);
+        const int32_t z = (int32_t)floorf(positions[i].z / m_settings.cell_size);
+        const auto res = m_cell_ids.emplace(Key(x, z), (uint32_t)m_cells.size());
+        if (res.second) {
+            m_cells.emplace_back();
+            m_cells.back().x = x;
+            m_cells.back().z = z;
+        }
+        Cell &cell = m_cells[res.first->second];
+        cell.entities.push_back(i);
+        cell.bytes += (i < entity_bytes.size()) ? entity_bytes[i] : 0;
+    }
+    m_stats.cells_num = (uint32_t)m_cells.size();
+}
+
+void WorldPartition::Update(const DirectX::XMFLOAT3 &camera_pos, std::vector<uint32_t> &loads, std::vector<uint32_t> &unloads) {
+    loads.clear();
+    unloads.clear();
+
+    m_order.resize(m_cells.size());
+    for (uint32_t i = 0; i < m_cells.size(); i++) {
+        m_cells[i].distance = DistanceToCell(m_cells[i], m_settings.cell_size, camera_pos.x, camera_pos.z);
+        m_order[i] = i;
+    }
+    std::sort(m_order.begin(), m_order.end(), [this](uint32_t a, uint32_t b) { return m_cells[a].distance < m_cells[b].distance; });
+
+    // cells still loading finish first, they go on a later update
+    for (auto it = m_order.rbegin(); it != m_order.rend() && m_cells[*it].distance > m_settings.unload_radius; ++it) {
+        if (m_cells[*it].state == CellState::cs_loaded) {
+            Unload(*it, unloads);
+        }
+    }
+
+    for (uint32_t id : m_order) {
+        Cell &cell = m_cells[id];
+        if (cell.distance > m_settings.load_radius || m_stats.loading_num >= m_settings.max_loads_in_flight) {
+            break;
+        }
+        if (cell.state != CellState::cs_unloaded) {
+            continue;
+        }
+
+        // farther cells make room for nearer ones, farthest first
+        for (auto it = m_order.rbegin(); it != m_order.rend() && m_stats.resident_bytes + cell.bytes > m_settings.memory_budget; ++it) {
+            const Cell &victim = m_cells[*it];
+            if (victim.distance <= cell.distance) {
+                break;
+            }
+            if (victim.state == CellState::cs_loaded) {
+                Unload(*it, unloads);
+                m_stats.evictions_num++;
+            }
+        }
+        if (m_stats.resident_bytes + cell.bytes > m_settings.memory_budget) {
+            m_stats.budget_misses++;
+            break;
+        }
+
+        cell.state = CellState::cs_loading;
+        m_stats.resident_bytes += cell.bytes;
+        m_stats.peak_bytes = std::max(m_stats.peak_bytes, m_stats.resident_bytes);
+        m_stats.loading_num++;
+        m_stats.loads_num++;
+        loads.push_back(id);
+    }
+}
+
+void WorldPartition::OnLoaded(uint32_t cell_id, uint64_t bytes) {
+    Cell &cell = m_cells[cell_id];
+    if (cell.state != CellState::cs_loading) {
+        return;
+    }
+
+    cell.state = CellState::cs_loaded;
+    m_stats.loading_num--;
+    m_stats.loaded_num++;
+    if (bytes) {
+        m_stats.resident_bytes = m_stats.resident_bytes - cell.bytes + bytes;
+        cell.bytes = bytes;
+        m_stats.peak_bytes = std::max(m_stats.peak_bytes, m_stats.resident_bytes);
+    }
+}
+
+void WorldPartition::SetCellBytes(uint32_t cell_id, uint64_t bytes) {
+    Cell &cell = m_cells[cell_id];
+    if (cell.state == CellState::cs_unloaded) {
+        cell.bytes = bytes;
+    }
+}
+
+void WorldPartition::Unload(uint32_t cell_id, std::vector<uint32_t> &unloads) {
+    Cell &cell = m_cells[cell_id];
+    cell.state = CellState::cs_unloaded;
+    m_stats.resident_bytes -= cell.bytes;
+    m_stats.loaded_num--;
+    m_stats.unloads_num++;
+    unloads.push_back(cell_id);
+}
+
+std::vector<WorldPartition::ReplayResult> WorldPartition::Replay(uint32_t entities_num, const Settings &settings, uint32_t load_latency) {
+    // 16x16 cells holding 8 budgets, so the ~25 cells around the camera come close to filling it
+    const float extent = settings.cell_size * 16.f;
+    const uint64_t average_bytes = std::max<uint64_t>(settings.memory_budget * 8 / std::max(entities_num, 1u), 1);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> coord(0.f, extent);
+    std::uniform_int_distribution<uint64_t> size(average_bytes / 5, average_bytes * 9 / 5);
+    std::vector<DirectX::XMFLOAT3> positions(entities_num);
+    std::vector<uint64_t> entity_bytes(entities_num);
+    for (uint32_t i = 0; i < entities_num; i++) {
+        positions[i] = DirectX::XMFLOAT3(coord(rng), 0.f, coord(rng));
+        entity_bytes[i] = size(rng);
+    }
+
+    static constexpr uint32_t thrash_window = 8;
+    std::vector<ReplayResult> results;
+    for (const CameraPath &path : camera_paths) {
+        WorldPartition partition;
+        partition.Build(positions, entity_bytes, settings);
+        ReplayResult res;
+        res.path = path.name;
+        res.frames_num = path.frames_num;
+
+        const Settings &checked = partition.GetSettings();
+        std::vector<std::pair<uint32_t, uint32_t>> in_flight; // cell, frame it finishes
+        std::vector<uint32_t> unloaded_at(partition.GetCellsNum(), uint32_t(-1));
+        std::vector<uint32_t> loads;
+        std::vector<uint32_t> unloads;
+        for (uint32_t frame = 0; frame < path.frames_num; frame++) {
+            // loads that finished go in before the update, as the streamer merges before it updates
+            for (auto it = in_flight.begin(); it != in_flight.end();) {
+                if (it->second <= frame) {
+                    partition.OnLoaded(it->first);
+                    it = in_flight.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+
+            partition.Update(path.pos(frame, extent, settings.cell_size), loads, unloads);
+            for (uint32_t cell : unloads) {
+                unloaded_at[cell] = frame;
+            }
+            for (uint32_t cell : loads) {
+                if (unloaded_at[cell] != uint32_t(-1) && frame - unloaded_at[cell] < thrash_window) {
+                    res.thrash_num++;
+                }
+                in_flight.emplace_back(cell, frame + load_latency);
+            }
+
+            // the nearest wanted cell still unloaded must wait only for a load slot or for the budget, what farther
+            // loaded cells could give up counts as room
+            const Stats &stats = partition.GetStats();
+            const Cell* nearest = nullptr;
+            bool stale = false;
+            for (uint32_t id = 0; id < partition.GetCellsNum(); id++) {
+                const Cell &cell = partition.GetCell(id);
+                if (cell.state == CellState::cs_unloaded && cell.distance <= checked.load_radius && (!nearest || cell.distance < nearest->distance)) {
+                    nearest = &cell;
+                }
+                stale |= cell.state == CellState::cs_loaded && cell.distance > checked.unload_radius;
+            }
+            bool missing = false;
+            if (nearest && stats.loading_num < checked.max_loads_in_flight) {
+                uint64_t room = checked.memory_budget - std::min(stats.resident_bytes, checked.memory_budget);
+                for (uint32_t id = 0; id < partition.GetCellsNum(); id++) {
+                    const Cell &cell = partition.GetCell(id);
+                    room += (cell.state == CellState::cs_loaded && cell.distance > nearest->distance) ? cell.bytes : 0;
+                }
+                missing = nearest->bytes <= room;
+            }
+            res.missing_frames += missing;
+            res.stale_frames += stale;
+            res.over_budget_frames += partition.GetStats().resident_bytes > checked.memory_budget;
+            res.max_loaded = std::max(res.max_loaded, partition.GetStats().loaded_num);
+        }
+
+        const Stats &stats = partition.GetStats();
+        res.peak_bytes = stats.peak_bytes;
+        res.loads_num = stats.loads_num;
+        res.unloads_num = stats.unloads_num;
+        res.evictions_num = stats.evictions_num;
+        res.passed = !res.missing_frames && !res.stale_frames && !res.over_budget_frames && !res.thrash_num;
+        results.push_back(res);
+    }
+
+    return results;
+}
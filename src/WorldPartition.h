@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <DirectXMath.h>
+
+// Square grid over the XZ plane deciding which cells of a level should be resident for a camera position.
+// It only schedules: the owner loads and unloads cells asynchronously and reports back when a load finished.
+// Cells load inside load_radius and unload past unload_radius, the band between them keeps a camera moving along a
+// border from loading and unloading the same cells. Resident and in flight cells stay within memory_budget: the
+// nearest cells load first and cells farther away than one that does not fit are given up for it.
+class WorldPartition {
+public:
+    enum class CellState { cs_unloaded, cs_loading, cs_loaded };
+
+    struct Settings {
+        float cell_size{ 64.f };
+        float load_radius{ 128.f };     // distance from the camera to the nearest point of a cell
+        float unload_radius{ 160.f };   // at least load_radius
+        uint64_t memory_budget{ 512ull << 20 };
+        uint32_t max_loads_in_flight{ 2 };
+    };
+
+    struct Cell {
+        int32_t x{ 0 };
+        int32_t z{ 0 };
+        std::vector<uint32_t> entities; // indices into the positions Build got
+        uint64_t bytes{ 0 };            // estimate until loaded, then what the owner reported
+        CellState state{ CellState::cs_unloaded };
+        float distance{ 0.f };          // at the last Update
+    };
+
+    struct Stats {
+        uint32_t cells_num{ 0 };
+        uint32_t loaded_num{ 0 };
+        uint32_t loading_num{ 0 };
+        uint64_t resident_bytes{ 0 };   // loaded and in flight
+        uint64_t peak_bytes{ 0 };
+        uint32_t loads_num{ 0 };
+        uint32_t unloads_num{ 0 };
+        uint32_t evictions_num{ 0 };    // unloads for the budget, inside unload_radius
+        uint32_t budget_misses{ 0 };    // updates that left a wanted cell unloaded for the budget
+    };
+
+    // entity_bytes per entity, what its cell costs when resident
+    void Build(const std::vector<DirectX::XMFLOAT3> &positions, const std::vector<uint64_t> &entity_bytes, const Settings &settings);
+    // cells to start loading now, nearest first, and cells to unload now
+    void Update(const DirectX::XMFLOAT3 &camera_pos, std::vector<uint32_t> &loads, std::vector<uint32_t> &unloads);
+    // bytes 0 keeps the estimate
+    void OnLoaded(uint32_t cell, uint64_t bytes = 0);
+    // replaces the estimate of a cell that is not resident
+    void SetCellBytes(uint32_t cell, uint64_t bytes);
+
+    const Settings& GetSettings() const { return m_settings; }
+    uint32_t GetCellsNum() const { return (uint32_t)m_cells.size(); }
+    const Cell& GetCell(uint32_t cell) const { return m_cells[cell]; }
+    const Stats& GetStats() const { return m_stats; }
+
+    struct ReplayResult {
+        const char* path{ nullptr };
+        uint32_t frames_num{ 0 };
+        uint32_t max_loaded{ 0 };
+        uint64_t peak_bytes{ 0 };
+        uint32_t loads_num{ 0 };
+        uint32_t unloads_num{ 0 };
+        uint32_t evictions_num{ 0 };
+        uint32_t missing_frames{ 0 };   // frames a wanted cell that fits waited with a load slot free
+        uint32_t stale_frames{ 0 };     // frames with a cell past unload_radius still resident
+        uint32_t over_budget_frames{ 0 };
+        uint32_t thrash_num{ 0 };       // cells loaded again within a few frames of their unload
+        bool passed{ false };
+    };
+
+    // synthetic world of entities_num entities replayed along a few camera paths, loads finish load_latency frames
+    // after they start; checks residency against the radii and the budget every frame
+    static std::vector<ReplayResult> Replay(uint32_t entities_num, const Settings &settings, uint32_t load_latency);
+
+private:
+    static uint64_t Key(int32_t x, int32_t z) { return ((uint64_t)(uint32_t)x << 32) | (uint32_t)z; }
+    void Unload(uint32_t cell, std::vector<uint32_t> &unloads);
+
+    Settings m_settings;
+    std::vector<Cell> m_cells;
+    std::vector<uint32_t> m_order;  // cells nearest first, kept between updates
+    std::unordered_map<uint64_t, uint32_t> m_cell_ids;
+    Stats m_stats;
+};
@@ -6,7 +6,9 @@
 #include "DynamicGpuHeap.h"
 #include "HeapBuffer.h"
 #include "DxBackend.h"
+#include "FrameArena.h"
 #include <array>
+#include <cassert>
 #include "RootSignature.h"
 #include "Techniques.h"
 
@@ -48,14 +50,14 @@ void CommandList::SetComputeRootDescriptorTable(uint32_t root_parameter_index, G
 	m_command_list->SetComputeRootDescriptorTable(root_parameter_index, hndl);
 }
 
-void CommandList::SetGraphicsRootConstantBufferView(uint32_t root_parameter_index, const std::shared_ptr<IHeapBuffer>& buff)
+void CommandList::SetGraphicsRootConstantBufferView(uint32_t root_parameter_index, const std::shared_ptr<IHeapBuffer>& buff, uint64_t offset)
 {
-	m_command_list->SetGraphicsRootConstantBufferView(root_parameter_index, GetDxHeap(buff)->GetResource()->GetGPUVirtualAddress());
+	m_command_list->SetGraphicsRootConstantBufferView(root_parameter_index, GetDxHeap(buff)->GetResource()->GetGPUVirtualAddress() + offset);
 }
 
-void CommandList::SetComputeRootConstantBufferView(uint32_t root_parameter_index, const std::shared_ptr<IHeapBuffer>& buff)
+void CommandList::SetComputeRootConstantBufferView(uint32_t root_parameter_index, const std::shared_ptr<IHeapBuffer>& buff, uint64_t offset)
 {
-	m_command_list->SetComputeRootConstantBufferView(root_parameter_index, GetDxHeap(buff)->GetResource()->GetGPUVirtualAddress());
+	m_command_list->SetComputeRootConstantBufferView(root_parameter_index, GetDxHeap(buff)->GetResource()->GetGPUVirtualAddress() + offset);
 }
 
 void CommandList::SetIndexBuffer(const IndexVufferView* view)
@@ -89,9 +91,10 @@ void CommandList::SetDescriptorHeap(const IDynamicGpuHeap* dynamic_heap)
 	m_command_list->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
 }
 
-void CommandList::SetRenderTargets(const std::vector<IGpuResource*>& resources, IGpuResource* depth_stencil_descriptor)
+void CommandList::SetRenderTargets(uint32_t num_rts, IGpuResource* const* resources, IGpuResource* depth_stencil_descriptor)
 {
-    const uint32_t rts_num = (uint32_t)resources.size();
+    assert(num_rts <= MAX_RTS_NUM);
+    const uint32_t rts_num = num_rts;
     D3D12_CPU_DESCRIPTOR_HANDLE dvs;
     std::array<D3D12_CPU_DESCRIPTOR_HANDLE, MAX_RTS_NUM> rtvs;
     for (uint32_t idx = 0; idx < rts_num; idx++) {
@@ -137,6 +140,11 @@ void CommandList::SetGraphicsRootShaderResourceView(uint32_t root_parameter_inde
 	m_command_list->SetGraphicsRootShaderResourceView(root_parameter_index, GetDxHeap(buff)->GetResource()->GetGPUVirtualAddress());
 }
 
+void CommandList::CopyBufferRegion(const std::shared_ptr<IHeapBuffer>& dst, uint64_t dst_offset, const std::shared_ptr<IHeapBuffer>& src, uint64_t src_offset, uint64_t size)
+{
+	m_command_list->CopyBufferRegion(GetDxHeap(dst)->GetResource().Get(), dst_offset, GetDxHeap(src)->GetResource().Get(), src_offset, size);
+}
+
 void CommandList::ResourceBarrier(std::shared_ptr<IGpuResource>& res, uint32_t to) {
     if (std::shared_ptr<IHeapBuffer> buff = res->GetBuffer().lock()) {
         D3D12_RESOURCE_STATES calculated_from = (D3D12_RESOURCE_STATES)res->GetState();
@@ -160,9 +168,9 @@ void CommandList::ResourceBarrier(IGpuResource& res, uint32_t to) {
 }
 
 void CommandList::ResourceBarrier(std::vector<std::shared_ptr<IGpuResource>>& res, uint32_t to) {
-    std::vector<CD3DX12_RESOURCE_BARRIER> resources;
+    frame_vector<CD3DX12_RESOURCE_BARRIER> resources;
     resources.reserve(res.size());
-    for (auto gpu_res : res) {
+    for (auto& gpu_res : res) {
         if (std::shared_ptr<IHeapBuffer> buff = gpu_res->GetBuffer().lock()) {
             D3D12_RESOURCE_STATES calculated_from = (D3D12_RESOURCE_STATES)gpu_res->GetState();
             D3D12_RESOURCE_STATES to_native = (D3D12_RESOURCE_STATES)to;
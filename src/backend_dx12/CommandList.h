@@ -24,14 +24,14 @@ public:
 	void RSSetScissorRects(uint32_t num_rects, const RectScissors* rects) override;
 	void SetGraphicsRootDescriptorTable(uint32_t root_parameter_index, GPUdescriptor base_descriptor) override;
 	void SetComputeRootDescriptorTable(uint32_t root_parameter_index, GPUdescriptor base_descriptor) override;
-	void SetGraphicsRootConstantBufferView(uint32_t root_parameter_index, const std::shared_ptr<IHeapBuffer> &buff) override;
-	void SetComputeRootConstantBufferView(uint32_t root_parameter_index, const std::shared_ptr<IHeapBuffer> &buff) override;
+	void SetGraphicsRootConstantBufferView(uint32_t root_parameter_index, const std::shared_ptr<IHeapBuffer> &buff, uint64_t offset = 0) override;
+	void SetComputeRootConstantBufferView(uint32_t root_parameter_index, const std::shared_ptr<IHeapBuffer> &buff, uint64_t offset = 0) override;
 	void SetIndexBuffer(const IndexVufferView* view) override;
 	void SetPrimitiveTopology(PrimitiveTopology primirive_topology) override;
 	void DrawInstanced(uint32_t vertex_per_instance, uint32_t instance_count, uint32_t start_vertex_location, uint32_t start_instance_location) override;
 	void DrawIndexedInstanced(uint32_t index_count_per_instance, uint32_t instance_count, uint32_t start_index_location, int32_t base_vertex_location, uint32_t start_instance_location) override;
 	void SetDescriptorHeap(const IDynamicGpuHeap*dynamic_heap) override;
-	void SetRenderTargets(const std::vector<IGpuResource*> &resources, IGpuResource* depth_stencil_descriptor) override;
+	void SetRenderTargets(uint32_t num_rts, IGpuResource* const* resources, IGpuResource* depth_stencil_descriptor) override;
 	void ClearRenderTargetView(IGpuResource* res, const float color[4], uint32_t num_rects, const RectScissors* rect) override;
 	void ClearRenderTargetView(IGpuResource& res, const float color[4], uint32_t num_rects, const RectScissors* rect) override {
 		ClearRenderTargetView(&res, color, num_rects, rect);
@@ -42,6 +42,7 @@ public:
 	}
 	void Dispatch(uint32_t thread_group_count_x, uint32_t thread_group_count_y, uint32_t thread_group_count_z) override;
 	void SetGraphicsRootShaderResourceView(uint32_t root_parameter_index, const std::shared_ptr<IHeapBuffer> &buff) override;
+	void CopyBufferRegion(const std::shared_ptr<IHeapBuffer> &dst, uint64_t dst_offset, const std::shared_ptr<IHeapBuffer> &src, uint64_t src_offset, uint64_t size) override;
 
 	void ResourceBarrier(std::shared_ptr<IGpuResource>& res, uint32_t to) override;
 	void ResourceBarrier(IGpuResource& res, uint32_t to) override;
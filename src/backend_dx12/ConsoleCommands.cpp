@@ -1,6 +1,7 @@
 #include "ConsoleCommands.h"
 
 #include "DxBackend.h"
+#include "ImguiHelper.h"
 
 extern DxBackend* gBackend;
 
@@ -15,6 +16,9 @@ void ConsoleCommands::ExecuteCommand(std::string name)
 	else if (name == "rebuild_shaders") {
 		gBackend->RebuildShaders();
 	}
+	else if (name == "mem_stats") {
+		((ImguiHelper*)gBackend->GetUiHelper())->ShowMemoryStats();
+	}
 	else if (name.find("r_mode") != std::string::npos) {
 		std::string name_copy = name;
 		name_copy.erase(0, 7);
@@ -28,6 +32,7 @@ std::vector<std::string>& ConsoleCommands::GetCommandNames()
 	if (m_command_names.empty()) {
 		m_command_names.push_back("quit");
 		m_command_names.push_back("rebuild_shaders");
+		m_command_names.push_back("mem_stats");
 		m_command_names.push_back("update_constants");
 		m_command_names.push_back("r_mode");
 	}
@@ -11,6 +11,10 @@
 #include "Techniques.h"
 #include "ImguiHelper.h"
 #include "ShaderManager.h"
+#include "StartupProfiler.h"
+#include "FrameArena.h"
+#include "StagingAllocator.h"
+#include "GpuMemoryAllocator.h"
 
 #include <directx/d3d12.h>
 #include <dxgi1_6.h>
@@ -73,6 +77,8 @@ void DxBackend::OnInit(const WindowHandler& window_hndl, uint32_t width, uint32_
 	ThrowIfFailed(CreateDXGIFactory2(dxgiFactoryFlags, IID_PPV_ARGS(&m_factory)));
 
 	// Device
+	StartupProfiler& profiler = StartupProfiler::Get();
+	uint32_t phase = profiler.Begin("device", nullptr);
 	m_device.swap(std::make_unique<DxDevice>());
 #if defined(USE_NSIGHT_AFTERMATH)
 	m_gpuCrashTracker.reset(new GpuCrashTracker(m_markerMap, path.string()));
@@ -123,8 +129,10 @@ void DxBackend::OnInit(const WindowHandler& window_hndl, uint32_t width, uint32_
 		aftermathFlags,
 		m_device->GetNativeObject().Get()));
 #endif
+	profiler.End(phase);
 
 	// Queues
+	phase = profiler.Begin("queues", nullptr);
 	m_commandQueueGfx.reset(new CommandQueue);
 	m_commandQueueCompute.reset(new CommandQueue);
 	m_commandQueueGfx->OnInit(ICommandQueue::QueueType::qt_gfx, GfxQueueCmdList_num, L"Gfx");
@@ -133,9 +141,17 @@ void DxBackend::OnInit(const WindowHandler& window_hndl, uint32_t width, uint32_
 	m_descriptor_heap_collection.swap(std::make_shared<DescriptorHeapCollection>());
 	m_descriptor_heap_collection->Initialize();
 
+	m_staging_allocator = std::make_unique<StagingAllocator>();
+	m_staging_allocator->Initialize(StagingRingSize);
+	m_gpu_memory = std::make_unique<GpuMemoryAllocator>();
+	m_gpu_memory->Initialize(GpuHeapSize, GpuHeapsMax);
+	profiler.End(phase);
+
 	// SwapChain
+	phase = profiler.Begin("swap chain", nullptr);
 	m_swap_chain.swap(std::make_unique<SwapChain>());
 	m_swap_chain->OnInit(m_factory.Get(), window_hndl, width, height, FramesCount);
+	profiler.End(phase);
 
 	// Misc
 	m_viewport = ViewPort(0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height));
@@ -146,12 +162,16 @@ void DxBackend::OnInit(const WindowHandler& window_hndl, uint32_t width, uint32_
 	m_frameIndex = m_swap_chain->GetCurrentBackBufferIndex();
 	m_root_dir = path;
 
+	phase = profiler.Begin("techniques", nullptr);
 	m_shader_mgr.swap(std::make_unique<ShaderManager>());
 	m_techniques.reset(new Techniques);
 	m_techniques->OnInit();
+	profiler.End(phase);
 
+	phase = profiler.Begin("imgui", nullptr);
 	m_gui.reset(new ImguiHelper);
 	m_gui->Initialize(FramesCount);
+	profiler.End(phase);
 	
 	m_fence_inter_queue.reset(new Fence);
 	m_fence_inter_queue->Initialize(m_fence_inter_queue_val);
@@ -221,6 +241,10 @@ void DxBackend::Present()
 
 	// Signal for this frame
 	m_fenceValues[m_frameIndex] = m_commandQueueGfx->Signal();
+	m_presented_fence = m_fenceValues[m_frameIndex];
+	// compute work of the frame is waited on by gfx before this signal
+	m_staging_allocator->FinishFrame(m_fenceValues[m_frameIndex]);
+	m_gpu_memory->FinishFrame(m_fenceValues[m_frameIndex]);
 
 	// get next frame
 	m_frameIndex = m_swap_chain->GetCurrentBackBufferIndex();
@@ -234,6 +258,10 @@ void DxBackend::OnResizeWindow()
 void DxBackend::SyncWithCPU()
 {
 	m_commandQueueGfx->WaitOnCPU(m_fenceValues[m_frameIndex]);
+	m_completed_fence = m_fenceValues[m_frameIndex];
+	m_staging_allocator->Retire(m_fenceValues[m_frameIndex]);
+	m_gpu_memory->Retire(m_fenceValues[m_frameIndex]);
+	FrameArena::NextFrame();
 }
 
 void DxBackend::SyncWithGpu(ICommandQueue::QueueType from, ICommandQueue::QueueType to)
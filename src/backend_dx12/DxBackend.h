@@ -27,6 +27,8 @@ class IDescriptorHeapCollection;
 class DescriptorHeapCollection;
 class IImguiHelper;
 class ShaderManager;
+class StagingAllocator;
+class GpuMemoryAllocator;
 
 class DxBackend : public IBackend {
 public:
@@ -52,6 +54,8 @@ public:
 	const IRootSignature* GetRootSignById(uint32_t id) override;
 	uint32_t GetRenderMode() const override { return m_render_mode; }
 	uint32_t GetFrameCount() const override { return FramesCount; }
+	uint64_t GetPresentedFence() const override { return m_presented_fence; }
+	uint64_t GetCompletedFence() const override { return m_completed_fence; }
 	IImguiHelper* GetUI() override { return m_gui.get(); }
 	void RebuildShaders(std::optional<std::wstring> dbg_name = std::nullopt);
 	void SetRenderMode(uint32_t mode) { m_render_mode = mode; }
@@ -66,15 +70,22 @@ public:
 	IDescriptorHeapCollection* GetDescriptorHeapCollection() { return (IDescriptorHeapCollection*)m_descriptor_heap_collection.get(); }
 	IImguiHelper* GetUiHelper() { return m_gui.get(); }
 	DxDevice* GetDevice() { return m_device.get();  }
+	StagingAllocator* GetStagingAllocator() { return m_staging_allocator.get(); }
+	GpuMemoryAllocator* GetGpuMemoryAllocator() { return m_gpu_memory.get(); }
 	void Close() { m_should_close = true; }
 	virtual ~DxBackend();
 private:
 	static const uint32_t FramesCount = 2;
 	static constexpr uint32_t GfxQueueCmdList_num = 6;
 	static constexpr uint32_t ComputeQueueCmdList_num = 6;
+	static constexpr uint64_t StagingRingSize = 64ull * 1024 * 1024;
+	static constexpr uint64_t GpuHeapSize = 64ull * 1024 * 1024;
+	static constexpr uint32_t GpuHeapsMax = 64;
 
 	ComPtr<IDXGIFactory4> m_factory;
 	std::unique_ptr<DxDevice> m_device;
+	// outlives the members holding resources placed in its heaps
+	std::unique_ptr<GpuMemoryAllocator> m_gpu_memory;
 	std::unique_ptr<SwapChain> m_swap_chain;
 	std::shared_ptr<ICommandQueue> m_commandQueueGfx;
 	std::shared_ptr<ICommandQueue> m_commandQueueCompute;
@@ -87,12 +98,15 @@ private:
 	std::unique_ptr<IImguiHelper> m_gui;
 	std::unique_ptr<ITechniques> m_techniques;
 	std::unique_ptr<ShaderManager> m_shader_mgr;
+	std::unique_ptr<StagingAllocator> m_staging_allocator;
 
 	std::unique_ptr<IFence> m_fence_inter_queue;
 	uint32_t m_fence_inter_queue_val{ 0 };
 
 	uint32_t m_frameIndex{ 0 };
 	uint32_t m_fenceValues[FramesCount]{ 0 };
+	uint64_t m_presented_fence{ 0 };
+	uint64_t m_completed_fence{ 0 };
 
 	uint32_t m_render_mode{ 0 };
 	bool m_rebuild_shaders{ false };
@@ -0,0 +1,168 @@
+#include "GpuMemoryAllocator.h"
+#include "dx12_helper.h"
+#include <directx/d3dx12.h>
+#include "DxBackend.h"
+#include "DxDevice.h"
+
+#include <algorithm>
+
+extern DxBackend* gBackend;
+
+namespace {
+	const wchar_t* PoolNames[GpuMemoryAllocator::pools_num] = { L"default_buffers_heap", L"default_textures_heap", L"upload_buffers_heap" };
+}
+
+void GpuMemoryAllocator::Initialize(uint64_t heap_size, uint32_t max_heaps)
+{
+	m_heaps = std::make_unique<pro_game_containers::gpu_heap_allocator>(heap_size, max_heaps, pools_num);
+}
+
+bool GpuMemoryAllocator::CreatePlacedResource(D3D12_HEAP_TYPE type, D3D12_RESOURCE_DESC desc, D3D12_RESOURCE_STATES initial_state,
+	const D3D12_CLEAR_VALUE* clear_val, uint64_t tag, ComPtr<ID3D12Resource>& resource, Placement& placement)
+{
+	// render targets and depth get memory of their own, they are few, big and come and go with the window size
+	const bool is_buffer = desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER;
+	const bool is_target = desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
+	uint32_t pool = pools_num;
+	if (type == D3D12_HEAP_TYPE_DEFAULT && !is_target) {
+		pool = is_buffer ? pool_default_buffers : pool_default_textures;
+	}
+	else if (type == D3D12_HEAP_TYPE_UPLOAD && is_buffer) {
+		pool = pool_upload_buffers;
+	}
+	if (pool == pools_num) {
+		m_committed_total_num++;
+		return false;
+	}
+
+	// buffers are always placed at 64 KB, a texture whose most detailed mip fits in 64 KB can take 4 KB
+	D3D12_RESOURCE_ALLOCATION_INFO info{};
+	bool is_small = false;
+	if (!is_buffer && desc.Alignment == 0 && desc.SampleDesc.Count == 1) {
+		desc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+		info = gBackend->GetDevice()->GetNativeObject()->GetResourceAllocationInfo(0, 1, &desc);
+		is_small = info.Alignment == D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+		desc.Alignment = is_small ? desc.Alignment : 0;
+	}
+	if (!is_small) {
+		info = gBackend->GetDevice()->GetNativeObject()->GetResourceAllocationInfo(0, 1, &desc);
+	}
+
+	// a quarter of a heap at most, big resources would leave holes nothing else fits in
+	if (info.SizeInBytes > m_heaps->heap_size() / 4) {
+		m_committed_total_num++;
+		return false;
+	}
+	placement = m_heaps->allocate(pool, info.SizeInBytes, info.Alignment, tag);
+	if (!placement.valid()) {
+		m_committed_total_num++;
+		return false;
+	}
+
+	ThrowIfFailed(gBackend->GetDevice()->GetNativeObject()->CreatePlacedResource(
+		GetHeap(placement),
+		placement.offset,
+		&desc,
+		initial_state,
+		clear_val,
+		IID_PPV_ARGS(resource.ReleaseAndGetAddressOf())));
+	m_placed_total_num++;
+
+	return true;
+}
+
+void GpuMemoryAllocator::Free(const Placement& placement)
+{
+	Pending pending;
+	pending.placement = placement;
+	m_pending.push_back(pending);
+	m_pending_bytes += placement.size;
+}
+
+uint32_t GpuMemoryAllocator::Defragment(uint32_t max_moves, const RelocateFunc& relocate)
+{
+	uint32_t moved = 0;
+	for (uint32_t pool = 0; pool < pools_num && moved < max_moves; pool++) {
+		for (const pro_game_containers::gpu_heap_allocator::move& move : m_heaps->plan_defragment(pool, max_moves - moved)) {
+			Relocation relocation;
+			relocation.tag = move.tag;
+			relocation.heap = GetHeap(move.to);
+			relocation.placement = move.to;
+			if (!relocate(relocation)) {
+				m_heaps->cancel_move(move);
+				continue;
+			}
+
+			// the copy out of the old place is recorded this frame
+			Pending pending;
+			pending.move = move;
+			pending.is_move = true;
+			m_pending.push_back(pending);
+			m_pending_bytes += move.from.size;
+			moved++;
+		}
+	}
+
+	return moved;
+}
+
+void GpuMemoryAllocator::FinishFrame(uint64_t fence_value)
+{
+	for (Pending& pending : m_pending) {
+		if (pending.fence == ~0ull) {
+			pending.fence = fence_value;
+		}
+	}
+}
+
+void GpuMemoryAllocator::Retire(uint64_t completed_fence_value)
+{
+	auto it = std::remove_if(m_pending.begin(), m_pending.end(), [this, completed_fence_value](const Pending& pending) {
+		if (pending.fence > completed_fence_value) {
+			return false;
+		}
+		if (pending.is_move) {
+			m_heaps->complete_move(pending.move);
+			m_pending_bytes -= pending.move.from.size;
+		}
+		else {
+			m_heaps->deallocate(pending.placement);
+			m_pending_bytes -= pending.placement.size;
+		}
+		return true;
+	});
+	m_pending.erase(it, m_pending.end());
+}
+
+GpuMemoryAllocator::Stats GpuMemoryAllocator::GetStats() const
+{
+	Stats stats;
+	for (uint32_t pool = 0; pool < pools_num; pool++) {
+		stats.pools[pool] = m_heaps->get_stats(pool);
+	}
+	stats.pending_bytes = m_pending_bytes;
+	stats.placed_total_num = m_placed_total_num;
+	stats.committed_total_num = m_committed_total_num;
+
+	return stats;
+}
+
+ID3D12Heap* GpuMemoryAllocator::GetHeap(const Placement& placement)
+{
+	// the allocator hands out heap indices in order, a new one is created with its first placement
+	std::vector<ComPtr<ID3D12Heap>>& heaps = m_native_heaps[placement.pool];
+	while (heaps.size() <= placement.heap) {
+		D3D12_HEAP_DESC desc{};
+		desc.SizeInBytes = m_heaps->heap_size();
+		desc.Properties = CD3DX12_HEAP_PROPERTIES(placement.pool == pool_upload_buffers ? D3D12_HEAP_TYPE_UPLOAD : D3D12_HEAP_TYPE_DEFAULT);
+		desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+		desc.Flags = placement.pool == pool_default_textures ? D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES : D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+
+		ComPtr<ID3D12Heap> heap;
+		ThrowIfFailed(gBackend->GetDevice()->GetNativeObject()->CreateHeap(&desc, IID_PPV_ARGS(heap.GetAddressOf())));
+		SetNameIndexed(heap.Get(), PoolNames[placement.pool], (uint32_t)heaps.size());
+		heaps.push_back(heap);
+	}
+
+	return heaps[placement.heap].Get();
+}
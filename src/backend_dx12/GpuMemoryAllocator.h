@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <directx/d3d12.h>
+#include <wrl.h>
+#include "gpu_heap_allocator.h"
+
+using Microsoft::WRL::ComPtr;
+
+// Placed resources for HeapBuffer: 64 MB heaps per heap type, buffers and textures apart so resource heap tier 1
+// takes them too, and the offsets in them from gpu_heap_allocator. Small textures are placed at 4 KB when the device
+// allows it, everything else at 64 KB. Render targets, depth, readback and what is bigger than a quarter of a heap
+// stay committed. Freed ranges and the old places of moved resources come back once the gfx fence signalled after the
+// frame that let go of them has completed, like the staging memory.
+class GpuMemoryAllocator {
+public:
+	using Placement = pro_game_containers::gpu_heap_allocator::allocation;
+
+	enum Pool : uint32_t {
+		pool_default_buffers,
+		pool_default_textures,
+		pool_upload_buffers,
+		pools_num
+	};
+
+	struct Stats {
+		pro_game_containers::gpu_heap_allocator::stats pools[pools_num];
+		uint64_t pending_bytes{ 0 };        // freed, waiting for their fence
+		uint32_t placed_total_num{ 0 };
+		uint32_t committed_total_num{ 0 };  // went past the heaps
+	};
+
+	// a resource the defragmentation wants somewhere else; the callback creates it in heap at placement.offset,
+	// records the copy and swaps it in, false leaves it where it is
+	struct Relocation {
+		uint64_t tag{ 0 };
+		ID3D12Heap* heap{ nullptr };
+		Placement placement;
+	};
+	using RelocateFunc = std::function<bool(const Relocation&)>;
+
+	void Initialize(uint64_t heap_size, uint32_t max_heaps);
+	// false when the resource is not for the heaps, the caller creates it committed; tag is handed back to relocate
+	bool CreatePlacedResource(D3D12_HEAP_TYPE type, D3D12_RESOURCE_DESC desc, D3D12_RESOURCE_STATES initial_state,
+		const D3D12_CLEAR_VALUE* clear_val, uint64_t tag, ComPtr<ID3D12Resource>& resource, Placement& placement);
+	void Free(const Placement& placement);
+	// up to max_moves resources from the last heaps of every pool into earlier ones
+	uint32_t Defragment(uint32_t max_moves, const RelocateFunc& relocate);
+	// everything freed or moved since the previous call is done on the gpu at fence_value
+	void FinishFrame(uint64_t fence_value);
+	void Retire(uint64_t completed_fence_value);
+	Stats GetStats() const;
+
+private:
+	struct Pending {
+		Placement placement;
+		pro_game_containers::gpu_heap_allocator::move move;
+		bool is_move{ false };
+		uint64_t fence{ ~0ull };            // until FinishFrame
+	};
+
+	ID3D12Heap* GetHeap(const Placement& placement);
+
+	std::unique_ptr<pro_game_containers::gpu_heap_allocator> m_heaps;
+	std::vector<ComPtr<ID3D12Heap>> m_native_heaps[pools_num];
+	std::vector<Pending> m_pending;
+	uint64_t m_pending_bytes{ 0 };
+	uint32_t m_placed_total_num{ 0 };
+	uint32_t m_committed_total_num{ 0 };
+};
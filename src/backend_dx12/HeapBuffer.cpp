@@ -5,22 +5,38 @@
 #include "DxBackend.h"
 #include "CommandList.h"
 #include "DxDevice.h"
+#include "StagingAllocator.h"
+#include "GpuMemoryAllocator.h"
 
 extern DxBackend* gBackend;
 
+HeapBuffer::~HeapBuffer() {
+    FreePlacement();
+}
+
+void HeapBuffer::FreePlacement() {
+    // on shutdown the backend can go first, its heaps with it
+    if (m_placement.valid() && gBackend) {
+        gBackend->GetGpuMemoryAllocator()->Free(m_placement);
+    }
+    m_placement = {};
+}
+
 void HeapBuffer::Create(HeapType type, uint32_t bufferSize, ResourceState initial_state, std::optional<std::wstring> dbg_name) {
     D3D12_HEAP_TYPE internal_type{ (D3D12_HEAP_TYPE)type };
-
-    ThrowIfFailed(gBackend->GetDevice()->GetNativeObject()->CreateCommittedResource(
-        &CD3DX12_HEAP_PROPERTIES(internal_type),
-        D3D12_HEAP_FLAG_NONE,
-        &CD3DX12_RESOURCE_DESC::Buffer(bufferSize, D3D12_RESOURCE_FLAG_NONE),
-        (D3D12_RESOURCE_STATES)initial_state,
-        nullptr,
-        IID_PPV_ARGS(&m_resourse)));
+    const CD3DX12_RESOURCE_DESC res_desc_native = CD3DX12_RESOURCE_DESC::Buffer(bufferSize, D3D12_RESOURCE_FLAG_NONE);
+
+    FreePlacement();
+    if (!gBackend->GetGpuMemoryAllocator()->CreatePlacedResource(internal_type, res_desc_native, (D3D12_RESOURCE_STATES)initial_state, nullptr, (uint64_t)this, m_resourse, m_placement)) {
+        ThrowIfFailed(gBackend->GetDevice()->GetNativeObject()->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(internal_type),
+            D3D12_HEAP_FLAG_NONE,
+            &res_desc_native,
+            (D3D12_RESOURCE_STATES)initial_state,
+            nullptr,
+            IID_PPV_ARGS(&m_resourse)));
+    }
     SetName(m_resourse, dbg_name.value_or(L"").append(L"_buffer").c_str());
-
-    m_recreate_intermediate_res = true;
 }
 
 void HeapBuffer::CreateTexture(HeapType type, const ResourceDesc &res_desc, ResourceState initial_state, const ClearColor *clear_val, std::optional<std::wstring> dbg_name){
@@ -54,38 +70,26 @@ void HeapBuffer::CreateTexture(HeapType type, const ResourceDesc &res_desc, Reso
         }
     }
 
-    ThrowIfFailed(gBackend->GetDevice()->GetNativeObject()->CreateCommittedResource(
-        &CD3DX12_HEAP_PROPERTIES(internal_type),
-        D3D12_HEAP_FLAG_NONE,
-        &res_desc_native,
-        (D3D12_RESOURCE_STATES)initial_state,
-        (clear_val ? &clear_val_native : nullptr),
-        IID_PPV_ARGS(&m_resourse)
-    ));
+    FreePlacement();
+    if (!gBackend->GetGpuMemoryAllocator()->CreatePlacedResource(internal_type, res_desc_native, (D3D12_RESOURCE_STATES)initial_state,
+        (clear_val ? &clear_val_native : nullptr), (uint64_t)this, m_resourse, m_placement)) {
+        ThrowIfFailed(gBackend->GetDevice()->GetNativeObject()->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(internal_type),
+            D3D12_HEAP_FLAG_NONE,
+            &res_desc_native,
+            (D3D12_RESOURCE_STATES)initial_state,
+            (clear_val ? &clear_val_native : nullptr),
+            IID_PPV_ARGS(&m_resourse)
+        ));
+    }
     SetName(m_resourse, dbg_name.value_or(L"").append(L"_texture").c_str());
-    
-    m_recreate_intermediate_res = true;
 }
 
 void HeapBuffer::Load(ICommandList* command_list, uint32_t numElements, uint32_t elementSize, const void* bufferData){
     if (bufferData)
     {
-        auto device = gBackend->GetDevice();
-        const size_t bufferSize = numElements * elementSize;
-        if (m_recreate_intermediate_res)
-        {
-            pIntermediateResource.Reset();
-            ThrowIfFailed(device->GetNativeObject()->CreateCommittedResource(
-                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-                D3D12_HEAP_FLAG_NONE,
-                &CD3DX12_RESOURCE_DESC::Buffer(bufferSize),
-                D3D12_RESOURCE_STATE_GENERIC_READ,
-                nullptr,
-                IID_PPV_ARGS(pIntermediateResource.GetAddressOf())));
-                SetName(pIntermediateResource, L"_intermediate");
-            
-            m_recreate_intermediate_res = !m_recreate_intermediate_res;
-        }
+        const uint64_t bufferSize = (uint64_t)numElements * elementSize;
+        const StagingAllocator::Allocation staging = gBackend->GetStagingAllocator()->Allocate(bufferSize, 16);
 
         D3D12_SUBRESOURCE_DATA subresourceData = {};
         subresourceData.pData = bufferData;
@@ -93,34 +97,20 @@ void HeapBuffer::Load(ICommandList* command_list, uint32_t numElements, uint32_t
         subresourceData.SlicePitch = subresourceData.RowPitch;
 
         UpdateSubresources(((CommandList*)command_list)->GetRawCommandList().Get(),
-            m_resourse.Get(), pIntermediateResource.Get(),
-            0, 0, 1, &subresourceData);
+            m_resourse.Get(), staging.resource,
+            staging.offset, 0, 1, &subresourceData);
     }
 }
 
 void HeapBuffer::Load(ICommandList* command_list, uint32_t firstSubresource, uint32_t numSubresources, SubresourceData* subresourceData){
     if (subresourceData)
     {
-        auto device = gBackend->GetDevice();
         const uint64_t required_size = GetRequiredIntermediateSize(m_resourse.Get(), firstSubresource, numSubresources);
-        if (m_recreate_intermediate_res)
-        {
-            pIntermediateResource.Reset();
-            ThrowIfFailed(device->GetNativeObject()->CreateCommittedResource(
-                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-                D3D12_HEAP_FLAG_NONE,
-                &CD3DX12_RESOURCE_DESC::Buffer(required_size),
-                D3D12_RESOURCE_STATE_GENERIC_READ,
-                nullptr,
-                IID_PPV_ARGS(pIntermediateResource.GetAddressOf())));
-                SetName(pIntermediateResource, L"_intermediate");
-            
-            m_recreate_intermediate_res = !m_recreate_intermediate_res;
-        }
+        const StagingAllocator::Allocation staging = gBackend->GetStagingAllocator()->Allocate(required_size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
 
         UpdateSubresources(((CommandList*)command_list)->GetRawCommandList().Get(),
-            m_resourse.Get(), pIntermediateResource.Get(),
-            0, firstSubresource, numSubresources, (D3D12_SUBRESOURCE_DATA*)subresourceData);
+            m_resourse.Get(), staging.resource,
+            staging.offset, firstSubresource, numSubresources, (D3D12_SUBRESOURCE_DATA*)subresourceData);
     }
 }
 
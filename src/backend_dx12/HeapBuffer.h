@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include "IHeapBuffer.h"
+#include "gpu_heap_allocator.h"
 #include <wrl.h>
 using Microsoft::WRL::ComPtr;
 
@@ -12,6 +13,7 @@ struct ResourceDesc;
 
 class HeapBuffer : public IHeapBuffer {
 public:
+    ~HeapBuffer();
     void Create(HeapType type, uint32_t bufferSize, ResourceState initial_state, std::optional<std::wstring> dbg_name = std::nullopt) override;
     void CreateTexture(HeapType type, const ResourceDesc& res_desc, ResourceState initial_state, const ClearColor* clear_val, std::optional<std::wstring> dbg_name = std::nullopt) override;
     
@@ -26,8 +28,9 @@ public:
     void Set(ComPtr<ID3D12Resource> resourse) { m_resourse = resourse; }
     ComPtr<ID3D12Resource> &GetResource() { return m_resourse; }
 private:
+    void FreePlacement();
+
     ComPtr<ID3D12Resource> m_resourse;
-    ComPtr<ID3D12Resource> pIntermediateResource;
+    pro_game_containers::gpu_heap_allocator::allocation m_placement;   // invalid when committed
     void* m_cpu_data{nullptr};
-    bool m_recreate_intermediate_res{false};
 };
\ No newline at end of file
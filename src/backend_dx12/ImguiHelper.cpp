@@ -15,6 +15,8 @@
 #include "Logger.h"
 #include "CommandList.h"
 #include "DxDevice.h"
+#include "StagingAllocator.h"
+#include "GpuMemoryAllocator.h"
 
 extern DxBackend* gBackend;
 
@@ -123,6 +125,9 @@ void ImguiHelper::Render(uint32_t frame_id)
 	if (m_console && m_console->Active()) {
 		m_console->Draw("Console");
 	}
+	if (m_show_memory_stats) {
+		DrawMemoryStats();
+	}
 
 	ICommandList* command_list = m_commandQueueGfx->ResetActiveCL();
 
@@ -131,9 +136,8 @@ void ImguiHelper::Render(uint32_t frame_id)
 
 	UINT backBufferIdx = frame_id;
 	if (IGpuResource* rt = m_rts[frame_id].get()) {
-		std::vector<IGpuResource*> rts{ rt };
 		command_list->ResourceBarrier(*rt, ResourceState::rs_resource_state_render_target);
-		command_list->SetRenderTargets(rts,nullptr);
+		command_list->SetRenderTargets(1, &rt, nullptr);
 		const float clearColor[] = { 0.0f, 0.0f, 0.0f, 0.0f };
 		command_list->ClearRenderTargetView(rt, clearColor, 0, nullptr);
 	}
@@ -152,6 +156,35 @@ void ImguiHelper::Render(uint32_t frame_id)
 	ImGui::EndFrame();
 }
 
+void ImguiHelper::DrawMemoryStats()
+{
+	const StagingAllocator::Stats stats = gBackend->GetStagingAllocator()->GetStats();
+	const float mb = 1.f / (1024.f * 1024.f);
+
+	ImGui::Begin("Memory", &m_show_memory_stats, ImGuiWindowFlags_AlwaysAutoResize);
+	ImGui::Text("upload heap: %.2f MB", (stats.ring.capacity + stats.overflow_bytes) * mb);
+	ImGui::Separator();
+	ImGui::Text("staging ring: %.2f / %.2f MB in %u frames, high water %.2f MB", stats.ring.used_bytes * mb, stats.ring.capacity * mb,
+		stats.ring.frames_in_flight, stats.ring.high_water * mb);
+	ImGui::Text("last frame: %u uploads, %.2f MB", stats.ring.last_frame_allocations, stats.ring.last_frame_bytes * mb);
+	ImGui::Text("overflow: %u buffers, %.2f MB, peak %.2f MB, %u total", stats.overflow_num, stats.overflow_bytes * mb,
+		stats.overflow_peak_bytes * mb, stats.overflow_total_num);
+	ImGui::Text("staged total: %.2f MB", stats.staged_total_bytes * mb);
+
+	const GpuMemoryAllocator::Stats heap_stats = gBackend->GetGpuMemoryAllocator()->GetStats();
+	const char* pool_names[GpuMemoryAllocator::pools_num] = { "default buffers", "default textures", "upload buffers" };
+	ImGui::Separator();
+	ImGui::Text("placed: %u resources, committed: %u, pending free %.2f MB", heap_stats.placed_total_num, heap_stats.committed_total_num,
+		heap_stats.pending_bytes * mb);
+	for (uint32_t pool = 0; pool < GpuMemoryAllocator::pools_num; pool++) {
+		const pro_game_containers::gpu_heap_allocator::stats& pool_stats = heap_stats.pools[pool];
+		ImGui::Text("%s: %.2f / %.2f MB in %u heaps (%u empty), %u resources, fragmentation %.2f", pool_names[pool], pool_stats.used_bytes * mb,
+			pool_stats.heaps_num * pool_stats.heap_size * mb, pool_stats.heaps_num, pool_stats.empty_heaps_num, pool_stats.allocations_num,
+			pool_stats.fragmentation);
+	}
+	ImGui::End();
+}
+
 bool ImguiHelper::WantCapture(CaptureInput_type type) const
 {
 	if (!m_is_initialized)
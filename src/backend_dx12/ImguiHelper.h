@@ -30,9 +30,11 @@ public:
 		return m_rts[frame_id].get();
 	}
 	bool PassImguiWndProc(const ImguiWindowData& data);
+	void ShowMemoryStats() { m_show_memory_stats = !m_show_memory_stats; }
 	~ImguiHelper();
 private:
 	void CreateQuadTexture(uint32_t width, uint32_t height, ResourceFormat formats, uint32_t texture_nums);
+	void DrawMemoryStats();
 
 	//Dx12
 	ComPtr<ID3D12Device2> m_device;
@@ -46,6 +48,7 @@ private:
 	float my_color[4];
 
 	bool m_is_initialized{ false };
+	bool m_show_memory_stats{ false };
 	bool show_demo_window = true;
 	bool show_another_window = false;
 };
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "ShaderManager.h"
 #include <assert.h>
 #include "DxBackend.h"
+#include "VirtualFileSystem.h"
+#include "StartupProfiler.h"
 
 #include <dxc/dxcapi.h>         // Be sure to link with dxcompiler.lib.
 //#include <dxc/d3d12shader.h>    // Shader reflection.
@@ -37,7 +39,8 @@ public:
 				return S_OK;
 			}
 
-			HRESULT hr = shader_mgr->GetShaderCompilerUtils()->LoadFile(full_path.c_str(), nullptr, pEncoding.GetAddressOf());
+			std::shared_ptr<VfsFile> file = VirtualFileSystem::Get().Open(full_path);
+			HRESULT hr = file ? shader_mgr->GetShaderCompilerUtils()->CreateBlob(file->GetData(), (UINT32)file->GetSize(), DXC_CP_ACP, pEncoding.GetAddressOf()) : E_FAIL;
 			if (SUCCEEDED(hr))
 			{
 				IncludedFiles.insert(full_path);
@@ -88,6 +91,7 @@ ShaderManager::~ShaderManager()
 }
 
 ShaderManager::ShaderBlob* ShaderManager::Load(const std::wstring& name, const std::wstring& entry_point, ShaderType target) {
+	StartupScope scope("shader", name);
 	ShaderManager::ShaderBlob* pShader = nullptr;
 
 	std::wstring pdb_name = name;
@@ -98,7 +102,11 @@ ShaderManager::ShaderBlob* ShaderManager::Load(const std::wstring& name, const s
 	std::filesystem::path full_path_hlsl = m_shader_source_dir / name;
 	std::filesystem::path full_path_bin = m_shader_bin_dir / bin_name;
 
-	assert(std::filesystem::exists(full_path_hlsl));
+	VirtualFileSystem& vfs = VirtualFileSystem::Get();
+	uint64_t hlsl_size = 0;
+	int64_t hlsl_time = 0;
+	const bool hlsl_found = vfs.Stat(full_path_hlsl, hlsl_size, hlsl_time);
+	assert(hlsl_found);
 
 	// check if shader already loaded in cache
 	if (ShaderManager::ShaderBlob* cached_shader = GetShaderBLOB(name)) {
@@ -106,20 +114,14 @@ ShaderManager::ShaderBlob* ShaderManager::Load(const std::wstring& name, const s
 	}
 
 	// check if shader already compiled
-	if (std::filesystem::exists(full_path_bin)) {
+	uint64_t bin_size = 0;
+	int64_t bin_time = 0;
+	if (vfs.Stat(full_path_bin, bin_size, bin_time)) {
 		// check if modified of bin > moifided of hlsl
-		if (std::filesystem::last_write_time(full_path_bin) > std::filesystem::last_write_time(full_path_hlsl)) {
-			FILE* fp = NULL;
-			_wfopen_s(&fp, full_path_bin.wstring().c_str(), L"rb");
-			fseek(fp, 0, SEEK_END);
-			uint32_t fsize = ftell(fp);
-			fseek(fp, 0, SEEK_SET);  /* same as rewind(f); */
-			std::vector<uint8_t> raw_data(fsize);
-			fread(raw_data.data(), fsize, 1, fp);
-			fclose(fp);
-
+		std::shared_ptr<VfsFile> file;
+		if (bin_time > hlsl_time && (file = vfs.Open(full_path_bin))) {
 			ShaderBlob blob;
-			blob.data = raw_data;
+			blob.data.assign(file->GetData(), file->GetData() + file->GetSize());
 			blob.name = name;
 
 			const uint32_t idx = m_loaded_shaders.push_back(blob);
@@ -129,6 +131,8 @@ ShaderManager::ShaderBlob* ShaderManager::Load(const std::wstring& name, const s
 		}
 	}
 
+	StartupScope compile_scope("shader compile", name);
+
 	//
 	// COMMAND LINE:
 	// dxc myshader.hlsl -E main -T ps_6_0 -Zi -D MYDEFINE=1 -Fo myshader.bin -Fd myshader.pdb -Qstrip_reflect
@@ -164,8 +168,9 @@ L"-T", targets[target],         // Target.
 	//
 
 	ComPtr<IDxcBlobEncoding> pSource = nullptr;
+	std::shared_ptr<VfsFile> source_file = vfs.Open(full_path_hlsl);
 	// TODO: check how it works on linux, is HRESULT a thing there?..
-	ThrowIfFailed(m_utils->LoadFile(full_path_hlsl.wstring().c_str(), nullptr, &pSource));
+	ThrowIfFailed(m_utils->CreateBlob(source_file->GetData(), (UINT32)source_file->GetSize(), DXC_CP_ACP, &pSource));
 	DxcBuffer Source;
 	Source.Ptr = pSource->GetBufferPointer();
 	Source.Size = pSource->GetBufferSize();
@@ -0,0 +1,95 @@
+#include "StagingAllocator.h"
+#include "dx12_helper.h"
+#include <directx/d3dx12.h>
+#include "DxBackend.h"
+#include "DxDevice.h"
+
+#include <algorithm>
+
+extern DxBackend* gBackend;
+
+namespace {
+	ComPtr<ID3D12Resource> CreateUploadBuffer(uint64_t size, const wchar_t* dbg_name)
+	{
+		ComPtr<ID3D12Resource> res;
+		ThrowIfFailed(gBackend->GetDevice()->GetNativeObject()->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+			D3D12_HEAP_FLAG_NONE,
+			&CD3DX12_RESOURCE_DESC::Buffer(size),
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(res.GetAddressOf())));
+		SetName(res, dbg_name);
+
+		return res;
+	}
+}
+
+void StagingAllocator::Initialize(uint64_t ring_size)
+{
+	m_ring_res = CreateUploadBuffer(ring_size, L"staging_ring");
+	m_ring = std::make_unique<pro_game_containers::ring_allocator>(ring_size);
+
+	// mapped for the lifetime of the ring, the maps UpdateSubresources does on top of it are free
+	void* data = nullptr;
+	ThrowIfFailed(m_ring_res->Map(0, nullptr, &data));
+}
+
+StagingAllocator::Allocation StagingAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	m_staged_total_bytes += size;
+
+	// a quarter of the ring at most, one big texture does not stall every small upload behind it
+	if (size <= m_ring->capacity() / 4) {
+		const uint64_t offset = m_ring->allocate(size, alignment);
+		if (offset != pro_game_containers::ring_allocator::invalid_offset) {
+			return { m_ring_res.Get(), offset };
+		}
+	}
+
+	Overflow overflow;
+	overflow.resource = CreateUploadBuffer(size, L"staging_overflow");
+	overflow.size = size;
+	m_overflow.push_back(overflow);
+	m_overflow_bytes += size;
+	m_overflow_peak_bytes = std::max(m_overflow_peak_bytes, m_overflow_bytes);
+	m_overflow_total_num++;
+
+	return { m_overflow.back().resource.Get(), 0 };
+}
+
+void StagingAllocator::FinishFrame(uint64_t fence_value)
+{
+	m_ring->finish_frame(fence_value);
+	for (Overflow& overflow : m_overflow) {
+		if (overflow.fence == ~0ull) {
+			overflow.fence = fence_value;
+		}
+	}
+}
+
+void StagingAllocator::Retire(uint64_t completed_fence_value)
+{
+	m_ring->retire(completed_fence_value);
+	auto it = std::remove_if(m_overflow.begin(), m_overflow.end(), [this, completed_fence_value](const Overflow& overflow) {
+		if (overflow.fence > completed_fence_value) {
+			return false;
+		}
+		m_overflow_bytes -= overflow.size;
+		return true;
+	});
+	m_overflow.erase(it, m_overflow.end());
+}
+
+StagingAllocator::Stats StagingAllocator::GetStats() const
+{
+	Stats stats;
+	stats.ring = m_ring->get_stats();
+	stats.overflow_bytes = m_overflow_bytes;
+	stats.overflow_peak_bytes = m_overflow_peak_bytes;
+	stats.overflow_num = (uint32_t)m_overflow.size();
+	stats.overflow_total_num = m_overflow_total_num;
+	stats.staged_total_bytes = m_staged_total_bytes;
+
+	return stats;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <wrl.h>
+#include "ring_allocator.h"
+
+using Microsoft::WRL::ComPtr;
+struct ID3D12Resource;
+
+// Upload memory for HeapBuffer::Load: one persistently mapped ring shared by every resource, and a buffer of its own
+// for what is too big for the ring or does not fit while frames are in flight. Both come back once the gfx fence
+// signalled after the frame that recorded the copy has completed.
+class StagingAllocator {
+public:
+	struct Allocation {
+		ID3D12Resource* resource{ nullptr };
+		uint64_t offset{ 0 };
+	};
+
+	struct Stats {
+		pro_game_containers::ring_allocator::stats ring;
+		uint64_t overflow_bytes{ 0 };       // dedicated buffers waiting for their fence
+		uint64_t overflow_peak_bytes{ 0 };
+		uint32_t overflow_num{ 0 };
+		uint32_t overflow_total_num{ 0 };
+		uint64_t staged_total_bytes{ 0 };   // everything handed out, ring and dedicated
+	};
+
+	void Initialize(uint64_t ring_size);
+	// alignment is a power of two; the data is copied in through a map of the returned resource
+	Allocation Allocate(uint64_t size, uint64_t alignment);
+	// everything allocated since the previous call is read by the gpu before fence_value
+	void FinishFrame(uint64_t fence_value);
+	void Retire(uint64_t completed_fence_value);
+	Stats GetStats() const;
+
+private:
+	struct Overflow {
+		ComPtr<ID3D12Resource> resource;
+		uint64_t size{ 0 };
+		uint64_t fence{ ~0ull };            // until FinishFrame
+	};
+
+	ComPtr<ID3D12Resource> m_ring_res;
+	std::unique_ptr<pro_game_containers::ring_allocator> m_ring;
+	std::vector<Overflow> m_overflow;
+	uint64_t m_overflow_bytes{ 0 };
+	uint64_t m_overflow_peak_bytes{ 0 };
+	uint32_t m_overflow_total_num{ 0 };
+	uint64_t m_staged_total_bytes{ 0 };
+};
@@ -8,6 +8,7 @@
 #include <directx/d3dx12.h>
 #include "DxBackend.h"
 #include "DxDevice.h"
+#include "StartupProfiler.h"
 
 extern DxBackend* gBackend;
 
@@ -86,7 +87,7 @@ static Techniques::TechniqueDx CreateTechnique_0(ComPtr<ID3D12Device2> &device,
     Techniques::TechniqueDx tech;
     tech.vs = L"g_buffer_vs.hlsl";
     tech.ps = L"g_buffer_ps.hlsl";
-    tech.vertex_type = 0;
+    tech.vertex_type = 4;
     tech.root_signature = root_sign.GetRSId();
 
     struct PipelineStateStream
@@ -134,7 +135,7 @@ static Techniques::TechniqueDx CreateTechnique_1(ComPtr<ID3D12Device2> &device,
     Techniques::TechniqueDx tech;
     tech.vs = L"g_buffer_vs.hlsl";
     tech.ps = L"g_buffer_ps.hlsl";
-    tech.vertex_type = 1;
+    tech.vertex_type = 5;
     tech.root_signature = root_sign.GetRSId();
 
     struct PipelineStateStream
@@ -792,6 +793,7 @@ void Techniques::OnInit(std::optional<std::wstring> dbg_name){
     auto device = gBackend->GetDevice()->GetNativeObject();
 
     {
+        StartupScope scope("root signatures");
         uint32_t id = 0;
         id = m_root_signatures.push_back();
         CreateRootSignature_0(device, &m_root_signatures[id], dbg_name);
@@ -811,6 +813,8 @@ void Techniques::OnInit(std::optional<std::wstring> dbg_name){
     }
 
     {
+        // shaders load or compile in here
+        StartupScope scope("pipelines");
         uint32_t id = 0;
         id = m_techniques.push_back(CreateTechnique_0(device, m_root_signatures[0], dbg_name));
         m_techniques[id].id = id;
@@ -5,6 +5,14 @@
 #include "DxDevice.h"
 #include "IGpuResource.h"
 #include "ICommandList.h"
+#include "TextureCooker.h"
+#include "TextureRegistry.h"
+#include "VirtualFileSystem.h"
+#include "StartupProfiler.h"
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cstring>
 
 extern DxBackend* gBackend;
 
@@ -15,6 +23,7 @@ ITextureLoader* CreateTextureLoader(const std::filesystem::path &root_dir) {
 TextureLoader::TextureLoader(const std::filesystem::path& root_dir)
 {
 	m_texture_dir = root_dir / L"content" / L"textures";
+	m_cooked_texture_dir = root_dir / L"content" / L"cooked" / L"textures";
 }
 
 void TextureLoader::OnInit()
@@ -29,93 +38,182 @@ void TextureLoader::OnInit()
 
 ITextureLoader::TextureData* TextureLoader::LoadTextureOnCPU(const std::wstring& name)
 {
-	std::filesystem::path related_path(name);
-	const std::wstring filename = related_path.filename().wstring();
+	ITextureLoader::TextureData* texture = ReserveTexture(name);
+	if (texture->NeedsDecode()) {
+		DecodeTexture(texture);
+	}
+
+	return texture;
+}
+
+ITextureLoader::TextureData* TextureLoader::ReserveTexture(const std::wstring& name)
+{
+	return m_registry.Reserve(name);
+}
+
+ITextureLoader::TextureData* TextureLoader::ReserveTexture(const std::wstring& name, uint64_t content_hash, const EmbeddedImage& image)
+{
+	return m_registry.Reserve(name, content_hash, image);
+}
 
-	const auto it = std::find_if(m_load_textures.begin(), m_load_textures.end(), [&filename](TextureDataDx& texture) { return (texture.name == filename); });
-	if (it != m_load_textures.end()) {
-		return &(*it);
+void TextureLoader::DecodeTexture(ITextureLoader::TextureData* tex_data)
+{
+	EmbeddedImage embedded;
+	if (tex_data->content_hash) {
+		embedded.data = tex_data->embedded_data.data();
+		embedded.size = tex_data->embedded_data.size();
+		embedded.width = tex_data->embedded_width;
+		embedded.height = tex_data->embedded_height;
+		embedded.format_hint = tex_data->embedded_format_hint;
 	}
-	else {
-		TextureDataDx* texture = &m_load_textures[m_load_textures.push_back()];
-		texture->name = filename;
-		std::filesystem::path full_path((m_texture_dir / filename));
-		assert(std::filesystem::exists(full_path));
 
-		if (full_path.extension() == ".dds" || full_path.extension() == ".DDS") {
-			ThrowIfFailed(DirectX::LoadFromDDSFile(full_path.wstring().c_str(), DirectX::DDS_FLAGS_NONE, &texture->meta_data, texture->scratch_image));
-		}
-		else if (full_path.extension() == ".hdr" || full_path.extension() == ".HDR") {
-			ThrowIfFailed(DirectX::LoadFromHDRFile(full_path.wstring().c_str(), &texture->meta_data, texture->scratch_image));
-		}
-		else if (full_path.extension() == ".tga" || full_path.extension() == ".TGA") {
-			ThrowIfFailed(DirectX::LoadFromTGAFile(full_path.wstring().c_str(), &texture->meta_data, texture->scratch_image));
+	image_decoder::Image image;
+	ThrowIfFailed(DecodeImage(tex_data->name, tex_data->content_hash ? &embedded : nullptr, image) ? S_OK : E_FAIL);
+	m_registry.SetDecoded(tex_data, std::move(image));
+}
+
+bool TextureLoader::DecodeImage(const std::wstring& name, const EmbeddedImage* embedded, image_decoder::Image& image)
+{
+	StartupScope scope("texture decode", name);
+	std::shared_ptr<VfsFile> file;
+	const uint8_t* data = nullptr;
+	uint64_t size = 0;
+	std::string extension;
+	if (embedded && embedded->width) {
+		// raw aiTexel data, bgra8 rows without padding
+		assert(embedded->size == (uint64_t)embedded->width * embedded->height * 4);
+		image_decoder::InitImage2D(ResourceFormat::rf_b8g8r8a8_unorm, embedded->width, embedded->height, image);
+		memcpy(image.pixels.data(), embedded->data, std::min<uint64_t>(embedded->size, image.pixels.size()));
+	}
+	else {
+		if (embedded) {
+			data = embedded->data;
+			size = embedded->size;
+			extension = embedded->format_hint;
 		}
 		else {
-			ThrowIfFailed(DirectX::LoadFromWICFile(full_path.wstring().c_str(), DirectX::WIC_FLAGS_NONE, &texture->meta_data, texture->scratch_image));
+			std::filesystem::path full_path((m_texture_dir / name));
+			// mips and block compression from the cooker when it ran on this source
+			const std::filesystem::path cooked_path = texture_cooker::GetCookedPath(m_cooked_texture_dir, name);
+			if (texture_cooker::IsCookedFresh(cooked_path, full_path) && image_decoder::DecodeFile(cooked_path, image)) {
+				return true;
+			}
+			// deleted or renamed since it was asked for
+			file = VirtualFileSystem::Get().Open(full_path);
+			if (!file) {
+				return false;
+			}
+
+			data = file->GetData();
+			size = file->GetSize();
+			extension = full_path.extension().u8string();
 		}
 
-		if (texture->meta_data.format != DXGI_FORMAT_R8_UNORM) {
-			texture->meta_data.format = DirectX::MakeSRGB(texture->meta_data.format);
+		if (!image_decoder::Decode(data, size, extension, image) && !DecodeWIC(data, size, image)) {
+			return false;
 		}
+	}
 
-		return (TextureData*)texture;
+	image.format = image_decoder::MakeSrgb(image.format);
+
+	return true;
+}
+
+bool TextureLoader::DecodeWIC(const uint8_t* data, uint64_t size, image_decoder::Image& image)
+{
+	// WIC needs COM on every thread that decodes
+	thread_local bool com_initialized = false;
+	if (!com_initialized) {
+		ThrowIfFailed(CoInitializeEx(nullptr, COINITBASE_MULTITHREADED));
+		com_initialized = true;
 	}
+
+	DirectX::TexMetadata meta_data;
+	DirectX::ScratchImage scratch_image;
+	if (FAILED(DirectX::LoadFromWICMemory(data, (size_t)size, DirectX::WIC_FLAGS_NONE, &meta_data, scratch_image))) {
+		return false;
+	}
+
+	image = image_decoder::Image();
+	image.format = (ResourceFormat)meta_data.format;
+	image.width = (uint32_t)meta_data.width;
+	image.height = (uint32_t)meta_data.height;
+	image.mip_levels = (uint32_t)meta_data.mipLevels;
+	image.array_size = (uint32_t)meta_data.arraySize;
+	image.pixels.assign(scratch_image.GetPixels(), scratch_image.GetPixels() + scratch_image.GetPixelsSize());
+
+	const DirectX::Image* images = scratch_image.GetImages();
+	for (size_t i = 0; i < scratch_image.GetImageCount(); i++) {
+		image_decoder::Subresource sub;
+		sub.offset = images[i].pixels - scratch_image.GetPixels();
+		sub.row_pitch = images[i].rowPitch;
+		sub.slice_pitch = images[i].slicePitch;
+		sub.width = (uint32_t)images[i].width;
+		sub.height = (uint32_t)images[i].height;
+		image.subresources.push_back(sub);
+	}
+
+	return true;
 }
 
 void TextureLoader::LoadTextureOnGPU(ICommandList* command_list, IGpuResource* res, ITextureLoader::TextureData* tex_data)
 {
-	TextureLoader::TextureDataDx* tex_data_dx = (TextureLoader::TextureDataDx*)tex_data;
+	// evicted while waiting for the upload
+	if (!tex_data->is_decoded) {
+		DecodeTexture(tex_data);
+	}
+
+	const image_decoder::Image& image = tex_data->image;
 	SRVdesc::SRVdimensionType srv_dim = SRVdesc::SRVdimensionType::srv_dt_texture2d;
 	ResourceDesc tex_desc;
 
-	switch (tex_data_dx->meta_data.dimension)
+	switch (image.dimension)
 	{
-	case DirectX::TEX_DIMENSION_TEXTURE1D:
-		tex_desc = ResourceDesc::tex_1d((ResourceFormat)tex_data_dx->meta_data.format, static_cast<UINT64>(tex_data_dx->meta_data.width), static_cast<UINT16>(tex_data_dx->meta_data.arraySize));
+	case ResourceDesc::ResourcesDimension::rd_texture1d:
+		tex_desc = ResourceDesc::tex_1d(image.format, image.width, (uint16_t)image.array_size, (uint16_t)image.mip_levels);
 		srv_dim = SRVdesc::SRVdimensionType::srv_dt_texture1d;
 		break;
-	case DirectX::TEX_DIMENSION_TEXTURE2D:
-		tex_desc = ResourceDesc::tex_2d((ResourceFormat)tex_data_dx->meta_data.format, static_cast<UINT64>(tex_data_dx->meta_data.width), static_cast<UINT>(tex_data_dx->meta_data.height), static_cast<UINT16>(tex_data_dx->meta_data.arraySize));
-		srv_dim = (tex_data_dx->meta_data.arraySize > 1) ? SRVdesc::SRVdimensionType::srv_dt_texturecube : SRVdesc::SRVdimensionType::srv_dt_texture2d;
+	case ResourceDesc::ResourcesDimension::rd_texture2d:
+		tex_desc = ResourceDesc::tex_2d(image.format, image.width, image.height, (uint16_t)image.array_size, (uint16_t)image.mip_levels);
+		srv_dim = image.is_cubemap ? SRVdesc::SRVdimensionType::srv_dt_texturecube : SRVdesc::SRVdimensionType::srv_dt_texture2d;
 		break;
-	case DirectX::TEX_DIMENSION_TEXTURE3D:
+	case ResourceDesc::ResourcesDimension::rd_texture3d:
 		srv_dim = SRVdesc::SRVdimensionType::srv_dt_texture3d;
-		tex_desc = ResourceDesc::tex_3d((ResourceFormat)tex_data_dx->meta_data.format, static_cast<UINT64>(tex_data_dx->meta_data.width), static_cast<UINT>(tex_data_dx->meta_data.height), static_cast<UINT16>(tex_data_dx->meta_data.depth));
+		tex_desc = ResourceDesc::tex_3d(image.format, image.width, image.height, (uint16_t)image.depth, (uint16_t)image.mip_levels);
 		break;
 	default:
 		throw std::exception("Invalid texture dimension.");
 		break;
 	}
 
-	res->CreateTexture(HeapType::ht_default, tex_desc, ResourceState::rs_resource_state_copy_dest, nullptr, std::wstring(tex_data_dx->name).append(L"model_srv_").c_str());
+	res->CreateTexture(HeapType::ht_default, tex_desc, ResourceState::rs_resource_state_copy_dest, nullptr, std::wstring(tex_data->name).append(L"model_srv_").c_str());
 
-	const uint32_t image_count = (uint32_t)tex_data_dx->scratch_image.GetImageCount();
-	std::vector<SubresourceData> subresources(image_count);
-	const DirectX::Image* pImages = tex_data_dx->scratch_image.GetImages();
-	for (uint32_t i = 0; i < (uint32_t)image_count; ++i) {
+	frame_vector<SubresourceData> subresources(image.subresources.size());
+	for (uint32_t i = 0; i < (uint32_t)subresources.size(); ++i) {
+		const image_decoder::Subresource& sub = image.subresources[i];
 		auto& subresource = subresources[i];
-		subresource.row_pitch = pImages[i].rowPitch;
-		subresource.slice_pitch = pImages[i].slicePitch;
-		subresource.data = pImages[i].pixels;
+		subresource.row_pitch = sub.row_pitch;
+		subresource.slice_pitch = sub.slice_pitch;
+		subresource.data = image.pixels.data() + sub.offset;
 	}
 	res->LoadBuffer(command_list, 0, (uint32_t)subresources.size(), subresources.data());
 	command_list->ResourceBarrier(*res, ResourceState::rs_resource_state_pixel_shader_resource);
 
 	SRVdesc srv_desc = {};
 
-	srv_desc.format = (ResourceFormat)tex_data_dx->meta_data.format; // TODO: remove when load text moved etc.
+	srv_desc.format = image.format;
 	srv_desc.dimension = srv_dim;
 	if (srv_dim == SRVdesc::SRVdimensionType::srv_dt_texture2d) {
 		srv_desc.texture2d.most_detailed_mip = 0;
-		srv_desc.texture2d.mip_levels = (UINT)tex_data_dx->meta_data.mipLevels;
+		srv_desc.texture2d.mip_levels = image.mip_levels;
 		srv_desc.texture2d.res_min_lod_clamp = 0.0f;
 	}
 	else if (srv_dim == SRVdesc::SRVdimensionType::srv_dt_texturecube) {
 		srv_desc.texture_cube.most_detailed_mip = 0;
-		srv_desc.texture_cube.mip_levels = (UINT)tex_data_dx->meta_data.mipLevels;
+		srv_desc.texture_cube.mip_levels = image.mip_levels;
 		srv_desc.texture_cube.res_min_lod_clamp = 0.0f;
 	}
 
 	res->Create_SRV(srv_desc);
+	m_registry.SetUploaded(tex_data);
 }
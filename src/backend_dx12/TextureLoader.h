@@ -2,22 +2,26 @@
 
 #include "ITextureLoader.h"
 #include "DirectXTex.h"
-#include "simple_object_pool.h"
+#include "TextureRegistry.h"
 #include <filesystem>
 
 class TextureLoader : public ITextureLoader {
 public:
-    struct TextureDataDx : ITextureLoader::TextureData {
-        DirectX::TexMetadata meta_data;
-        DirectX::ScratchImage scratch_image;
-    };
     TextureLoader(const std::filesystem::path& root_dir);
     void OnInit() override;
     ITextureLoader::TextureData* LoadTextureOnCPU(const std::wstring& name) override;
+    ITextureLoader::TextureData* ReserveTexture(const std::wstring& name) override;
+    ITextureLoader::TextureData* ReserveTexture(const std::wstring& name, uint64_t content_hash, const EmbeddedImage& image) override;
+    void DecodeTexture(ITextureLoader::TextureData* tex_data) override;
+    bool DecodeImage(const std::wstring& name, const EmbeddedImage* embedded, image_decoder::Image& image) override;
     void LoadTextureOnGPU(ICommandList* command_list, IGpuResource* res, ITextureLoader::TextureData* tex_data) override;
+    TextureRegistry& GetRegistry() override { return m_registry; }
 
 private:
-    static constexpr uint32_t textures_capacity = 128;
-    pro_game_containers::simple_object_pool<TextureDataDx, textures_capacity> m_load_textures;
+    // WIC fallback for containers image_decoder does not know (jpg, bmp, ...)
+    static bool DecodeWIC(const uint8_t* data, uint64_t size, image_decoder::Image& image);
+
+    TextureRegistry m_registry;
     std::filesystem::path m_texture_dir;
+    std::filesystem::path m_cooked_texture_dir;
 };
\ No newline at end of file
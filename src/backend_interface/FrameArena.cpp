@@ -0,0 +1,66 @@
+#include "FrameArena.h"
+
+#include <cassert>
+
+std::atomic<uint64_t> FrameArena::s_frame{ 0 };
+
+FrameArena& FrameArena::Get()
+{
+    thread_local FrameArena arena;
+    return arena;
+}
+
+void FrameArena::NextFrame()
+{
+    s_frame.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+    assert(alignment && !(alignment & (alignment - 1)));
+    const uint64_t frame = s_frame.load(std::memory_order_relaxed);
+    if (frame != m_frame) {
+        m_frame = frame;
+        Rewind();
+    }
+
+    // the chunks of earlier frames first, a new one only past them
+    while (m_chunk < m_chunks.size()) {
+        Chunk& chunk = m_chunks[m_chunk];
+        const uintptr_t base = (uintptr_t)chunk.data.get();
+        const size_t offset = (size_t)(((base + m_offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base);
+        if (offset + size <= chunk.size) {
+            m_offset = offset + size;
+            m_stats.used_bytes += size;
+            m_stats.high_water = m_stats.used_bytes > m_stats.high_water ? m_stats.used_bytes : m_stats.high_water;
+            return chunk.data.get() + offset;
+        }
+        m_chunk++;
+        m_offset = 0;
+    }
+
+    Chunk chunk;
+    chunk.size = size + alignment > chunk_size ? size + alignment : chunk_size;
+    chunk.data.reset(new uint8_t[chunk.size]);
+    m_stats.reserved_bytes += chunk.size;
+    m_stats.chunks_num++;
+    m_chunks.push_back(std::move(chunk));
+    m_chunk = (uint32_t)m_chunks.size() - 1;
+    m_offset = 0;
+    return Allocate(size, alignment);
+}
+
+void FrameArena::Free(void* ptr, size_t size)
+{
+    if (m_chunk < m_chunks.size() && (uint8_t*)ptr + size == m_chunks[m_chunk].data.get() + m_offset) {
+        m_offset -= size;
+        m_stats.used_bytes -= size;
+    }
+}
+
+void FrameArena::Rewind()
+{
+    m_chunk = 0;
+    m_offset = 0;
+    m_stats.used_bytes = 0;
+}
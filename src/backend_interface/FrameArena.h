@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Bump allocator for data that lives no longer than the frame it was made in: command recording scratch, barrier
+// lists, subresource tables. One arena per thread, rewound when the thread first allocates after NextFrame, which the
+// backends call from SyncWithCPU. Chunks are kept across frames, so once the arena has seen the largest frame the
+// render path does no heap allocations for it. Not for work that crosses a frame boundary (loader threads, tasks).
+class FrameArena {
+public:
+    struct Stats {
+        uint64_t used_bytes{ 0 };       // this frame
+        uint64_t high_water{ 0 };       // largest frame so far
+        uint64_t reserved_bytes{ 0 };   // chunks
+        uint32_t chunks_num{ 0 };
+    };
+
+    // the calling thread's arena
+    static FrameArena& Get();
+    // ends the frame for the arenas of all threads
+    static void NextFrame();
+
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    // memory of this frame is freed by NextFrame, this only lets the last allocation grow back in place
+    void Free(void* ptr, size_t size);
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    static constexpr size_t chunk_size = 64 * 1024;
+
+    struct Chunk {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size{ 0 };
+    };
+
+    void Rewind();
+
+    std::vector<Chunk> m_chunks;
+    uint32_t m_chunk{ 0 };          // in use
+    size_t m_offset{ 0 };           // in m_chunks[m_chunk]
+    uint64_t m_frame{ 0 };
+    Stats m_stats;
+
+    static std::atomic<uint64_t> s_frame;
+};
+
+// std allocator over the calling thread's FrameArena, deallocate is a no-op
+template <class T>
+class frame_allocator {
+public:
+    using value_type = T;
+
+    frame_allocator() noexcept = default;
+    template <class U>
+    frame_allocator(const frame_allocator<U>&) noexcept {}
+
+    T* allocate(size_t n) { return static_cast<T*>(FrameArena::Get().Allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T* ptr, size_t n) noexcept { FrameArena::Get().Free(ptr, n * sizeof(T)); }
+
+    template <class U>
+    bool operator==(const frame_allocator<U>&) const noexcept { return true; }
+    template <class U>
+    bool operator!=(const frame_allocator<U>&) const noexcept { return false; }
+};
+
+template <class T>
+using frame_vector = std::vector<T, frame_allocator<T>>;
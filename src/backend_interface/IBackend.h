@@ -36,6 +36,9 @@ public:
 	virtual const IRootSignature* GetRootSignById(uint32_t id) = 0;
 	virtual uint32_t GetRenderMode() const = 0;
 	virtual uint32_t GetFrameCount() const = 0;
+	// gfx fence of the frame the last Present closed, and the last one SyncWithCPU waited for
+	virtual uint64_t GetPresentedFence() const = 0;
+	virtual uint64_t GetCompletedFence() const = 0;
 	virtual IImguiHelper* GetUI() = 0;
 	virtual bool PassImguiWndProc(const ImguiWindowData& data) = 0;
 	virtual bool ShouldClose() = 0;
@@ -1,20 +1,65 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <list>
 #include <filesystem>
+#include "ImageDecoder.h"
 
 class ICommandList;
 class IGpuResource;
+class TextureRegistry;
 
 class ITextureLoader {
 public:
+    // image embedded in a model file, decoded from memory
+    struct EmbeddedImage {
+        const uint8_t* data{ nullptr };
+        uint64_t size{ 0 };
+        uint32_t width{ 0 };  // 0: data is a compressed file (png, jpg, ...) and format_hint its extension
+        uint32_t height{ 0 }; // otherwise width * height bgra8 texels
+        std::string format_hint;
+    };
+
     struct TextureData {
         std::wstring name;
+        bool is_decoded{ false };
+        uint64_t content_hash{ 0 }; // embedded textures only
+        // copy of the embedded bytes, released once uploaded
+        std::vector<uint8_t> embedded_data;
+        uint32_t embedded_width{ 0 };
+        uint32_t embedded_height{ 0 };
+        std::string embedded_format_hint;
+        image_decoder::Image image; // every mip and array slice, in subresource order; texels are released once uploaded
+        // one gpu texture per entry, shared by every model using it
+        std::shared_ptr<IGpuResource> gpu_resource;
+
+        // TextureRegistry bookkeeping
+        uint32_t ref_count{ 0 };
+        uint32_t decodes_num{ 0 };
+        uint64_t cpu_bytes{ 0 }; // texels and embedded bytes
+        uint64_t gpu_bytes{ 0 }; // texels uploaded
+        bool in_lru{ false };
+        std::list<TextureData*>::iterator lru_it;
+
+        bool NeedsDecode() const { return !is_decoded && !gpu_resource; }
     };
 
     virtual void OnInit() = 0;
     virtual ITextureLoader::TextureData* LoadTextureOnCPU(const std::wstring& name) = 0;
+    // LoadTextureOnCPU split in two for parallel loading: reserve on one thread, decode reserved entries on any thread
+    virtual ITextureLoader::TextureData* ReserveTexture(const std::wstring& name) = 0;
+    // embedded images are keyed by content hash, so every model sharing one gets the same entry
+    virtual ITextureLoader::TextureData* ReserveTexture(const std::wstring& name, uint64_t content_hash, const EmbeddedImage& image) = 0;
+    virtual void DecodeTexture(TextureData* tex_data) = 0;
+    // what DecodeTexture does, without a reserved entry: thread safe, so decoding can start before the texture is reserved.
+    // embedded is null for texture files
+    virtual bool DecodeImage(const std::wstring& name, const EmbeddedImage* embedded, image_decoder::Image& image) = 0;
+    // decodes again when the cpu copy was evicted, releases it afterwards
     virtual void LoadTextureOnGPU(ICommandList* command_list, IGpuResource* res, TextureData* tex_data) = 0;
+    virtual TextureRegistry& GetRegistry() = 0;
     virtual ~ITextureLoader() = default;
 };
 
@@ -0,0 +1,1235 @@
+#include "ImageDecoder.h"
+#include "VirtualFileSystem.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace image_decoder {
+
+namespace {
+    uint32_t ReadBe32(const uint8_t* p) {
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+
+    uint16_t ReadLe16(const uint8_t* p) {
+        return (uint16_t)(p[0] | (p[1] << 8));
+    }
+
+    uint32_t ReadLe32(const uint8_t* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    std::string ToLower(const std::string &str) {
+        std::string res = str;
+        std::transform(res.begin(), res.end(), res.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+        if (!res.empty() && res[0] == '.') {
+            res.erase(0, 1);
+        }
+
+        return res;
+    }
+
+    // deflate, RFC 1951
+
+    class BitReader {
+    public:
+        BitReader(const uint8_t* data, uint64_t size) : m_data(data), m_size(size) {}
+
+        uint32_t Peek(uint32_t count) {
+            Refill();
+            return (uint32_t)(m_bits & ((1ull << count) - 1));
+        }
+
+        void Consume(uint32_t count) {
+            m_bits >>= count;
+            m_count -= count;
+        }
+
+        uint32_t Get(uint32_t count) {
+            const uint32_t res = Peek(count);
+            Consume(count);
+            return res;
+        }
+
+        void AlignToByte() {
+            Consume(m_count % 8);
+        }
+
+        bool IsOverrun() const {
+            return m_pos * 8 - m_count > m_size * 8;
+        }
+
+    private:
+        void Refill() {
+            while (m_count <= 56) {
+                const uint64_t byte = m_pos < m_size ? m_data[m_pos] : 0;
+                m_bits |= byte << m_count;
+                m_count += 8;
+                m_pos++;
+            }
+        }
+
+        const uint8_t* m_data;
+        uint64_t m_size;
+        uint64_t m_pos{ 0 };
+        uint64_t m_bits{ 0 };
+        uint32_t m_count{ 0 };
+    };
+
+    // canonical huffman code, short codes through a lookup table, the rest bit by bit
+    class Huffman {
+    public:
+        static constexpr uint32_t max_bits = 15;
+        static constexpr uint32_t fast_bits = 10;
+
+        bool Build(const uint8_t* lengths, uint32_t symbols_num) {
+            memset(m_counts, 0, sizeof(m_counts));
+            memset(m_fast, 0, sizeof(m_fast));
+            for (uint32_t i = 0; i < symbols_num; i++) {
+                m_counts[lengths[i]]++;
+            }
+            m_counts[0] = 0;
+
+            int32_t left = 1;
+            for (uint32_t len = 1; len <= max_bits; len++) {
+                left = (left << 1) - m_counts[len];
+                if (left < 0) {
+                    return false;
+                }
+            }
+
+            uint16_t offsets[max_bits + 1];
+            offsets[1] = 0;
+            for (uint32_t len = 1; len < max_bits; len++) {
+                offsets[len + 1] = offsets[len] + m_counts[len];
+            }
+            for (uint32_t i = 0; i < symbols_num; i++) {
+                if (lengths[i]) {
+                    m_symbols[offsets[lengths[i]]++] = (uint16_t)i;
+                }
+            }
+
+            // codes come msb first, the reader hands out lsb first
+            uint32_t code = 0;
+            uint32_t idx = 0;
+            for (uint32_t len = 1; len <= fast_bits; len++) {
+                for (uint32_t k = 0; k < m_counts[len]; k++, idx++, code++) {
+                    uint32_t reversed = 0;
+                    for (uint32_t b = 0; b < len; b++) {
+                        reversed |= ((code >> b) & 1) << (len - 1 - b);
+                    }
+                    for (uint32_t slot = reversed; slot < (1u << fast_bits); slot += (1u << len)) {
+                        m_fast[slot] = (uint16_t)((m_symbols[idx] << 4) | len);
+                    }
+                }
+                code <<= 1;
+            }
+
+            return true;
+        }
+
+        int32_t Decode(BitReader &reader) const {
+            const uint16_t entry = m_fast[reader.Peek(fast_bits)];
+            if (entry) {
+                reader.Consume(entry & 0xf);
+                return entry >> 4;
+            }
+
+            int32_t code = 0;
+            int32_t first = 0;
+            int32_t index = 0;
+            for (uint32_t len = 1; len <= max_bits; len++) {
+                code |= (int32_t)reader.Get(1);
+                const int32_t count = m_counts[len];
+                if (code - count < first) {
+                    return m_symbols[index + (code - first)];
+                }
+                index += count;
+                first = (first + count) << 1;
+                code <<= 1;
+            }
+
+            return -1;
+        }
+
+    private:
+        uint16_t m_counts[max_bits + 1];
+        uint16_t m_symbols[288];
+        uint16_t m_fast[1 << fast_bits];
+    };
+
+    const uint16_t length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    const uint8_t length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    const uint16_t dist_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    const uint8_t dist_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    bool InflateBlock(BitReader &reader, const Huffman &lit, const Huffman &dist, uint64_t max_size, std::vector<uint8_t> &out) {
+        while (true) {
+            const int32_t sym = lit.Decode(reader);
+            if (sym < 0 || reader.IsOverrun()) {
+                return false;
+            }
+            if (sym < 256) {
+                if (out.size() == max_size) {
+                    return false;
+                }
+                out.push_back((uint8_t)sym);
+                continue;
+            }
+            if (sym == 256) {
+                return true;
+            }
+
+            const uint32_t len_idx = (uint32_t)sym - 257;
+            if (len_idx >= 29) {
+                return false;
+            }
+            const uint32_t length = length_base[len_idx] + reader.Get(length_extra[len_idx]);
+            const int32_t dist_sym = dist.Decode(reader);
+            if (dist_sym < 0 || dist_sym >= 30) {
+                return false;
+            }
+            const uint32_t distance = dist_base[dist_sym] + reader.Get(dist_extra[dist_sym]);
+            if (distance > out.size() || out.size() + length > max_size) {
+                return false;
+            }
+
+            // overlapping copies repeat the tail, so byte by byte
+            const size_t at = out.size();
+            out.resize(at + length);
+            uint8_t* dst = out.data() + at;
+            const uint8_t* src = dst - distance;
+            for (uint32_t i = 0; i < length; i++) {
+                dst[i] = src[i];
+            }
+        }
+    }
+
+    // fails once the output would grow past max_size, a few bytes of deflate can expand to gigabytes
+    bool Inflate(const uint8_t* data, uint64_t size, uint64_t max_size, std::vector<uint8_t> &out) {
+        BitReader reader(data, size);
+        uint32_t final_block = 0;
+        do {
+            final_block = reader.Get(1);
+            const uint32_t type = reader.Get(2);
+            if (type == 0) {
+                reader.AlignToByte();
+                const uint32_t len = reader.Get(16);
+                const uint32_t nlen = reader.Get(16);
+                if ((len ^ 0xffff) != nlen || out.size() + len > max_size) {
+                    return false;
+                }
+                for (uint32_t i = 0; i < len; i++) {
+                    out.push_back((uint8_t)reader.Get(8));
+                }
+            }
+            else if (type == 1) {
+                static const struct FixedTables {
+                    Huffman lit;
+                    Huffman dist;
+                    FixedTables() {
+                        uint8_t lengths[288];
+                        memset(lengths, 8, 144);
+                        memset(lengths + 144, 9, 112);
+                        memset(lengths + 256, 7, 24);
+                        memset(lengths + 280, 8, 8);
+                        lit.Build(lengths, 288);
+                        memset(lengths, 5, 30);
+                        dist.Build(lengths, 30);
+                    }
+                } fixed;
+                if (!InflateBlock(reader, fixed.lit, fixed.dist, max_size, out)) {
+                    return false;
+                }
+            }
+            else if (type == 2) {
+                static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+                const uint32_t lit_num = reader.Get(5) + 257;
+                const uint32_t dist_num = reader.Get(5) + 1;
+                const uint32_t code_num = reader.Get(4) + 4;
+                uint8_t code_lengths[19] = {};
+                for (uint32_t i = 0; i < code_num; i++) {
+                    code_lengths[order[i]] = (uint8_t)reader.Get(3);
+                }
+                Huffman code_huffman;
+                if (lit_num > 286 || dist_num > 30 || !code_huffman.Build(code_lengths, 19)) {
+                    return false;
+                }
+
+                uint8_t lengths[286 + 30] = {};
+                uint32_t idx = 0;
+                while (idx < lit_num + dist_num) {
+                    const int32_t sym = code_huffman.Decode(reader);
+                    if (sym < 0 || reader.IsOverrun()) {
+                        return false;
+                    }
+                    if (sym < 16) {
+                        lengths[idx++] = (uint8_t)sym;
+                        continue;
+                    }
+
+                    uint8_t value = 0;
+                    uint32_t repeat = 0;
+                    if (sym == 16) {
+                        if (idx == 0) {
+                            return false;
+                        }
+                        value = lengths[idx - 1];
+                        repeat = 3 + reader.Get(2);
+                    }
+                    else if (sym == 17) {
+                        repeat = 3 + reader.Get(3);
+                    }
+                    else {
+                        repeat = 11 + reader.Get(7);
+                    }
+                    if (idx + repeat > lit_num + dist_num) {
+                        return false;
+                    }
+                    memset(lengths + idx, value, repeat);
+                    idx += repeat;
+                }
+
+                Huffman lit;
+                Huffman dist;
+                if (!lengths[256] || !lit.Build(lengths, lit_num) || !dist.Build(lengths + lit_num, dist_num) || !InflateBlock(reader, lit, dist, max_size, out)) {
+                    return false;
+                }
+            }
+            else {
+                return false;
+            }
+
+            if (reader.IsOverrun()) {
+                return false;
+            }
+        } while (!final_block);
+
+        return true;
+    }
+
+    // PNG
+
+    const uint8_t png_signature[8] = { 0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a };
+
+    uint8_t Paeth(int32_t a, int32_t b, int32_t c) {
+        const int32_t p = a + b - c;
+        const int32_t pa = std::abs(p - a);
+        const int32_t pb = std::abs(p - b);
+        const int32_t pc = std::abs(p - c);
+        if (pa <= pb && pa <= pc) {
+            return (uint8_t)a;
+        }
+
+        return (uint8_t)((pb <= pc) ? b : c);
+    }
+
+    bool Unfilter(uint8_t* rows, uint32_t rows_num, uint64_t row_size, uint32_t bpp) {
+        const uint8_t* prior = nullptr;
+        for (uint32_t y = 0; y < rows_num; y++) {
+            uint8_t* row = rows + y * (row_size + 1);
+            const uint8_t filter = row[0];
+            uint8_t* cur = row + 1;
+            switch (filter) {
+                case 0:
+                    break;
+                case 1:
+                    for (uint64_t i = bpp; i < row_size; i++) {
+                        cur[i] += cur[i - bpp];
+                    }
+                    break;
+                case 2:
+                    if (prior) {
+                        for (uint64_t i = 0; i < row_size; i++) {
+                            cur[i] += prior[i];
+                        }
+                    }
+                    break;
+                case 3:
+                    for (uint64_t i = 0; i < row_size; i++) {
+                        const uint32_t left = i >= bpp ? cur[i - bpp] : 0;
+                        const uint32_t up = prior ? prior[i] : 0;
+                        cur[i] += (uint8_t)((left + up) >> 1);
+                    }
+                    break;
+                case 4:
+                    for (uint64_t i = 0; i < row_size; i++) {
+                        const int32_t left = i >= bpp ? cur[i - bpp] : 0;
+                        const int32_t up = prior ? prior[i] : 0;
+                        const int32_t up_left = (prior && i >= bpp) ? prior[i - bpp] : 0;
+                        cur[i] += Paeth(left, up, up_left);
+                    }
+                    break;
+                default:
+                    return false;
+            }
+            prior = cur;
+        }
+
+        return true;
+    }
+
+    struct PngInfo {
+        uint32_t width{ 0 };
+        uint32_t height{ 0 };
+        uint32_t bit_depth{ 0 };
+        uint32_t color_type{ 0 };
+        uint32_t channels{ 0 };
+        uint8_t palette[256][4];
+        uint32_t palette_size{ 0 };
+        bool has_key{ false };
+        uint16_t key[3]{}; // tRNS color key of gray and rgb images
+        uint32_t out_bytes{ 0 }; // per pixel
+    };
+
+    uint32_t GetSample(const uint8_t* row, uint64_t idx, uint32_t bit_depth) {
+        if (bit_depth == 8) {
+            return row[idx];
+        }
+        if (bit_depth == 16) {
+            return (row[idx * 2] << 8) | row[idx * 2 + 1];
+        }
+
+        const uint64_t bit = idx * bit_depth;
+        return (row[bit / 8] >> (8 - bit_depth - bit % 8)) & ((1u << bit_depth) - 1);
+    }
+
+    // one unfiltered row to the output pixels at dst, dst_step bytes apart
+    void StorePngRow(const PngInfo &png, const uint8_t* row, uint32_t pixels_num, uint8_t* dst, uint64_t dst_step) {
+        const uint32_t bd = png.bit_depth;
+        if (bd == 8 && !png.has_key && dst_step == png.out_bytes) {
+            if (png.color_type == 0 || png.color_type == 6) {
+                memcpy(dst, row, (uint64_t)pixels_num * png.out_bytes);
+                return;
+            }
+            if (png.color_type == 2) {
+                for (uint32_t x = 0; x < pixels_num; x++, dst += 4, row += 3) {
+                    dst[0] = row[0];
+                    dst[1] = row[1];
+                    dst[2] = row[2];
+                    dst[3] = 255;
+                }
+                return;
+            }
+        }
+
+        for (uint32_t x = 0; x < pixels_num; x++, dst += dst_step) {
+            uint32_t s[4] = { 0, 0, 0, 0 };
+            for (uint32_t c = 0; c < png.channels; c++) {
+                s[c] = GetSample(row, (uint64_t)x * png.channels + c, bd);
+            }
+
+            if (png.color_type == 3) {
+                const uint8_t* entry = png.palette[std::min(s[0], 255u)];
+                memcpy(dst, entry, 4);
+                continue;
+            }
+
+            const uint32_t max_val = (1u << bd) - 1;
+            uint32_t rgba[4];
+            switch (png.color_type) {
+                case 0:
+                    rgba[0] = rgba[1] = rgba[2] = s[0];
+                    rgba[3] = (png.has_key && s[0] == png.key[0]) ? 0 : max_val;
+                    break;
+                case 2:
+                    rgba[0] = s[0];
+                    rgba[1] = s[1];
+                    rgba[2] = s[2];
+                    rgba[3] = (png.has_key && s[0] == png.key[0] && s[1] == png.key[1] && s[2] == png.key[2]) ? 0 : max_val;
+                    break;
+                case 4:
+                    rgba[0] = rgba[1] = rgba[2] = s[0];
+                    rgba[3] = s[1];
+                    break;
+                default:
+                    rgba[0] = s[0];
+                    rgba[1] = s[1];
+                    rgba[2] = s[2];
+                    rgba[3] = s[3];
+                    break;
+            }
+
+            if (bd == 16) {
+                const uint32_t channels = png.out_bytes / 2;
+                for (uint32_t c = 0; c < channels; c++) {
+                    dst[c * 2] = (uint8_t)rgba[c];
+                    dst[c * 2 + 1] = (uint8_t)(rgba[c] >> 8);
+                }
+            }
+            else {
+                const uint32_t channels = png.out_bytes;
+                for (uint32_t c = 0; c < channels; c++) {
+                    dst[c] = (uint8_t)(bd == 8 ? rgba[c] : rgba[c] * 255 / max_val);
+                }
+            }
+        }
+    }
+
+    bool DecodePng(const uint8_t* data, uint64_t size, Image &image) {
+        if (size < 8 || memcmp(data, png_signature, 8) != 0) {
+            return false;
+        }
+
+        PngInfo png;
+        std::vector<uint8_t> idat;
+        uint32_t interlace = 0;
+        uint8_t trns[256];
+        uint32_t trns_size = 0;
+        bool has_header = false;
+        for (uint64_t pos = 8; pos + 12 <= size;) {
+            const uint32_t len = ReadBe32(data + pos);
+            const uint8_t* type = data + pos + 4;
+            const uint8_t* chunk = data + pos + 8;
+            if (len > size - pos - 12) {
+                return false;
+            }
+
+            if (memcmp(type, "IHDR", 4) == 0 && len >= 13) {
+                png.width = ReadBe32(chunk);
+                png.height = ReadBe32(chunk + 4);
+                png.bit_depth = chunk[8];
+                png.color_type = chunk[9];
+                interlace = chunk[12];
+                has_header = true;
+            }
+            else if (memcmp(type, "PLTE", 4) == 0) {
+                png.palette_size = std::min(len / 3, 256u);
+                for (uint32_t i = 0; i < png.palette_size; i++) {
+                    png.palette[i][0] = chunk[i * 3];
+                    png.palette[i][1] = chunk[i * 3 + 1];
+                    png.palette[i][2] = chunk[i * 3 + 2];
+                    png.palette[i][3] = 255;
+                }
+            }
+            else if (memcmp(type, "tRNS", 4) == 0) {
+                trns_size = std::min(len, 256u);
+                memcpy(trns, chunk, trns_size);
+            }
+            else if (memcmp(type, "IDAT", 4) == 0) {
+                idat.insert(idat.end(), chunk, chunk + len);
+            }
+            else if (memcmp(type, "IEND", 4) == 0) {
+                break;
+            }
+            pos += 12 + (uint64_t)len;
+        }
+
+        static const uint32_t channels_by_type[7] = { 1, 0, 3, 1, 2, 0, 4 };
+        const uint32_t bd = png.bit_depth;
+        if (!has_header || !png.width || !png.height || png.width > max_dimension || png.height > max_dimension || png.color_type > 6 || !channels_by_type[png.color_type] || interlace > 1 ||
+            (bd != 1 && bd != 2 && bd != 4 && bd != 8 && bd != 16) || idat.size() < 2 || (idat[0] & 0x0f) != 8 || (idat[1] & 0x20)) {
+            return false;
+        }
+        png.channels = channels_by_type[png.color_type];
+        if ((png.color_type >= 2 && png.color_type != 3 && bd < 8) || (png.color_type == 3 && (bd > 8 || !png.palette_size))) {
+            return false;
+        }
+
+        if (png.color_type == 3) {
+            for (uint32_t i = 0; i < std::min(trns_size, png.palette_size); i++) {
+                png.palette[i][3] = trns[i];
+            }
+            for (uint32_t i = png.palette_size; i < 256; i++) {
+                memset(png.palette[i], 0, 4);
+            }
+        }
+        else if ((png.color_type == 0 && trns_size >= 2) || (png.color_type == 2 && trns_size >= 6)) {
+            png.has_key = true;
+            for (uint32_t c = 0; c < png.channels; c++) {
+                png.key[c] = (uint16_t)((trns[c * 2] << 8) | trns[c * 2 + 1]);
+            }
+        }
+
+        // gray stays one channel, everything else becomes rgba
+        ResourceFormat format = ResourceFormat::rf_r8g8b8a8_unorm;
+        png.out_bytes = 4;
+        if (png.color_type == 0 && !png.has_key) {
+            format = (bd == 16) ? ResourceFormat::rf_r16_unorm : ResourceFormat::rf_r8_unorm;
+            png.out_bytes = (bd == 16) ? 2 : 1;
+        }
+        else if (bd == 16) {
+            format = ResourceFormat::rf_r16g16b16a16_unorm;
+            png.out_bytes = 8;
+        }
+
+        const uint32_t bits_per_pixel = bd * png.channels;
+        const uint32_t filter_bpp = std::max(bits_per_pixel / 8, 1u);
+        auto raw_row_size = [bits_per_pixel](uint32_t width) { return ((uint64_t)width * bits_per_pixel + 7) / 8; };
+
+        // adam7 passes: x0, y0, dx, dy; one pass covering everything when not interlaced
+        static const uint32_t adam7[7][4] = { { 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 }, { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 } };
+        static const uint32_t progressive[1][4] = { { 0, 0, 1, 1 } };
+        const uint32_t (*passes)[4] = interlace ? adam7 : progressive;
+        const uint32_t passes_num = interlace ? 7 : 1;
+
+        uint64_t expected = 0;
+        for (uint32_t p = 0; p < passes_num; p++) {
+            const uint32_t w = (png.width - std::min(png.width, passes[p][0]) + passes[p][2] - 1) / passes[p][2];
+            const uint32_t h = (png.height - std::min(png.height, passes[p][1]) + passes[p][3] - 1) / passes[p][3];
+            if (w && h) {
+                expected += (raw_row_size(w) + 1) * h;
+            }
+        }
+
+        // deflate expands 1032:1 at most, a small file claiming a big image doesn't get to reserve it
+        std::vector<uint8_t> raw;
+        raw.reserve(std::min<uint64_t>(expected, (uint64_t)idat.size() * 1032));
+        if (!Inflate(idat.data() + 2, idat.size() - 2, expected, raw) || raw.size() < expected) {
+            return false;
+        }
+
+        InitImage2D(format, png.width, png.height, image);
+        const uint64_t dst_pitch = image.subresources[0].row_pitch;
+        uint8_t* rows = raw.data();
+        for (uint32_t p = 0; p < passes_num; p++) {
+            const uint32_t w = (png.width - std::min(png.width, passes[p][0]) + passes[p][2] - 1) / passes[p][2];
+            const uint32_t h = (png.height - std::min(png.height, passes[p][1]) + passes[p][3] - 1) / passes[p][3];
+            if (!w || !h) {
+                continue;
+            }
+
+            const uint64_t row_size = raw_row_size(w);
+            if (!Unfilter(rows, h, row_size, filter_bpp)) {
+                image = Image();
+                return false;
+            }
+            for (uint32_t y = 0; y < h; y++) {
+                uint8_t* dst = image.pixels.data() + (uint64_t)(passes[p][1] + y * passes[p][3]) * dst_pitch + (uint64_t)passes[p][0] * png.out_bytes;
+                StorePngRow(png, rows + y * (row_size + 1) + 1, w, dst, (uint64_t)passes[p][2] * png.out_bytes);
+            }
+            rows += (row_size + 1) * h;
+        }
+
+        return true;
+    }
+
+    // TGA
+
+    bool DecodeTga(const uint8_t* data, uint64_t size, Image &image) {
+        if (size < 18) {
+            return false;
+        }
+
+        const uint32_t id_length = data[0];
+        const uint32_t color_map_type = data[1];
+        const uint32_t image_type = data[2];
+        const uint32_t map_first = ReadLe16(data + 3);
+        const uint32_t map_length = ReadLe16(data + 5);
+        const uint32_t map_depth = data[7];
+        const uint32_t width = ReadLe16(data + 12);
+        const uint32_t height = ReadLe16(data + 14);
+        const uint32_t depth = data[16];
+        const uint32_t descriptor = data[17];
+        const bool rle = image_type >= 9;
+        const uint32_t base_type = rle ? image_type - 8 : image_type;
+        if (!width || !height || width > max_dimension || height > max_dimension || base_type < 1 || base_type > 3 || (base_type == 1 && (color_map_type != 1 || depth != 8)) ||
+            (depth != 8 && depth != 15 && depth != 16 && depth != 24 && depth != 32)) {
+            return false;
+        }
+
+        uint64_t pos = 18 + id_length;
+        const uint32_t map_bytes = (map_depth + 7) / 8;
+        const uint8_t* color_map = data + pos;
+        if (color_map_type == 1) {
+            pos += (uint64_t)map_length * map_bytes;
+        }
+        if (pos > size) {
+            return false;
+        }
+
+        const bool gray = (base_type == 3);
+        const bool has_alpha = (descriptor & 0x0f) != 0;
+        auto to_rgba = [has_alpha](const uint8_t* p, uint32_t bits, uint8_t* rgba) {
+            if (bits == 15 || bits == 16) {
+                const uint32_t v = ReadLe16(p);
+                rgba[0] = (uint8_t)(((v >> 10) & 0x1f) * 255 / 31);
+                rgba[1] = (uint8_t)(((v >> 5) & 0x1f) * 255 / 31);
+                rgba[2] = (uint8_t)((v & 0x1f) * 255 / 31);
+                rgba[3] = (bits == 16 && has_alpha) ? ((v & 0x8000) ? 255 : 0) : 255;
+            }
+            else {
+                rgba[0] = p[2];
+                rgba[1] = p[1];
+                rgba[2] = p[0];
+                rgba[3] = (bits == 32 && has_alpha) ? p[3] : 255;
+            }
+        };
+
+        const uint32_t pixel_bytes = (depth + 7) / 8;
+        const uint32_t out_bytes = gray ? 1 : 4;
+        if (!rle && pos + (uint64_t)width * height * pixel_bytes > size) {
+            return false;
+        }
+        InitImage2D(gray ? ResourceFormat::rf_r8_unorm : ResourceFormat::rf_r8g8b8a8_unorm, width, height, image);
+
+        auto store = [&](const uint8_t* src, uint8_t* dst) {
+            if (gray) {
+                dst[0] = src[0];
+            }
+            else if (base_type == 1) {
+                const uint32_t idx = src[0] - std::min<uint32_t>(src[0], map_first);
+                if (idx < map_length) {
+                    to_rgba(color_map + (uint64_t)idx * map_bytes, map_depth, dst);
+                }
+                else {
+                    memset(dst, 0, 4);
+                }
+            }
+            else {
+                to_rgba(src, depth, dst);
+            }
+        };
+
+        const uint64_t pixels_num = (uint64_t)width * height;
+        std::vector<uint8_t> linear(pixels_num * out_bytes);
+        uint64_t pixel = 0;
+        while (pixel < pixels_num) {
+            uint32_t count = 1;
+            bool repeat = false;
+            if (rle) {
+                if (pos >= size) {
+                    image = Image();
+                    return false;
+                }
+                const uint8_t header = data[pos++];
+                count = (header & 0x7f) + 1;
+                repeat = (header & 0x80) != 0;
+            }
+            else {
+                count = (uint32_t)std::min<uint64_t>(pixels_num, 1u << 30);
+            }
+            count = (uint32_t)std::min<uint64_t>(count, pixels_num - pixel);
+
+            const uint64_t src_bytes = repeat ? pixel_bytes : (uint64_t)count * pixel_bytes;
+            if (pos + src_bytes > size) {
+                image = Image();
+                return false;
+            }
+            for (uint32_t i = 0; i < count; i++, pixel++) {
+                store(data + pos + (repeat ? 0 : (uint64_t)i * pixel_bytes), &linear[pixel * out_bytes]);
+            }
+            pos += src_bytes;
+        }
+
+        // stored bottom-up unless bit 5 is set, right-to-left when bit 4 is
+        const bool top_down = (descriptor & 0x20) != 0;
+        const bool right_to_left = (descriptor & 0x10) != 0;
+        const uint64_t row_pitch = image.subresources[0].row_pitch;
+        for (uint32_t y = 0; y < height; y++) {
+            const uint8_t* src = &linear[(uint64_t)(top_down ? y : height - 1 - y) * width * out_bytes];
+            uint8_t* dst = image.pixels.data() + y * row_pitch;
+            if (!right_to_left) {
+                memcpy(dst, src, (uint64_t)width * out_bytes);
+                continue;
+            }
+            for (uint32_t x = 0; x < width; x++) {
+                memcpy(dst + (uint64_t)x * out_bytes, src + (uint64_t)(width - 1 - x) * out_bytes, out_bytes);
+            }
+        }
+
+        return true;
+    }
+
+    // Radiance HDR
+
+    bool ReadHdrLine(const uint8_t* data, uint64_t size, uint64_t &pos, std::string &line) {
+        line.clear();
+        while (pos < size && data[pos] != '\n') {
+            line.push_back((char)data[pos++]);
+        }
+        if (pos >= size) {
+            return false;
+        }
+        pos++;
+
+        return true;
+    }
+
+    bool DecodeHdr(const uint8_t* data, uint64_t size, Image &image) {
+        uint64_t pos = 0;
+        std::string line;
+        if (!ReadHdrLine(data, size, pos, line) || (line != "#?RADIANCE" && line != "#?RGBE")) {
+            return false;
+        }
+        do {
+            if (!ReadHdrLine(data, size, pos, line)) {
+                return false;
+            }
+            if (line.rfind("FORMAT=", 0) == 0 && line != "FORMAT=32-bit_rle_rgbe") {
+                return false;
+            }
+        } while (!line.empty());
+
+        char y_sign = 0;
+        char x_sign = 0;
+        int32_t height = 0;
+        int32_t width = 0;
+        if (!ReadHdrLine(data, size, pos, line) || sscanf(line.c_str(), "%cY %d %cX %d", &y_sign, &height, &x_sign, &width) != 4 ||
+            width <= 0 || height <= 0 || width > (int32_t)max_dimension || height > (int32_t)max_dimension || x_sign != '+' || (y_sign != '-' && y_sign != '+')) {
+            return false;
+        }
+
+        InitImage2D(ResourceFormat::rf_r32g32b32a32_float, (uint32_t)width, (uint32_t)height, image);
+        std::vector<uint8_t> scanline((size_t)width * 4);
+        for (int32_t y = 0; y < height; y++) {
+            // new rle: 2 2 w_hi w_lo, then every component run length encoded on its own
+            if (width >= 8 && width < 0x8000 && pos + 4 <= size && data[pos] == 2 && data[pos + 1] == 2 && ((data[pos + 2] << 8) | data[pos + 3]) == width) {
+                pos += 4;
+                for (uint32_t c = 0; c < 4; c++) {
+                    int32_t x = 0;
+                    while (x < width) {
+                        if (pos >= size) {
+                            image = Image();
+                            return false;
+                        }
+                        uint32_t count = data[pos++];
+                        const bool run = count > 128;
+                        count = run ? count - 128 : count;
+                        if (!count || x + (int32_t)count > width || pos + (run ? 1 : count) > size) {
+                            image = Image();
+                            return false;
+                        }
+                        for (uint32_t i = 0; i < count; i++, x++) {
+                            scanline[(size_t)x * 4 + c] = data[pos + (run ? 0 : i)];
+                        }
+                        pos += run ? 1 : count;
+                    }
+                }
+            }
+            else {
+                // flat pixels, 1 1 1 n repeats the previous one n << shift times
+                int32_t x = 0;
+                uint32_t shift = 0;
+                while (x < width) {
+                    if (pos + 4 > size) {
+                        image = Image();
+                        return false;
+                    }
+                    const uint8_t* p = data + pos;
+                    pos += 4;
+                    if (p[0] == 1 && p[1] == 1 && p[2] == 1) {
+                        const int32_t count = (int32_t)(p[3] << shift);
+                        if (!x || x + count > width) {
+                            image = Image();
+                            return false;
+                        }
+                        for (int32_t i = 0; i < count; i++, x++) {
+                            memcpy(&scanline[(size_t)x * 4], &scanline[(size_t)(x - 1) * 4], 4);
+                        }
+                        shift += 8;
+                        continue;
+                    }
+                    memcpy(&scanline[(size_t)x * 4], p, 4);
+                    x++;
+                    shift = 0;
+                }
+            }
+
+            const uint32_t row = (y_sign == '-') ? (uint32_t)y : (uint32_t)(height - 1 - y);
+            float* dst = (float*)(image.pixels.data() + row * image.subresources[0].row_pitch);
+            for (int32_t x = 0; x < width; x++) {
+                const uint8_t* rgbe = &scanline[(size_t)x * 4];
+                const float scale = rgbe[3] ? ldexpf(1.f, (int32_t)rgbe[3] - (128 + 8)) : 0.f;
+                dst[x * 4] = rgbe[0] * scale;
+                dst[x * 4 + 1] = rgbe[1] * scale;
+                dst[x * 4 + 2] = rgbe[2] * scale;
+                dst[x * 4 + 3] = 1.f;
+            }
+        }
+
+        return true;
+    }
+
+    // DDS
+
+    constexpr uint32_t MakeFourCC(char a, char b, char c, char d) {
+        return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8) | ((uint32_t)(uint8_t)c << 16) | ((uint32_t)(uint8_t)d << 24);
+    }
+
+    enum DdsFlags : uint32_t {
+        ddsd_mipmapcount = 0x20000,
+        ddsd_depth = 0x800000,
+        ddpf_alpha = 0x2,
+        ddpf_fourcc = 0x4,
+        ddpf_rgb = 0x40,
+        ddpf_luminance = 0x20000,
+        ddscaps2_cubemap = 0x200,
+        ddscaps2_volume = 0x200000,
+        dds_misc_texturecube = 0x4
+    };
+
+    struct DdsPixelFormat {
+        uint32_t flags;
+        uint32_t fourcc;
+        uint32_t bits;
+        uint32_t masks[4];
+    };
+
+    ResourceFormat GetLegacyDdsFormat(const DdsPixelFormat &pf, bool &expand_24bpp) {
+        expand_24bpp = false;
+        if (pf.flags & ddpf_fourcc) {
+            switch (pf.fourcc) {
+                case MakeFourCC('D', 'X', 'T', '1'): return ResourceFormat::rf_bc1_unorm;
+                case MakeFourCC('D', 'X', 'T', '2'):
+                case MakeFourCC('D', 'X', 'T', '3'): return ResourceFormat::rf_bc2_unorm;
+                case MakeFourCC('D', 'X', 'T', '4'):
+                case MakeFourCC('D', 'X', 'T', '5'): return ResourceFormat::rf_bc3_unorm;
+                case MakeFourCC('A', 'T', 'I', '1'):
+                case MakeFourCC('B', 'C', '4', 'U'): return ResourceFormat::rf_bc4_unorm;
+                case MakeFourCC('B', 'C', '4', 'S'): return ResourceFormat::rf_bc4_snorm;
+                case MakeFourCC('A', 'T', 'I', '2'):
+                case MakeFourCC('B', 'C', '5', 'U'): return ResourceFormat::rf_bc5_unorm;
+                case MakeFourCC('B', 'C', '5', 'S'): return ResourceFormat::rf_bc5_snorm;
+                case 36: return ResourceFormat::rf_r16g16b16a16_unorm;
+                case 110: return ResourceFormat::rf_r16g16b16a16_snorm;
+                case 111: return ResourceFormat::rf_r16_float;
+                case 112: return ResourceFormat::rf_r16g16_float;
+                case 113: return ResourceFormat::rf_r16g16b16a16_float;
+                case 114: return ResourceFormat::rf_r32_float;
+                case 115: return ResourceFormat::rf_r32g32_float;
+                case 116: return ResourceFormat::rf_r32g32b32a32_float;
+                default: return ResourceFormat::rf_unknown;
+            }
+        }
+
+        auto is_mask = [&pf](uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+            return pf.masks[0] == r && pf.masks[1] == g && pf.masks[2] == b && pf.masks[3] == a;
+        };
+        if (pf.flags & ddpf_rgb) {
+            if (pf.bits == 32) {
+                if (is_mask(0xff, 0xff00, 0xff0000, 0xff000000)) return ResourceFormat::rf_r8g8b8a8_unorm;
+                if (is_mask(0xff0000, 0xff00, 0xff, 0xff000000)) return ResourceFormat::rf_b8g8r8a8_unorm;
+                if (is_mask(0xff0000, 0xff00, 0xff, 0)) return ResourceFormat::rf_b8g8r8x8_unorm;
+                if (is_mask(0x3ff, 0xffc00, 0x3ff00000, 0xc0000000)) return ResourceFormat::rf_r10g10b10a2_unorm;
+                if (is_mask(0xffff, 0xffff0000, 0, 0)) return ResourceFormat::rf_r16g16_unorm;
+                if (is_mask(0xffffffff, 0, 0, 0)) return ResourceFormat::rf_r32_float;
+            }
+            else if (pf.bits == 24 && is_mask(0xff0000, 0xff00, 0xff, 0)) {
+                expand_24bpp = true;
+                return ResourceFormat::rf_r8g8b8a8_unorm;
+            }
+            else if (pf.bits == 16) {
+                if (is_mask(0xf800, 0x7e0, 0x1f, 0)) return ResourceFormat::rf_b5g6r5_unorm;
+                if (is_mask(0x7c00, 0x3e0, 0x1f, 0x8000)) return ResourceFormat::rf_b5g5r5a1_unorm;
+                if (is_mask(0xf00, 0xf0, 0xf, 0xf000)) return ResourceFormat::rf_b4g4r4a4_unorm;
+            }
+        }
+        else if (pf.flags & ddpf_luminance) {
+            if (pf.bits == 8 && pf.masks[0] == 0xff) return ResourceFormat::rf_r8_unorm;
+            if (pf.bits == 16 && pf.masks[0] == 0xffff) return ResourceFormat::rf_r16_unorm;
+            if (pf.bits == 16 && pf.masks[0] == 0xff && pf.masks[3] == 0xff00) return ResourceFormat::rf_r8g8_unorm;
+        }
+        else if ((pf.flags & ddpf_alpha) && pf.bits == 8) {
+            return ResourceFormat::rf_a8_unorm;
+        }
+
+        return ResourceFormat::rf_unknown;
+    }
+
+    bool DecodeDds(const uint8_t* data, uint64_t size, Image &image) {
+        static constexpr uint64_t header_size = 4 + 124;
+        if (size < header_size || ReadLe32(data) != MakeFourCC('D', 'D', 'S', ' ') || ReadLe32(data + 4) != 124) {
+            return false;
+        }
+
+        const uint8_t* header = data + 4;
+        const uint32_t flags = ReadLe32(header + 4);
+        uint32_t height = ReadLe32(header + 8);
+        uint32_t width = ReadLe32(header + 12);
+        uint32_t depth = (flags & ddsd_depth) ? std::max(ReadLe32(header + 20), 1u) : 1;
+        uint32_t mip_levels = (flags & ddsd_mipmapcount) ? std::max(ReadLe32(header + 24), 1u) : 1;
+        DdsPixelFormat pf;
+        pf.flags = ReadLe32(header + 76);
+        pf.fourcc = ReadLe32(header + 80);
+        pf.bits = ReadLe32(header + 84);
+        for (uint32_t i = 0; i < 4; i++) {
+            pf.masks[i] = ReadLe32(header + 88 + i * 4);
+        }
+        const uint32_t caps2 = ReadLe32(header + 108);
+
+        uint64_t pos = header_size;
+        ResourceFormat format = ResourceFormat::rf_unknown;
+        ResourceDesc::ResourcesDimension dimension = ResourceDesc::ResourcesDimension::rd_texture2d;
+        uint32_t array_size = 1;
+        bool is_cubemap = false;
+        bool expand_24bpp = false;
+        if ((pf.flags & ddpf_fourcc) && pf.fourcc == MakeFourCC('D', 'X', '1', '0')) {
+            if (size < pos + 20) {
+                return false;
+            }
+            format = (ResourceFormat)ReadLe32(data + pos);
+            const uint32_t res_dimension = ReadLe32(data + pos + 4);
+            const uint32_t misc_flags = ReadLe32(data + pos + 8);
+            array_size = std::max(ReadLe32(data + pos + 12), 1u);
+            pos += 20;
+            if (res_dimension < 2 || res_dimension > 4 || array_size > max_depth) {
+                return false;
+            }
+            dimension = (ResourceDesc::ResourcesDimension)res_dimension;
+            if (dimension != ResourceDesc::ResourcesDimension::rd_texture3d) {
+                depth = 1;
+            }
+            if (dimension == ResourceDesc::ResourcesDimension::rd_texture1d) {
+                height = 1;
+            }
+            if (misc_flags & dds_misc_texturecube) {
+                is_cubemap = true;
+                array_size *= 6;
+            }
+        }
+        else {
+            format = GetLegacyDdsFormat(pf, expand_24bpp);
+            if (caps2 & ddscaps2_cubemap) {
+                // partial cube maps are not a thing in d3d10+
+                if ((caps2 & 0xfc00) != 0xfc00) {
+                    return false;
+                }
+                is_cubemap = true;
+                array_size = 6;
+            }
+            else if ((caps2 & ddscaps2_volume) && depth > 1) {
+                dimension = ResourceDesc::ResourcesDimension::rd_texture3d;
+            }
+            else {
+                depth = 1;
+            }
+        }
+
+        if (!width || !height || width > max_dimension || height > max_dimension || depth > max_depth || array_size > max_depth || !BitsPerPixel(format) ||
+            mip_levels > 16) {
+            return false;
+        }
+
+        image = Image();
+        image.format = format;
+        image.dimension = dimension;
+        image.width = width;
+        image.height = height;
+        image.depth = depth;
+        image.array_size = array_size;
+        image.mip_levels = mip_levels;
+        image.is_cubemap = is_cubemap;
+
+        const uint32_t src_bpp = expand_24bpp ? 3 : 0;
+        uint64_t src_offset = pos;
+        uint64_t dst_offset = 0;
+        image.subresources.reserve((size_t)array_size * mip_levels);
+        for (uint32_t item = 0; item < array_size; item++) {
+            uint32_t w = width;
+            uint32_t h = height;
+            uint32_t d = depth;
+            for (uint32_t mip = 0; mip < mip_levels; mip++) {
+                Subresource sub;
+                ComputePitch(format, w, h, sub.row_pitch, sub.slice_pitch);
+                sub.offset = dst_offset;
+                sub.width = w;
+                sub.height = h;
+                sub.depth = d;
+                image.subresources.push_back(sub);
+
+                const uint64_t src_size = src_bpp ? (uint64_t)w * h * d * src_bpp : sub.slice_pitch * d;
+                if (src_offset + src_size > size) {
+                    image = Image();
+                    return false;
+                }
+                src_offset += src_size;
+                dst_offset += sub.slice_pitch * d;
+
+                w = std::max(w >> 1, 1u);
+                h = std::max(h >> 1, 1u);
+                d = std::max(d >> 1, 1u);
+            }
+        }
+
+        if (!src_bpp) {
+            image.pixels.assign(data + pos, data + pos + dst_offset);
+            return true;
+        }
+
+        image.pixels.resize(dst_offset);
+        const uint8_t* src = data + pos;
+        uint8_t* dst = image.pixels.data();
+        for (uint64_t i = 0; i < dst_offset / 4; i++, src += 3, dst += 4) {
+            dst[0] = src[2];
+            dst[1] = src[1];
+            dst[2] = src[0];
+            dst[3] = 255;
+        }
+
+        return true;
+    }
+}
+
+Container GetContainer(const uint8_t* data, uint64_t size, const std::string &extension) {
+    if (size >= 8 && memcmp(data, png_signature, 8) == 0) {
+        return Container::c_png;
+    }
+    if (size >= 4 && ReadLe32(data) == MakeFourCC('D', 'D', 'S', ' ')) {
+        return Container::c_dds;
+    }
+    if ((size >= 10 && memcmp(data, "#?RADIANCE", 10) == 0) || (size >= 6 && memcmp(data, "#?RGBE", 6) == 0)) {
+        return Container::c_hdr;
+    }
+    if (ToLower(extension) == "tga") {
+        return Container::c_tga;
+    }
+
+    return Container::c_unknown;
+}
+
+bool IsSupported(const std::string &extension) {
+    const std::string ext = ToLower(extension);
+    return ext == "png" || ext == "tga" || ext == "hdr" || ext == "dds";
+}
+
+bool Decode(const uint8_t* data, uint64_t size, const std::string &extension, Image &image) {
+    image = Image();
+    switch (GetContainer(data, size, extension)) {
+        case Container::c_png:
+            return DecodePng(data, size, image);
+        case Container::c_tga:
+            return DecodeTga(data, size, image);
+        case Container::c_hdr:
+            return DecodeHdr(data, size, image);
+        case Container::c_dds:
+            return DecodeDds(data, size, image);
+        default:
+            return false;
+    }
+}
+
+bool DecodeFile(const std::filesystem::path &path, Image &image) {
+    std::shared_ptr<VfsFile> file = VirtualFileSystem::Get().Open(path);
+    if (!file) {
+        image = Image();
+        return false;
+    }
+
+    return Decode(file->GetData(), file->GetSize(), path.extension().u8string(), image);
+}
+
+void InitImage2D(ResourceFormat format, uint32_t width, uint32_t height, Image &image) {
+    image = Image();
+    image.format = format;
+    image.width = width;
+    image.height = height;
+
+    Subresource sub;
+    const bool valid = ComputePitch(format, width, height, sub.row_pitch, sub.slice_pitch);
+    assert(valid);
+    sub.width = width;
+    sub.height = height;
+    image.subresources.push_back(sub);
+    image.pixels.resize(sub.slice_pitch);
+}
+
+uint32_t BitsPerPixel(ResourceFormat format) {
+    switch (format) {
+        case ResourceFormat::rf_r32g32b32a32_float:
+            return 128;
+        case ResourceFormat::rf_r16g16b16a16_float:
+        case ResourceFormat::rf_r16g16b16a16_unorm:
+        case ResourceFormat::rf_r16g16b16a16_snorm:
+        case ResourceFormat::rf_r32g32_float:
+            return 64;
+        case ResourceFormat::rf_r10g10b10a2_unorm:
+        case ResourceFormat::rf_r11g11b10_float:
+        case ResourceFormat::rf_r8g8b8a8_unorm:
+        case ResourceFormat::rf_r8g8b8a8_unorm_srgb:
+        case ResourceFormat::rf_r8g8b8a8_snorm:
+        case ResourceFormat::rf_r16g16_float:
+        case ResourceFormat::rf_r16g16_unorm:
+        case ResourceFormat::rf_r16g16_snorm:
+        case ResourceFormat::rf_r32_float:
+        case ResourceFormat::rf_r9g9b9e5_sharedexp:
+        case ResourceFormat::rf_b8g8r8a8_unorm:
+        case ResourceFormat::rf_b8g8r8x8_unorm:
+        case ResourceFormat::rf_b8g8r8a8_unorm_srgb:
+        case ResourceFormat::rf_b8g8r8x8_unorm_srgb:
+            return 32;
+        case ResourceFormat::rf_r8g8_unorm:
+        case ResourceFormat::rf_r8g8_snorm:
+        case ResourceFormat::rf_r16_float:
+        case ResourceFormat::rf_r16_unorm:
+        case ResourceFormat::rf_r16_snorm:
+        case ResourceFormat::rf_b5g6r5_unorm:
+        case ResourceFormat::rf_b5g5r5a1_unorm:
+        case ResourceFormat::rf_b4g4r4a4_unorm:
+            return 16;
+        case ResourceFormat::rf_r8_unorm:
+        case ResourceFormat::rf_r8_snorm:
+        case ResourceFormat::rf_a8_unorm:
+        case ResourceFormat::rf_bc2_unorm:
+        case ResourceFormat::rf_bc2_unorm_srgb:
+        case ResourceFormat::rf_bc3_unorm:
+        case ResourceFormat::rf_bc3_unorm_srgb:
+        case ResourceFormat::rf_bc5_unorm:
+        case ResourceFormat::rf_bc5_snorm:
+        case ResourceFormat::rf_bc6h_uf16:
+        case ResourceFormat::rf_bc6h_sf16:
+        case ResourceFormat::rf_bc7_unorm:
+        case ResourceFormat::rf_bc7_unorm_srgb:
+            return 8;
+        case ResourceFormat::rf_bc1_unorm:
+        case ResourceFormat::rf_bc1_unorm_srgb:
+        case ResourceFormat::rf_bc4_unorm:
+        case ResourceFormat::rf_bc4_snorm:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+bool IsBlockCompressed(ResourceFormat format) {
+    return (format >= ResourceFormat::rf_bc1_typeless && format <= ResourceFormat::rf_bc5_snorm) ||
+        (format >= ResourceFormat::rf_bc6h_typeless && format <= ResourceFormat::rf_bc7_unorm_srgb);
+}
+
+bool ComputePitch(ResourceFormat format, uint32_t width, uint32_t height, uint64_t &row_pitch, uint64_t &slice_pitch) {
+    const uint32_t bpp = BitsPerPixel(format);
+    if (!bpp) {
+        row_pitch = slice_pitch = 0;
+        return false;
+    }
+
+    if (IsBlockCompressed(format)) {
+        const uint64_t blocks_wide = std::max(1u, (width + 3) / 4);
+        const uint64_t blocks_high = std::max(1u, (height + 3) / 4);
+        row_pitch = blocks_wide * bpp * 2; // 16 texels a block
+        slice_pitch = row_pitch * blocks_high;
+    }
+    else {
+        row_pitch = ((uint64_t)width * bpp + 7) / 8;
+        slice_pitch = row_pitch * height;
+    }
+
+    return true;
+}
+
+ResourceFormat MakeSrgb(ResourceFormat format) {
+    switch (format) {
+        case ResourceFormat::rf_r8g8b8a8_unorm:
+            return ResourceFormat::rf_r8g8b8a8_unorm_srgb;
+        case ResourceFormat::rf_bc1_unorm:
+            return ResourceFormat::rf_bc1_unorm_srgb;
+        case ResourceFormat::rf_bc2_unorm:
+            return ResourceFormat::rf_bc2_unorm_srgb;
+        case ResourceFormat::rf_bc3_unorm:
+            return ResourceFormat::rf_bc3_unorm_srgb;
+        case ResourceFormat::rf_b8g8r8a8_unorm:
+            return ResourceFormat::rf_b8g8r8a8_unorm_srgb;
+        case ResourceFormat::rf_b8g8r8x8_unorm:
+            return ResourceFormat::rf_b8g8r8x8_unorm_srgb;
+        case ResourceFormat::rf_bc7_unorm:
+            return ResourceFormat::rf_bc7_unorm_srgb;
+        default:
+            return format;
+    }
+}
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include "defines.h"
+
+// CPU image decoding shared by the backends: PNG, TGA, HDR and DDS from memory or file, no OS codecs.
+// Decoders are stateless and can run on any number of threads at once.
+namespace image_decoder {
+    enum class Container { c_unknown = 0, c_png, c_tga, c_hdr, c_dds };
+
+    // the d3d12 texture2d limit, bigger images are rejected before anything is allocated for them
+    static constexpr uint32_t max_dimension = 16384;
+    // depth of 3d textures and array slices, cube faces included
+    static constexpr uint32_t max_depth = 2048;
+
+    // one mip of one array slice; 3d mips hold all their depth slices
+    struct Subresource {
+        uint64_t offset{ 0 }; // into Image::pixels
+        uint64_t row_pitch{ 0 };
+        uint64_t slice_pitch{ 0 };
+        uint32_t width{ 0 };
+        uint32_t height{ 0 };
+        uint32_t depth{ 1 };
+    };
+
+    struct Image {
+        ResourceFormat format{ ResourceFormat::rf_unknown };
+        ResourceDesc::ResourcesDimension dimension{ ResourceDesc::ResourcesDimension::rd_texture2d };
+        uint32_t width{ 0 };
+        uint32_t height{ 0 };
+        uint32_t depth{ 1 };
+        uint32_t array_size{ 1 }; // 6 per cube
+        uint32_t mip_levels{ 1 };
+        bool is_cubemap{ false };
+        std::vector<uint8_t> pixels;
+        std::vector<Subresource> subresources; // array slice major, mip minor, same order as d3d12 subresource indices
+
+        uint64_t GetSize() const { return pixels.size(); }
+    };
+
+    // by signature, TGA has none and goes by extension (".tga", "tga" and "TGA" all work)
+    Container GetContainer(const uint8_t* data, uint64_t size, const std::string &extension);
+    bool IsSupported(const std::string &extension);
+
+    // false for anything broken or unsupported, image is left empty then
+    bool Decode(const uint8_t* data, uint64_t size, const std::string &extension, Image &image);
+    bool DecodeFile(const std::filesystem::path &path, Image &image); // through the VirtualFileSystem
+
+    // single mip, single slice image with tightly packed rows
+    void InitImage2D(ResourceFormat format, uint32_t width, uint32_t height, Image &image);
+
+    uint32_t BitsPerPixel(ResourceFormat format); // 0 for formats the decoders never produce
+    bool IsBlockCompressed(ResourceFormat format);
+    bool ComputePitch(ResourceFormat format, uint32_t width, uint32_t height, uint64_t &row_pitch, uint64_t &slice_pitch);
+    ResourceFormat MakeSrgb(ResourceFormat format);
+}
@@ -0,0 +1,167 @@
+#include "Lz4.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace lz4 {
+
+namespace {
+    constexpr uint32_t min_match = 4;
+    constexpr uint32_t last_literals = 5; // the block always ends with that many literals
+    constexpr uint32_t match_limit = 12; // no match starts in the last 12 bytes
+    constexpr uint32_t max_offset = 65535;
+    constexpr uint32_t hash_log = 16;
+
+    uint32_t Read32(const uint8_t* p) {
+        uint32_t val;
+        memcpy(&val, p, sizeof(val));
+        return val;
+    }
+
+    uint32_t Hash(uint32_t seq) {
+        return (seq * 2654435761u) >> (32 - hash_log);
+    }
+
+    uint8_t* WriteLength(uint8_t* op, uint64_t len) {
+        for (; len >= 255; len -= 255) {
+            *op++ = 255;
+        }
+        *op++ = (uint8_t)len;
+
+        return op;
+    }
+
+    uint8_t* WriteSequence(uint8_t* op, const uint8_t* literals, uint64_t literals_num, uint32_t offset, uint64_t match_len) {
+        uint8_t* token = op++;
+        *token = (uint8_t)(std::min<uint64_t>(literals_num, 15) << 4);
+        if (literals_num >= 15) {
+            op = WriteLength(op, literals_num - 15);
+        }
+        memcpy(op, literals, literals_num);
+        op += literals_num;
+
+        if (match_len) {
+            *op++ = (uint8_t)offset;
+            *op++ = (uint8_t)(offset >> 8);
+            const uint64_t len = match_len - min_match;
+            *token |= (uint8_t)std::min<uint64_t>(len, 15);
+            if (len >= 15) {
+                op = WriteLength(op, len - 15);
+            }
+        }
+
+        return op;
+    }
+
+    bool ReadLength(const uint8_t* &ip, const uint8_t* iend, uint64_t &len) {
+        uint8_t b;
+        do {
+            if (ip >= iend) {
+                return false;
+            }
+            b = *ip++;
+            len += b;
+        } while (b == 255);
+
+        return true;
+    }
+}
+
+uint64_t CompressBound(uint64_t size) {
+    return size + size / 255 + 16;
+}
+
+uint64_t Compress(const uint8_t* src, uint64_t size, uint8_t* dst) {
+    uint8_t* op = dst;
+    const uint8_t* anchor = src;
+
+    if (size > match_limit) {
+        std::vector<uint32_t> table(1u << hash_log, 0); // position of the last sequence with that hash
+        const uint8_t* ip = src;
+        const uint8_t* ilimit = src + size - match_limit;
+        const uint8_t* mlimit = src + size - last_literals;
+        uint32_t misses = 0;
+        while (ip < ilimit) {
+            const uint32_t seq = Read32(ip);
+            const uint32_t h = Hash(seq);
+            const uint8_t* ref = src + table[h];
+            table[h] = (uint32_t)(ip - src);
+            if (ref >= ip || ip - ref > max_offset || Read32(ref) != seq) {
+                // incompressible runs are skipped faster and faster
+                ip += 1 + (misses++ >> 6);
+                continue;
+            }
+            misses = 0;
+
+            const uint8_t* mp = ip + min_match;
+            const uint8_t* rp = ref + min_match;
+            while (mp < mlimit && *mp == *rp) {
+                mp++;
+                rp++;
+            }
+            op = WriteSequence(op, anchor, ip - anchor, (uint32_t)(ip - ref), mp - ip);
+            ip = anchor = mp;
+            if (ip < ilimit) {
+                table[Hash(Read32(ip - 2))] = (uint32_t)(ip - 2 - src);
+            }
+        }
+    }
+
+    op = WriteSequence(op, anchor, src + size - anchor, 0, 0);
+
+    return op - dst;
+}
+
+bool Decompress(const uint8_t* src, uint64_t size, uint8_t* dst, uint64_t dst_size) {
+    const uint8_t* ip = src;
+    const uint8_t* iend = src + size;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + dst_size;
+    while (ip < iend) {
+        const uint8_t token = *ip++;
+        uint64_t literals_num = token >> 4;
+        if (literals_num == 15 && !ReadLength(ip, iend, literals_num)) {
+            return false;
+        }
+        if (literals_num > (uint64_t)(iend - ip) || literals_num > (uint64_t)(oend - op)) {
+            return false;
+        }
+        memcpy(op, ip, literals_num);
+        op += literals_num;
+        ip += literals_num;
+        if (ip == iend) {
+            break; // the last sequence has no match
+        }
+
+        if (iend - ip < 2) {
+            return false;
+        }
+        const uint32_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        uint64_t match_len = token & 15;
+        if (match_len == 15 && !ReadLength(ip, iend, match_len)) {
+            return false;
+        }
+        match_len += min_match;
+        if (offset == 0 || offset > (uint64_t)(op - dst) || match_len > (uint64_t)(oend - op)) {
+            return false;
+        }
+
+        const uint8_t* match = op - offset;
+        if (offset >= match_len) {
+            memcpy(op, match, match_len);
+        }
+        else {
+            // overlapping: repeats the last offset bytes
+            for (uint64_t i = 0; i < match_len; i++) {
+                op[i] = match[i];
+            }
+        }
+        op += match_len;
+    }
+
+    return op == oend;
+}
+
+}
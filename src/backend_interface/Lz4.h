@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+// LZ4 block format (no frame), greedy single hash compressor. Output decodes with any LZ4 block decoder.
+namespace lz4 {
+    uint64_t CompressBound(uint64_t size);
+    // dst holds CompressBound(size) bytes; returns the compressed size
+    uint64_t Compress(const uint8_t* src, uint64_t size, uint8_t* dst);
+    // false for a corrupt block or one that does not decode to exactly dst_size bytes
+    bool Decompress(const uint8_t* src, uint64_t size, uint8_t* dst, uint64_t dst_size);
+}
@@ -0,0 +1,128 @@
+#include "MappedFile.h"
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // WIN32
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+#ifdef WIN32
+bool MappedFile::Open(const std::filesystem::path& path)
+{
+    Close();
+
+    // delete sharing lets a re-cook rename over a file that is still mapped
+    HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_data = (const uint8_t*)data;
+    m_size = (uint64_t)size.QuadPart;
+
+    return true;
+}
+
+void MappedFile::Prefetch() const
+{
+    if (m_data) {
+        WIN32_MEMORY_RANGE_ENTRY range{ (void*)m_data, (size_t)m_size };
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+}
+
+void MappedFile::Close()
+{
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping) {
+        CloseHandle((HANDLE)m_mapping);
+    }
+    if (m_file) {
+        CloseHandle((HANDLE)m_file);
+    }
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_file = nullptr;
+    m_size = 0;
+}
+#else
+bool MappedFile::Open(const std::filesystem::path& path)
+{
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+
+    m_fd = fd;
+    m_data = (const uint8_t*)data;
+    m_size = (uint64_t)st.st_size;
+
+    return true;
+}
+
+void MappedFile::Prefetch() const
+{
+    if (m_data) {
+        madvise((void*)m_data, (size_t)m_size, MADV_WILLNEED);
+    }
+}
+
+void MappedFile::Close()
+{
+    if (m_data) {
+        munmap((void*)m_data, (size_t)m_size);
+    }
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+    m_data = nullptr;
+    m_fd = -1;
+    m_size = 0;
+}
+#endif // WIN32
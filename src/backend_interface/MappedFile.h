@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+// read-only memory mapping of a whole file
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    bool Open(const std::filesystem::path& path);
+    void Close();
+    // asks the OS to read the whole file ahead, in the background and in file order
+    void Prefetch() const;
+
+    const uint8_t* GetData() const { return m_data; }
+    uint64_t GetSize() const { return m_size; }
+    bool IsOpen() const { return m_data != nullptr; }
+
+private:
+    const uint8_t* m_data{ nullptr };
+    uint64_t m_size{ 0 };
+#ifdef WIN32
+    void* m_file{ nullptr };
+    void* m_mapping{ nullptr };
+#else
+    int m_fd{ -1 };
+#endif // WIN32
+};
@@ -0,0 +1,235 @@
+#include "StartupProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+
+namespace {
+    // open scopes of this thread, innermost last
+    struct ThreadStack {
+        uint64_t generation{ 0 };
+        std::vector<uint32_t> scopes;
+    };
+    thread_local ThreadStack thread_stack;
+
+    std::string Escape(const std::string& str) {
+        std::string res;
+        res.reserve(str.size());
+        for (char c : str) {
+            if (c == '"' || c == '\\') {
+                res += '\\';
+                res += c;
+            }
+            else if ((unsigned char)c < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                res += buf;
+            }
+            else {
+                res += c;
+            }
+        }
+        return res;
+    }
+
+    struct PhaseTotal {
+        uint32_t count{ 0 };
+        double total_ms{ 0.0 };
+        double self_ms{ 0.0 };
+    };
+}
+
+StartupProfiler& StartupProfiler::Get() {
+    static StartupProfiler profiler;
+    return profiler;
+}
+
+void StartupProfiler::Start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_scopes.clear();
+    m_open.clear();
+    m_threads.clear();
+    m_threads.emplace(std::this_thread::get_id(), 0);
+    m_generation++;
+    m_total_ms = 0.0;
+    m_origin = clock::now();
+    m_recording = true;
+}
+
+void StartupProfiler::Finish() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_recording) {
+        return;
+    }
+
+    m_total_ms = std::chrono::duration<double, std::milli>(clock::now() - m_origin).count();
+    for (uint32_t i = 0; i < m_scopes.size(); i++) {
+        if (m_open[i]) {
+            m_scopes[i].duration_ms = m_total_ms - m_scopes[i].start_ms;
+            m_open[i] = false;
+        }
+    }
+    m_recording = false;
+}
+
+uint32_t StartupProfiler::Begin(const char* name, const std::wstring* asset) {
+    if (!m_recording) {
+        return no_scope;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_recording) {
+        return no_scope;
+    }
+    if (thread_stack.generation != m_generation) {
+        thread_stack.generation = m_generation;
+        thread_stack.scopes.clear();
+    }
+
+    Scope scope;
+    scope.name = name;
+    if (asset) {
+        scope.asset = std::filesystem::path(*asset).u8string();
+    }
+    scope.thread = m_threads.emplace(std::this_thread::get_id(), (uint32_t)m_threads.size()).first->second;
+    scope.depth = (uint32_t)thread_stack.scopes.size();
+    scope.parent = thread_stack.scopes.empty() ? no_scope : thread_stack.scopes.back();
+    scope.start_ms = std::chrono::duration<double, std::milli>(clock::now() - m_origin).count();
+
+    const uint32_t id = (uint32_t)m_scopes.size();
+    m_scopes.push_back(std::move(scope));
+    m_open.push_back(true);
+    thread_stack.scopes.push_back(id);
+    return id;
+}
+
+void StartupProfiler::End(uint32_t scope) {
+    if (scope == no_scope) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (thread_stack.generation != m_generation) {
+        return;
+    }
+    if (!thread_stack.scopes.empty() && thread_stack.scopes.back() == scope) {
+        thread_stack.scopes.pop_back();
+    }
+    // Finish already closed it
+    if (scope < m_open.size() && m_open[scope]) {
+        m_scopes[scope].duration_ms = std::chrono::duration<double, std::milli>(clock::now() - m_origin).count() - m_scopes[scope].start_ms;
+        m_open[scope] = false;
+    }
+}
+
+std::vector<StartupProfiler::Scope> StartupProfiler::GetScopes() const {
+    std::vector<Scope> scopes;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        scopes = m_scopes;
+    }
+
+    for (Scope& scope : scopes) {
+        scope.self_ms = scope.duration_ms;
+    }
+    for (const Scope& scope : scopes) {
+        if (scope.parent != no_scope) {
+            scopes[scope.parent].self_ms -= scope.duration_ms;
+        }
+    }
+    return scopes;
+}
+
+bool StartupProfiler::WriteJson(const std::filesystem::path& path) const {
+    const std::vector<Scope> scopes = GetScopes();
+    std::map<std::string, PhaseTotal> phases;
+    uint32_t threads_num = 0;
+    for (const Scope& scope : scopes) {
+        PhaseTotal& phase = phases[scope.name];
+        phase.count++;
+        phase.total_ms += scope.duration_ms;
+        phase.self_ms += scope.self_ms;
+        threads_num = std::max(threads_num, scope.thread + 1);
+    }
+    std::vector<std::pair<std::string, PhaseTotal>> sorted(phases.begin(), phases.end());
+    std::stable_sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second.self_ms > b.second.self_ms; });
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+
+    char buf[512];
+    snprintf(buf, sizeof(buf), "{\n  \"total_ms\": %.3f,\n  \"threads_num\": %u,\n  \"phases\": [\n", m_total_ms, threads_num);
+    file << buf;
+    for (uint32_t i = 0; i < sorted.size(); i++) {
+        snprintf(buf, sizeof(buf), "    { \"name\": \"%s\", \"count\": %u, \"total_ms\": %.3f, \"self_ms\": %.3f }%s\n",
+            Escape(sorted[i].first).c_str(), sorted[i].second.count, sorted[i].second.total_ms, sorted[i].second.self_ms, (i + 1 < sorted.size()) ? "," : "");
+        file << buf;
+    }
+    file << "  ],\n  \"scopes\": [\n";
+    for (uint32_t i = 0; i < scopes.size(); i++) {
+        const Scope& scope = scopes[i];
+        file << "    { \"name\": \"" << Escape(scope.name) << "\", \"asset\": \"" << Escape(scope.asset) << "\"";
+        snprintf(buf, sizeof(buf), ", \"thread\": %u, \"depth\": %u, \"parent\": %d, \"start_ms\": %.3f, \"duration_ms\": %.3f, \"self_ms\": %.3f }%s\n",
+            scope.thread, scope.depth, (scope.parent == no_scope) ? -1 : (int32_t)scope.parent, scope.start_ms, scope.duration_ms, scope.self_ms, (i + 1 < scopes.size()) ? "," : "");
+        file << buf;
+    }
+    file << "  ]\n}\n";
+    return (bool)file;
+}
+
+bool StartupProfiler::WriteCsv(const std::filesystem::path& path) const {
+    const std::vector<Scope> scopes = GetScopes();
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+
+    file << "name,asset,thread,depth,parent,start_ms,duration_ms,self_ms\n";
+    char buf[128];
+    for (const Scope& scope : scopes) {
+        // quoted, quotes doubled
+        std::string asset;
+        for (char c : scope.asset) {
+            asset += c;
+            if (c == '"') {
+                asset += c;
+            }
+        }
+        snprintf(buf, sizeof(buf), ",%u,%u,%d,%.3f,%.3f,%.3f\n",
+            scope.thread, scope.depth, (scope.parent == no_scope) ? -1 : (int32_t)scope.parent, scope.start_ms, scope.duration_ms, scope.self_ms);
+        file << scope.name << ",\"" << asset << "\"" << buf;
+    }
+    return (bool)file;
+}
+
+bool StartupProfiler::WriteChromeTrace(const std::filesystem::path& path) const {
+    const std::vector<Scope> scopes = GetScopes();
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+
+    uint32_t threads_num = 1;
+    for (const Scope& scope : scopes) {
+        threads_num = std::max(threads_num, scope.thread + 1);
+    }
+
+    char buf[256];
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for (uint32_t thread = 0; thread < threads_num; thread++) {
+        snprintf(buf, sizeof(buf), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}},\n", thread, thread ? "worker" : "main", thread);
+        file << buf;
+    }
+    // complete events, microseconds
+    for (uint32_t i = 0; i < scopes.size(); i++) {
+        const Scope& scope = scopes[i];
+        file << "{\"name\":\"" << Escape(scope.name) << "\",\"cat\":\"startup\",\"ph\":\"X\"";
+        snprintf(buf, sizeof(buf), ",\"ts\":%.1f,\"dur\":%.1f,\"pid\":1,\"tid\":%u,\"args\":{\"asset\":\"", scope.start_ms * 1000.0, scope.duration_ms * 1000.0, scope.thread);
+        file << buf << Escape(scope.asset) << "\"}}" << ((i + 1 < scopes.size()) ? ",\n" : "\n");
+    }
+    file << "]}\n";
+    return (bool)file;
+}
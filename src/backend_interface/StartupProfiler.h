@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <unordered_map>
+#include <filesystem>
+
+// Wall clock timers for startup: init phases and the assets they load, nested per thread.
+// Scopes only record between Start and Finish, the same code paths running later (hot reload, streaming) cost an
+// atomic load: the asset name is only converted while recording. Thread safe; the report comes out once startup is over.
+class StartupProfiler {
+public:
+    static constexpr uint32_t no_scope = uint32_t(-1);
+
+    struct Scope {
+        std::string name;
+        std::string asset;          // utf-8, empty for phases
+        uint32_t thread{ 0 };       // 0 is the thread that called Start, workers in order of their first scope
+        uint32_t depth{ 0 };        // on its thread
+        uint32_t parent{ no_scope };
+        double start_ms{ 0.0 };     // since Start
+        double duration_ms{ 0.0 };
+        double self_ms{ 0.0 };      // minus the children on the same thread
+    };
+
+    static StartupProfiler& Get();
+
+    void Start();
+    // total is taken here, scopes still open are closed at it
+    void Finish();
+    bool IsRecording() const { return m_recording; }
+    double GetTotalMs() const { return m_total_ms; }
+
+    // no_scope when not recording; asset is null for phases
+    uint32_t Begin(const char* name, const std::wstring* asset);
+    void End(uint32_t scope);
+
+    // finished scopes in start order, self times filled in
+    std::vector<Scope> GetScopes() const;
+
+    // flat report of every scope plus totals per phase name
+    bool WriteJson(const std::filesystem::path& path) const;
+    bool WriteCsv(const std::filesystem::path& path) const;
+    // chrome://tracing and Perfetto
+    bool WriteChromeTrace(const std::filesystem::path& path) const;
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    clock::time_point m_origin;
+    std::atomic<bool> m_recording{ false };
+    double m_total_ms{ 0.0 };
+    uint64_t m_generation{ 0 };     // Start drops the stacks of an earlier run
+
+    mutable std::mutex m_mutex;
+    std::vector<Scope> m_scopes;
+    std::vector<bool> m_open;
+    std::unordered_map<std::thread::id, uint32_t> m_threads;
+};
+
+// times its block when the profiler is recording
+class StartupScope {
+public:
+    explicit StartupScope(const char* name) : m_scope(StartupProfiler::Get().Begin(name, nullptr)) {}
+    StartupScope(const char* name, const std::wstring& asset) : m_scope(StartupProfiler::Get().Begin(name, &asset)) {}
+    ~StartupScope() { StartupProfiler::Get().End(m_scope); }
+    StartupScope(const StartupScope&) = delete;
+    StartupScope& operator=(const StartupScope&) = delete;
+
+private:
+    uint32_t m_scope;
+};
@@ -0,0 +1,1337 @@
+#include "TextureCooker.h"
+#include "VirtualFileSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <cwctype>
+#include <fstream>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTURE_COOKER_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace texture_cooker {
+
+namespace {
+    using image_decoder::Image;
+    using image_decoder::Subresource;
+
+    constexpr uint32_t dds_magic = 0x20534444; // "DDS "
+    constexpr uint32_t stamp_magic = 0x4b4f4f43; // "COOK", first of the header reserved words
+
+    int64_t GetSourceTime(const std::filesystem::path &path) {
+        std::error_code ec;
+        return (int64_t)std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    }
+
+    uint8_t ToUnorm8(float val) {
+        return (uint8_t)(std::min(std::max(val, 0.f), 1.f) * 255.f + 0.5f);
+    }
+
+    float SrgbToLinear(float val) {
+        return (val <= 0.04045f) ? val / 12.92f : std::pow((val + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float LinearToSrgb(float val) {
+        return (val <= 0.0031308f) ? val * 12.92f : 1.055f * std::pow(val, 1.f / 2.4f) - 0.055f;
+    }
+
+    float HalfToFloat(uint16_t val) {
+        const uint32_t sign = (uint32_t)(val & 0x8000) << 16;
+        const uint32_t exponent = (val >> 10) & 0x1f;
+        const uint32_t mantissa = val & 0x3ff;
+        if (exponent == 0) {
+            const float res = std::ldexp((float)mantissa, -24);
+            return sign ? -res : res;
+        }
+
+        uint32_t bits = sign | ((exponent == 31) ? (0xff << 23) : ((exponent + 112) << 23)) | (mantissa << 13);
+        float res;
+        memcpy(&res, &bits, sizeof(res));
+        return res;
+    }
+
+    bool IsSingleChannel(ResourceFormat format) {
+        return format == ResourceFormat::rf_r8_unorm || format == ResourceFormat::rf_r16_unorm || format == ResourceFormat::rf_r32_float;
+    }
+
+    bool IsFloat(ResourceFormat format) {
+        return format == ResourceFormat::rf_r32g32b32a32_float || format == ResourceFormat::rf_r16g16b16a16_float || format == ResourceFormat::rf_r32_float;
+    }
+
+    // top mip to float rgba, single channel formats are replicated into rgb
+    bool LoadTexels(const Image &image, std::vector<float> &texels) {
+        const Subresource &sub = image.subresources[0];
+        texels.resize((size_t)sub.width * sub.height * 4);
+        for (uint32_t y = 0; y < sub.height; y++) {
+            const uint8_t* row = image.pixels.data() + sub.offset + y * sub.row_pitch;
+            float* dst = texels.data() + (size_t)y * sub.width * 4;
+            for (uint32_t x = 0; x < sub.width; x++, dst += 4) {
+                float rgba[4] = { 0.f, 0.f, 0.f, 1.f };
+                switch (image.format) {
+                    case ResourceFormat::rf_r8_unorm:
+                        rgba[0] = rgba[1] = rgba[2] = row[x] / 255.f;
+                        break;
+                    case ResourceFormat::rf_r16_unorm:
+                        rgba[0] = rgba[1] = rgba[2] = ((const uint16_t*)row)[x] / 65535.f;
+                        break;
+                    case ResourceFormat::rf_r32_float:
+                        rgba[0] = rgba[1] = rgba[2] = ((const float*)row)[x];
+                        break;
+                    case ResourceFormat::rf_r8g8_unorm:
+                        rgba[0] = row[x * 2] / 255.f;
+                        rgba[1] = row[x * 2 + 1] / 255.f;
+                        break;
+                    case ResourceFormat::rf_r8g8b8a8_unorm:
+                    case ResourceFormat::rf_r8g8b8a8_unorm_srgb:
+                        for (uint32_t c = 0; c < 4; c++) {
+                            rgba[c] = row[x * 4 + c] / 255.f;
+                        }
+                        break;
+                    case ResourceFormat::rf_b8g8r8a8_unorm:
+                    case ResourceFormat::rf_b8g8r8a8_unorm_srgb:
+                    case ResourceFormat::rf_b8g8r8x8_unorm:
+                    case ResourceFormat::rf_b8g8r8x8_unorm_srgb:
+                        rgba[0] = row[x * 4 + 2] / 255.f;
+                        rgba[1] = row[x * 4 + 1] / 255.f;
+                        rgba[2] = row[x * 4] / 255.f;
+                        if (image.format == ResourceFormat::rf_b8g8r8a8_unorm || image.format == ResourceFormat::rf_b8g8r8a8_unorm_srgb) {
+                            rgba[3] = row[x * 4 + 3] / 255.f;
+                        }
+                        break;
+                    case ResourceFormat::rf_r16g16b16a16_unorm:
+                        for (uint32_t c = 0; c < 4; c++) {
+                            rgba[c] = ((const uint16_t*)row)[x * 4 + c] / 65535.f;
+                        }
+                        break;
+                    case ResourceFormat::rf_r16g16b16a16_float:
+                        for (uint32_t c = 0; c < 4; c++) {
+                            rgba[c] = HalfToFloat(((const uint16_t*)row)[x * 4 + c]);
+                        }
+                        break;
+                    case ResourceFormat::rf_r32g32b32a32_float:
+                        memcpy(rgba, row + x * 16, sizeof(rgba));
+                        break;
+                    default:
+                        return false;
+                }
+                memcpy(dst, rgba, sizeof(rgba));
+            }
+        }
+
+        return true;
+    }
+
+    // Mips
+
+    // weights of one destination texel over the source line, indices are clamped to the edge already
+    struct FilterTaps {
+        std::vector<uint32_t> offsets; // per destination texel into indices/weights, one past the end at the back
+        std::vector<uint32_t> indices;
+        std::vector<float> weights;
+    };
+
+    float BesselI0(float x) {
+        float sum = 1.f;
+        float term = 1.f;
+        for (uint32_t k = 1; k < 32 && term > sum * 1e-8f; k++) {
+            const float half = x / (2.f * k);
+            term *= half * half;
+            sum += term;
+        }
+        return sum;
+    }
+
+    // kaiser windowed sinc, width 3 and alpha 4 in destination texels
+    float Kaiser(float x) {
+        static constexpr float width = 3.f;
+        static constexpr float alpha = 4.f;
+        const float t = x / width;
+        if (std::abs(t) >= 1.f) {
+            return 0.f;
+        }
+        const float pi_x = 3.14159265f * x;
+        const float sinc = (std::abs(pi_x) < 1e-6f) ? 1.f : std::sin(pi_x) / pi_x;
+        return sinc * BesselI0(alpha * std::sqrt(1.f - t * t)) / BesselI0(alpha);
+    }
+
+    void BuildTaps(uint32_t src_size, uint32_t dst_size, Filter filter, FilterTaps &taps) {
+        const float scale = (float)src_size / dst_size;
+        taps.offsets.assign(1, 0);
+        taps.indices.clear();
+        taps.weights.clear();
+        for (uint32_t dst = 0; dst < dst_size; dst++) {
+            const uint32_t first = (uint32_t)taps.weights.size();
+            if (filter == Filter::f_box) {
+                // exact footprint, odd sizes get fractional edge texels
+                const float lo = dst * scale;
+                const float hi = lo + scale;
+                for (int32_t src = (int32_t)std::floor(lo); (float)src < hi; src++) {
+                    const float weight = std::min((float)src + 1.f, hi) - std::max((float)src, lo);
+                    if (weight > 1e-6f) {
+                        taps.indices.push_back((uint32_t)std::min(src, (int32_t)src_size - 1));
+                        taps.weights.push_back(weight);
+                    }
+                }
+            }
+            else {
+                const float center = (dst + 0.5f) * scale;
+                const float radius = 3.f * scale;
+                for (int32_t src = (int32_t)std::floor(center - radius); (float)src <= center + radius; src++) {
+                    const float weight = Kaiser(((float)src + 0.5f - center) / scale);
+                    if (weight != 0.f) {
+                        taps.indices.push_back((uint32_t)std::min(std::max(src, 0), (int32_t)src_size - 1));
+                        taps.weights.push_back(weight);
+                    }
+                }
+            }
+
+            float sum = 0.f;
+            for (uint32_t i = first; i < taps.weights.size(); i++) {
+                sum += taps.weights[i];
+            }
+            for (uint32_t i = first; i < taps.weights.size(); i++) {
+                taps.weights[i] /= sum;
+            }
+            taps.offsets.push_back((uint32_t)taps.weights.size());
+        }
+    }
+
+    // one rgba float texel
+    inline void Accumulate(float* dst, const float* src, float weight) {
+#if TEXTURE_COOKER_SSE
+        _mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), _mm_mul_ps(_mm_loadu_ps(src), _mm_set1_ps(weight))));
+#else
+        for (uint32_t c = 0; c < 4; c++) {
+            dst[c] += src[c] * weight;
+        }
+#endif
+    }
+
+    // separable, horizontal pass into tmp then vertical into dst
+    void Downsample(const std::vector<float> &src, uint32_t src_w, uint32_t src_h, Filter filter, std::vector<float> &dst, uint32_t dst_w, uint32_t dst_h) {
+        FilterTaps h_taps;
+        FilterTaps v_taps;
+        BuildTaps(src_w, dst_w, filter, h_taps);
+        BuildTaps(src_h, dst_h, filter, v_taps);
+
+        std::vector<float> tmp((size_t)dst_w * src_h * 4, 0.f);
+        for (uint32_t y = 0; y < src_h; y++) {
+            const float* src_row = src.data() + (size_t)y * src_w * 4;
+            float* tmp_row = tmp.data() + (size_t)y * dst_w * 4;
+            for (uint32_t x = 0; x < dst_w; x++) {
+                for (uint32_t tap = h_taps.offsets[x]; tap < h_taps.offsets[x + 1]; tap++) {
+                    Accumulate(tmp_row + x * 4, src_row + h_taps.indices[tap] * 4, h_taps.weights[tap]);
+                }
+            }
+        }
+
+        dst.assign((size_t)dst_w * dst_h * 4, 0.f);
+        for (uint32_t y = 0; y < dst_h; y++) {
+            float* dst_row = dst.data() + (size_t)y * dst_w * 4;
+            for (uint32_t tap = v_taps.offsets[y]; tap < v_taps.offsets[y + 1]; tap++) {
+                const float* tmp_row = tmp.data() + (size_t)v_taps.indices[tap] * dst_w * 4;
+                for (uint32_t x = 0; x < dst_w; x++) {
+                    Accumulate(dst_row + x * 4, tmp_row + x * 4, v_taps.weights[tap]);
+                }
+            }
+        }
+    }
+
+    void FixupTexels(std::vector<float> &texels, Role role, bool is_float) {
+        for (size_t i = 0; i < texels.size(); i += 4) {
+            float* texel = &texels[i];
+            if (role == Role::tr_normal) {
+                float n[3] = { texel[0] * 2.f - 1.f, texel[1] * 2.f - 1.f, texel[2] * 2.f - 1.f };
+                const float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                if (len > 1e-6f) {
+                    for (uint32_t c = 0; c < 3; c++) {
+                        texel[c] = n[c] / len * 0.5f + 0.5f;
+                    }
+                }
+            }
+
+            // kaiser rings a bit around edges
+            for (uint32_t c = 0; c < 4; c++) {
+                texel[c] = is_float ? std::max(texel[c], 0.f) : std::min(std::max(texel[c], 0.f), 1.f);
+            }
+        }
+    }
+
+    // BC
+
+    struct BitWriter {
+        uint8_t* data;
+        uint32_t pos{ 0 };
+
+        void Write(uint32_t val, uint32_t bits) {
+            for (uint32_t i = 0; i < bits; i++, pos++) {
+                data[pos >> 3] |= (uint8_t)(((val >> i) & 1) << (pos & 7));
+            }
+        }
+    };
+
+    struct BitReader {
+        const uint8_t* data;
+        uint32_t pos{ 0 };
+
+        uint32_t Read(uint32_t bits) {
+            uint32_t val = 0;
+            for (uint32_t i = 0; i < bits; i++, pos++) {
+                val |= (uint32_t)((data[pos >> 3] >> (pos & 7)) & 1) << i;
+            }
+            return val;
+        }
+    };
+
+    // principal axis of the texels through their mean, line end points are where the texels project the furthest
+    template<uint32_t channels>
+    void FitLine(const float texels[16][4], float ep0[4], float ep1[4]) {
+        float mean[channels] = {};
+        for (uint32_t i = 0; i < 16; i++) {
+            for (uint32_t c = 0; c < channels; c++) {
+                mean[c] += texels[i][c] / 16.f;
+            }
+        }
+
+        float cov[channels][channels] = {};
+        float lo[channels];
+        float hi[channels];
+        for (uint32_t c = 0; c < channels; c++) {
+            lo[c] = hi[c] = texels[0][c];
+        }
+        for (uint32_t i = 0; i < 16; i++) {
+            for (uint32_t a = 0; a < channels; a++) {
+                lo[a] = std::min(lo[a], texels[i][a]);
+                hi[a] = std::max(hi[a], texels[i][a]);
+                for (uint32_t b = 0; b < channels; b++) {
+                    cov[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+                }
+            }
+        }
+
+        float axis[channels];
+        for (uint32_t c = 0; c < channels; c++) {
+            axis[c] = hi[c] - lo[c];
+        }
+        for (uint32_t iter = 0; iter < 8; iter++) {
+            float next[channels] = {};
+            float len = 0.f;
+            for (uint32_t a = 0; a < channels; a++) {
+                for (uint32_t b = 0; b < channels; b++) {
+                    next[a] += cov[a][b] * axis[b];
+                }
+                len = std::max(len, std::abs(next[a]));
+            }
+            if (len < 1e-6f) {
+                break;
+            }
+            for (uint32_t c = 0; c < channels; c++) {
+                axis[c] = next[c] / len;
+            }
+        }
+
+        float axis_len = 0.f;
+        for (uint32_t c = 0; c < channels; c++) {
+            axis_len += axis[c] * axis[c];
+        }
+        float t_min = 0.f;
+        float t_max = 0.f;
+        if (axis_len > 1e-12f) {
+            for (uint32_t i = 0; i < 16; i++) {
+                float t = 0.f;
+                for (uint32_t c = 0; c < channels; c++) {
+                    t += (texels[i][c] - mean[c]) * axis[c];
+                }
+                t /= axis_len;
+                t_min = std::min(t_min, t);
+                t_max = std::max(t_max, t);
+            }
+        }
+
+        for (uint32_t c = 0; c < channels; c++) {
+            ep0[c] = std::min(std::max(mean[c] + axis[c] * t_min, 0.f), 255.f);
+            ep1[c] = std::min(std::max(mean[c] + axis[c] * t_max, 0.f), 255.f);
+        }
+    }
+
+    // end points minimizing the error for fixed indices, weights[i] is how much of ep1 texel i takes; false when degenerate
+    template<uint32_t channels>
+    bool SolveEndpoints(const float texels[16][4], const float weights[16], float ep0[4], float ep1[4]) {
+        float aa = 0.f, ab = 0.f, bb = 0.f;
+        float ax[channels] = {};
+        float bx[channels] = {};
+        for (uint32_t i = 0; i < 16; i++) {
+            const float b = weights[i];
+            const float a = 1.f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (uint32_t c = 0; c < channels; c++) {
+                ax[c] += a * texels[i][c];
+                bx[c] += b * texels[i][c];
+            }
+        }
+
+        const float det = aa * bb - ab * ab;
+        if (std::abs(det) < 1e-6f) {
+            return false;
+        }
+        for (uint32_t c = 0; c < channels; c++) {
+            ep0[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) / det, 0.f), 255.f);
+            ep1[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) / det, 0.f), 255.f);
+        }
+        return true;
+    }
+
+    uint16_t To565(const float color[4]) {
+        const uint32_t r = (uint32_t)std::min(std::max(std::round(color[0] * 31.f / 255.f), 0.f), 31.f);
+        const uint32_t g = (uint32_t)std::min(std::max(std::round(color[1] * 63.f / 255.f), 0.f), 63.f);
+        const uint32_t b = (uint32_t)std::min(std::max(std::round(color[2] * 31.f / 255.f), 0.f), 31.f);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    void From565(uint16_t val, int32_t color[3]) {
+        const int32_t r = val >> 11;
+        const int32_t g = (val >> 5) & 0x3f;
+        const int32_t b = val & 0x1f;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    // four color mode, index 2 and 3 at a third and two thirds towards c1
+    void ColorPalette(uint16_t c0, uint16_t c1, int32_t palette[4][3]) {
+        From565(c0, palette[0]);
+        From565(c1, palette[1]);
+        for (uint32_t c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+        }
+    }
+
+    uint32_t ColorIndices(const float texels[16][4], const int32_t palette[4][3], uint8_t indices[16]) {
+        uint32_t error = 0;
+        for (uint32_t i = 0; i < 16; i++) {
+            uint32_t best = std::numeric_limits<uint32_t>::max();
+            for (uint8_t p = 0; p < 4; p++) {
+                uint32_t dist = 0;
+                for (uint32_t c = 0; c < 3; c++) {
+                    const int32_t d = (int32_t)texels[i][c] - palette[p][c];
+                    dist += d * d;
+                }
+                if (dist < best) {
+                    best = dist;
+                    indices[i] = p;
+                }
+            }
+            error += best;
+        }
+        return error;
+    }
+
+    // BC1 in four color mode, the color half of BC3 too
+    void EncodeColorBlock(const uint8_t texels[64], uint8_t* block) {
+        float colors[16][4];
+        for (uint32_t i = 0; i < 16; i++) {
+            for (uint32_t c = 0; c < 4; c++) {
+                colors[i][c] = texels[i * 4 + c];
+            }
+        }
+
+        float ep0[4];
+        float ep1[4];
+        FitLine<3>(colors, ep0, ep1);
+
+        static constexpr float index_weights[4] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+        uint32_t best_error = std::numeric_limits<uint32_t>::max();
+        uint16_t best_c0 = 0;
+        uint16_t best_c1 = 0;
+        uint8_t best_indices[16] = {};
+        for (uint32_t iter = 0; iter < 3; iter++) {
+            const uint16_t c0 = To565(ep0);
+            const uint16_t c1 = To565(ep1);
+            int32_t palette[4][3];
+            ColorPalette(c0, c1, palette);
+            uint8_t indices[16];
+            const uint32_t error = ColorIndices(colors, palette, indices);
+            if (error < best_error) {
+                best_error = error;
+                best_c0 = c0;
+                best_c1 = c1;
+                memcpy(best_indices, indices, sizeof(indices));
+            }
+
+            float weights[16];
+            for (uint32_t i = 0; i < 16; i++) {
+                weights[i] = index_weights[indices[i]];
+            }
+            if (best_error == 0 || !SolveEndpoints<3>(colors, weights, ep0, ep1)) {
+                break;
+            }
+        }
+
+        // c0 > c1 selects four colors on BC1, BC3 ignores the order
+        if (best_c0 < best_c1) {
+            std::swap(best_c0, best_c1);
+            for (uint8_t &index : best_indices) {
+                index ^= 1;
+            }
+        }
+        else if (best_c0 == best_c1) {
+            memset(best_indices, 0, sizeof(best_indices));
+        }
+
+        uint32_t bits = 0;
+        for (uint32_t i = 0; i < 16; i++) {
+            bits |= (uint32_t)best_indices[i] << (i * 2);
+        }
+        memcpy(block, &best_c0, 2);
+        memcpy(block + 2, &best_c1, 2);
+        memcpy(block + 4, &bits, 4);
+    }
+
+    void DecodeColorBlock(const uint8_t* block, bool four_colors, uint8_t texels[64]) {
+        uint16_t c0;
+        uint16_t c1;
+        uint32_t bits;
+        memcpy(&c0, block, 2);
+        memcpy(&c1, block + 2, 2);
+        memcpy(&bits, block + 4, 4);
+
+        int32_t palette[4][3];
+        ColorPalette(c0, c1, palette);
+        uint8_t alpha[4] = { 255, 255, 255, 255 };
+        if (!four_colors && c0 <= c1) {
+            for (uint32_t c = 0; c < 3; c++) {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+            alpha[3] = 0;
+        }
+
+        for (uint32_t i = 0; i < 16; i++) {
+            const uint32_t index = (bits >> (i * 2)) & 3;
+            for (uint32_t c = 0; c < 3; c++) {
+                texels[i * 4 + c] = (uint8_t)palette[index][c];
+            }
+            texels[i * 4 + 3] = alpha[index];
+        }
+    }
+
+    // index 0 and 1 are the end points, r0 > r1 interpolates six values, otherwise four plus 0 and 255
+    void AlphaPalette(uint8_t r0, uint8_t r1, int32_t palette[8]) {
+        palette[0] = r0;
+        palette[1] = r1;
+        if (r0 > r1) {
+            for (int32_t i = 1; i < 7; i++) {
+                palette[i + 1] = ((7 - i) * r0 + i * r1 + 3) / 7;
+            }
+        }
+        else {
+            for (int32_t i = 1; i < 5; i++) {
+                palette[i + 1] = ((5 - i) * r0 + i * r1 + 2) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    uint32_t AlphaIndices(const uint8_t values[16], uint8_t r0, uint8_t r1, uint8_t indices[16]) {
+        int32_t palette[8];
+        AlphaPalette(r0, r1, palette);
+        uint32_t error = 0;
+        for (uint32_t i = 0; i < 16; i++) {
+            uint32_t best = std::numeric_limits<uint32_t>::max();
+            for (uint8_t p = 0; p < 8; p++) {
+                const int32_t d = (int32_t)values[i] - palette[p];
+                if ((uint32_t)(d * d) < best) {
+                    best = d * d;
+                    indices[i] = p;
+                }
+            }
+            error += best;
+        }
+        return error;
+    }
+
+    // BC4 block, the alpha half of BC3 and both halves of BC5
+    void EncodeAlphaBlock(const uint8_t values[16], uint8_t* block) {
+        uint8_t lo = 255, hi = 0;
+        uint8_t inner_lo = 255, inner_hi = 0;
+        for (uint32_t i = 0; i < 16; i++) {
+            lo = std::min(lo, values[i]);
+            hi = std::max(hi, values[i]);
+            if (values[i] != 0 && values[i] != 255) {
+                inner_lo = std::min(inner_lo, values[i]);
+                inner_hi = std::max(inner_hi, values[i]);
+            }
+        }
+
+        // six interpolated values over the range first, refined once
+        uint8_t best_r0 = hi;
+        uint8_t best_r1 = lo;
+        uint8_t best_indices[16];
+        uint32_t best_error = AlphaIndices(values, hi, lo, best_indices);
+        if (hi > lo && best_error) {
+            static constexpr float index_weights[8] = { 0.f, 1.f, 1.f / 7.f, 2.f / 7.f, 3.f / 7.f, 4.f / 7.f, 5.f / 7.f, 6.f / 7.f };
+            float texels[16][4] = {};
+            float weights[16];
+            for (uint32_t i = 0; i < 16; i++) {
+                texels[i][0] = values[i];
+                weights[i] = index_weights[best_indices[i]];
+            }
+            float ep0[4];
+            float ep1[4];
+            if (SolveEndpoints<1>(texels, weights, ep0, ep1)) {
+                const uint8_t r0 = (uint8_t)std::round(ep0[0]);
+                const uint8_t r1 = (uint8_t)std::round(ep1[0]);
+                uint8_t indices[16];
+                const uint32_t error = (r0 > r1) ? AlphaIndices(values, r0, r1, indices) : best_error;
+                if (error < best_error) {
+                    best_error = error;
+                    best_r0 = r0;
+                    best_r1 = r1;
+                    memcpy(best_indices, indices, sizeof(indices));
+                }
+            }
+        }
+
+        // four interpolated values plus exact 0 and 255, wins on blocks with a few extremes
+        if (best_error && inner_lo <= inner_hi) {
+            uint8_t indices[16];
+            const uint32_t error = AlphaIndices(values, inner_lo, inner_hi, indices);
+            if (error < best_error) {
+                best_error = error;
+                best_r0 = inner_lo;
+                best_r1 = inner_hi;
+                memcpy(best_indices, indices, sizeof(indices));
+            }
+        }
+
+        block[0] = best_r0;
+        block[1] = best_r1;
+        uint64_t bits = 0;
+        for (uint32_t i = 0; i < 16; i++) {
+            bits |= (uint64_t)best_indices[i] << (i * 3);
+        }
+        for (uint32_t i = 0; i < 6; i++) {
+            block[2 + i] = (uint8_t)(bits >> (i * 8));
+        }
+    }
+
+    void DecodeAlphaBlock(const uint8_t* block, uint8_t* values, uint32_t stride) {
+        int32_t palette[8];
+        AlphaPalette(block[0], block[1], palette);
+        uint64_t bits = 0;
+        for (uint32_t i = 0; i < 6; i++) {
+            bits |= (uint64_t)block[2 + i] << (i * 8);
+        }
+        for (uint32_t i = 0; i < 16; i++) {
+            values[i * stride] = (uint8_t)palette[(bits >> (i * 3)) & 7];
+        }
+    }
+
+    // BC7, one subset modes only. Mode 6: rgba end points of 7 bits plus a p-bit each, 4 bit indices.
+    // Mode 5: rgb end points of 7 bits and 8 bit alpha with their own 2 bit indices, for blocks where alpha does not follow color
+    static constexpr uint32_t bc7_weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+    static constexpr uint32_t bc7_weights2[4] = { 0, 21, 43, 64 };
+
+    struct Bc7Block {
+        uint32_t error{ std::numeric_limits<uint32_t>::max() };
+        uint32_t color[2][4]{}; // quantized, mode 6 keeps alpha in [3]
+        uint32_t pbits[2]{};
+        uint32_t alpha[2]{};
+        uint8_t indices[16]{};
+        uint8_t alpha_indices[16]{};
+    };
+
+    uint32_t Quantize(float val, float scale, uint32_t max) {
+        return (uint32_t)std::min(val * scale + 0.5f, (float)max);
+    }
+
+    // nearest weight to t in [0, 64] of the 4 bit table
+    uint32_t NearestWeight4(float t) {
+        static const struct Table {
+            uint8_t nearest[65];
+            Table() {
+                for (uint32_t t = 0; t <= 64; t++) {
+                    uint32_t best = 0;
+                    for (uint32_t p = 1; p < 16; p++) {
+                        if (std::abs((int32_t)bc7_weights4[p] - (int32_t)t) < std::abs((int32_t)bc7_weights4[best] - (int32_t)t)) {
+                            best = p;
+                        }
+                    }
+                    nearest[t] = (uint8_t)best;
+                }
+            }
+        } table;
+        return table.nearest[(uint32_t)std::min(std::max(t + 0.5f, 0.f), 64.f)];
+    }
+
+    template<uint32_t channels>
+    uint32_t Bc7Indices(const float texels[16][4], const int32_t ep0[4], const int32_t ep1[4], const uint32_t* weights, uint32_t weights_num, uint8_t indices[16], uint32_t first_channel = 0) {
+        int32_t palette[16][4];
+        for (uint32_t p = 0; p < weights_num; p++) {
+            for (uint32_t c = 0; c < channels; c++) {
+                palette[p][c] = ((64 - weights[p]) * ep0[c] + weights[p] * ep1[c] + 32) >> 6;
+            }
+        }
+
+        float dir[channels];
+        float dir_len = 0.f;
+        for (uint32_t c = 0; c < channels; c++) {
+            dir[c] = (float)(ep1[c] - ep0[c]);
+            dir_len += dir[c] * dir[c];
+        }
+
+        uint32_t error = 0;
+        for (uint32_t i = 0; i < 16; i++) {
+            // nearest weight along the line, then its neighbours by actual error
+            float t = 0.f;
+            if (dir_len > 0.f) {
+                for (uint32_t c = 0; c < channels; c++) {
+                    t += (texels[i][first_channel + c] - ep0[c]) * dir[c];
+                }
+                t = t * 64.f / dir_len;
+            }
+            const uint32_t guess = (weights_num == 16) ? NearestWeight4(t) : (uint32_t)std::min(std::max(t * 3.f / 64.f + 0.5f, 0.f), 3.f);
+
+            uint32_t best = std::numeric_limits<uint32_t>::max();
+            for (uint32_t p = (guess ? guess - 1 : 0); p <= std::min(guess + 1, weights_num - 1); p++) {
+                uint32_t dist = 0;
+                for (uint32_t c = 0; c < channels; c++) {
+                    const int32_t d = (int32_t)texels[i][first_channel + c] - palette[p][c];
+                    dist += d * d;
+                }
+                if (dist < best) {
+                    best = dist;
+                    indices[i] = (uint8_t)p;
+                }
+            }
+            error += best;
+        }
+        return error;
+    }
+
+    void EncodeBc7Mode6(const float texels[16][4], Bc7Block &best) {
+        float ep0[4];
+        float ep1[4];
+        FitLine<4>(texels, ep0, ep1);
+
+        for (uint32_t iter = 0; iter < 2; iter++) {
+            // every p-bit combination, the quantized end points differ with each
+            const uint32_t error_before = best.error;
+            for (uint32_t pbits = 0; pbits < 4; pbits++) {
+                const uint32_t p[2] = { pbits & 1, pbits >> 1 };
+                uint32_t q[2][4];
+                int32_t eps[2][4];
+                for (uint32_t c = 0; c < 4; c++) {
+                    q[0][c] = Quantize(std::max(ep0[c] - p[0], 0.f), 0.5f, 127);
+                    q[1][c] = Quantize(std::max(ep1[c] - p[1], 0.f), 0.5f, 127);
+                    eps[0][c] = (int32_t)((q[0][c] << 1) | p[0]);
+                    eps[1][c] = (int32_t)((q[1][c] << 1) | p[1]);
+                }
+
+                uint8_t indices[16];
+                const uint32_t error = Bc7Indices<4>(texels, eps[0], eps[1], bc7_weights4, 16, indices);
+                if (error < best.error) {
+                    best.error = error;
+                    memcpy(best.color, q, sizeof(q));
+                    memcpy(best.pbits, p, sizeof(p));
+                    memcpy(best.indices, indices, sizeof(indices));
+                }
+            }
+
+            float weights[16];
+            for (uint32_t i = 0; i < 16; i++) {
+                weights[i] = bc7_weights4[best.indices[i]] / 64.f;
+            }
+            if (best.error == 0 || best.error == error_before || !SolveEndpoints<4>(texels, weights, ep0, ep1)) {
+                break;
+            }
+        }
+    }
+
+    void EncodeBc7Mode5(const float texels[16][4], Bc7Block &best) {
+        float ep0[4];
+        float ep1[4];
+        FitLine<3>(texels, ep0, ep1);
+
+        float alphas[16][4] = {};
+        float alpha0[4] = { 255.f };
+        float alpha1[4] = { 0.f };
+        for (uint32_t i = 0; i < 16; i++) {
+            alphas[i][0] = texels[i][3];
+            alpha0[0] = std::min(alpha0[0], alphas[i][0]);
+            alpha1[0] = std::max(alpha1[0], alphas[i][0]);
+        }
+
+        uint32_t color_error = std::numeric_limits<uint32_t>::max();
+        uint32_t alpha_error = std::numeric_limits<uint32_t>::max();
+        for (uint32_t iter = 0; iter < 2; iter++) {
+            uint32_t q[2][4] = {};
+            int32_t eps[2][4] = {};
+            for (uint32_t c = 0; c < 3; c++) {
+                q[0][c] = Quantize(ep0[c], 127.f / 255.f, 127);
+                q[1][c] = Quantize(ep1[c], 127.f / 255.f, 127);
+                eps[0][c] = (int32_t)((q[0][c] << 1) | (q[0][c] >> 6));
+                eps[1][c] = (int32_t)((q[1][c] << 1) | (q[1][c] >> 6));
+            }
+            uint8_t indices[16];
+            uint32_t error = Bc7Indices<3>(texels, eps[0], eps[1], bc7_weights2, 4, indices);
+            if (error < color_error) {
+                color_error = error;
+                memcpy(best.color, q, sizeof(q));
+                memcpy(best.indices, indices, sizeof(indices));
+            }
+
+            const int32_t a[2][4] = { { (int32_t)Quantize(alpha0[0], 1.f, 255) }, { (int32_t)Quantize(alpha1[0], 1.f, 255) } };
+            error = Bc7Indices<1>(alphas, a[0], a[1], bc7_weights2, 4, indices);
+            if (error < alpha_error) {
+                alpha_error = error;
+                best.alpha[0] = (uint32_t)a[0][0];
+                best.alpha[1] = (uint32_t)a[1][0];
+                memcpy(best.alpha_indices, indices, sizeof(indices));
+            }
+
+            float weights[16];
+            for (uint32_t i = 0; i < 16; i++) {
+                weights[i] = bc7_weights2[best.indices[i]] / 64.f;
+            }
+            const bool color_solved = color_error && SolveEndpoints<3>(texels, weights, ep0, ep1);
+            for (uint32_t i = 0; i < 16; i++) {
+                weights[i] = bc7_weights2[best.alpha_indices[i]] / 64.f;
+            }
+            const bool alpha_solved = alpha_error && SolveEndpoints<1>(alphas, weights, alpha0, alpha1);
+            if (!color_solved && !alpha_solved) {
+                break;
+            }
+        }
+        best.error = color_error + alpha_error;
+    }
+
+    void EncodeBc7Block(const uint8_t texels[64], uint8_t* block) {
+        float colors[16][4];
+        bool alpha_varies = false;
+        for (uint32_t i = 0; i < 16; i++) {
+            for (uint32_t c = 0; c < 4; c++) {
+                colors[i][c] = texels[i * 4 + c];
+            }
+            alpha_varies |= texels[i * 4 + 3] != texels[3];
+        }
+
+        Bc7Block mode6;
+        EncodeBc7Mode6(colors, mode6);
+        Bc7Block mode5;
+        if (alpha_varies && mode6.error) {
+            EncodeBc7Mode5(colors, mode5);
+        }
+
+        memset(block, 0, 16);
+        BitWriter writer{ block };
+        if (mode5.error < mode6.error) {
+            // the anchor index drops its top bit, so it has to be in the lower half
+            if (mode5.indices[0] & 2) {
+                for (uint32_t c = 0; c < 3; c++) {
+                    std::swap(mode5.color[0][c], mode5.color[1][c]);
+                }
+                for (uint8_t &index : mode5.indices) {
+                    index = 3 - index;
+                }
+            }
+            if (mode5.alpha_indices[0] & 2) {
+                std::swap(mode5.alpha[0], mode5.alpha[1]);
+                for (uint8_t &index : mode5.alpha_indices) {
+                    index = 3 - index;
+                }
+            }
+
+            writer.Write(1 << 5, 6);
+            writer.Write(0, 2); // no channel rotation
+            for (uint32_t c = 0; c < 3; c++) {
+                writer.Write(mode5.color[0][c], 7);
+                writer.Write(mode5.color[1][c], 7);
+            }
+            writer.Write(mode5.alpha[0], 8);
+            writer.Write(mode5.alpha[1], 8);
+            for (uint32_t i = 0; i < 16; i++) {
+                writer.Write(mode5.indices[i], i ? 2 : 1);
+            }
+            for (uint32_t i = 0; i < 16; i++) {
+                writer.Write(mode5.alpha_indices[i], i ? 2 : 1);
+            }
+            return;
+        }
+
+        if (mode6.indices[0] & 8) {
+            for (uint32_t c = 0; c < 4; c++) {
+                std::swap(mode6.color[0][c], mode6.color[1][c]);
+            }
+            std::swap(mode6.pbits[0], mode6.pbits[1]);
+            for (uint8_t &index : mode6.indices) {
+                index = 15 - index;
+            }
+        }
+
+        writer.Write(1 << 6, 7);
+        for (uint32_t c = 0; c < 4; c++) {
+            writer.Write(mode6.color[0][c], 7);
+            writer.Write(mode6.color[1][c], 7);
+        }
+        writer.Write(mode6.pbits[0], 1);
+        writer.Write(mode6.pbits[1], 1);
+        for (uint32_t i = 0; i < 16; i++) {
+            writer.Write(mode6.indices[i], i ? 4 : 3);
+        }
+    }
+
+    bool DecodeBc7Block(const uint8_t* block, uint8_t texels[64]) {
+        BitReader reader{ block };
+        uint32_t mode = 0;
+        while (mode < 8 && !reader.Read(1)) {
+            mode++;
+        }
+
+        if (mode == 5) {
+            const uint32_t rotation = reader.Read(2);
+            int32_t eps[2][4];
+            for (uint32_t c = 0; c < 3; c++) {
+                for (uint32_t e = 0; e < 2; e++) {
+                    const int32_t val = (int32_t)reader.Read(7);
+                    eps[e][c] = (val << 1) | (val >> 6);
+                }
+            }
+            eps[0][3] = (int32_t)reader.Read(8);
+            eps[1][3] = (int32_t)reader.Read(8);
+            uint32_t color_weights[16];
+            for (uint32_t i = 0; i < 16; i++) {
+                color_weights[i] = bc7_weights2[reader.Read(i ? 2 : 1)];
+            }
+            for (uint32_t i = 0; i < 16; i++) {
+                const uint32_t alpha_weight = bc7_weights2[reader.Read(i ? 2 : 1)];
+                for (uint32_t c = 0; c < 4; c++) {
+                    const uint32_t weight = (c == 3) ? alpha_weight : color_weights[i];
+                    texels[i * 4 + c] = (uint8_t)(((64 - weight) * eps[0][c] + weight * eps[1][c] + 32) >> 6);
+                }
+                if (rotation) {
+                    std::swap(texels[i * 4 + 3], texels[i * 4 + rotation - 1]);
+                }
+            }
+            return true;
+        }
+
+        if (mode != 6) {
+            return false;
+        }
+
+        int32_t eps[2][4];
+        for (uint32_t c = 0; c < 4; c++) {
+            eps[0][c] = (int32_t)reader.Read(7) << 1;
+            eps[1][c] = (int32_t)reader.Read(7) << 1;
+        }
+        const uint32_t p0 = reader.Read(1);
+        const uint32_t p1 = reader.Read(1);
+        for (uint32_t c = 0; c < 4; c++) {
+            eps[0][c] |= p0;
+            eps[1][c] |= p1;
+        }
+        for (uint32_t i = 0; i < 16; i++) {
+            const uint32_t weight = bc7_weights4[reader.Read(i ? 4 : 3)];
+            for (uint32_t c = 0; c < 4; c++) {
+                texels[i * 4 + c] = (uint8_t)(((64 - weight) * eps[0][c] + weight * eps[1][c] + 32) >> 6);
+            }
+        }
+        return true;
+    }
+
+    uint32_t BlockSize(ResourceFormat format) {
+        return (format == ResourceFormat::rf_bc1_unorm || format == ResourceFormat::rf_bc1_unorm_srgb || format == ResourceFormat::rf_bc4_unorm) ? 8 : 16;
+    }
+
+    // 4x4 texels at x, y with the edges repeated for blocks sticking out of small mips
+    void GatherBlock(const uint8_t* texels, uint32_t width, uint32_t height, uint32_t x, uint32_t y, uint8_t block_texels[64]) {
+        for (uint32_t by = 0; by < 4; by++) {
+            const uint32_t sy = std::min(y + by, height - 1);
+            for (uint32_t bx = 0; bx < 4; bx++) {
+                const uint32_t sx = std::min(x + bx, width - 1);
+                memcpy(block_texels + (by * 4 + bx) * 4, texels + ((size_t)sy * width + sx) * 4, 4);
+            }
+        }
+    }
+
+    void WriteLe32(std::vector<uint8_t> &out, uint32_t val) {
+        for (uint32_t i = 0; i < 4; i++) {
+            out.push_back((uint8_t)(val >> (i * 8)));
+        }
+    }
+}
+
+Role GuessRole(const std::wstring &name) {
+    std::wstring lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](wchar_t c) { return (wchar_t)towlower(c); });
+
+    static const wchar_t* normal_keys[] = { L"normal", L"_nrm", L"_n." };
+    static const wchar_t* mask_keys[] = { L"rough", L"metal", L"_ao", L" ao", L"occlusion", L"height", L"gloss", L"specular", L"mask" };
+    for (const wchar_t* key : normal_keys) {
+        if (lower.find(key) != std::wstring::npos) {
+            return Role::tr_normal;
+        }
+    }
+    for (const wchar_t* key : mask_keys) {
+        if (lower.find(key) != std::wstring::npos) {
+            return Role::tr_mask;
+        }
+    }
+    return Role::tr_albedo;
+}
+
+bool Cook(const Image &source, const Settings &settings, Image &cooked, Report* report) {
+    if (source.dimension != ResourceDesc::ResourcesDimension::rd_texture2d || source.array_size != 1 || source.subresources.empty() ||
+        image_decoder::IsBlockCompressed(source.format)) {
+        return false;
+    }
+
+    std::vector<float> level;
+    if (!LoadTexels(source, level)) {
+        return false;
+    }
+
+    // single channel sources were never sampled as sRGB, they stay linear data
+    const bool is_float = IsFloat(source.format);
+    const Role role = (IsSingleChannel(source.format) && !is_float) ? Role::tr_mask : settings.role;
+    const bool is_srgb = (role == Role::tr_albedo) && !is_float;
+    const uint32_t width = source.subresources[0].width;
+    const uint32_t height = source.subresources[0].height;
+
+    bool has_alpha = false;
+    for (size_t i = 0; i < level.size(); i += 4) {
+        has_alpha |= level[i + 3] < 1.f - 0.5f / 255.f;
+        if (is_srgb) {
+            for (uint32_t c = 0; c < 3; c++) {
+                level[i + c] = SrgbToLinear(level[i + c]);
+            }
+        }
+    }
+
+    // BC needs the top mip in whole blocks, anything else stays uncompressed
+    ResourceFormat format = ResourceFormat::rf_r32g32b32a32_float;
+    if (!is_float) {
+        const bool block_aligned = (width % 4 == 0) && (height % 4 == 0);
+        switch (role) {
+            case Role::tr_albedo:
+                format = !block_aligned ? ResourceFormat::rf_r8g8b8a8_unorm_srgb :
+                    settings.bc7 ? ResourceFormat::rf_bc7_unorm_srgb : has_alpha ? ResourceFormat::rf_bc3_unorm_srgb : ResourceFormat::rf_bc1_unorm_srgb;
+                break;
+            case Role::tr_normal:
+                format = block_aligned ? ResourceFormat::rf_bc5_unorm : ResourceFormat::rf_r8g8b8a8_unorm;
+                break;
+            case Role::tr_mask:
+                format = block_aligned ? ResourceFormat::rf_bc4_unorm : ResourceFormat::rf_r8_unorm;
+                break;
+        }
+    }
+
+    uint32_t mip_levels = 1;
+    while ((std::max(width, height) >> mip_levels) != 0) {
+        mip_levels++;
+    }
+
+    cooked = Image();
+    cooked.format = format;
+    cooked.width = width;
+    cooked.height = height;
+    cooked.mip_levels = mip_levels;
+    uint64_t size = 0;
+    for (uint32_t mip = 0; mip < mip_levels; mip++) {
+        Subresource sub;
+        sub.width = std::max(width >> mip, 1u);
+        sub.height = std::max(height >> mip, 1u);
+        sub.offset = size;
+        image_decoder::ComputePitch(format, sub.width, sub.height, sub.row_pitch, sub.slice_pitch);
+        size += sub.slice_pitch;
+        cooked.subresources.push_back(sub);
+    }
+    cooked.pixels.resize(size);
+
+    const bool is_compressed = image_decoder::IsBlockCompressed(format);
+    const uint32_t block_size = BlockSize(format);
+    std::vector<uint8_t> top_texels;
+    std::vector<uint8_t> texels;
+    std::vector<float> next_level;
+    for (uint32_t mip = 0; mip < mip_levels; mip++) {
+        const Subresource &sub = cooked.subresources[mip];
+        if (mip) {
+            const Subresource &prev = cooked.subresources[mip - 1];
+            Downsample(level, prev.width, prev.height, settings.filter, next_level, sub.width, sub.height);
+            level.swap(next_level);
+        }
+        FixupTexels(level, role, is_float);
+
+        uint8_t* dst = cooked.pixels.data() + sub.offset;
+        if (is_float) {
+            for (uint32_t y = 0; y < sub.height; y++) {
+                memcpy(dst + y * sub.row_pitch, level.data() + (size_t)y * sub.width * 4, (size_t)sub.width * 16);
+            }
+            continue;
+        }
+
+        texels.resize((size_t)sub.width * sub.height * 4);
+        for (size_t i = 0; i < level.size(); i += 4) {
+            for (uint32_t c = 0; c < 4; c++) {
+                texels[i + c] = ToUnorm8((is_srgb && c < 3) ? LinearToSrgb(level[i + c]) : level[i + c]);
+            }
+        }
+        if (mip == 0) {
+            top_texels = texels;
+        }
+
+        if (!is_compressed) {
+            for (uint32_t y = 0; y < sub.height; y++) {
+                for (uint32_t x = 0; x < sub.width; x++) {
+                    const uint8_t* texel = texels.data() + ((size_t)y * sub.width + x) * 4;
+                    if (format == ResourceFormat::rf_r8_unorm) {
+                        dst[y * sub.row_pitch + x] = texel[0];
+                    }
+                    else {
+                        memcpy(dst + y * sub.row_pitch + x * 4, texel, 4);
+                    }
+                }
+            }
+            continue;
+        }
+
+        for (uint32_t y = 0; y < sub.height; y += 4) {
+            for (uint32_t x = 0; x < sub.width; x += 4) {
+                uint8_t block_texels[64];
+                GatherBlock(texels.data(), sub.width, sub.height, x, y, block_texels);
+                EncodeBlock(format, block_texels, dst + (y / 4) * sub.row_pitch + (x / 4) * block_size);
+            }
+        }
+    }
+
+    if (report) {
+        report->format = format;
+        report->width = width;
+        report->height = height;
+        report->mip_levels = mip_levels;
+        report->source_size = source.subresources[0].slice_pitch;
+        report->cooked_size = cooked.pixels.size();
+        report->psnr = std::numeric_limits<double>::infinity();
+        if (is_compressed) {
+            const Subresource &sub = cooked.subresources[0];
+            std::vector<uint8_t> decoded(top_texels.size());
+            for (uint32_t y = 0; y < height; y += 4) {
+                for (uint32_t x = 0; x < width; x += 4) {
+                    uint8_t block_texels[64];
+                    DecodeBlock(format, cooked.pixels.data() + (y / 4) * sub.row_pitch + (x / 4) * block_size, block_texels);
+                    for (uint32_t by = 0; by < 4; by++) {
+                        memcpy(decoded.data() + ((size_t)(y + by) * width + x) * 4, block_texels + by * 16, 16);
+                    }
+                }
+            }
+            const uint32_t channels = (role == Role::tr_mask) ? 1 : (role == Role::tr_normal) ? 2 : has_alpha ? 4 : 3;
+            report->psnr = ComputePSNR(top_texels.data(), decoded.data(), (uint64_t)width * height, channels);
+        }
+    }
+
+    return true;
+}
+
+void EncodeBlock(ResourceFormat format, const uint8_t texels[64], uint8_t* block) {
+    uint8_t values[16];
+    auto gather = [&texels, &values](uint32_t channel) {
+        for (uint32_t i = 0; i < 16; i++) {
+            values[i] = texels[i * 4 + channel];
+        }
+    };
+
+    switch (format) {
+        case ResourceFormat::rf_bc1_unorm:
+        case ResourceFormat::rf_bc1_unorm_srgb:
+            EncodeColorBlock(texels, block);
+            break;
+        case ResourceFormat::rf_bc3_unorm:
+        case ResourceFormat::rf_bc3_unorm_srgb:
+            gather(3);
+            EncodeAlphaBlock(values, block);
+            EncodeColorBlock(texels, block + 8);
+            break;
+        case ResourceFormat::rf_bc4_unorm:
+            gather(0);
+            EncodeAlphaBlock(values, block);
+            break;
+        case ResourceFormat::rf_bc5_unorm:
+            gather(0);
+            EncodeAlphaBlock(values, block);
+            gather(1);
+            EncodeAlphaBlock(values, block + 8);
+            break;
+        case ResourceFormat::rf_bc7_unorm:
+        case ResourceFormat::rf_bc7_unorm_srgb:
+            EncodeBc7Block(texels, block);
+            break;
+        default:
+            assert(false);
+            break;
+    }
+}
+
+bool DecodeBlock(ResourceFormat format, const uint8_t* block, uint8_t texels[64]) {
+    switch (format) {
+        case ResourceFormat::rf_bc1_unorm:
+        case ResourceFormat::rf_bc1_unorm_srgb:
+            DecodeColorBlock(block, false, texels);
+            return true;
+        case ResourceFormat::rf_bc3_unorm:
+        case ResourceFormat::rf_bc3_unorm_srgb:
+            DecodeColorBlock(block + 8, true, texels);
+            DecodeAlphaBlock(block, texels + 3, 4);
+            return true;
+        case ResourceFormat::rf_bc4_unorm:
+            DecodeAlphaBlock(block, texels, 4);
+            for (uint32_t i = 0; i < 16; i++) {
+                texels[i * 4 + 1] = texels[i * 4 + 2] = 0;
+                texels[i * 4 + 3] = 255;
+            }
+            return true;
+        case ResourceFormat::rf_bc5_unorm:
+            DecodeAlphaBlock(block, texels, 4);
+            DecodeAlphaBlock(block + 8, texels + 1, 4);
+            for (uint32_t i = 0; i < 16; i++) {
+                texels[i * 4 + 2] = 0;
+                texels[i * 4 + 3] = 255;
+            }
+            return true;
+        case ResourceFormat::rf_bc7_unorm:
+        case ResourceFormat::rf_bc7_unorm_srgb:
+            return DecodeBc7Block(block, texels);
+        default:
+            return false;
+    }
+}
+
+double ComputePSNR(const uint8_t* reference, const uint8_t* texels, uint64_t pixels_num, uint32_t channels) {
+    double error = 0.0;
+    for (uint64_t i = 0; i < pixels_num; i++) {
+        for (uint32_t c = 0; c < channels; c++) {
+            const double d = (double)reference[i * 4 + c] - texels[i * 4 + c];
+            error += d * d;
+        }
+    }
+    if (error == 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    const double mse = error / ((double)pixels_num * channels);
+    return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+bool WriteDDS(const std::filesystem::path &path, const Image &image, const std::filesystem::path &source_path) {
+    if (image.subresources.empty() || image.array_size != 1 || image.dimension != ResourceDesc::ResourcesDimension::rd_texture2d) {
+        return false;
+    }
+
+    enum : uint32_t {
+        ddsd_caps = 0x1, ddsd_height = 0x2, ddsd_width = 0x4, ddsd_pitch = 0x8, ddsd_pixelformat = 0x1000, ddsd_mipmapcount = 0x20000, ddsd_linearsize = 0x80000,
+        ddpf_fourcc = 0x4, ddscaps_complex = 0x8, ddscaps_texture = 0x1000, ddscaps_mipmap = 0x400000
+    };
+
+    std::error_code ec;
+    const uint64_t source_size = std::filesystem::file_size(source_path, ec);
+    const int64_t source_time = GetSourceTime(source_path);
+    const bool is_compressed = image_decoder::IsBlockCompressed(image.format);
+    const Subresource &top = image.subresources[0];
+
+    std::vector<uint8_t> blob;
+    blob.reserve(148 + image.pixels.size());
+    WriteLe32(blob, dds_magic);
+    WriteLe32(blob, 124);
+    WriteLe32(blob, ddsd_caps | ddsd_height | ddsd_width | ddsd_pixelformat | ddsd_mipmapcount | (is_compressed ? ddsd_linearsize : ddsd_pitch));
+    WriteLe32(blob, image.height);
+    WriteLe32(blob, image.width);
+    WriteLe32(blob, (uint32_t)(is_compressed ? top.slice_pitch : top.row_pitch));
+    WriteLe32(blob, 0);
+    WriteLe32(blob, image.mip_levels);
+    // reserved words: stamp, cooker version, source size and time
+    const uint32_t stamp[11] = { stamp_magic, version, (uint32_t)source_size, (uint32_t)(source_size >> 32), (uint32_t)source_time, (uint32_t)((uint64_t)source_time >> 32) };
+    for (uint32_t val : stamp) {
+        WriteLe32(blob, val);
+    }
+    // pixel format, everything goes through the DX10 header
+    WriteLe32(blob, 32);
+    WriteLe32(blob, ddpf_fourcc);
+    WriteLe32(blob, 0x30315844); // "DX10"
+    for (uint32_t i = 0; i < 5; i++) {
+        WriteLe32(blob, 0);
+    }
+    WriteLe32(blob, ddscaps_texture | ((image.mip_levels > 1) ? (ddscaps_complex | ddscaps_mipmap) : 0));
+    for (uint32_t i = 0; i < 4; i++) {
+        WriteLe32(blob, 0);
+    }
+    WriteLe32(blob, (uint32_t)image.format);
+    WriteLe32(blob, (uint32_t)ResourceDesc::ResourcesDimension::rd_texture2d);
+    WriteLe32(blob, 0);
+    WriteLe32(blob, 1);
+    WriteLe32(blob, 0);
+    blob.insert(blob.end(), image.pixels.begin(), image.pixels.end());
+
+    // write aside and swap in like the model cooks, each write gets its own file so concurrent cooks never share one
+    static std::atomic<uint32_t> writes_num{ 0 };
+    std::filesystem::path tmp_path = path;
+    tmp_path += L"." + std::to_wstring(writes_num++) + L".tmp";
+    std::filesystem::create_directories(path.parent_path(), ec);
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file.write((const char*)blob.data(), blob.size())) {
+            file.close();
+            std::filesystem::remove(tmp_path, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        std::error_code remove_ec;
+        std::filesystem::remove(tmp_path, remove_ec);
+        return false;
+    }
+
+    return true;
+}
+
+std::filesystem::path GetCookedPath(const std::filesystem::path &cooked_dir, const std::wstring &name) {
+    std::filesystem::path cooked_path = cooked_dir / std::filesystem::path(name).filename();
+    cooked_path += L".dds";
+
+    return cooked_path;
+}
+
+bool IsCookedFresh(const std::filesystem::path &cooked_path, const std::filesystem::path &source_path) {
+    VirtualFileSystem& vfs = VirtualFileSystem::Get();
+    std::shared_ptr<VfsFile> file = vfs.Open(cooked_path);
+    uint32_t header[18];
+    if (!file || file->GetSize() < sizeof(header)) {
+        return false;
+    }
+    memcpy(header, file->GetData(), sizeof(header));
+    if (header[0] != dds_magic || header[8] != stamp_magic || header[9] != version) {
+        return false;
+    }
+
+    uint64_t source_size = 0;
+    int64_t source_time = 0;
+    if (!vfs.Stat(source_path, source_size, source_time)) {
+        return true;
+    }
+
+    const uint64_t cooked_size = header[10] | ((uint64_t)header[11] << 32);
+    const int64_t cooked_time = (int64_t)(header[12] | ((uint64_t)header[13] << 32));
+    return cooked_size == source_size && cooked_time == source_time;
+}
+
+}
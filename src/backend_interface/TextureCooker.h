@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <filesystem>
+#include "ImageDecoder.h"
+
+// Offline texture cooking: gamma correct mip chains, block compression picked by texture role and DDS output.
+// Cooked textures live in content/cooked/textures/<texture file>.dds, the loaders take them over the source when fresh.
+// Everything is stateless and cpu only, textures can be cooked on any number of threads at once.
+namespace texture_cooker {
+    static constexpr uint32_t version = 1;
+
+    enum class Role { tr_albedo = 0, tr_normal, tr_mask };
+    enum class Filter { f_box = 0, f_kaiser };
+
+    struct Settings {
+        Role role{ Role::tr_albedo };
+        Filter filter{ Filter::f_kaiser };
+        bool bc7{ true }; // albedo as BC7, BC1 (opaque) or BC3 otherwise
+    };
+
+    struct Report {
+        ResourceFormat format{ ResourceFormat::rf_unknown };
+        uint32_t width{ 0 };
+        uint32_t height{ 0 };
+        uint32_t mip_levels{ 0 };
+        uint64_t source_size{ 0 }; // decoded top mip
+        uint64_t cooked_size{ 0 }; // whole chain
+        double psnr{ 0.0 }; // dB, block compression of the top mip over the channels the role keeps; infinity when lossless
+    };
+
+    // by name: "normal", "roughness", "metallic", ... anything else is albedo
+    Role GuessRole(const std::wstring &name);
+
+    // source is a single 2d image, any uncompressed format image_decoder produces; false for the rest (already block compressed dds, cube maps, ...)
+    // rgb albedo is treated as sRGB and filtered in linear space, normals are renormalized every mip, float sources keep float texels
+    bool Cook(const image_decoder::Image &source, const Settings &settings, image_decoder::Image &cooked, Report* report = nullptr);
+
+    // one 4x4 block, texels are rgba8 in row order. BC1/BC3/BC4/BC5/BC7, BC7 blocks are mode 5 or 6 and the decoder only knows those two
+    void EncodeBlock(ResourceFormat format, const uint8_t texels[64], uint8_t* block);
+    bool DecodeBlock(ResourceFormat format, const uint8_t* block, uint8_t texels[64]);
+
+    // over the first channels of two rgba8 buffers
+    double ComputePSNR(const uint8_t* reference, const uint8_t* texels, uint64_t pixels_num, uint32_t channels);
+
+    // the source size and time go into the header reserved words, IsCookedFresh compares them with the source file
+    bool WriteDDS(const std::filesystem::path &path, const image_decoder::Image &image, const std::filesystem::path &source_path);
+    std::filesystem::path GetCookedPath(const std::filesystem::path &cooked_dir, const std::wstring &name);
+    // true without a source, cooked only content is fine
+    bool IsCookedFresh(const std::filesystem::path &cooked_path, const std::filesystem::path &source_path);
+}
@@ -0,0 +1,163 @@
+#include "TextureRegistry.h"
+
+#include <algorithm>
+#include <cassert>
+#include <filesystem>
+
+TextureRegistry::TextureData* TextureRegistry::Reserve(const std::wstring& name) {
+    const std::wstring filename = std::filesystem::path(name).filename().wstring();
+    const auto it = m_file_textures.find(filename);
+    if (it != m_file_textures.end()) {
+        Touch(&m_textures[it->second]);
+        return &m_textures[it->second];
+    }
+
+    const pro_game_containers::pool_handle handle = m_textures.insert();
+    m_file_textures.emplace(filename, handle);
+    TextureData* texture = &m_textures[handle];
+    texture->name = filename;
+
+    return texture;
+}
+
+TextureRegistry::TextureData* TextureRegistry::Reserve(const std::wstring& name, uint64_t content_hash, const ITextureLoader::EmbeddedImage& image) {
+    TextureData* texture = nullptr;
+    const auto it = m_embedded_textures.find(content_hash);
+    if (it != m_embedded_textures.end()) {
+        texture = &m_textures[it->second];
+        if (!texture->NeedsDecode() || !texture->embedded_data.empty()) {
+            Touch(texture);
+            return texture;
+        }
+    }
+    else {
+        const pro_game_containers::pool_handle handle = m_textures.insert();
+        m_embedded_textures.emplace(content_hash, handle);
+        texture = &m_textures[handle];
+        texture->name = name;
+        texture->content_hash = content_hash;
+    }
+
+    // new, or the bytes already went with an upload
+    std::lock_guard<std::mutex> lock(m_mutex);
+    texture->embedded_data.assign(image.data, image.data + image.size);
+    texture->embedded_width = image.width;
+    texture->embedded_height = image.height;
+    texture->embedded_format_hint = image.format_hint;
+    texture->cpu_bytes += texture->embedded_data.size();
+    m_cpu_bytes += texture->embedded_data.size();
+    m_cpu_peak_bytes = std::max(m_cpu_peak_bytes, m_cpu_bytes);
+
+    return texture;
+}
+
+TextureRegistry::TextureData* TextureRegistry::Find(const std::wstring& name) {
+    const auto it = m_file_textures.find(std::filesystem::path(name).filename().wstring());
+    return (it != m_file_textures.end()) ? m_textures.get(it->second) : nullptr;
+}
+
+void TextureRegistry::AddRef(TextureData* texture) {
+    texture->ref_count++;
+}
+
+void TextureRegistry::Release(TextureData* texture) {
+    assert(texture->ref_count);
+    if (--texture->ref_count) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Evict(texture);
+    m_cpu_bytes -= texture->cpu_bytes;
+    if (texture->content_hash) {
+        m_embedded_textures.erase(texture->content_hash);
+    }
+    else {
+        m_file_textures.erase(texture->name);
+    }
+    m_textures.erase(m_textures.handle_of(texture));
+}
+
+void TextureRegistry::SetDecoded(TextureData* texture, image_decoder::Image&& image) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Evict(texture);
+    texture->image = std::move(image);
+    texture->is_decoded = true;
+    texture->decodes_num++;
+    texture->cpu_bytes += texture->image.GetSize();
+    m_cpu_bytes += texture->image.GetSize();
+    m_cpu_peak_bytes = std::max(m_cpu_peak_bytes, m_cpu_bytes);
+
+    texture->lru_it = m_lru.insert(m_lru.end(), texture);
+    texture->in_lru = true;
+    EvictOverBudget(texture);
+}
+
+void TextureRegistry::SetUploaded(TextureData* texture) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    texture->gpu_bytes = texture->image.GetSize();
+    Evict(texture);
+    m_cpu_bytes -= texture->cpu_bytes;
+    texture->cpu_bytes = 0;
+    texture->embedded_data.clear();
+    texture->embedded_data.shrink_to_fit();
+}
+
+void TextureRegistry::Replace(TextureData* texture, image_decoder::Image&& image) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        texture->gpu_resource.reset();
+        texture->gpu_bytes = 0;
+    }
+    SetDecoded(texture, std::move(image));
+}
+
+void TextureRegistry::SetCpuBudget(uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cpu_budget = bytes;
+    EvictOverBudget(nullptr);
+}
+
+TextureRegistry::Stats TextureRegistry::GetStats() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats;
+    stats.cpu_bytes = m_cpu_bytes;
+    stats.cpu_peak_bytes = m_cpu_peak_bytes;
+    stats.cpu_budget = m_cpu_budget;
+    stats.evictions_num = m_evictions_num;
+    for (const TextureData& texture : m_textures) {
+        stats.gpu_bytes += texture.gpu_bytes;
+        stats.textures.push_back({ texture.name, texture.ref_count, texture.decodes_num, texture.cpu_bytes, texture.gpu_bytes });
+    }
+
+    return stats;
+}
+
+void TextureRegistry::Touch(TextureData* texture) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (texture->in_lru) {
+        m_lru.splice(m_lru.end(), m_lru, texture->lru_it);
+    }
+}
+
+void TextureRegistry::Evict(TextureData* texture) {
+    // keeps the metadata, only the texels go
+    if (texture->is_decoded) {
+        texture->cpu_bytes -= texture->image.GetSize();
+        m_cpu_bytes -= texture->image.GetSize();
+        texture->image.pixels.clear();
+        texture->image.pixels.shrink_to_fit();
+        texture->is_decoded = false;
+    }
+    if (texture->in_lru) {
+        m_lru.erase(texture->lru_it);
+        texture->in_lru = false;
+    }
+}
+
+void TextureRegistry::EvictOverBudget(const TextureData* keep) {
+    while (m_cpu_bytes > m_cpu_budget && !m_lru.empty() && m_lru.front() != keep) {
+        Evict(m_lru.front());
+        m_evictions_num++;
+    }
+}
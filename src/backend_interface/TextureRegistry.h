@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include "ITextureLoader.h"
+#include "generational_pool.h"
+
+// Texture entries of a loader: found by file name or embedded content hash in O(1), kept alive by TextureHandles.
+// Decoded texels stay on the cpu only until uploaded; copies waiting for upload are evicted least recently used first
+// once over the cpu budget and decoded again when needed. The last handle drops the entry with its gpu texture, a
+// later model asking for the same texture reserves and decodes it again.
+class TextureRegistry {
+public:
+    using TextureData = ITextureLoader::TextureData;
+
+    struct TextureStats {
+        std::wstring name;
+        uint32_t ref_count{ 0 };
+        uint32_t decodes_num{ 0 };
+        uint64_t cpu_bytes{ 0 };
+        uint64_t gpu_bytes{ 0 };
+    };
+
+    struct Stats {
+        uint64_t cpu_bytes{ 0 };
+        uint64_t cpu_peak_bytes{ 0 };
+        uint64_t cpu_budget{ 0 };
+        uint64_t gpu_bytes{ 0 };
+        uint32_t evictions_num{ 0 };
+        std::vector<TextureStats> textures;
+    };
+
+    // by file name, the path is dropped
+    TextureData* Reserve(const std::wstring& name);
+    // embedded bytes are copied, they are the only way back to the texels after an eviction
+    TextureData* Reserve(const std::wstring& name, uint64_t content_hash, const ITextureLoader::EmbeddedImage& image);
+
+    // by file name without reserving, null when no model ever asked for it
+    TextureData* Find(const std::wstring& name);
+
+    void AddRef(TextureData* texture);
+    void Release(TextureData* texture);
+
+    // thread safe, may evict other decoded textures to stay in budget
+    void SetDecoded(TextureData* texture, image_decoder::Image&& image);
+    // texels are on the gpu, the cpu copy and embedded bytes go away
+    void SetUploaded(TextureData* texture);
+    // the file changed: new texels replace the cpu copy and the gpu texture is dropped, handles stay valid
+    void Replace(TextureData* texture, image_decoder::Image&& image);
+    void SetCpuBudget(uint64_t bytes);
+    Stats GetStats();
+
+private:
+    // moves a waiting cpu copy to the back of the lru
+    void Touch(TextureData* texture);
+    // callers hold m_mutex
+    void Evict(TextureData* texture);
+    void EvictOverBudget(const TextureData* keep);
+
+    static constexpr uint32_t textures_capacity = 128;
+    pro_game_containers::generational_pool<TextureData, textures_capacity, 8> m_textures;
+    std::unordered_map<std::wstring, pro_game_containers::pool_handle> m_file_textures; // file name to pool handle
+    std::unordered_map<uint64_t, pro_game_containers::pool_handle> m_embedded_textures; // content hash to pool handle
+
+    std::mutex m_mutex;
+    std::list<TextureData*> m_lru; // decoded and not uploaded yet, least recently used first
+    uint64_t m_cpu_bytes{ 0 };
+    uint64_t m_cpu_peak_bytes{ 0 };
+    uint64_t m_cpu_budget{ 512ull << 20 };
+    uint32_t m_evictions_num{ 0 };
+};
+
+// counted reference to a registry entry, what models keep for their texture slots
+class TextureHandle {
+public:
+    TextureHandle() = default;
+    TextureHandle(TextureRegistry& registry, ITextureLoader::TextureData* texture) : m_registry(&registry), m_texture(texture) { if (m_texture) m_registry->AddRef(m_texture); }
+    TextureHandle(const TextureHandle& other) : m_registry(other.m_registry), m_texture(other.m_texture) { if (m_texture) m_registry->AddRef(m_texture); }
+    TextureHandle(TextureHandle&& other) noexcept : m_registry(other.m_registry), m_texture(other.m_texture) { other.m_texture = nullptr; }
+    TextureHandle& operator=(TextureHandle other) noexcept { std::swap(m_registry, other.m_registry); std::swap(m_texture, other.m_texture); return *this; }
+    ~TextureHandle() { if (m_texture) m_registry->Release(m_texture); }
+
+    ITextureLoader::TextureData* Get() const { return m_texture; }
+    ITextureLoader::TextureData* operator->() const { return m_texture; }
+    explicit operator bool() const { return m_texture != nullptr; }
+
+private:
+    TextureRegistry* m_registry{ nullptr };
+    ITextureLoader::TextureData* m_texture{ nullptr };
+};
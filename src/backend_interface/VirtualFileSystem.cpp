@@ -0,0 +1,378 @@
+#include "VirtualFileSystem.h"
+#include "MappedFile.h"
+#include "Lz4.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+
+namespace {
+    constexpr uint32_t pak_magic = 'D' | ('X' << 8) | ('P' << 16) | ('K' << 24);
+    constexpr uint32_t pak_version = 1;
+
+    enum Compression : uint32_t { pc_none = 0, pc_lz4 };
+
+    struct PakHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entries_num;
+        uint32_t reserved;
+        uint64_t toc_offset;
+        uint64_t strings_offset;
+        uint64_t strings_size;
+        uint64_t file_size;
+    };
+
+    struct PakEntry {
+        uint32_t path_offset;
+        uint32_t path_size;
+        uint64_t offset;
+        uint64_t stored_size;
+        uint64_t size;
+        int64_t time;
+        uint32_t compression;
+        uint32_t reserved;
+    };
+
+    bool IsRangeValid(uint64_t offset, uint64_t size, uint64_t total) {
+        return offset <= total && size <= total - offset;
+    }
+
+    uint64_t AlignUp(uint64_t val, uint64_t alignment) {
+        return (val + alignment - 1) / alignment * alignment;
+    }
+
+    int64_t GetFileTime(const std::filesystem::path& path, std::error_code& ec) {
+        return (int64_t)std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    }
+}
+
+struct VirtualFileSystem::Pak {
+    MappedFile file;
+    const PakHeader* header{ nullptr };
+    const PakEntry* entries{ nullptr };
+    const char* strings{ nullptr };
+
+    std::string_view GetPath(const PakEntry& entry) const { return std::string_view(strings + entry.path_offset, entry.path_size); }
+
+    const PakEntry* Find(const std::string& path) const {
+        const PakEntry* end = entries + header->entries_num;
+        const PakEntry* it = std::lower_bound(entries, end, path, [this](const PakEntry& entry, const std::string& val) { return GetPath(entry) < val; });
+        return (it != end && GetPath(*it) == path) ? it : nullptr;
+    }
+};
+
+VirtualFileSystem& VirtualFileSystem::Get() {
+    static VirtualFileSystem vfs;
+    return vfs;
+}
+
+void VirtualFileSystem::SetRoot(const std::filesystem::path& root) {
+    m_root = root;
+}
+
+bool VirtualFileSystem::MountDirectory(const std::filesystem::path& dir) {
+    std::error_code ec;
+    if (!std::filesystem::is_directory(dir, ec)) {
+        return false;
+    }
+
+    Mount mount;
+    mount.dir = dir;
+    m_mounts.push_back(std::move(mount));
+
+    return true;
+}
+
+bool VirtualFileSystem::MountPak(const std::filesystem::path& path, bool prefetch) {
+    std::shared_ptr<Pak> pak = std::make_shared<Pak>();
+    if (!pak->file.Open(path)) {
+        return false;
+    }
+
+    // nothing past the header is trusted before the ranges check out
+    const uint8_t* data = pak->file.GetData();
+    const uint64_t file_size = pak->file.GetSize();
+    const PakHeader* header = (const PakHeader*)data;
+    if (file_size < sizeof(PakHeader) || header->magic != pak_magic || header->version != pak_version || header->file_size != file_size ||
+        !IsRangeValid(header->toc_offset, (uint64_t)header->entries_num * sizeof(PakEntry), file_size) ||
+        !IsRangeValid(header->strings_offset, header->strings_size, file_size)) {
+        return false;
+    }
+
+    const PakEntry* entries = (const PakEntry*)(data + header->toc_offset);
+    for (uint32_t i = 0; i < header->entries_num; i++) {
+        const PakEntry& entry = entries[i];
+        if (!IsRangeValid(entry.path_offset, entry.path_size, header->strings_size) || !IsRangeValid(entry.offset, entry.stored_size, file_size) ||
+            (entry.compression == pc_none && entry.stored_size != entry.size) || entry.compression > pc_lz4) {
+            return false;
+        }
+    }
+
+    pak->header = header;
+    pak->entries = entries;
+    pak->strings = (const char*)(data + header->strings_offset);
+    for (uint32_t i = 1; i < header->entries_num; i++) {
+        if (!(pak->GetPath(entries[i - 1]) < pak->GetPath(entries[i]))) {
+            return false;
+        }
+    }
+
+    if (prefetch) {
+        pak->file.Prefetch();
+    }
+
+    Mount mount;
+    mount.pak = std::move(pak);
+    m_mounts.push_back(std::move(mount));
+
+    return true;
+}
+
+void VirtualFileSystem::UnmountAll() {
+    m_mounts.clear();
+}
+
+void VirtualFileSystem::PreferLoose(const std::filesystem::path& path) {
+    std::lock_guard<std::mutex> lock(m_loose_mutex);
+    m_loose_only.insert(ToVirtual(path));
+    m_has_loose_only = true;
+}
+
+bool VirtualFileSystem::IsLooseOnly(const std::string& vpath) const {
+    if (!m_has_loose_only) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_loose_mutex);
+    return m_loose_only.count(vpath) != 0;
+}
+
+std::string VirtualFileSystem::ToVirtual(const std::filesystem::path& path) const {
+    const std::filesystem::path rel = (path.is_absolute() && !m_root.empty()) ? path.lexically_relative(m_root) : path;
+    return rel.lexically_normal().generic_u8string();
+}
+
+std::shared_ptr<VfsFile> VirtualFileSystem::Open(const std::filesystem::path& path) {
+    const std::string vpath = ToVirtual(path);
+    const bool loose_only = IsLooseOnly(vpath);
+    for (auto it = m_mounts.rbegin(); it != m_mounts.rend(); ++it) {
+        if (it->pak) {
+            if (loose_only) {
+                continue;
+            }
+            const Pak& pak = *it->pak;
+            const PakEntry* entry = pak.Find(vpath);
+            if (!entry) {
+                continue;
+            }
+
+            m_pak_opens++;
+            m_pak_bytes += entry->stored_size;
+            const uint8_t* data = pak.file.GetData() + entry->offset;
+            if (entry->compression == pc_none) {
+                // aliases the pak mapping, which lives as long as the file
+                return std::make_shared<VfsFile>(std::shared_ptr<MappedFile>(it->pak, const_cast<MappedFile*>(&pak.file)), data, entry->size);
+            }
+
+            std::vector<uint8_t> bytes(entry->size);
+            if (!lz4::Decompress(data, entry->stored_size, bytes.data(), bytes.size())) {
+                return nullptr;
+            }
+            return std::make_shared<VfsFile>(std::move(bytes));
+        }
+
+        const std::filesystem::path full_path = it->dir / std::filesystem::u8path(vpath);
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(full_path, ec)) {
+            continue;
+        }
+
+        std::shared_ptr<MappedFile> mapping = std::make_shared<MappedFile>();
+        if (!mapping->Open(full_path)) {
+            // empty files do not map, anything else that fails to is an error, not a zero byte file
+            if (std::filesystem::file_size(full_path, ec) == 0 && !ec) {
+                m_loose_opens++;
+                return std::make_shared<VfsFile>(std::vector<uint8_t>());
+            }
+            m_misses++;
+            return nullptr;
+        }
+        m_loose_opens++;
+        m_loose_bytes += mapping->GetSize();
+        const uint8_t* data = mapping->GetData();
+        const uint64_t size = mapping->GetSize();
+        return std::make_shared<VfsFile>(std::move(mapping), data, size);
+    }
+
+    m_misses++;
+    return nullptr;
+}
+
+bool VirtualFileSystem::Exists(const std::filesystem::path& path) const {
+    uint64_t size;
+    int64_t time;
+    return Stat(path, size, time);
+}
+
+bool VirtualFileSystem::Stat(const std::filesystem::path& path, uint64_t& size, int64_t& time) const {
+    const std::string vpath = ToVirtual(path);
+    const bool loose_only = IsLooseOnly(vpath);
+    for (auto it = m_mounts.rbegin(); it != m_mounts.rend(); ++it) {
+        if (it->pak) {
+            if (loose_only) {
+                continue;
+            }
+            if (const PakEntry* entry = it->pak->Find(vpath)) {
+                size = entry->size;
+                time = entry->time;
+                return true;
+            }
+            continue;
+        }
+
+        const std::filesystem::path full_path = it->dir / std::filesystem::u8path(vpath);
+        std::error_code ec;
+        if (std::filesystem::is_regular_file(full_path, ec)) {
+            size = std::filesystem::file_size(full_path, ec);
+            time = GetFileTime(full_path, ec);
+            return !ec;
+        }
+    }
+
+    return false;
+}
+
+VirtualFileSystem::Stats VirtualFileSystem::GetStats() const {
+    Stats stats;
+    stats.mounts_num = (uint32_t)m_mounts.size();
+    stats.pak_opens = m_pak_opens;
+    stats.loose_opens = m_loose_opens;
+    stats.misses = m_misses;
+    stats.pak_bytes = m_pak_bytes;
+    stats.loose_bytes = m_loose_bytes;
+
+    return stats;
+}
+
+bool VirtualFileSystem::WritePak(const std::filesystem::path& pak_path, const std::filesystem::path& root, const std::vector<std::filesystem::path>& dirs, bool compress, PakReport* report) {
+    struct Source {
+        std::string path;
+        std::filesystem::path full_path;
+    };
+
+    std::vector<Source> sources;
+    std::error_code ec;
+    for (const std::filesystem::path& dir : dirs) {
+        for (std::filesystem::recursive_directory_iterator it(root / dir, ec), end; !ec && it != end; it.increment(ec)) {
+            std::error_code pak_ec;
+            if (it->is_regular_file() && !std::filesystem::equivalent(it->path(), pak_path, pak_ec)) {
+                sources.push_back({ it->path().lexically_relative(root).lexically_normal().generic_u8string(), it->path() });
+            }
+        }
+    }
+    std::sort(sources.begin(), sources.end(), [](const Source& l, const Source& r) { return l.path < r.path; });
+    sources.erase(std::unique(sources.begin(), sources.end(), [](const Source& l, const Source& r) { return l.path == r.path; }), sources.end());
+
+    PakHeader header = {};
+    header.magic = pak_magic;
+    header.version = pak_version;
+    header.entries_num = (uint32_t)sources.size();
+    header.toc_offset = sizeof(PakHeader);
+    header.strings_offset = header.toc_offset + sources.size() * sizeof(PakEntry);
+
+    std::vector<PakEntry> entries(sources.size());
+    std::string strings;
+    for (uint32_t i = 0; i < sources.size(); i++) {
+        entries[i].path_offset = (uint32_t)strings.size();
+        entries[i].path_size = (uint32_t)sources[i].path.size();
+        strings += sources[i].path;
+    }
+    header.strings_size = strings.size();
+
+    std::filesystem::path tmp_path = pak_path;
+    tmp_path += L".tmp";
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    // no failure below leaves the tmp file behind
+    auto discard = [&file, &tmp_path]() {
+        file.close();
+        std::error_code remove_ec;
+        std::filesystem::remove(tmp_path, remove_ec);
+        return false;
+    };
+
+    // files first, the header and toc are written once the offsets are known
+    PakReport pak_report;
+    const std::vector<char> padding(pak_alignment, 0);
+    auto write_padding = [&file, &padding](uint64_t size) {
+        for (; size; size -= std::min<uint64_t>(size, padding.size())) {
+            file.write(padding.data(), std::min<uint64_t>(size, padding.size()));
+        }
+    };
+    uint64_t offset = AlignUp(header.strings_offset + header.strings_size, pak_alignment);
+    write_padding(offset);
+    std::vector<uint8_t> bytes;
+    std::vector<uint8_t> compressed;
+    for (uint32_t i = 0; i < sources.size(); i++) {
+        PakEntry& entry = entries[i];
+        const uint64_t size = std::filesystem::file_size(sources[i].full_path, ec);
+        entry.time = GetFileTime(sources[i].full_path, ec);
+        if (ec) {
+            return discard();
+        }
+
+        bytes.resize(size);
+        std::ifstream in(sources[i].full_path, std::ios::binary);
+        if (!in.read((char*)bytes.data(), size)) {
+            return discard();
+        }
+
+        const uint8_t* stored = bytes.data();
+        entry.size = size;
+        entry.stored_size = size;
+        entry.compression = pc_none;
+        if (compress && size) {
+            compressed.resize(lz4::CompressBound(size));
+            const uint64_t compressed_size = lz4::Compress(bytes.data(), size, compressed.data());
+            if (compressed_size < size - size / 8) {
+                stored = compressed.data();
+                entry.stored_size = compressed_size;
+                entry.compression = pc_lz4;
+                pak_report.compressed_num++;
+            }
+        }
+
+        entry.offset = offset;
+        file.write((const char*)stored, entry.stored_size);
+        offset = AlignUp(offset + entry.stored_size, pak_alignment);
+        write_padding(offset - (entry.offset + entry.stored_size));
+        pak_report.raw_size += size;
+    }
+    header.file_size = offset;
+
+    file.seekp(0);
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)entries.data(), entries.size() * sizeof(PakEntry));
+    file.write(strings.data(), strings.size());
+    file.close();
+    if (!file) {
+        return discard();
+    }
+
+    std::filesystem::rename(tmp_path, pak_path, ec);
+    if (ec) {
+        return discard();
+    }
+
+    pak_report.files_num = (uint32_t)sources.size();
+    pak_report.pak_size = header.file_size;
+    if (report) {
+        *report = pak_report;
+    }
+
+    return true;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+#include <filesystem>
+
+class MappedFile;
+
+// contents of one file: points into a mapping (loose file or pak entry stored as is) or owns the decompressed bytes
+class VfsFile {
+public:
+    VfsFile(std::shared_ptr<MappedFile> mapping, const uint8_t* data, uint64_t size) : m_mapping(std::move(mapping)), m_data(data), m_size(size) {}
+    explicit VfsFile(std::vector<uint8_t>&& bytes) : m_bytes(std::move(bytes)), m_data(m_bytes.data()), m_size(m_bytes.size()) {}
+
+    const uint8_t* GetData() const { return m_data; }
+    uint64_t GetSize() const { return m_size; }
+
+private:
+    std::shared_ptr<MappedFile> m_mapping;
+    std::vector<uint8_t> m_bytes;
+    const uint8_t* m_data{ nullptr };
+    uint64_t m_size{ 0 };
+};
+
+// Read only view of the content: loose directories and pak archives mounted under one root.
+// Paths are relative to the root (content/models/x.fbx, build/src/shaders/x.bin); absolute paths under the root work too,
+// so callers keep building them from the root dir. Mounts are searched newest first and are set up before loading,
+// everything else is thread safe.
+//
+// Pak: header, toc sorted by path, path strings, then the files at 64 KB aligned offsets, each stored as is or LZ4 compressed.
+// The toc keeps every file's size and write time, so cooked data freshness checks work the same from a pak.
+class VirtualFileSystem {
+public:
+    static constexpr uint64_t pak_alignment = 64 * 1024;
+
+    struct Stats {
+        uint32_t mounts_num{ 0 };
+        uint32_t pak_opens{ 0 };
+        uint32_t loose_opens{ 0 };
+        uint32_t misses{ 0 };
+        uint64_t pak_bytes{ 0 };
+        uint64_t loose_bytes{ 0 };
+    };
+
+    struct PakReport {
+        uint32_t files_num{ 0 };
+        uint32_t compressed_num{ 0 };
+        uint64_t raw_size{ 0 };
+        uint64_t pak_size{ 0 };
+    };
+
+    static VirtualFileSystem& Get();
+
+    void SetRoot(const std::filesystem::path& root);
+    const std::filesystem::path& GetRoot() const { return m_root; }
+    bool MountDirectory(const std::filesystem::path& dir);
+    // prefetch reads the whole archive ahead in one sequential pass
+    bool MountPak(const std::filesystem::path& path, bool prefetch = true);
+    void UnmountAll();
+    // hot reload: a loose file written after mounting wins over the paks from now on
+    void PreferLoose(const std::filesystem::path& path);
+
+    // null when no mount has the file
+    std::shared_ptr<VfsFile> Open(const std::filesystem::path& path);
+    bool Exists(const std::filesystem::path& path) const;
+    // time is std::filesystem::file_time_type ticks, what the cooked data stamps compare against
+    bool Stat(const std::filesystem::path& path, uint64_t& size, int64_t& time) const;
+    Stats GetStats() const;
+
+    // every regular file under dirs (relative to root) into one archive; files LZ4 does not shrink by an eighth are stored as is
+    static bool WritePak(const std::filesystem::path& pak_path, const std::filesystem::path& root, const std::vector<std::filesystem::path>& dirs, bool compress, PakReport* report = nullptr);
+
+private:
+    struct Pak;
+    struct Mount {
+        std::filesystem::path dir; // loose
+        std::shared_ptr<Pak> pak;
+    };
+
+    std::string ToVirtual(const std::filesystem::path& path) const;
+    bool IsLooseOnly(const std::string& vpath) const;
+
+    std::filesystem::path m_root;
+    std::vector<Mount> m_mounts;
+    mutable std::mutex m_loose_mutex;
+    std::unordered_set<std::string> m_loose_only;
+    std::atomic<bool> m_has_loose_only{ false };
+    mutable std::atomic<uint32_t> m_pak_opens{ 0 };
+    mutable std::atomic<uint32_t> m_loose_opens{ 0 };
+    mutable std::atomic<uint32_t> m_misses{ 0 };
+    mutable std::atomic<uint64_t> m_pak_bytes{ 0 };
+    mutable std::atomic<uint64_t> m_loose_bytes{ 0 };
+};
@@ -0,0 +1,209 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pro_game_containers {
+    // 32 bit handle: slot index in the low bits, the slot's generation in the high bits.
+    // Every erase moves the slot's generation on, so handles to erased elements stop resolving.
+    // Generations wrap after 4095 erases of the same slot; value 0 never resolves.
+    struct pool_handle {
+        static constexpr uint32_t index_bits = 20;
+        static constexpr uint32_t index_mask = (1u << index_bits) - 1;
+        static constexpr uint32_t generation_mask = (1u << (32 - index_bits)) - 1;
+
+        uint32_t value{ 0 };
+
+        static pool_handle make(uint32_t index, uint32_t generation) { return pool_handle{ (generation << index_bits) | index }; }
+        uint32_t index() const { return value & index_mask; }
+        uint32_t generation() const { return value >> index_bits; }
+        explicit operator bool() const { return value != 0; }
+        bool operator==(pool_handle other) const { return value == other.value; }
+        bool operator!=(pool_handle other) const { return value != other.value; }
+    };
+
+    // Pool with O(1) insert and erase. Free slots are chained through the storage of the elements erased from them,
+    // live slots are kept in a dense list, so iteration never meets a hole. Elements never move: slots come in chunks
+    // of chunk_size, up to max_chunks, allocated as the pool fills, and a pointer stays good until its element is erased.
+    template <class T, uint32_t chunk_size, uint32_t max_chunks = 1>
+    class generational_pool {
+        static_assert(chunk_size > 0 && max_chunks > 0, "empty pool");
+        static_assert((uint64_t)chunk_size * max_chunks <= pool_handle::index_mask, "pool_handle can't index that many slots");
+
+        static constexpr uint32_t npos = uint32_t(-1);
+
+        struct slot {
+            slot() {}
+            union {
+                uint32_t next_free;
+                alignas(T) unsigned char storage[sizeof(T)];
+            };
+            uint32_t generation{ 1 };
+            uint32_t live{ npos }; // position in m_live
+        };
+
+    public:
+        using handle = pool_handle;
+
+        template <bool is_const>
+        class iterator_base {
+            using pool_type = std::conditional_t<is_const, const generational_pool, generational_pool>;
+            using value_type = std::conditional_t<is_const, const T, T>;
+        public:
+            iterator_base(pool_type* pool, uint32_t pos) : m_pool(pool), m_pos(pos) {}
+            value_type& operator*() const { return *m_pool->element(m_pool->m_live[m_pos]); }
+            value_type* operator->() const { return m_pool->element(m_pool->m_live[m_pos]); }
+            iterator_base& operator++() { ++m_pos; return *this; }
+            bool operator==(const iterator_base& other) const { return m_pos == other.m_pos; }
+            bool operator!=(const iterator_base& other) const { return m_pos != other.m_pos; }
+            handle get_handle() const { const uint32_t idx = m_pool->m_live[m_pos]; return handle::make(idx, m_pool->at(idx).generation); }
+        private:
+            pool_type* m_pool;
+            uint32_t m_pos;
+        };
+        using iterator = iterator_base<false>;
+        using const_iterator = iterator_base<true>;
+
+        generational_pool() = default;
+        generational_pool(const generational_pool&) = delete;
+        generational_pool& operator=(const generational_pool&) = delete;
+        ~generational_pool() { clear(); }
+
+        // an invalid handle when every chunk is full
+        template <class... Args>
+        handle insert(Args&&... args) {
+            const bool reuse = m_free_head != npos;
+            if (!reuse && m_slots_num == m_chunks.size() * chunk_size) {
+                if (m_chunks.size() == max_chunks) {
+                    assert(false && "generational_pool is full");
+                    return handle{};
+                }
+                m_chunks.emplace_back(new slot[chunk_size]);
+            }
+
+            const uint32_t idx = reuse ? m_free_head : m_slots_num;
+            slot& s = at(idx);
+            // the element overwrites the link
+            const uint32_t next_free = reuse ? s.next_free : npos;
+            new (s.storage) T(std::forward<Args>(args)...);
+            if (reuse) {
+                m_free_head = next_free;
+            }
+            else {
+                m_slots_num++;
+            }
+            s.live = (uint32_t)m_live.size();
+            m_live.push_back(idx);
+            return handle::make(idx, s.generation);
+        }
+
+        // false for stale handles
+        bool erase(handle h) {
+            slot* s = resolve(h);
+            if (!s) {
+                return false;
+            }
+
+            reinterpret_cast<T*>(s->storage)->~T();
+            const uint32_t last = m_live.back();
+            m_live[s->live] = last;
+            at(last).live = s->live;
+            m_live.pop_back();
+
+            s->live = npos;
+            s->generation = (s->generation + 1) & pool_handle::generation_mask;
+            s->generation += !s->generation;
+            s->next_free = m_free_head;
+            m_free_head = h.index();
+            return true;
+        }
+
+        // null for stale handles
+        T* get(handle h) {
+            slot* s = resolve(h);
+            return s ? reinterpret_cast<T*>(s->storage) : nullptr;
+        }
+        const T* get(handle h) const {
+            const slot* s = resolve(h);
+            return s ? reinterpret_cast<const T*>(s->storage) : nullptr;
+        }
+        bool is_valid(handle h) const {
+            return resolve(h) != nullptr;
+        }
+        T& operator[](handle h) {
+            T* element = get(h);
+            assert(element);
+            return *element;
+        }
+        const T& operator[](handle h) const {
+            const T* element = get(h);
+            assert(element);
+            return *element;
+        }
+
+        // handle of an element in this pool, invalid for anything else; one compare per chunk
+        handle handle_of(const T* element) const {
+            const unsigned char* ptr = reinterpret_cast<const unsigned char*>(element);
+            for (uint32_t chunk = 0; chunk < m_chunks.size(); chunk++) {
+                const unsigned char* base = reinterpret_cast<const unsigned char*>(m_chunks[chunk].get());
+                if (ptr < base || ptr >= base + sizeof(slot) * chunk_size) {
+                    continue;
+                }
+                const size_t offset = ptr - base;
+                const uint32_t idx = chunk * chunk_size + (uint32_t)(offset / sizeof(slot));
+                const slot& s = at(idx);
+                // the storage opens the slot
+                if (offset % sizeof(slot) != 0 || s.live == npos) {
+                    return handle{};
+                }
+                return handle::make(idx, s.generation);
+            }
+            return handle{};
+        }
+
+        iterator begin() noexcept { return iterator(this, 0); }
+        iterator end() noexcept { return iterator(this, (uint32_t)m_live.size()); }
+        const_iterator begin() const noexcept { return const_iterator(this, 0); }
+        const_iterator end() const noexcept { return const_iterator(this, (uint32_t)m_live.size()); }
+
+        uint32_t size() const noexcept { return (uint32_t)m_live.size(); }
+        bool empty() const noexcept { return m_live.empty(); }
+        static constexpr uint32_t capacity() noexcept { return chunk_size * max_chunks; }
+        // slots in the chunks allocated so far
+        uint32_t reserved() const noexcept { return (uint32_t)m_chunks.size() * chunk_size; }
+
+        // erases everything, handles from before stay stale; the chunks are kept
+        void clear() {
+            while (!m_live.empty()) {
+                erase(handle::make(m_live.back(), at(m_live.back()).generation));
+            }
+        }
+
+    private:
+        slot& at(uint32_t idx) { return m_chunks[idx / chunk_size][idx % chunk_size]; }
+        const slot& at(uint32_t idx) const { return m_chunks[idx / chunk_size][idx % chunk_size]; }
+        T* element(uint32_t idx) { return reinterpret_cast<T*>(at(idx).storage); }
+        const T* element(uint32_t idx) const { return reinterpret_cast<const T*>(at(idx).storage); }
+
+        slot* resolve(handle h) {
+            return const_cast<slot*>(static_cast<const generational_pool*>(this)->resolve(h));
+        }
+        const slot* resolve(handle h) const {
+            const uint32_t idx = h.index();
+            if (idx >= m_slots_num) {
+                return nullptr;
+            }
+            const slot& s = at(idx);
+            return (s.live != npos && s.generation == h.generation()) ? &s : nullptr;
+        }
+
+        std::vector<std::unique_ptr<slot[]>> m_chunks;
+        std::vector<uint32_t> m_live;   // slot indices, dense
+        uint32_t m_slots_num{ 0 };      // slots ever used, the rest of the last chunk is untouched
+        uint32_t m_free_head{ npos };
+    };
+}
@@ -0,0 +1,218 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+#include "tlsf_allocator.h"
+
+namespace pro_game_containers {
+    // Places resources in heaps of a fixed size, without touching a device: a pool per kind of heap the backend keeps
+    // apart (heap type, buffers or textures), each a tlsf_allocator whose pages are the heaps. An allocation says
+    // which heap and where in it; a heap index past what the backend has created means it creates that heap now.
+    // Heaps are never given back, an empty one stays for later allocations.
+    // Defragmentation is planned here and carried out by the owner of the memory: plan_defragment picks allocations
+    // from the last heaps that fit into earlier ones and reserves their new place, the owner copies the resource over
+    // and calls complete_move once the gpu is done with the old place, or cancel_move.
+    class gpu_heap_allocator {
+    public:
+        static constexpr uint32_t invalid_heap = ~0u;
+        static constexpr uint64_t small_alignment = 4 * 1024;          // small textures
+        static constexpr uint64_t default_alignment = 64 * 1024;       // buffers and everything else
+
+        struct allocation {
+            uint32_t pool{ 0 };
+            uint32_t heap{ invalid_heap };
+            uint64_t offset{ 0 };           // in the heap
+            uint64_t size{ 0 };             // rounded to small_alignment
+
+            bool valid() const { return heap != invalid_heap; }
+        };
+
+        struct move {
+            allocation from;
+            allocation to;
+            uint64_t tag{ 0 };              // as given to allocate
+        };
+
+        struct stats {
+            uint64_t heap_size{ 0 };
+            uint32_t heaps_num{ 0 };
+            uint32_t empty_heaps_num{ 0 };
+            uint32_t allocations_num{ 0 };
+            uint32_t moves_num{ 0 };        // planned and not completed or cancelled
+            uint32_t failed_num{ 0 };
+            uint64_t used_bytes{ 0 };
+            uint64_t largest_free{ 0 };
+            float fragmentation{ 0.0f };
+        };
+
+        gpu_heap_allocator(uint64_t heap_size, uint32_t max_heaps, uint32_t pools_num) :
+            m_heap_size(heap_size), m_max_heaps(max_heaps)
+        {
+            assert(heap_size % default_alignment == 0 && pools_num);
+            m_pools.resize(pools_num);
+        }
+
+        // alignment is a power of two, 0 for small_alignment; tag is for the owner, plan_defragment hands it back.
+        // An invalid allocation when it is bigger than a heap or the pool has max_heaps full ones
+        allocation allocate(uint32_t pool, uint64_t size, uint64_t alignment = 0, uint64_t tag = 0) {
+            return place(pool, size, alignment, tag, true);
+        }
+
+        void deallocate(const allocation& alloc) {
+            pool_data& pool = m_pools[alloc.pool];
+            const uint64_t offset = global_offset(alloc);
+            const auto it = pool.live.find(offset);
+            if (it == pool.live.end()) {
+                assert(false && "gpu_heap_allocator: not allocated");
+                return;
+            }
+            assert(!it->second.moving && "gpu_heap_allocator: complete or cancel the move first");
+            release(pool, it);
+        }
+
+        // up to max_moves allocations of the pool, taken from the highest heap down, that have room in a lower heap;
+        // their new place is reserved until complete_move or cancel_move
+        std::vector<move> plan_defragment(uint32_t pool_index, uint32_t max_moves) {
+            std::vector<move> moves;
+            pool_data& pool = m_pools[pool_index];
+            if (!pool.storage) {
+                return moves;
+            }
+
+            std::vector<uint64_t> candidates;
+            for (auto it = pool.live.rbegin(); it != pool.live.rend(); ++it) {
+                if (!it->second.moving && it->first >= m_heap_size) {
+                    candidates.push_back(it->first);
+                }
+            }
+            for (uint64_t offset : candidates) {
+                if (moves.size() == max_moves) {
+                    break;
+                }
+                live_allocation& live = pool.live[offset];
+                const allocation to = place(pool_index, live.size, live.alignment, live.tag, false);
+                if (!to.valid()) {
+                    continue;
+                }
+                if (to.heap >= offset / m_heap_size) {
+                    // no better than where it is
+                    release(pool, pool.live.find(global_offset(to)));
+                    continue;
+                }
+
+                live.moving = true;
+                pool.live[global_offset(to)].moving = true;
+                moves.push_back({ to_allocation(pool_index, offset, pool.storage->size_of(offset)), to, live.tag });
+            }
+            pool.moves_num += (uint32_t)moves.size();
+            return moves;
+        }
+
+        // the resource lives at move.to now, the old place is free
+        void complete_move(const move& m) {
+            pool_data& pool = m_pools[m.from.pool];
+            const auto from = pool.live.find(global_offset(m.from));
+            const auto to = pool.live.find(global_offset(m.to));
+            assert(from != pool.live.end() && to != pool.live.end() && from->second.moving && to->second.moving);
+            to->second.moving = false;
+            from->second.moving = false;
+            release(pool, from);
+            pool.moves_num--;
+        }
+
+        // the resource stays where it was
+        void cancel_move(const move& m) {
+            pool_data& pool = m_pools[m.from.pool];
+            const auto from = pool.live.find(global_offset(m.from));
+            const auto to = pool.live.find(global_offset(m.to));
+            assert(from != pool.live.end() && to != pool.live.end() && from->second.moving && to->second.moving);
+            from->second.moving = false;
+            to->second.moving = false;
+            release(pool, to);
+            pool.moves_num--;
+        }
+
+        stats get_stats(uint32_t pool_index) const {
+            const pool_data& pool = m_pools[pool_index];
+            stats res;
+            res.heap_size = m_heap_size;
+            res.failed_num = pool.failed_num;
+            res.moves_num = pool.moves_num;
+            if (!pool.storage) {
+                return res;
+            }
+
+            const tlsf_allocator::stats storage = pool.storage->get_stats();
+            res.heaps_num = storage.pages_num;
+            res.allocations_num = storage.allocations_num;
+            res.used_bytes = storage.used_bytes;
+            res.largest_free = storage.largest_free;
+            res.fragmentation = storage.fragmentation();
+            for (uint64_t used : pool.heap_used) {
+                res.empty_heaps_num += used ? 0 : 1;
+            }
+            return res;
+        }
+
+        uint32_t heaps_num(uint32_t pool_index) const {
+            return m_pools[pool_index].storage ? m_pools[pool_index].storage->pages_num() : 0;
+        }
+        uint32_t pools_num() const { return (uint32_t)m_pools.size(); }
+        uint64_t heap_size() const { return m_heap_size; }
+
+    private:
+        struct live_allocation {
+            uint64_t size{ 0 };
+            uint64_t alignment{ 0 };
+            uint64_t tag{ 0 };
+            bool moving{ false };           // either end of a planned move
+        };
+
+        struct pool_data {
+            std::unique_ptr<tlsf_allocator> storage;        // created with the first allocation
+            std::map<uint64_t, live_allocation> live;       // by offset over all heaps, sorted for plan_defragment
+            std::vector<uint64_t> heap_used;
+            uint32_t moves_num{ 0 };
+            uint32_t failed_num{ 0 };
+        };
+
+        allocation place(uint32_t pool_index, uint64_t size, uint64_t alignment, uint64_t tag, bool grow) {
+            pool_data& pool = m_pools[pool_index];
+            if (!pool.storage) {
+                pool.storage = std::make_unique<tlsf_allocator>(m_heap_size, m_max_heaps, (uint32_t)small_alignment);
+            }
+
+            const uint64_t offset = pool.storage->allocate(size, alignment, grow);
+            if (offset == tlsf_allocator::invalid_offset) {
+                pool.failed_num += grow ? 1 : 0;
+                return allocation{ pool_index };
+            }
+
+            const uint64_t rounded = pool.storage->size_of(offset);
+            pool.live[offset] = { size, alignment, tag, false };
+            pool.heap_used.resize(pool.storage->pages_num());
+            pool.heap_used[offset / m_heap_size] += rounded;
+            return to_allocation(pool_index, offset, rounded);
+        }
+
+        void release(pool_data& pool, std::map<uint64_t, live_allocation>::iterator it) {
+            pool.heap_used[it->first / m_heap_size] -= pool.storage->size_of(it->first);
+            pool.storage->deallocate(it->first);
+            pool.live.erase(it);
+        }
+
+        allocation to_allocation(uint32_t pool_index, uint64_t offset, uint64_t size) const {
+            return { pool_index, uint32_t(offset / m_heap_size), offset % m_heap_size, size };
+        }
+
+        uint64_t global_offset(const allocation& alloc) const {
+            return alloc.heap * m_heap_size + alloc.offset;
+        }
+
+        std::vector<pool_data> m_pools;
+        uint64_t m_heap_size{ 0 };
+        uint32_t m_max_heaps{ 0 };
+    };
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace pro_game_containers {
+    // Linear allocator over a ring of offsets for data the gpu reads once: allocations are bumped from the head, a
+    // frame is closed with finish_frame(fence) and its whole range comes back with retire(completed_fence) once the
+    // gpu is past that fence. Nothing is freed one by one. An allocation never wraps, the tail it skips is retired
+    // with the frame.
+    class ring_allocator {
+        struct frame_mark {
+            uint64_t fence{ 0 };
+            uint64_t allocated{ 0 };    // m_allocated when the frame was closed
+        };
+
+    public:
+        static constexpr uint64_t invalid_offset = ~0ull;
+
+        struct stats {
+            uint64_t capacity{ 0 };
+            uint64_t used_bytes{ 0 };       // in flight, alignment padding and skipped tails included
+            uint64_t high_water{ 0 };       // peak used_bytes
+            uint64_t last_frame_bytes{ 0 }; // of the frame closed last
+            uint32_t last_frame_allocations{ 0 };
+            uint32_t frames_in_flight{ 0 }; // closed and not retired yet
+            uint32_t failed_num{ 0 };       // allocate calls that returned invalid_offset
+        };
+
+        explicit ring_allocator(uint64_t capacity) : m_capacity(capacity) {
+            assert(capacity);
+            m_marks.reserve(8);
+        }
+
+        // alignment is a power of two, 0 for none; invalid_offset when the frames in flight leave no room
+        uint64_t allocate(uint64_t size, uint64_t alignment = 0) {
+            assert(!(alignment & (alignment - 1)));
+            if (m_allocated == m_retired) {
+                m_head = 0;
+            }
+
+            uint64_t offset = alignment ? (m_head + alignment - 1) & ~(alignment - 1) : m_head;
+            if (offset + size > m_capacity) {
+                offset = 0;
+            }
+            // bytes from the head to the end of this allocation, the skipped tail included when it wrapped
+            const uint64_t taken = offset + size - m_head + (offset < m_head ? m_capacity : 0);
+            if (m_allocated - m_retired + taken > m_capacity) {
+                m_failed_num++;
+                return invalid_offset;
+            }
+
+            m_head = offset + size;
+            m_allocated += taken;
+            m_allocations_num++;
+            const uint64_t used = m_allocated - m_retired;
+            m_high_water = used > m_high_water ? used : m_high_water;
+            return offset;
+        }
+
+        // everything allocated since the previous call belongs to the frame signalled with fence
+        void finish_frame(uint64_t fence) {
+            assert(m_marks.empty() || m_marks.back().fence <= fence);
+            m_marks.push_back({ fence, m_allocated });
+            m_last_frame_bytes = m_allocated - m_frame_start;
+            m_last_frame_allocations = m_allocations_num;
+            m_frame_start = m_allocated;
+            m_allocations_num = 0;
+        }
+
+        // frames closed with a fence up to completed_fence are done on the gpu
+        void retire(uint64_t completed_fence) {
+            uint32_t done = 0;
+            while (done < m_marks.size() && m_marks[done].fence <= completed_fence) {
+                m_retired = m_marks[done].allocated;
+                done++;
+            }
+            m_marks.erase(m_marks.begin(), m_marks.begin() + done);
+        }
+
+        stats get_stats() const {
+            stats res;
+            res.capacity = m_capacity;
+            res.used_bytes = m_allocated - m_retired;
+            res.high_water = m_high_water;
+            res.last_frame_bytes = m_last_frame_bytes;
+            res.last_frame_allocations = m_last_frame_allocations;
+            res.frames_in_flight = (uint32_t)m_marks.size();
+            res.failed_num = m_failed_num;
+            return res;
+        }
+
+        uint64_t capacity() const { return m_capacity; }
+
+    private:
+        std::vector<frame_mark> m_marks;
+        uint64_t m_capacity{ 0 };
+        uint64_t m_head{ 0 };
+        uint64_t m_allocated{ 0 };      // running totals, their difference is what is in flight
+        uint64_t m_retired{ 0 };
+        uint64_t m_frame_start{ 0 };
+        uint64_t m_high_water{ 0 };
+        uint64_t m_last_frame_bytes{ 0 };
+        uint32_t m_allocations_num{ 0 };    // since the last finish_frame
+        uint32_t m_last_frame_allocations{ 0 };
+        uint32_t m_failed_num{ 0 };
+    };
+}
@@ -0,0 +1,338 @@
+#pragma once
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace pro_game_containers {
+    // Two level segregated fit allocator over offsets: O(1) allocate and deallocate, an alignment per allocation and
+    // coalescing with free neighbours on every deallocate. The blocks are tracked outside the memory they describe,
+    // so the same allocator hands out ranges of a gpu buffer, a heap or a cpu array.
+    // Space comes in pages of page_size, appended to the offset range when an allocation finds no room, up to
+    // max_pages. A block never spans two pages, a page can be a heap of its own.
+    class tlsf_allocator {
+        static constexpr uint32_t sl_log = 4;                   // second level: 16 linear buckets per power of two
+        static constexpr uint32_t sl_count = 1u << sl_log;
+        static constexpr uint32_t fl_count = 64 - sl_log + 1;   // first level 0 holds the sizes below sl_count units
+        static constexpr uint32_t npos = uint32_t(-1);
+
+        struct block {
+            uint64_t offset{ 0 };
+            uint64_t size{ 0 };
+            uint32_t prev_phys{ npos };     // neighbours in the same page
+            uint32_t next_phys{ npos };
+            uint32_t prev_free{ npos };     // free list of the bucket, or the unused list
+            uint32_t next_free{ npos };
+            bool free{ false };
+        };
+
+    public:
+        static constexpr uint64_t invalid_offset = ~0ull;
+
+        struct stats {
+            uint64_t capacity{ 0 };         // pages allocated so far
+            uint64_t page_size{ 0 };
+            uint64_t used_bytes{ 0 };       // rounded to the granularity, alignment padding is free space
+            uint64_t high_water{ 0 };       // peak used_bytes
+            uint64_t high_offset{ 0 };      // peak end of an allocation, what a copy of the whole range has to cover
+            uint64_t largest_free{ 0 };
+            uint32_t pages_num{ 0 };
+            uint32_t allocations_num{ 0 };
+            uint32_t free_blocks_num{ 0 };
+            uint32_t failed_num{ 0 };       // allocate calls that returned invalid_offset
+
+            // 0 when the largest free block is as big as the free space allows (a page at most), close to 1 when
+            // the free space is all crumbs
+            float fragmentation() const {
+                const uint64_t free_bytes = capacity - used_bytes;
+                const uint64_t best = free_bytes < page_size ? free_bytes : page_size;
+                return best ? 1.0f - float(largest_free) / float(best) : 0.0f;
+            }
+        };
+
+        // page_size is a multiple of granularity, the smallest block and the alignment every offset has
+        tlsf_allocator(uint64_t page_size, uint32_t max_pages = 1, uint32_t granularity = 16) :
+            m_page_size(page_size), m_max_pages(max_pages), m_granularity(granularity)
+        {
+            assert(granularity && !(granularity & (granularity - 1)));
+            assert(page_size && page_size % granularity == 0 && max_pages);
+            for (std::array<uint32_t, sl_count>& heads : m_heads) {
+                heads.fill(npos);
+            }
+            add_page();
+        }
+
+        // alignment is a power of two, 0 for the granularity; invalid_offset when no page can take it, or no page
+        // that is there already when grow is false
+        uint64_t allocate(uint64_t size, uint64_t alignment = 0, bool grow = true) {
+            alignment = alignment > m_granularity ? alignment : m_granularity;
+            assert(!(alignment & (alignment - 1)));
+            size = align_up(size ? size : 1, m_granularity);
+            // a block this big has room for the size wherever the aligned offset falls
+            const uint64_t search_size = size + alignment - m_granularity;
+
+            uint32_t idx = find_free(search_size);
+            while (idx == npos && grow && m_pages_num < m_max_pages && search_size <= m_page_size) {
+                add_page();
+                idx = find_free(search_size);
+            }
+            if (idx == npos) {
+                m_stats.failed_num++;
+                return invalid_offset;
+            }
+            remove_free(idx);
+
+            const uint64_t aligned = align_up(m_blocks[idx].offset, alignment);
+            if (const uint64_t padding = aligned - m_blocks[idx].offset) {
+                // the padding stays free in front, its neighbour before is in use or it would have merged already
+                const uint32_t front = new_block(m_blocks[idx].offset, padding);
+                link_before(front, idx);
+                m_blocks[idx].offset = aligned;
+                m_blocks[idx].size -= padding;
+                insert_free(front);
+            }
+            if (const uint64_t rest = m_blocks[idx].size - size) {
+                const uint32_t tail = new_block(aligned + size, rest);
+                link_after(tail, idx);
+                m_blocks[idx].size = size;
+                insert_free(tail);
+            }
+
+            m_used.emplace(aligned, idx);
+            m_stats.used_bytes += size;
+            m_stats.allocations_num++;
+            m_stats.high_water = m_stats.used_bytes > m_stats.high_water ? m_stats.used_bytes : m_stats.high_water;
+            m_stats.high_offset = aligned + size > m_stats.high_offset ? aligned + size : m_stats.high_offset;
+            return aligned;
+        }
+
+        // offset as returned by allocate
+        void deallocate(uint64_t offset) {
+            const auto it = m_used.find(offset);
+            if (it == m_used.end()) {
+                assert(false && "tlsf_allocator: offset is not allocated");
+                return;
+            }
+            uint32_t idx = it->second;
+            m_used.erase(it);
+            m_stats.used_bytes -= m_blocks[idx].size;
+            m_stats.allocations_num--;
+
+            const uint32_t prev = m_blocks[idx].prev_phys;
+            if (prev != npos && m_blocks[prev].free) {
+                remove_free(prev);
+                m_blocks[prev].size += m_blocks[idx].size;
+                unlink(idx);
+                idx = prev;
+            }
+            const uint32_t next = m_blocks[idx].next_phys;
+            if (next != npos && m_blocks[next].free) {
+                remove_free(next);
+                m_blocks[idx].size += m_blocks[next].size;
+                unlink(next);
+            }
+            insert_free(idx);
+        }
+
+        // allocated size, rounded to the granularity; 0 for offsets not allocated
+        uint64_t size_of(uint64_t offset) const {
+            const auto it = m_used.find(offset);
+            return it != m_used.end() ? m_blocks[it->second].size : 0;
+        }
+
+        // largest_free walks the bucket list of the largest class, the rest is kept on the way
+        stats get_stats() const {
+            stats result = m_stats;
+            result.capacity = capacity();
+            result.page_size = m_page_size;
+            result.pages_num = m_pages_num;
+            result.free_blocks_num = m_free_blocks_num;
+            if (m_fl_bitmap) {
+                const uint32_t fl = 63 - clz64(m_fl_bitmap);
+                const uint32_t sl = 31 - clz32(m_sl_bitmap[fl]);
+                for (uint32_t idx = m_heads[fl][sl]; idx != npos; idx = m_blocks[idx].next_free) {
+                    result.largest_free = m_blocks[idx].size > result.largest_free ? m_blocks[idx].size : result.largest_free;
+                }
+            }
+            return result;
+        }
+
+        uint64_t capacity() const { return m_page_size * m_pages_num; }
+        uint64_t page_size() const { return m_page_size; }
+        uint32_t pages_num() const { return m_pages_num; }
+        uint32_t granularity() const { return m_granularity; }
+
+    private:
+        static uint64_t align_up(uint64_t value, uint64_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+#ifdef _MSC_VER
+        static uint32_t clz64(uint64_t value) { unsigned long bit; _BitScanReverse64(&bit, value); return 63 - bit; }
+        static uint32_t clz32(uint32_t value) { unsigned long bit; _BitScanReverse(&bit, value); return 31 - bit; }
+        static uint32_t ctz64(uint64_t value) { unsigned long bit; _BitScanForward64(&bit, value); return bit; }
+        static uint32_t ctz32(uint32_t value) { unsigned long bit; _BitScanForward(&bit, value); return bit; }
+#else
+        static uint32_t clz64(uint64_t value) { return __builtin_clzll(value); }
+        static uint32_t clz32(uint32_t value) { return __builtin_clz(value); }
+        static uint32_t ctz64(uint64_t value) { return __builtin_ctzll(value); }
+        static uint32_t ctz32(uint32_t value) { return __builtin_ctz(value); }
+#endif
+
+        // bucket of a free block: its size is at least the bucket's lower bound
+        static void mapping_insert(uint64_t units, uint32_t& fl, uint32_t& sl) {
+            if (units < sl_count) {
+                fl = 0;
+                sl = (uint32_t)units;
+                return;
+            }
+            const uint32_t msb = 63 - clz64(units);
+            fl = msb - sl_log + 1;
+            sl = (uint32_t)(units >> (msb - sl_log)) - sl_count;
+        }
+
+        // first bucket where any block fits units: the size rounded up to the next bucket bound
+        static bool mapping_search(uint64_t units, uint32_t& fl, uint32_t& sl) {
+            if (units >= sl_count) {
+                const uint64_t round = (1ull << (63 - clz64(units) - sl_log)) - 1;
+                if (units > ~0ull - round) {
+                    return false;
+                }
+                units += round;
+            }
+            mapping_insert(units, fl, sl);
+            return true;
+        }
+
+        uint32_t find_free(uint64_t size) const {
+            uint32_t fl = 0;
+            uint32_t sl = 0;
+            if (!mapping_search(size / m_granularity, fl, sl)) {
+                return npos;
+            }
+            uint32_t sl_map = m_sl_bitmap[fl] & (~0u << sl);
+            if (!sl_map) {
+                const uint64_t fl_map = fl + 1 < fl_count ? m_fl_bitmap & (~0ull << (fl + 1)) : 0;
+                if (!fl_map) {
+                    return npos;
+                }
+                fl = ctz64(fl_map);
+                sl_map = m_sl_bitmap[fl];
+            }
+            return m_heads[fl][ctz32(sl_map)];
+        }
+
+        void insert_free(uint32_t idx) {
+            uint32_t fl = 0;
+            uint32_t sl = 0;
+            mapping_insert(m_blocks[idx].size / m_granularity, fl, sl);
+            block& b = m_blocks[idx];
+            b.free = true;
+            b.prev_free = npos;
+            b.next_free = m_heads[fl][sl];
+            if (b.next_free != npos) {
+                m_blocks[b.next_free].prev_free = idx;
+            }
+            m_heads[fl][sl] = idx;
+            m_fl_bitmap |= 1ull << fl;
+            m_sl_bitmap[fl] |= 1u << sl;
+            m_free_blocks_num++;
+        }
+
+        void remove_free(uint32_t idx) {
+            uint32_t fl = 0;
+            uint32_t sl = 0;
+            mapping_insert(m_blocks[idx].size / m_granularity, fl, sl);
+            block& b = m_blocks[idx];
+            if (b.prev_free != npos) {
+                m_blocks[b.prev_free].next_free = b.next_free;
+            }
+            else {
+                m_heads[fl][sl] = b.next_free;
+                if (b.next_free == npos) {
+                    m_sl_bitmap[fl] &= ~(1u << sl);
+                    if (!m_sl_bitmap[fl]) {
+                        m_fl_bitmap &= ~(1ull << fl);
+                    }
+                }
+            }
+            if (b.next_free != npos) {
+                m_blocks[b.next_free].prev_free = b.prev_free;
+            }
+            b.free = false;
+            b.prev_free = b.next_free = npos;
+            m_free_blocks_num--;
+        }
+
+        uint32_t new_block(uint64_t offset, uint64_t size) {
+            uint32_t idx = m_unused_head;
+            if (idx != npos) {
+                m_unused_head = m_blocks[idx].next_free;
+                m_blocks[idx] = block{};
+            }
+            else {
+                idx = (uint32_t)m_blocks.size();
+                m_blocks.emplace_back();
+            }
+            m_blocks[idx].offset = offset;
+            m_blocks[idx].size = size;
+            return idx;
+        }
+
+        void link_before(uint32_t idx, uint32_t next) {
+            block& b = m_blocks[idx];
+            b.next_phys = next;
+            b.prev_phys = m_blocks[next].prev_phys;
+            if (b.prev_phys != npos) {
+                m_blocks[b.prev_phys].next_phys = idx;
+            }
+            m_blocks[next].prev_phys = idx;
+        }
+
+        void link_after(uint32_t idx, uint32_t prev) {
+            block& b = m_blocks[idx];
+            b.prev_phys = prev;
+            b.next_phys = m_blocks[prev].next_phys;
+            if (b.next_phys != npos) {
+                m_blocks[b.next_phys].prev_phys = idx;
+            }
+            m_blocks[prev].next_phys = idx;
+        }
+
+        // takes the block out of its page, its bytes already belong to a neighbour
+        void unlink(uint32_t idx) {
+            block& b = m_blocks[idx];
+            if (b.prev_phys != npos) {
+                m_blocks[b.prev_phys].next_phys = b.next_phys;
+            }
+            if (b.next_phys != npos) {
+                m_blocks[b.next_phys].prev_phys = b.prev_phys;
+            }
+            b = block{};
+            b.next_free = m_unused_head;
+            m_unused_head = idx;
+        }
+
+        void add_page() {
+            insert_free(new_block(m_page_size * m_pages_num, m_page_size));
+            m_pages_num++;
+        }
+
+        uint64_t m_page_size;
+        uint32_t m_max_pages;
+        uint32_t m_granularity;
+        uint32_t m_pages_num{ 0 };
+
+        std::vector<block> m_blocks;
+        uint32_t m_unused_head{ npos };
+        std::unordered_map<uint64_t, uint32_t> m_used;  // offset, block
+
+        uint64_t m_fl_bitmap{ 0 };
+        std::array<uint32_t, fl_count> m_sl_bitmap{};
+        std::array<std::array<uint32_t, sl_count>, fl_count> m_heads;
+        uint32_t m_free_blocks_num{ 0 };
+        stats m_stats;
+    };
+}
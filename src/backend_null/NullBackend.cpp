@@ -0,0 +1,166 @@
+#include "NullBackend.h"
+#include "defines.h"
+#include "Logger.h"
+#include "NullFence.h"
+#include "NullCommandQueue.h"
+#include "NullGpuResource.h"
+#include "NullTechniques.h"
+#include "NullImguiHelper.h"
+#include "ICommandList.h"
+#include "StartupProfiler.h"
+#include "FrameArena.h"
+
+#include <cassert>
+
+NullBackend* gBackend = nullptr;
+
+IBackend* CreateBackend() {
+	assert(!gBackend);
+
+	gBackend = new NullBackend;
+	return (IBackend *)gBackend;
+}
+
+void DestroyBackend() {
+	assert(gBackend);
+	delete gBackend;
+	gBackend = nullptr;
+}
+
+NullBackendStats& NullBackendStats::operator+=(const NullBackendStats& other)
+{
+	draw_calls += other.draw_calls;
+	indices += other.indices;
+	vertices += other.vertices;
+	dispatches += other.dispatches;
+	barriers += other.barriers;
+	root_cbv_binds += other.root_cbv_binds;
+	root_srv_binds += other.root_srv_binds;
+	descriptor_tables += other.descriptor_tables;
+	descriptors_staged += other.descriptors_staged;
+	render_target_sets += other.render_target_sets;
+	clears += other.clears;
+	pso_changes += other.pso_changes;
+	root_sign_changes += other.root_sign_changes;
+	command_lists_executed += other.command_lists_executed;
+	buffer_upload_bytes += other.buffer_upload_bytes;
+	buffer_copies += other.buffer_copies;
+	buffer_copy_bytes += other.buffer_copy_bytes;
+	texture_upload_bytes += other.texture_upload_bytes;
+	resources_created += other.resources_created;
+	resource_bytes_created += other.resource_bytes_created;
+
+	return *this;
+}
+
+void NullBackend::OnInit(const WindowHandler& window_hndl, uint32_t width, uint32_t height, const std::filesystem::path& path)
+{
+	StartupProfiler& profiler = StartupProfiler::Get();
+
+	// Queues
+	uint32_t phase = profiler.Begin("queues", nullptr);
+	m_commandQueueGfx.reset(new NullCommandQueue);
+	m_commandQueueCompute.reset(new NullCommandQueue);
+	m_commandQueueGfx->OnInit(ICommandQueue::QueueType::qt_gfx, GfxQueueCmdList_num, L"Gfx");
+	m_commandQueueCompute->OnInit(ICommandQueue::QueueType::qt_compute, ComputeQueueCmdList_num, L"Compute");
+
+	profiler.End(phase);
+
+	// SwapChain replacement
+	phase = profiler.Begin("back buffers", nullptr);
+	for (uint32_t i = 0; i < FramesCount; i++) {
+		m_back_buffers[i].reset(CreateGpuResource());
+		ResourceDesc desc = ResourceDesc::tex_2d(ResourceFormat::rf_r8g8b8a8_unorm, width, height, 1, 1, 1, 0, ResourceDesc::ResourceFlags::rf_allow_render_target);
+		m_back_buffers[i]->CreateTexture(HeapType::ht_default, desc, ResourceState::rs_resource_state_present, nullptr, L"back_buffer");
+		m_back_buffers[i]->CreateRTV();
+	}
+	{
+		m_depth_buffer.reset(CreateGpuResource());
+		ResourceDesc desc = ResourceDesc::tex_2d(ResourceFormat::rf_r32_typeless, width, height, 1, 1, 1, 0, ResourceDesc::ResourceFlags::rf_allow_depth_stencil);
+		m_depth_buffer->CreateTexture(HeapType::ht_default, desc, ResourceState::rs_resource_state_depth_write, nullptr, L"depth_buffer");
+		DSVdesc dsv_desc = {};
+		dsv_desc.format = ResourceFormat::rf_d32_float;
+		dsv_desc.dimension = DSVdesc::DSVdimensionType::dsv_dt_texture2d;
+		m_depth_buffer->Create_DSV(dsv_desc);
+		SRVdesc srv_desc = {};
+		srv_desc.format = ResourceFormat::rf_r32_float;
+		srv_desc.dimension = SRVdesc::SRVdimensionType::srv_dt_texture2d;
+		m_depth_buffer->Create_SRV(srv_desc);
+	}
+
+	profiler.End(phase);
+
+	// Misc
+	m_viewport = ViewPort(0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height));
+	m_scissorRect = RectScissors(0, 0, width, height);
+
+	m_logger.reset(new logger("app.log", logger::log_level::ll_INFO));
+
+	phase = profiler.Begin("techniques", nullptr);
+	m_techniques.reset(new NullTechniques);
+	m_techniques->OnInit();
+	profiler.End(phase);
+
+	m_gui.reset(new NullImguiHelper);
+	m_gui->Initialize(FramesCount);
+
+	m_fence_inter_queue.reset(new NullFence);
+	m_fence_inter_queue->Initialize(m_fence_inter_queue_val);
+}
+
+void NullBackend::Present()
+{
+	// Signal for this frame
+	m_fenceValues[m_frameIndex] = m_commandQueueGfx->Signal();
+	m_presented_fence = m_fenceValues[m_frameIndex];
+
+	m_last_frame_stats = m_frame_stats;
+	m_total_stats += m_frame_stats;
+	m_frame_stats = NullBackendStats();
+	m_presented_frames++;
+
+	// get next frame
+	m_frameIndex = (m_frameIndex + 1) % FramesCount;
+}
+
+void NullBackend::SyncWithCPU()
+{
+	m_commandQueueGfx->WaitOnCPU(m_fenceValues[m_frameIndex]);
+	m_completed_fence = m_fenceValues[m_frameIndex];
+	FrameArena::NextFrame();
+}
+
+void NullBackend::SyncWithGpu(ICommandQueue::QueueType from, ICommandQueue::QueueType to)
+{
+	auto get_queue = [this](ICommandQueue::QueueType type) {
+		std::shared_ptr<ICommandQueue>& from_queue = (type == ICommandQueue::QueueType::qt_gfx ? m_commandQueueGfx : m_commandQueueCompute);
+		return from_queue;
+	};
+	get_queue(from)->Signal(m_fence_inter_queue, ++m_fence_inter_queue_val);
+	get_queue(to)->WaitOnGPU(m_fence_inter_queue, m_fence_inter_queue_val);
+}
+
+ICommandList* NullBackend::InitCmdList()
+{
+	ICommandList* command_list_gfx = m_commandQueueGfx->ResetActiveCL();
+	command_list_gfx->RSSetViewports(1, &m_viewport);
+	command_list_gfx->RSSetScissorRects(1, &m_scissorRect);
+
+	return command_list_gfx;
+}
+
+const ITechniques::Technique* NullBackend::GetTechniqueById(uint32_t id) const
+{
+	return m_techniques->GetTechniqueById(id);
+}
+
+const IRootSignature* NullBackend::GetRootSignById(uint32_t id)
+{
+	return m_techniques->GetRootSignById(id);
+}
+
+NullBackend::~NullBackend()
+{
+	m_gui->Destroy();
+	m_commandQueueGfx->OnDestroy();
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "IBackend.h"
+#include "ICommandQueue.h"
+#include "defines.h"
+#include "IFence.h"
+
+#include <memory>
+#include <array>
+
+class IGpuResource;
+struct WindowHandler;
+class logger;
+class IImguiHelper;
+
+// counters recorded instead of talking to a device
+struct NullBackendStats {
+	uint64_t draw_calls{ 0 };
+	uint64_t indices{ 0 };
+	uint64_t vertices{ 0 };
+	uint64_t dispatches{ 0 };
+	uint64_t barriers{ 0 };
+	uint64_t root_cbv_binds{ 0 };
+	uint64_t root_srv_binds{ 0 };
+	uint64_t descriptor_tables{ 0 };
+	uint64_t descriptors_staged{ 0 };
+	uint64_t render_target_sets{ 0 };
+	uint64_t clears{ 0 };
+	uint64_t pso_changes{ 0 };
+	uint64_t root_sign_changes{ 0 };
+	uint64_t command_lists_executed{ 0 };
+	uint64_t buffer_upload_bytes{ 0 };
+	uint64_t buffer_copies{ 0 };
+	uint64_t buffer_copy_bytes{ 0 };
+	uint64_t texture_upload_bytes{ 0 };
+	uint64_t resources_created{ 0 };
+	uint64_t resource_bytes_created{ 0 };
+
+	NullBackendStats& operator+=(const NullBackendStats& other);
+};
+
+class NullBackend : public IBackend {
+public:
+	NullBackend() = default;
+	void OnInit(const WindowHandler& window_hndl, uint32_t width, uint32_t height, const std::filesystem::path& path) override;
+	uint32_t GetCurrentBackBufferIndex() const override { return m_frameIndex; }
+	IGpuResource& GetCurrentBackBuffer() override { return *m_back_buffers[m_frameIndex]; }
+	IGpuResource* GetDepthBuffer() override { return m_depth_buffer.get(); }
+	void Present() override;
+	void OnResizeWindow() override {}
+	std::shared_ptr<ICommandQueue>& GetQueue(ICommandQueue::QueueType type) override {
+		return (type == ICommandQueue::QueueType::qt_gfx ? m_commandQueueGfx : m_commandQueueCompute);
+	}
+	logger* GetLogger() override { return m_logger.get(); }
+	void SyncWithCPU() override;
+	void SyncWithGpu(ICommandQueue::QueueType from, ICommandQueue::QueueType to) override;
+	ICommandList* InitCmdList() override;
+	void ChechUpdatedShader() override {}
+	void RenderUI() override {}
+	void DebugSectionBegin(ICommandList* cmd_list, const std::string& name) override {}
+	void DebugSectionEnd(ICommandList* cmd_list) override {}
+	const ITechniques::Technique* GetTechniqueById(uint32_t id) const override;
+	const IRootSignature* GetRootSignById(uint32_t id) override;
+	uint32_t GetRenderMode() const override { return 0; }
+	uint32_t GetFrameCount() const override { return FramesCount; }
+	uint64_t GetPresentedFence() const override { return m_presented_fence; }
+	uint64_t GetCompletedFence() const override { return m_completed_fence; }
+	IImguiHelper* GetUI() override { return m_gui.get(); }
+	bool PassImguiWndProc(const ImguiWindowData& data) override { return false; }
+	bool ShouldClose() override { return false; }
+
+	// stats of the frame being recorded, folded into totals on Present
+	NullBackendStats& GetStats() { return m_frame_stats; }
+	const NullBackendStats& GetLastFrameStats() const { return m_last_frame_stats; }
+	const NullBackendStats& GetTotalStats() const { return m_total_stats; }
+	uint64_t GetPresentedFrames() const { return m_presented_frames; }
+	virtual ~NullBackend();
+private:
+	static const uint32_t FramesCount = 2;
+	static constexpr uint32_t GfxQueueCmdList_num = 6;
+	static constexpr uint32_t ComputeQueueCmdList_num = 6;
+
+	std::shared_ptr<ICommandQueue> m_commandQueueGfx;
+	std::shared_ptr<ICommandQueue> m_commandQueueCompute;
+	std::array<std::unique_ptr<IGpuResource>, FramesCount> m_back_buffers;
+	std::unique_ptr<IGpuResource> m_depth_buffer;
+
+	ViewPort m_viewport;
+	RectScissors m_scissorRect;
+
+	std::unique_ptr<logger> m_logger;
+	std::unique_ptr<IImguiHelper> m_gui;
+	std::unique_ptr<ITechniques> m_techniques;
+
+	std::unique_ptr<IFence> m_fence_inter_queue;
+	uint32_t m_fence_inter_queue_val{ 0 };
+
+	uint32_t m_frameIndex{ 0 };
+	uint32_t m_fenceValues[FramesCount]{ 0 };
+	uint64_t m_presented_fence{ 0 };
+	uint64_t m_completed_fence{ 0 };
+
+	NullBackendStats m_frame_stats;
+	NullBackendStats m_last_frame_stats;
+	NullBackendStats m_total_stats;
+	uint64_t m_presented_frames{ 0 };
+};
@@ -0,0 +1,108 @@
+#include "NullCommandList.h"
+#include "defines.h"
+#include "IGpuResource.h"
+#include "NullBackend.h"
+
+#include <cassert>
+
+extern NullBackend* gBackend;
+
+void NullCommandList::Reset()
+{
+    m_pso = uint32_t(-1);
+    m_root_sign = uint32_t(-1);
+}
+
+void NullCommandList::SetGraphicsRootDescriptorTable(uint32_t root_parameter_index, GPUdescriptor base_descriptor)
+{
+    gBackend->GetStats().descriptor_tables++;
+}
+
+void NullCommandList::SetComputeRootDescriptorTable(uint32_t root_parameter_index, GPUdescriptor base_descriptor)
+{
+    gBackend->GetStats().descriptor_tables++;
+}
+
+void NullCommandList::SetGraphicsRootConstantBufferView(uint32_t root_parameter_index, const std::shared_ptr<IHeapBuffer>& buff, uint64_t offset)
+{
+    gBackend->GetStats().root_cbv_binds++;
+}
+
+void NullCommandList::SetComputeRootConstantBufferView(uint32_t root_parameter_index, const std::shared_ptr<IHeapBuffer>& buff, uint64_t offset)
+{
+    gBackend->GetStats().root_cbv_binds++;
+}
+
+void NullCommandList::DrawInstanced(uint32_t vertex_per_instance, uint32_t instance_count, uint32_t start_vertex_location, uint32_t start_instance_location)
+{
+    NullBackendStats& stats = gBackend->GetStats();
+    stats.draw_calls++;
+    stats.vertices += (uint64_t)vertex_per_instance * instance_count;
+}
+
+void NullCommandList::DrawIndexedInstanced(uint32_t index_count_per_instance, uint32_t instance_count, uint32_t start_index_location, int32_t base_vertex_location, uint32_t start_instance_location)
+{
+    NullBackendStats& stats = gBackend->GetStats();
+    stats.draw_calls++;
+    stats.indices += (uint64_t)index_count_per_instance * instance_count;
+}
+
+void NullCommandList::SetRenderTargets(uint32_t num_rts, IGpuResource* const* resources, IGpuResource* depth_stencil_descriptor)
+{
+    assert(num_rts <= MAX_RTS_NUM);
+    gBackend->GetStats().render_target_sets++;
+}
+
+void NullCommandList::ClearRenderTargetView(IGpuResource* res, const float color[4], uint32_t num_rects, const RectScissors* rect)
+{
+    gBackend->GetStats().clears++;
+}
+
+void NullCommandList::ClearDepthStencilView(IGpuResource* res, ClearFlagsDsv clear_flags, float depth, uint8_t stencil, uint32_t num_rects, const RectScissors* rects)
+{
+    gBackend->GetStats().clears++;
+}
+
+void NullCommandList::Dispatch(uint32_t thread_group_count_x, uint32_t thread_group_count_y, uint32_t thread_group_count_z)
+{
+    gBackend->GetStats().dispatches++;
+}
+
+void NullCommandList::SetGraphicsRootShaderResourceView(uint32_t root_parameter_index, const std::shared_ptr<IHeapBuffer>& buff)
+{
+    gBackend->GetStats().root_srv_binds++;
+}
+
+void NullCommandList::CopyBufferRegion(const std::shared_ptr<IHeapBuffer>& dst, uint64_t dst_offset, const std::shared_ptr<IHeapBuffer>& src, uint64_t src_offset, uint64_t size)
+{
+    NullBackendStats& stats = gBackend->GetStats();
+    stats.buffer_copies++;
+    stats.buffer_copy_bytes += size;
+}
+
+void NullCommandList::ResourceBarrier(std::shared_ptr<IGpuResource>& res, uint32_t to) {
+    ResourceBarrier(*res, to);
+}
+
+void NullCommandList::ResourceBarrier(IGpuResource& res, uint32_t to) {
+    if (res.GetState() != (ResourceState)to) {
+        res.UpdateState((ResourceState)to);
+        gBackend->GetStats().barriers++;
+    }
+}
+
+void NullCommandList::ResourceBarrier(std::vector<std::shared_ptr<IGpuResource>>& res, uint32_t to) {
+    for (auto& gpu_res : res) {
+        ResourceBarrier(*gpu_res, to);
+    }
+}
+
+void NullCommandList::SetPSO(uint32_t id) {
+    m_pso = id;
+    gBackend->GetStats().pso_changes++;
+}
+
+void NullCommandList::SetRootSign(uint32_t id, bool gfx) {
+    m_root_sign = id;
+    gBackend->GetStats().root_sign_changes++;
+}
@@ -0,0 +1,87 @@
+#include "NullCommandQueue.h"
+#include "NullDynamicGpuHeap.h"
+#include "NullCommandList.h"
+#include "NullFence.h"
+#include "NullBackend.h"
+
+#include <cassert>
+
+extern NullBackend* gBackend;
+
+#define GetFence(fence) ((NullFence*)fence.get())
+
+void NullCommandQueue::Flush()
+{
+    const uint32_t fence_value = Signal();
+    WaitOnCPU(fence_value);
+}
+
+uint32_t NullCommandQueue::Signal(){
+    uint32_t fenceValueForSignal = ++m_fence_value;
+    // nothing is in flight, so the fence completes right away
+    GetFence(m_fence)->Signal(fenceValueForSignal);
+
+    return fenceValueForSignal;
+}
+
+void NullCommandQueue::Signal(std::unique_ptr<IFence> &fence, uint32_t fence_value)
+{
+    GetFence(fence)->Signal(fence_value);
+}
+
+void NullCommandQueue::WaitOnCPU(uint32_t fence_value){
+    assert(GetFence(m_fence)->GetCompletedValue() >= fence_value);
+}
+
+uint32_t NullCommandQueue::GetCompletedValue() const
+{
+    return ((NullFence*)m_fence.get())->GetCompletedValue();
+}
+
+void NullCommandQueue::OnInit(QueueType type, uint32_t command_list_num, std::optional<std::wstring> dbg_name) {
+    NullCommandList* cmd_list = new NullCommandList;
+
+    assert(command_list_num <= m_dynamic_gpu_heaps.size());
+    m_command_list_num = command_list_num;
+    m_type = type;
+    cmd_list->m_queue = this;
+    cmd_list->m_type = (type == QueueType::qt_gfx ? CommandListType::clt_direct : CommandListType::clt_compute);
+
+    // allocate
+    for (uint32_t i = 0; i < 6; i++) {
+        m_dynamic_gpu_heaps[i].reset(new NullDynamicGpuHeap);
+    }
+
+    m_fence.reset(new NullFence);
+    m_fence->Initialize(m_fence_value);
+
+    for (uint32_t id = 0; id < m_command_list_num; id++) {
+        m_dynamic_gpu_heaps[id]->Initialize(id);
+    }
+
+    m_command_list.reset(cmd_list);
+}
+
+ICommandList* NullCommandQueue::ResetActiveCL() {
+    m_active_cl = (m_active_cl + 1) % m_command_list_num;
+
+    // set gpu heap
+    m_command_list->SetDescriptorHeap(m_dynamic_gpu_heaps[m_active_cl].get());
+    m_dynamic_gpu_heaps[m_active_cl]->Reset();
+    m_command_list->Reset();
+
+    return m_command_list.get();
+}
+
+ICommandList* NullCommandQueue::GetActiveCL() {
+    return m_command_list.get();
+}
+
+void NullCommandQueue::ExecuteActiveCL() {
+    gBackend->GetStats().command_lists_executed++;
+}
+
+IDynamicGpuHeap& NullCommandQueue::GetGpuHeap()
+{
+    return *m_dynamic_gpu_heaps[m_active_cl];
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include "ICommandList.h"
+#include "ICommandQueue.h"
+#include "IDynamicGpuHeap.h"
+#include "IFence.h"
+
+class NullCommandQueue : public ICommandQueue {
+public:
+    void OnInit(QueueType type, uint32_t command_list_num, std::optional<std::wstring> dbg_name = std::nullopt) override;
+    void OnDestroy() override { Flush(); }
+    uint32_t Signal() override;
+    void Signal(std::unique_ptr<IFence>& fence, uint32_t fence_value) override;
+    void WaitOnCPU(uint32_t fence_value) override;
+    void WaitOnGPU(std::unique_ptr<IFence>& fence, uint32_t fence_value) override {}
+    void Flush() override;
+
+    ICommandList* ResetActiveCL() override;
+    ICommandList* GetActiveCL() override;
+    void ExecuteActiveCL() override;
+
+    IDynamicGpuHeap& GetGpuHeap() override;
+
+    uint32_t GetCompletedValue() const;
+    virtual ~NullCommandQueue() = default;
+protected:
+    uint32_t m_fence_value{0};
+    uint32_t m_active_cl{0};
+    std::unique_ptr<IFence> m_fence;
+
+    QueueType m_type;
+
+    uint32_t m_command_list_num{ 0 };
+    std::array<std::unique_ptr<IDynamicGpuHeap>, 6> m_dynamic_gpu_heaps;
+    std::unique_ptr<ICommandList> m_command_list;
+};
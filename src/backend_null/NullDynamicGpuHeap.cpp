@@ -0,0 +1,41 @@
+#include "NullDynamicGpuHeap.h"
+#include "ICommandList.h"
+#include "NullBackend.h"
+
+#include <cassert>
+
+extern NullBackend* gBackend;
+
+void NullDynamicGpuHeap::CacheRootSignature(const IRootSignature* root_sig) {
+    m_tables_mask = 0;
+}
+
+void NullDynamicGpuHeap::StageDesctriptorInTable(uint32_t root_id, uint32_t offset, const std::shared_ptr<IResourceDescriptor>& desc_handle)
+{
+    assert(root_id < MaxTableSize);
+    m_tables_mask |= (1ull << root_id);
+    gBackend->GetStats().descriptors_staged++;
+}
+
+void NullDynamicGpuHeap::ReserveDescriptor(CPUdescriptor& cpu_descriptor, GPUdescriptor& gpu_descriptor)
+{
+    assert(m_actual_heap_size < HeapSize);
+    cpu_descriptor.ptr = m_actual_heap_size;
+    gpu_descriptor.ptr = m_actual_heap_size;
+
+    m_actual_heap_size++;
+}
+
+void NullDynamicGpuHeap::CommitRootSignature(ICommandList* command_list, bool gfx) {
+    for (uint32_t root_id = 0; root_id < MaxTableSize; root_id++) {
+        if (m_tables_mask & (1ull << root_id)) {
+            GPUdescriptor handle{ root_id };
+            if (gfx) {
+                command_list->SetGraphicsRootDescriptorTable(root_id, handle);
+            }
+            else {
+                command_list->SetComputeRootDescriptorTable(root_id, handle);
+            }
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "IDynamicGpuHeap.h"
+#include <cstdint>
+
+class IRootSignature;
+class ICommandList;
+class IResourceDescriptor;
+
+class NullDynamicGpuHeap : public IDynamicGpuHeap {
+public:
+    void Initialize(uint32_t frame_id) override { m_frame_id = frame_id; }
+    void CacheRootSignature(const IRootSignature* root_sig) override;
+    void StageDesctriptorInTable(uint32_t root_id, uint32_t offset, const std::shared_ptr<IResourceDescriptor>& desc_handle) override;
+    void ReserveDescriptor(CPUdescriptor& cpu_descriptor, GPUdescriptor& gpu_descriptor) override;
+    void CommitRootSignature(ICommandList* command_list, bool gfx = true) override;
+    void Reset() override {
+        m_actual_heap_size = 0;
+        m_tables_mask = 0;
+    }
+private:
+    static const uint32_t HeapSize = 128;
+    static const uint32_t MaxTableSize = 32;
+
+    uint64_t m_tables_mask{0};
+    uint32_t m_actual_heap_size{ 0 };
+    uint32_t m_frame_id{ 0 };
+};
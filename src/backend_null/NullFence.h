@@ -0,0 +1,12 @@
+#pragma once
+
+#include "IFence.h"
+
+class NullFence : public IFence {
+public:
+	void Initialize(uint32_t val) override { m_value = val; }
+	void Signal(uint32_t val) { m_value = val; }
+	uint32_t GetCompletedValue() const { return m_value; }
+private:
+	uint32_t m_value{ 0 };
+};
@@ -0,0 +1,75 @@
+#include "NullGpuResource.h"
+#include "NullResourceDescriptor.h"
+#include "NullHeapBuffer.h"
+#include "ICommandList.h"
+
+IGpuResource* CreateGpuResource() {
+    return new NullGpuResource;
+}
+
+void NullGpuResource::CreateBuffer(HeapType type, uint32_t bufferSize, ResourceState initial_state, std::optional<std::wstring> dbg_name){
+    if (m_buffer){
+        ResetViews();
+    }
+    m_buffer = std::make_shared<NullHeapBuffer>();
+    m_buffer->Create(type, bufferSize, initial_state, dbg_name);
+    m_current_state = initial_state;
+}
+
+void NullGpuResource::CreateTexture(HeapType type, const ResourceDesc &res_desc, ResourceState initial_state, const ClearColor *clear_val, std::optional<std::wstring> dbg_name){
+    if (m_buffer){
+        ResetViews();
+    }
+    m_buffer = std::make_shared<NullHeapBuffer>();
+    m_buffer->CreateTexture(type, res_desc, initial_state, clear_val, dbg_name);
+    m_current_state = initial_state;
+}
+
+void NullGpuResource::LoadBuffer(ICommandList* command_list, uint32_t numElements, uint32_t elementSize, const void* bufferData){
+    m_buffer->Load(command_list, numElements, elementSize, bufferData);
+}
+
+void NullGpuResource::LoadBuffer(ICommandList* command_list, uint32_t firstSubresource, uint32_t numSubresources, SubresourceData* subresourceData){
+    m_buffer->Load(command_list, firstSubresource, numSubresources, subresourceData);
+}
+
+void NullGpuResource::CreateRTV(){
+    m_rtv = std::make_shared<NullResourceDescriptor>();
+    m_rtv->Create_RTV(m_buffer);
+}
+
+void NullGpuResource::Create_DSV(const DSVdesc &desc){
+    m_dsv = std::make_shared<NullResourceDescriptor>();
+    m_dsv->Create_DSV(m_buffer, desc);
+}
+
+void NullGpuResource::Create_SRV(const SRVdesc &desc){
+    m_srv = std::make_shared<NullResourceDescriptor>();
+    m_srv->Create_SRV(m_buffer, desc);
+}
+
+void NullGpuResource::Create_UAV(const UAVdesc &desc){
+    m_uav = std::make_shared<NullResourceDescriptor>();
+    m_uav->Create_UAV(m_buffer, desc);
+}
+
+void NullGpuResource::Create_CBV(const CBVdesc &desc) {
+    m_cbv = std::make_shared<NullResourceDescriptor>();
+    m_cbv->Create_CBV(m_buffer, desc);
+}
+
+void NullGpuResource::Create_Index_View(ResourceFormat format, uint32_t SizeInBytes){
+    m_index_view = std::make_shared<IndexVufferView>();
+    m_index_view->buffer_location = m_buffer;
+    m_index_view->format = format;
+    m_index_view->size_in_bytes = SizeInBytes;
+}
+
+void NullGpuResource::ResetViews(){
+    m_rtv.reset();
+    m_dsv.reset();
+    m_srv.reset();
+    m_uav.reset();
+    m_cbv.reset();
+    m_index_view.reset();
+}
@@ -0,0 +1,101 @@
+#include "NullHeapBuffer.h"
+
+#include "defines.h"
+#include "NullBackend.h"
+
+#include <algorithm>
+#include <cassert>
+
+extern NullBackend* gBackend;
+
+static uint32_t BitsPerPixel(ResourceFormat format) {
+    const uint64_t f = (uint64_t)format;
+    if (f >= 1 && f <= 4) return 128;
+    if (f >= 5 && f <= 8) return 96;
+    if (f >= 9 && f <= 22) return 64;
+    if (f >= 23 && f <= 47) return 32;
+    if (f >= 48 && f <= 59) return 16;
+    if (f >= 60 && f <= 65) return 8;
+    if (format == ResourceFormat::rf_r1_unorm) return 1;
+    if (f >= 67 && f <= 69) return 32;
+    if (f >= 70 && f <= 72) return 4;    // bc1
+    if (f >= 73 && f <= 78) return 8;    // bc2, bc3
+    if (f >= 79 && f <= 81) return 4;    // bc4
+    if (f >= 82 && f <= 84) return 8;    // bc5
+    if (f >= 85 && f <= 86) return 16;
+    if (f >= 87 && f <= 93) return 32;
+    if (f >= 94 && f <= 99) return 8;    // bc6h, bc7
+    if (format == ResourceFormat::rf_b4g4r4a4_unorm) return 16;
+
+    return 32;
+}
+
+void NullHeapBuffer::Create(HeapType type, uint32_t bufferSize, ResourceState initial_state, std::optional<std::wstring> dbg_name) {
+    m_type = type;
+    m_size = bufferSize;
+    if (type != HeapType::ht_default) {
+        m_storage.resize(bufferSize);
+    }
+
+    NullBackendStats& stats = gBackend->GetStats();
+    stats.resources_created++;
+    stats.resource_bytes_created += m_size;
+}
+
+void NullHeapBuffer::CreateTexture(HeapType type, const ResourceDesc &res_desc, ResourceState initial_state, const ClearColor *clear_val, std::optional<std::wstring> dbg_name){
+    m_type = type;
+
+    // full chain when mip_levels is 0
+    uint64_t width = res_desc.width;
+    uint64_t height = res_desc.height;
+    uint32_t mips = res_desc.mip_levels;
+    if (mips == 0) {
+        mips = 1;
+        for (uint64_t dim = std::max(width, height); dim > 1; dim >>= 1) {
+            mips++;
+        }
+    }
+
+    const uint64_t bpp = BitsPerPixel(res_desc.format);
+    m_size = 0;
+    for (uint32_t mip = 0; mip < mips; mip++) {
+        m_size += std::max<uint64_t>((width * height * bpp) / 8, 1);
+        width = std::max<uint64_t>(width >> 1, 1);
+        height = std::max<uint64_t>(height >> 1, 1);
+    }
+    m_size *= res_desc.depth_or_array_size;
+
+    NullBackendStats& stats = gBackend->GetStats();
+    stats.resources_created++;
+    stats.resource_bytes_created += m_size;
+}
+
+void NullHeapBuffer::Load(ICommandList* command_list, uint32_t numElements, uint32_t elementSize, const void* bufferData){
+    if (bufferData)
+    {
+        const uint64_t bufferSize = (uint64_t)numElements * elementSize;
+        gBackend->GetStats().buffer_upload_bytes += bufferSize;
+    }
+}
+
+void NullHeapBuffer::Load(ICommandList* command_list, uint32_t firstSubresource, uint32_t numSubresources, SubresourceData* subresourceData){
+    if (subresourceData)
+    {
+        uint64_t required_size = 0;
+        for (uint32_t i = 0; i < numSubresources; i++) {
+            required_size += subresourceData[i].slice_pitch;
+        }
+        gBackend->GetStats().texture_upload_bytes += required_size;
+    }
+}
+
+uint8_t* NullHeapBuffer::Map(){
+    assert(m_type != HeapType::ht_default);
+    m_cpu_data = m_storage.data();
+
+    return (uint8_t*)m_cpu_data;
+}
+
+void NullHeapBuffer::Unmap(){
+    m_cpu_data = nullptr;
+}
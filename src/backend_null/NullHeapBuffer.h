@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "IHeapBuffer.h"
+
+class ICommandList;
+struct ClearColor;
+struct ResourceDesc;
+
+// keeps cpu storage only for cpu visible heaps, uploads are just counted
+class NullHeapBuffer : public IHeapBuffer {
+public:
+    void Create(HeapType type, uint32_t bufferSize, ResourceState initial_state, std::optional<std::wstring> dbg_name = std::nullopt) override;
+    void CreateTexture(HeapType type, const ResourceDesc& res_desc, ResourceState initial_state, const ClearColor* clear_val, std::optional<std::wstring> dbg_name = std::nullopt) override;
+
+    void Load(ICommandList* command_list, uint32_t numElements, uint32_t elementSize, const void* bufferData) override;
+    void Load(ICommandList* command_list, uint32_t firstSubresource, uint32_t numSubresources, SubresourceData* subresourceData) override;
+
+    uint8_t* Map() override;
+    void Unmap() override;
+    void* GetCpuData() override { return m_cpu_data; }
+
+    uint64_t GetSize() const { return m_size; }
+private:
+    std::vector<uint8_t> m_storage;
+    void* m_cpu_data{nullptr};
+    uint64_t m_size{ 0 };
+    HeapType m_type{ HeapType::ht_default };
+};
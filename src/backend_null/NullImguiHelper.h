@@ -0,0 +1,15 @@
+#pragma once
+
+#include "IImguiHelper.h"
+
+class NullImguiHelper : public IImguiHelper {
+public:
+	void Initialize(uint32_t frames_num) override {}
+	void Destroy() override {}
+	void Render(uint32_t frame_id) override {}
+	bool WantCapture(CaptureInput_type type) const override { return false; }
+	void ShowConsole() override {}
+	void AddToConsoleLog(const std::string& line) override {}
+
+	IGpuResource* GetGuiQuad(uint32_t frame_id) override { return nullptr; }
+};
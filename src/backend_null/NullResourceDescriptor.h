@@ -0,0 +1,25 @@
+#pragma once
+
+#include "IResourceDescriptor.h"
+
+class NullResourceDescriptor : public IResourceDescriptor {
+public:
+    bool Create_RTV(std::weak_ptr<IHeapBuffer> buff) override { return Create(ResourceDescriptorType::rdt_rtv); }
+    bool Create_DSV(std::weak_ptr<IHeapBuffer> buff, const DSVdesc& desc) override { return Create(ResourceDescriptorType::rdt_dsv); }
+    bool Create_SRV(std::weak_ptr<IHeapBuffer> buff, const SRVdesc& desc) override { return Create(ResourceDescriptorType::rdt_srv); }
+    bool Create_UAV(std::weak_ptr<IHeapBuffer> buff, const UAVdesc& desc) override { return Create(ResourceDescriptorType::rdt_uav); }
+    bool Create_CBV(std::weak_ptr<IHeapBuffer> buff, const CBVdesc& desc) override { return Create(ResourceDescriptorType::rdt_cbv); }
+
+    CPUdescriptor GetCPUhandle() const override { return m_cpu_handle; }
+    ResourceDescriptorType GetType() const override { return m_type; }
+private:
+    bool Create(ResourceDescriptorType type) {
+        static uint64_t s_next_handle = 1;
+        m_type = type;
+        m_cpu_handle.ptr = s_next_handle++;
+        return true;
+    }
+
+    CPUdescriptor m_cpu_handle{ 0 };
+    ResourceDescriptorType m_type{ ResourceDescriptorType::rdt_srv };
+};
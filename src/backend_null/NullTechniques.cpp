@@ -0,0 +1,50 @@
+#include "NullTechniques.h"
+
+static ITechniques::Technique CreateTechnique(uint32_t root_sign, const wchar_t* vs, const wchar_t* ps, const wchar_t* cs, uint32_t vertex_type) {
+    ITechniques::Technique tech;
+    tech.root_signature = root_sign;
+    tech.vs = vs;
+    tech.ps = ps;
+    tech.cs = cs;
+    tech.vertex_type = vertex_type;
+
+    return tech;
+}
+
+void NullTechniques::OnInit(std::optional<std::wstring> dbg_name)
+{
+    // root signatures
+    {
+        for (uint32_t i = 0; i < 5; i++) {
+            uint32_t id = m_root_signatures.push_back();
+            m_root_signatures[id].SetRSId(id);
+        }
+    }
+
+    // techniques
+    {
+        uint32_t id = 0;
+        id = m_techniques.push_back(CreateTechnique(0, L"g_buffer_vs.hlsl", L"g_buffer_ps.hlsl", L"", 4));
+        m_techniques[id].id = id;
+        id = m_techniques.push_back(CreateTechnique(0, L"g_buffer_vs.hlsl", L"g_buffer_ps.hlsl", L"", 5));
+        m_techniques[id].id = id;
+        id = m_techniques.push_back(CreateTechnique(1, L"quad_screen_vs.hlsl", L"post_processing_ps.hlsl", L"", 2));
+        m_techniques[id].id = id;
+        id = m_techniques.push_back(CreateTechnique(2, L"quad_screen_vs.hlsl", L"def_shading_ps.hlsl", L"", 2));
+        m_techniques[id].id = id;
+        id = m_techniques.push_back(CreateTechnique(0, L"skybox_vs.hlsl", L"skybox_ps.hlsl", L"", 3));
+        m_techniques[id].id = id;
+        id = m_techniques.push_back(CreateTechnique(4, L"", L"", L"ssao_cs.hlsl", 0));
+        m_techniques[id].id = id;
+        id = m_techniques.push_back(CreateTechnique(4, L"", L"", L"gaussian_blur_cs.hlsl", 0));
+        m_techniques[id].id = id;
+        id = m_techniques.push_back(CreateTechnique(3, L"terrain_vs.hlsl", L"terrain_ps.hlsl", L"", 0));
+        m_techniques[id].id = id;
+        id = m_techniques.push_back(CreateTechnique(3, L"water_vs.hlsl", L"water_ps.hlsl", L"", 0));
+        m_techniques[id].id = id;
+        id = m_techniques.push_back(CreateTechnique(0, L"shadow_vs.hlsl", L"", L"", 0));
+        m_techniques[id].id = id;
+        id = m_techniques.push_back(CreateTechnique(4, L"", L"", L"refl_cs.hlsl", 0));
+        m_techniques[id].id = id;
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <optional>
+#include <cstdint>
+#include <string>
+
+#include "ITechniques.h"
+#include "IRootSignature.h"
+#include "simple_object_pool.h"
+
+class NullRootSignature : public IRootSignature {
+public:
+    uint32_t GetRSId() const override { return m_id; }
+    void SetRSId(uint32_t id) override { m_id = id; }
+private:
+    uint32_t m_id{ 0 };
+};
+
+// same ids, root signatures and vertex types as the dx12 techniques, no pipelines
+class NullTechniques : public ITechniques {
+public:
+    void OnInit(std::optional<std::wstring> dbg_name = std::nullopt) override;
+    const ITechniques::Technique * GetTechniqueById(uint32_t id) const override { return &m_techniques[id]; }
+    const IRootSignature* GetRootSignById(uint32_t id) const override { return &m_root_signatures[id]; }
+    bool TechHasColor(uint32_t tech_id) override { return (tech_id == 0); }
+    void RebuildShaders(std::optional<std::wstring> dbg_name = std::nullopt) override {}
+private:
+    static constexpr uint32_t TechniquesCount = 16;
+    static constexpr uint32_t RootSignCount = 16;
+    pro_game_containers::simple_object_pool<NullRootSignature, RootSignCount> m_root_signatures;
+    pro_game_containers::simple_object_pool<ITechniques::Technique, TechniquesCount> m_techniques;
+};
@@ -0,0 +1,150 @@
+#include "NullTextureLoader.h"
+#include "defines.h"
+#include "IGpuResource.h"
+#include "ICommandList.h"
+#include "TextureCooker.h"
+#include "TextureRegistry.h"
+#include "VirtualFileSystem.h"
+#include "StartupProfiler.h"
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cstring>
+
+ITextureLoader* CreateTextureLoader(const std::filesystem::path &root_dir) {
+	return new NullTextureLoader(root_dir);
+}
+
+NullTextureLoader::NullTextureLoader(const std::filesystem::path& root_dir)
+{
+	m_texture_dir = root_dir / L"content" / L"textures";
+	m_cooked_texture_dir = root_dir / L"content" / L"cooked" / L"textures";
+}
+
+ITextureLoader::TextureData* NullTextureLoader::LoadTextureOnCPU(const std::wstring& name)
+{
+	ITextureLoader::TextureData* texture = ReserveTexture(name);
+	if (texture->NeedsDecode()) {
+		DecodeTexture(texture);
+	}
+
+	return texture;
+}
+
+ITextureLoader::TextureData* NullTextureLoader::ReserveTexture(const std::wstring& name)
+{
+	return m_registry.Reserve(name);
+}
+
+ITextureLoader::TextureData* NullTextureLoader::ReserveTexture(const std::wstring& name, uint64_t content_hash, const EmbeddedImage& image)
+{
+	return m_registry.Reserve(name, content_hash, image);
+}
+
+void NullTextureLoader::DecodeTexture(ITextureLoader::TextureData* tex_data)
+{
+	EmbeddedImage embedded;
+	if (tex_data->content_hash) {
+		embedded.data = tex_data->embedded_data.data();
+		embedded.size = tex_data->embedded_data.size();
+		embedded.width = tex_data->embedded_width;
+		embedded.height = tex_data->embedded_height;
+		embedded.format_hint = tex_data->embedded_format_hint;
+	}
+
+	image_decoder::Image image;
+	DecodeImage(tex_data->name, tex_data->content_hash ? &embedded : nullptr, image, true);
+	m_registry.SetDecoded(tex_data, std::move(image));
+}
+
+bool NullTextureLoader::DecodeImage(const std::wstring& name, const EmbeddedImage* embedded, image_decoder::Image& image)
+{
+	// a file caught half written must fail, not pass as raw bytes
+	return DecodeImage(name, embedded, image, false);
+}
+
+bool NullTextureLoader::DecodeImage(const std::wstring& name, const EmbeddedImage* embedded, image_decoder::Image& image, bool keep_undecoded)
+{
+	StartupScope scope("texture decode", name);
+	std::shared_ptr<VfsFile> file;
+	const uint8_t* data = nullptr;
+	uint64_t size = 0;
+	bool decoded = false;
+	if (embedded && embedded->width) {
+		image_decoder::InitImage2D(ResourceFormat::rf_b8g8r8a8_unorm, embedded->width, embedded->height, image);
+		memcpy(image.pixels.data(), embedded->data, std::min<uint64_t>(embedded->size, image.pixels.size()));
+		decoded = true;
+	}
+	else if (embedded) {
+		data = embedded->data;
+		size = embedded->size;
+		decoded = image_decoder::Decode(data, size, embedded->format_hint, image);
+	}
+	else {
+		std::filesystem::path full_path((m_texture_dir / name));
+		// mips and block compression from the cooker when it ran on this source
+		const std::filesystem::path cooked_path = texture_cooker::GetCookedPath(m_cooked_texture_dir, name);
+		if (texture_cooker::IsCookedFresh(cooked_path, full_path) && image_decoder::DecodeFile(cooked_path, image)) {
+			return true;
+		}
+		// deleted or renamed since it was asked for
+		file = VirtualFileSystem::Get().Open(full_path);
+		if (!file) {
+			return false;
+		}
+
+		data = file->GetData();
+		size = file->GetSize();
+		decoded = image_decoder::Decode(data, size, full_path.extension().u8string(), image);
+	}
+
+	if (!decoded && !keep_undecoded) {
+		return false;
+	}
+	// jpg and friends: the file bytes stand in for the texels
+	if (!decoded) {
+		image = image_decoder::Image();
+		image.width = image.height = 1;
+		image.pixels.assign(data, data + size);
+		image_decoder::Subresource sub;
+		sub.row_pitch = sub.slice_pitch = image.pixels.size();
+		sub.width = sub.height = 1;
+		image.subresources.push_back(sub);
+	}
+	image.format = image_decoder::MakeSrgb(image.format);
+
+	return true;
+}
+
+void NullTextureLoader::LoadTextureOnGPU(ICommandList* command_list, IGpuResource* res, ITextureLoader::TextureData* tex_data)
+{
+	// evicted while waiting for the upload
+	if (!tex_data->is_decoded) {
+		DecodeTexture(tex_data);
+	}
+
+	const image_decoder::Image& image = tex_data->image;
+	ResourceDesc tex_desc = ResourceDesc::tex_2d(ResourceFormat::rf_r8g8b8a8_unorm_srgb, 1, 1, 1, 1);
+
+	res->CreateTexture(HeapType::ht_default, tex_desc, ResourceState::rs_resource_state_copy_dest, nullptr, std::wstring(tex_data->name).append(L"model_srv_").c_str());
+
+	frame_vector<SubresourceData> subresources(image.subresources.size());
+	for (uint32_t i = 0; i < (uint32_t)subresources.size(); i++) {
+		const image_decoder::Subresource& sub = image.subresources[i];
+		subresources[i].data = image.pixels.data() + sub.offset;
+		subresources[i].row_pitch = sub.row_pitch;
+		subresources[i].slice_pitch = sub.slice_pitch;
+	}
+	res->LoadBuffer(command_list, 0, (uint32_t)subresources.size(), subresources.data());
+	command_list->ResourceBarrier(*res, ResourceState::rs_resource_state_pixel_shader_resource);
+
+	SRVdesc srv_desc = {};
+	srv_desc.format = tex_desc.format;
+	srv_desc.dimension = SRVdesc::SRVdimensionType::srv_dt_texture2d;
+	srv_desc.texture2d.most_detailed_mip = 0;
+	srv_desc.texture2d.mip_levels = 1;
+	srv_desc.texture2d.res_min_lod_clamp = 0.0f;
+
+	res->Create_SRV(srv_desc);
+	m_registry.SetUploaded(tex_data);
+}
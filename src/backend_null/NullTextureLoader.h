@@ -0,0 +1,28 @@
+#pragma once
+
+#include "ITextureLoader.h"
+#include "TextureRegistry.h"
+#include <filesystem>
+#include <vector>
+
+// decodes on the cpu like the real backends; the gpu side gets a 1x1 placeholder and counts the decoded bytes as upload.
+// files the decoder does not support are kept as is when a texture loads; DecodeImage, which hot reload uses, fails on them
+class NullTextureLoader : public ITextureLoader {
+public:
+    NullTextureLoader(const std::filesystem::path& root_dir);
+    void OnInit() override {}
+    ITextureLoader::TextureData* LoadTextureOnCPU(const std::wstring& name) override;
+    ITextureLoader::TextureData* ReserveTexture(const std::wstring& name) override;
+    ITextureLoader::TextureData* ReserveTexture(const std::wstring& name, uint64_t content_hash, const EmbeddedImage& image) override;
+    void DecodeTexture(ITextureLoader::TextureData* tex_data) override;
+    bool DecodeImage(const std::wstring& name, const EmbeddedImage* embedded, image_decoder::Image& image) override;
+    void LoadTextureOnGPU(ICommandList* command_list, IGpuResource* res, ITextureLoader::TextureData* tex_data) override;
+    TextureRegistry& GetRegistry() override { return m_registry; }
+
+private:
+    bool DecodeImage(const std::wstring& name, const EmbeddedImage* embedded, image_decoder::Image& image, bool keep_undecoded);
+
+    TextureRegistry m_registry;
+    std::filesystem::path m_texture_dir;
+    std::filesystem::path m_cooked_texture_dir;
+};
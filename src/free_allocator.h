@@ -6,7 +6,7 @@
 #include <cassert>
 
 namespace pro_game_containers {
-    // TODO: ideally introduce Pages to be able to extend/shrink the buffer if necessary?
+    // first fit over a list of free ranges, O(free ranges) per call; tlsf_allocator is what the engine uses
     class free_allocator {
     public:
         free_allocator(uint32_t size) :
@@ -32,6 +32,10 @@ namespace pro_game_containers {
         }
         
         void deallocate(uint64_t start, uint32_t size) {
+            if (!size) {
+                return;
+            }
+
             std::vector<MemoryBlock>::iterator before_block = m_free_spaces.end();
             std::vector<MemoryBlock>::iterator after_block = m_free_spaces.end();
 
@@ -49,11 +53,11 @@ namespace pro_game_containers {
                 m_free_spaces.erase(after_block);
             }
             else if (before_block != m_free_spaces.end()) {
-                after_block->size += size;
-                after_block->start = start;
+                before_block->size += size;
             }
             else if (after_block != m_free_spaces.end()) {
-                before_block->size += size;
+                after_block->size += size;
+                after_block->start = start;
             }
             else {
                 m_free_spaces.push_back({ start, size});
@@ -25,8 +25,64 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
 }
 #else
 #include "LinApplication.h"
+#include "HeadlessApplication.h"
+#include <cstring>
+#include <cstdlib>
+
+int main(int argc, char** argv) {
+    bool headless = false;
+    HeadlessOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            options.frames = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--cook") == 0) {
+            options.cook = true;
+        }
+        else if (strcmp(argv[i], "--bench-vertices") == 0) {
+            options.bench_vertices = (i + 1 < argc && argv[i + 1][0] != '-') ? (uint32_t)strtoul(argv[++i], nullptr, 10) : 1000000;
+        }
+        else if (strcmp(argv[i], "--bench-level") == 0) {
+            options.bench_level = (i + 1 < argc && argv[i + 1][0] != '-') ? (uint32_t)strtoul(argv[++i], nullptr, 10) : 100000;
+        }
+        else if (strcmp(argv[i], "--bench-pool") == 0) {
+            options.bench_pool = (i + 1 < argc && argv[i + 1][0] != '-') ? (uint32_t)strtoul(argv[++i], nullptr, 10) : 1000000;
+        }
+        else if (strcmp(argv[i], "--bench-alloc") == 0) {
+            options.bench_alloc = (i + 1 < argc && argv[i + 1][0] != '-') ? (uint32_t)strtoul(argv[++i], nullptr, 10) : 1000000;
+        }
+        else if (strcmp(argv[i], "--stream-replay") == 0) {
+            options.stream_replay = (i + 1 < argc && argv[i + 1][0] != '-') ? (uint32_t)strtoul(argv[++i], nullptr, 10) : 100000;
+        }
+        else if (strcmp(argv[i], "--check-frame-allocs") == 0) {
+            options.check_frame_allocs = true;
+        }
+        else if (strcmp(argv[i], "--check-upload") == 0) {
+            options.check_upload = true;
+        }
+        else if (strcmp(argv[i], "--check-textures") == 0) {
+            options.check_textures = true;
+        }
+        else if (strcmp(argv[i], "--startup-budget-ms") == 0 && i + 1 < argc) {
+            options.startup_budget_ms = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--pack") == 0) {
+            options.pack = true;
+            if (i + 1 < argc && strcmp(argv[i + 1], "lz4") == 0) {
+                options.pack_lz4 = true;
+                i++;
+            }
+        }
+    }
+
+    if (headless) {
+        HeadlessApplication app(1280, 720, L"DX12Lib-headless");
+        return app.Run(options);
+    }
 
-int main() {
     LinApplication app(1280, 720, L"DX12Lib-linux");
     return app.Run();
 }